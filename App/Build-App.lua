@@ -20,6 +20,11 @@ project "App"
       "Core"
    }
 
+   -- Matches the MIXERGL_WITH_LUA switch in Core
+   if WithLua then
+      links { "Lua" }
+   end
+
    targetdir ("../Binaries/" .. OutputDir .. "/%{prj.name}")
    objdir ("../Binaries/Intermediates/" .. OutputDir .. "/%{prj.name}")
 
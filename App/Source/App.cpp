@@ -13,26 +13,72 @@
 
 #include "Core/shader_m.h"
 #include "Core/camera.h"
+#include "Core/projection.h"
+#include "Core/gl_state_cache.h"
+#include "Core/gpu_resources.h"
+#include "Core/gl_debug.h"
+#include "Core/mesh_pool.h"
+#include "Core/job_system.h"
+#include "Core/timeline.h"
+#include "Core/particles.h"
+#include "Core/automation.h"
+#include "Core/scripting.h"
+#include "Core/scatter.h"
+#include "Core/instance_batch.h"
+#include "Core/redraw.h"
+#include "Core/frame_pacer.h"
+#include "Core/selection.h"
+#include "Core/region_select.h"
+#include "Core/id_buffer.h"
+#include "Core/snap_index.h"
+#include "Core/editable_mesh.h"
+#include "Core/modifiers.h"
+#include "Core/tessellation.h"
+#include "Core/csg.h"
+#include "Core/image_decoder.h"
+#include "Core/gltf_scene.h"
+#include "Core/exporter.h"
+#include "Core/path_tracer.h"
+#include "Core/ao_baker.h"
+#include "Core/asset_library.h"
+#include "Core/thumbnail_renderer.h"
 #include "Core/tinyfiledialogs.h"
 
 #include <iostream>
 #include <vector>
 #include <string>
+#include <unordered_map>
+#include <chrono>
+#include <random>
+#include <cstddef>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <filesystem>
 
 // Declare the Object struct before function declarations
 struct Object {
     glm::vec3 position;
     glm::vec3 scale;
     glm::vec4 color; // RGBA color
-    bool isCube;     // true if cube, false if sphere
+    const Mesh* mesh; // shared primitive mesh from the mesh pool, or the GPU copy of an editable mesh
     unsigned int textureID; // ID of the texture to be applied
 };
 
+// Animated object properties are addressed as float offsets into the objects array, so the timeline
+// writes its results in place. Components 0-2 are the position, 3-5 the scale.
+const size_t OBJECT_FLOATS = sizeof(Object) / sizeof(float);
+const size_t OBJECT_ANIMATED_COMPONENTS = 6;
+static_assert(sizeof(Object) % sizeof(float) == 0, "Object must be addressable as a float array");
+
 // Function prototypes
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void mouse_button_callback(GLFWwindow* window, int button, int action, int mods);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods);
+void window_refresh_callback(GLFWwindow* window);
 void processInput(GLFWwindow* window);
 
 // Helper functions for raycasting and rendering
@@ -54,8 +100,92 @@ bool IsRayNearCircle(const glm::vec3& ray_origin, const glm::vec3& ray_direction
 void RenderObjectSettings();
 void SetupFrameBuffer();
 unsigned int LoadTexture(const char* path);
-void SetupSphere();
 void DrawSmallCube(Shader& shader, const glm::vec3& position, const glm::vec4& color);
+glm::mat4 GetProjectionMatrix();
+void SetDepthMode(Depth_Mode mode);
+void RenderViewportSettings();
+void RenderStatistics();
+void SetupGizmoLines();
+void ReleaseTextureIfUnused(unsigned int textureID);
+void ReleaseGpuResources();
+void RenderGpuMemory();
+void RenderGLDebugStatistics();
+void AddPrimitive(const PrimitiveDesc& desc, const glm::vec3& position);
+void RenderAddPrimitive();
+size_t ObjectChannelTarget(size_t objectIndex, size_t component);
+void UpdateAnimation();
+void RenderTimeline();
+void KeySelectedObject();
+void AnimateAllObjects();
+void BenchmarkTimeline();
+void RenderParticleSettings();
+void BenchmarkParticles();
+void ProcessAutomation();
+void HandleAutomationBatch(const std::vector<uint8_t>& request, MessageWriter& reply);
+Automation_Status ValidateAutomationCommand(uint32_t command, MessageReader reader, size_t& objectCount);
+void ApplyAutomationCommand(uint32_t command, MessageReader reader, MessageWriter& reply);
+void RenderAutomation();
+void BenchmarkAutomation();
+void BindScripting();
+void RenderScripting();
+bool BuildScatterSurface(ScatterSurface& surface);
+void ScatterInstancesOnTarget();
+void RenderInstanceBatches(Shader& shader);
+void RenderScatter();
+void InputEvent();
+bool IsViewportWindow(GLFWwindow* window);
+void WakeMainLoop();
+void RequestRedraws();
+void WaitForRedraw(GLFWwindow* window);
+void ApplyGizmoDrag();
+void SelectObject(int index, bool extend);
+void UpdateSelectionPivot();
+void BenchmarkSelectionTransform();
+void UpdateRegionSelect(GLFWwindow* window, Shader& idShader);
+void FilterVisibleInRegion(Shader& idShader, const SelectionRegion& region, const glm::vec2& windowSize, std::vector<uint32_t>& hits);
+void RenderRegionOverlay();
+float SnapRadiusAt(const glm::vec3& point);
+void BeginSnapDrag();
+glm::vec3 SnapDragTarget(glm::vec3 target);
+void RenderSnapMarker();
+void RenderMeshEdit();
+EditableMesh* FindEditableMesh(const Mesh* mesh);
+void MakeObjectEditable(int index);
+void ApplySculpt();
+const Mesh* BaseMesh(int index);
+uint64_t BaseMeshKey(const Mesh* mesh);
+MeshData BaseMeshData(const Mesh* mesh);
+MeshData DrawnMeshData(int index);
+void UpdateModifiers();
+void RenderModifiers();
+void ApplyBoolean(Boolean_Operation operation, int target, int cutter);
+void BenchmarkBooleans();
+void RenderBooleans();
+const GltfScene* FindImportedScene(const Mesh* mesh);
+bool ImportGltf(const std::string& path);
+void UpdateImports();
+void BenchmarkGltfImport();
+void RenderImport();
+ExportScene BuildExportScene();
+bool ExportObjects(const std::string& path, Export_Format format);
+void BenchmarkExport();
+void RenderExport();
+uint64_t DrawnMeshKey(size_t index);
+uint64_t TracedSceneKey();
+void RebuildTracedScene();
+bool SyncTracedScene();
+void UpdatePathTracer();
+void PresentPathTracer();
+void RenderPathTracer();
+void BakeOcclusion(bool incremental);
+void UploadOcclusion(const std::vector<size_t>& changed, bool relayout);
+void UpdateOcclusion();
+GLint ObjectOcclusionOffset(size_t index);
+void RenderOcclusion();
+void RescanAssets();
+void UpdateAssetBrowser();
+void ApplyTextureToSelection(const std::string& path);
+void RenderAssetBrowser();
 
 
 // Global settings
@@ -68,6 +198,15 @@ float lastX = SCR_WIDTH / 2.0f;
 float lastY = SCR_HEIGHT / 2.0f;
 bool firstMouse = true;
 
+// Projection and depth buffer setup; reverse-Z is used when the context supports glClipControl
+Projection viewProjection;
+bool reverseZSupported = false;
+int framebufferWidth = SCR_WIDTH;
+int framebufferHeight = SCR_HEIGHT;
+
+// Shadowed GL state; binds and toggles go through this to skip redundant driver calls
+GLStateCache glState;
+
 // Timing for frame handling
 float deltaTime = 0.0f;
 float lastFrame = 0.0f;
@@ -78,7 +217,24 @@ float gridStep = 1.0f;
 
 // Vector to store created objects
 std::vector<Object> objects;
-int selectedObject = -1;
+int selectedObject = -1; // active object, shown in Object Settings; always part of the selection
+
+// Every selected object; the gizmo sits at their mean position and transforms all of them
+Selection selection;
+glm::vec3 selectionPivot = glm::vec3(0.0f);
+const ObjectLayout OBJECT_LAYOUT = { OBJECT_FLOATS, offsetof(Object, position) / sizeof(float), offsetof(Object, scale) / sizeof(float) };
+
+// Box and lasso selection; a left drag that misses the gizmo draws a rectangle, or a lasso with Ctrl held
+bool regionSelecting = false;
+bool regionPending = false; // released, applied at the start of the next frame
+bool regionExtend = false;
+Region_Shape regionShape = REGION_RECTANGLE;
+glm::vec2 regionStart = glm::vec2(0.0f);
+glm::vec2 regionEnd = glm::vec2(0.0f);
+std::vector<glm::vec2> lassoPoints;
+bool selectVisibleOnly = false; // keep only objects with visible pixels in the region, read back from an ID pass
+RegionSelectStats regionStats;
+double regionIdPassMs = 0.0;
 
 // Gizmo settings 
 int selectedAxis = -1; // -1 means no axis selected, 0 = X, 1 = Y, 2 = Z
@@ -98,14 +254,228 @@ bool settingsDisplayed = false;
 
 float movementSensitivity = 4.0f;
 
+// Snapping while moving with the gizmo; object and vertex targets come from a spatial hash synced when a drag starts
+Snap_Mode snapMode = SNAP_OFF;
+float snapRadiusPixels = 12.0f;
+SnapIndex snapIndex;
+glm::vec3 dragStartPivot = glm::vec3(0.0f);
+glm::vec3 dragOffset = glm::vec3(0.0f); // unsnapped translation accumulated since the drag started
+bool snapActive = false;
+glm::vec3 snapPoint = glm::vec3(0.0f);
+
 
-// VAOs for cube and sphere
-unsigned int cubeVAO, VBO, texture1;
-unsigned int gridVAO, gridVBO;
-unsigned int sphereVAO;
-unsigned int sphereVertexCount;
+// Every GL object is owned by a handle registered here, so memory can be reported and leaks caught at shutdown
+GpuResourceRegistry gpuResources;
+
+// KHR_debug output routed into the console, with per-category counters and pass markers
+GLDebugOutput glDebug;
+
+GpuHandle texture1;
+GpuHandle gridVAO, gridVBO;
+GpuHandle gizmoLineVAO, gizmoLineVBO;
+const unsigned int GIZMO_LINE_CAPACITY = 128; // Max vertices per gizmo line strip
 unsigned int gridVertexCount = 0; // Variable to store the number of grid vertices
-unsigned int fbo, fboTexture, rbo;
+GpuHandle fbo, fboTexture, rbo;
+
+// Primitive meshes are generated once and shared by every object with the same parameters
+MeshPool meshPool(gpuResources, glState);
+
+// Object ID render target for depth-aware region selection
+IdBuffer idBuffer(gpuResources, glState);
+
+// GL 4.0 path that smooths adaptive subdivision surfaces further on the GPU
+TessellationPreview tessellation(gpuResources, glState);
+
+// Meshes in edit mode; objects using one point at its GPU copy instead of a pooled mesh
+std::vector<std::unique_ptr<EditableMesh>> editableMeshes;
+int editDensity = 1; // multiplies the primitive's resolution when a mesh is made editable
+bool sculptMode = false; // left drag pushes the vertices under the cursor out along their normals, Shift pulls them in
+bool sculpting = false;
+float brushRadius = 0.1f;
+float brushStrength = 0.5f; // world units per second at the brush center
+
+// Modifier stack of an object together with the mesh it starts from; the object draws the stack's result
+struct ObjectModifiers {
+    ModifierStack Stack;
+    const Mesh* Base = nullptr;                 // pooled or editable mesh the object had before the stack
+    uint64_t BaseKey = 0;
+    std::shared_ptr<const MeshData> BaseData;   // CPU copy of Base, made when a stage first needs it
+    uint64_t MeshKey = 0;                       // derived pool mesh the object draws; 0 while it draws Base
+};
+std::unordered_map<int, ObjectModifiers> objectModifiers;
+Modifier_Type newModifierType = MODIFIER_ARRAY;
+double modifierUpdateMs = 0.0; // last frame that evaluated any stack
+size_t modifierUpdateStacks = 0;
+
+// Boolean results have no primitive description to regenerate from, so their CPU copy is kept with them
+struct BooleanResult {
+    uint64_t Key;
+    std::shared_ptr<const MeshData> Data;
+    const Mesh* Gpu;
+};
+std::vector<BooleanResult> booleanResults;
+uint64_t booleanCount = 0; // operations so far; numbers the pool keys, which must stay unique as results are released
+BooleanStats booleanStats; // of the last operation
+
+const Mesh* cubeMesh = nullptr; // also used for gizmo handles
+std::vector<GpuHandle> shaderPrograms;
+
+// Textures loaded for objects, keyed by file path so objects using the same image share one texture
+std::unordered_map<std::string, GpuHandle> textureLibrary;
+
+// Texture workers: loaders hand them compressed images, UpdateImports uploads what they decoded
+ImageDecoder textureWorkers(2);
+
+// Imported glTF assets; objects point at their meshes, so a scene lives until the GPU resources are released.
+// Each node primitive became one object, starting at FirstObject in instance order.
+struct ImportedScene {
+    std::unique_ptr<GltfScene> Scene;
+    size_t FirstObject;
+    std::vector<std::vector<size_t>> NodeObjects; // objects made from each node, for the hierarchy view
+};
+std::vector<ImportedScene> importedScenes;
+// Embedded images on the texture workers, by ticket; the library key is the asset path and image index
+struct PendingImportTexture {
+    std::string Key;
+    std::vector<size_t> Objects;
+};
+std::unordered_map<uint64_t, PendingImportTexture> pendingImportTextures;
+char importPath[512] = "";
+double importTexturesMs = 0.0; // main thread time spent uploading decoded images
+
+// Export of the object array; objects sharing a mesh share one copy of it in the file
+char exportPath[512] = "";
+int exportFormat = EXPORT_GLB;
+ExportStats exportStats;                // of the last export
+size_t exportPeakResidentBytes = 0;     // process peak afterwards; the peak never goes down, so compare it with the one before
+size_t exportPeakBeforeBytes = 0;
+
+// Path traced preview; replaces the raster passes while enabled and starts over on any camera, scene or setting
+// change. Mesh BVHs are kept by content key for as long as the scene uses them.
+PathTracer pathTracer;
+bool pathTracerEnabled = false;
+TracerSettings tracerSettings;
+float tracerResolutionScale = 0.5f; // of the framebuffer; the image is stretched over the window
+std::unordered_map<uint64_t, std::shared_ptr<const TracedMesh>> tracedMeshes;
+std::shared_ptr<const TracedScene> tracedScene;
+uint64_t tracedSceneKey = 0;
+uint64_t tracedSceneGeneration = 0;  // counts rebuilds, so each user can tell whether it has the current scene
+uint64_t tracerSceneGeneration = 0;  // the one pathTracer was last restarted with
+TracerCamera tracedCamera;
+TracerSettings tracedSettings;
+double tracerSceneMs = 0.0; // last scene rebuild, including mesh BVHs it had to build
+size_t tracerMeshesBuilt = 0;
+GpuHandle tracerTexture, tracerFramebuffer;
+int tracerTextureWidth = 0;
+int tracerTextureHeight = 0;
+std::vector<uint8_t> tracerPixels;
+
+// Baked per-vertex ambient occlusion, traced against the path tracer's scene BVH. The values of all objects share
+// one buffer texture that the scene shaders index by object offset and vertex ID; an edit rebakes only the objects
+// within occlusion distance of what changed.
+struct BakedOcclusion {
+    AoBakeRecord Record;
+    uint64_t MeshKey = 0;
+    unsigned int VertexCount = 0;   // of the mesh baked; a different mesh drawn since reads no values
+    size_t Offset = 0;              // of the first value in the buffer
+    std::vector<uint8_t> Values;
+};
+const GLint OCCLUSION_TEXTURE_UNIT = 1; // texture unit 0 keeps the object textures
+std::vector<BakedOcclusion> bakedOcclusion; // per object
+AoBakeSettings aoSettings;
+AoBakeSettings bakedAoSettings;
+bool aoAutoRebake = true;       // after each edit, once the drag ends
+uint64_t aoSceneKey = 0;        // TracedSceneKey of the last bake
+AoBakeStats aoStats;            // of the last bake
+double aoBakeMs = 0.0;          // including the scene and the upload
+size_t aoUploadedBytes = 0;
+GpuHandle occlusionBuffer, occlusionTexture;
+
+// Asset browser over the indexed directories. Thumbnails are requested as their cells scroll into view; finished
+// ones are uploaded and meshes rendered within a per-frame budget, and textures of cells long out of view are
+// dropped again once there are too many, since the disk cache brings them back quickly.
+enum Thumbnail_State {
+    THUMBNAIL_NONE,
+    THUMBNAIL_REQUESTED,
+    THUMBNAIL_READY,
+    THUMBNAIL_FAILED
+};
+struct AssetView {
+    AssetEntry Entry;
+    Thumbnail_State State = THUMBNAIL_NONE;
+    GpuHandle Texture;
+    int Width = 0;
+    int Height = 0;
+    uint64_t LastVisibleFrame = 0;
+};
+const size_t MAX_THUMBNAIL_TEXTURES = 1024;
+std::unique_ptr<AssetLibrary> assetLibrary;
+ThumbnailRenderer thumbnailRenderer(gpuResources, glState);
+std::vector<AssetView> assetViews;
+uint64_t assetGeneration = 0;
+uint64_t assetFrame = 0;
+size_t assetTextureCount = 0;
+char assetRoot[512] = "Source/textures";
+char assetFilter[128] = "";
+int assetKindFilter = -1;           // Asset_Kind shown, -1 for all
+float assetBudgetMs = 4.0f;         // per frame for uploading thumbnails and rendering meshes
+double assetFrameMs = 0.0;          // spent by the last frame that had work
+size_t assetMeshesRendered = 0;
+char texturePath[512] = "Source/textures/texture1.jpg"; // of the object settings, also filled by the asset browser
+
+// Worker threads shared by the batched per-frame passes
+JobSystem jobs;
+
+// Keyframe animation of object transforms
+Timeline timeline;
+Interpolation_Mode keyMode = INTERPOLATION_BEZIER;
+float animationEvaluatedTime = -1.0f; // time of the last evaluation; -1 forces the next one
+float animationEvaluateMs = 0.0f;
+
+// CPU time of the last ImGui draw submission, including its vertex/index upload
+float imguiRenderMs = 0.0f;
+int imguiVertices = 0;
+int imguiIndices = 0;
+
+// GPU particle effect preview; buffers are only allocated once the effect is enabled
+ParticleSystem particles(gpuResources, glState);
+ParticleEmitter particleEmitter;
+bool particlesEnabled = false;
+int particleCapacity = 250000;
+
+// Local automation socket; batches are applied between frames
+AutomationServer automationServer;
+char automationSocketPath[256] = "/tmp/mixergl.sock";
+unsigned long long automationCommandsApplied = 0;
+unsigned int automationCommandsLastFrame = 0;
+
+// Automation benchmark client running on its own thread; the result is logged by the main thread
+std::thread automationBenchmarkThread;
+std::atomic<bool> automationBenchmarkDone{ false };
+std::mutex automationBenchmarkMutex;
+std::string automationBenchmarkResult;
+
+// Embedded Lua scripting over the object array
+ScriptRuntime scripting;
+char scriptSource[64 * 1024] = "";
+Script_Status lastScriptStatus = SCRIPT_IDLE;
+
+// Scatter tool; every scatter becomes one instanced batch drawn with a single call
+std::vector<std::unique_ptr<InstanceBatch>> scatterBatches;
+ScatterSettings scatterSettings;
+int scatterTarget = 0; // 0 grid plane, 1 selected object
+int scatterPrimitive = PRIMITIVE_CUBE;
+
+// On-demand rendering; the loop sleeps in glfwWaitEvents while nothing changes
+RedrawScheduler redraw;
+double lastInputTime = 0.0;
+Camera renderedCamera = camera; // camera as of the last rendered frame
+
+// Frames-in-flight limit and input latency; the cursor is sampled once per frame right after the GPU wait
+FramePacer framePacer;
+double frameCursorX = 0.0;
+double frameCursorY = 0.0;
+bool rawMouseMotion = false; // unaccelerated mouse look while the right button holds the cursor
 
 // Vector to store debug messages for ImGui console
 std::vector<std::string> debugMessages;
@@ -120,6 +490,9 @@ int main()
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+#ifdef DEBUG
+    glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GLFW_TRUE); // Drivers only report performance warnings on debug contexts
+#endif
 
 #ifdef __APPLE__
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
@@ -138,9 +511,12 @@ int main()
     glfwSetCursorPosCallback(window, mouse_callback);
     glfwSetMouseButtonCallback(window, mouse_button_callback);
     glfwSetScrollCallback(window, scroll_callback);
+    glfwSetKeyCallback(window, key_callback);
+    glfwSetWindowRefreshCallback(window, window_refresh_callback);
 
     // Make the cursor visible
     glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
+    rawMouseMotion = glfwRawMouseMotionSupported() == GLFW_TRUE;
 
 
 
@@ -153,6 +529,8 @@ int main()
     io.ConfigFlags |= ImGuiConfigFlags_DockingEnable;
 
     ImGui_ImplGlfw_InitForOpenGL(window, true);
+    // Detached viewports get their own GLFW windows; chain our callbacks there too so their input wakes the loop
+    ImGui_ImplGlfw_SetCallbacksChainForAllWindows(true);
     ImGui_ImplOpenGL3_Init("#version 330");
 
     // Load all OpenGL functions using GLAD
@@ -162,23 +540,76 @@ int main()
         return -1;
     }
 
+    gpuResources.StateCache = &glState;
+
+    // Route driver errors and performance warnings into the log
+    if (glDebug.Install((GLADloadproc)glfwGetProcAddress, Log)) {
+        Log("KHR_debug output enabled");
+    }
+    else {
+        Log("KHR_debug unavailable, polling glGetError once per frame");
+    }
+
     // Enable depth test for proper 3D rendering
-    glEnable(GL_DEPTH_TEST);
+    glState.ActiveTexture(GL_TEXTURE0);
+    glState.Enable(GL_DEPTH_TEST);
+
+    // Prefer reverse-Z with a 32-bit float depth buffer; the default framebuffer's depth is fixed-point,
+    // so the scene is rendered offscreen and blitted to the window in that mode
+    glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+    reverseZSupported = LoadClipControl((GLADloadproc)glfwGetProcAddress);
+    SetupFrameBuffer();
+    SetDepthMode(reverseZSupported ? DEPTH_REVERSE_Z : DEPTH_STANDARD);
+    Log(reverseZSupported ? "Reverse-Z depth enabled (infinite far plane)" : "glClipControl unavailable, using standard depth range");
 
     // Grid setup
     SetupGrid(gridSize, gridStep);
 
-    // Sphere setup
-    SetupSphere();
+    // Primitive meshes
+    cubeMesh = meshPool.Acquire(PrimitiveDesc::Cube());
+
+    // Shared line buffer for gizmo arrows and circles
+    SetupGizmoLines();
 
     // Load shaders
     Shader ourShader("Source/shaders/vertex.glsl", "Source/shaders/fragment.glsl");
     Shader gridShader("Source/shaders/grid_vertex.glsl", "Source/shaders/grid_fragment.glsl");
     Shader gizmoShader("Source/shaders/gizmo_vertex.glsl", "Source/shaders/gizmo_fragment.glsl");
+    Shader instancedShader("Source/shaders/instanced_vertex.glsl", "Source/shaders/instanced_fragment.glsl");
+    Shader idShader("Source/shaders/id_vertex.glsl", "Source/shaders/id_fragment.glsl");
+    shaderPrograms.push_back(GpuHandle::Adopt(gpuResources, GPU_PROGRAM, ourShader.ID, "Scene shader"));
+    shaderPrograms.push_back(GpuHandle::Adopt(gpuResources, GPU_PROGRAM, gridShader.ID, "Grid shader"));
+    shaderPrograms.push_back(GpuHandle::Adopt(gpuResources, GPU_PROGRAM, gizmoShader.ID, "Gizmo shader"));
+    shaderPrograms.push_back(GpuHandle::Adopt(gpuResources, GPU_PROGRAM, instancedShader.ID, "Instanced shader"));
+    shaderPrograms.push_back(GpuHandle::Adopt(gpuResources, GPU_PROGRAM, idShader.ID, "Object ID shader"));
+    glState.UseProgram(ourShader.ID);
+    ourShader.setInt("occlusion", OCCLUSION_TEXTURE_UNIT);
+    ourShader.setInt("occlusionOffset", -1);
+    tessellation.OcclusionUnit = OCCLUSION_TEXTURE_UNIT;
+    thumbnailRenderer.Initialize("Source/shaders/", OCCLUSION_TEXTURE_UNIT);
+    if (!particles.Initialize("Source/shaders/")) {
+        Log("Failed to build the particle shaders");
+    }
+    if (tessellation.Initialize("Source/shaders/")) {
+        Log("Tessellation preview enabled for adaptive subdivision surfaces");
+    }
+    else {
+        Log("Tessellation shaders unavailable, adaptive subdivision surfaces draw their refined mesh");
+    }
+
+    // Expose the scene to scripts
+    BindScripting();
+
+    // Automation requests arrive on the IO thread and have to wake an idle loop
+    automationServer.OnRequest = WakeMainLoop;
+    textureWorkers.OnDecoded = WakeMainLoop;
+    assetLibrary = std::make_unique<AssetLibrary>((std::filesystem::temp_directory_path() / "mixergl_thumbnails").string());
+    assetLibrary->OnReady = WakeMainLoop;
+    RescanAssets();
 
     // Load and create a texture
-    glGenTextures(1, &texture1);
-    glBindTexture(GL_TEXTURE_2D, texture1);
+    texture1 = GpuHandle::Create(gpuResources, GPU_TEXTURE, "Default texture");
+    glState.BindTexture(GL_TEXTURE_2D, texture1.ID());
 
     // Set the texture wrapping and filtering options
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
@@ -194,6 +625,7 @@ int main()
     {
         glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
         glGenerateMipmap(GL_TEXTURE_2D);
+        texture1.SetBytes(EstimateTextureBytes(width, height, 4, true));
     }
     else
     {
@@ -201,85 +633,52 @@ int main()
     }
     stbi_image_free(data); // Free the texture data
 
-    // Cube vertices with positions and texture coordinates
-    float vertices[] = {
-        // Positions          // Texture Coords
-        -0.5f, -0.5f, -0.5f,  0.0f, 0.0f,
-         0.5f, -0.5f, -0.5f,  1.0f, 0.0f,
-         0.5f,  0.5f, -0.5f,  1.0f, 1.0f,
-         0.5f,  0.5f, -0.5f,  1.0f, 1.0f,
-        -0.5f,  0.5f, -0.5f,  0.0f, 1.0f,
-        -0.5f, -0.5f, -0.5f,  0.0f, 0.0f,
-
-        -0.5f, -0.5f,  0.5f,  0.0f, 0.0f,
-         0.5f, -0.5f,  0.5f,  1.0f, 0.0f,
-         0.5f,  0.5f,  0.5f,  1.0f, 1.0f,
-         0.5f,  0.5f,  0.5f,  1.0f, 1.0f,
-        -0.5f,  0.5f,  0.5f,  0.0f, 1.0f,
-        -0.5f, -0.5f,  0.5f,  0.0f, 0.0f,
-
-        -0.5f,  0.5f,  0.5f,  1.0f, 0.0f,
-        -0.5f,  0.5f, -0.5f,  1.0f, 1.0f,
-        -0.5f, -0.5f, -0.5f,  0.0f, 1.0f,
-        -0.5f, -0.5f, -0.5f,  0.0f, 1.0f,
-        -0.5f, -0.5f,  0.5f,  0.0f, 0.0f,
-        -0.5f,  0.5f,  0.5f,  1.0f, 0.0f,
-
-         0.5f,  0.5f,  0.5f,  1.0f, 0.0f,
-         0.5f,  0.5f, -0.5f,  1.0f, 1.0f,
-         0.5f, -0.5f, -0.5f,  0.0f, 1.0f,
-         0.5f, -0.5f, -0.5f,  0.0f, 1.0f,
-         0.5f, -0.5f,  0.5f,  0.0f, 0.0f,
-         0.5f,  0.5f,  0.5f,  1.0f, 0.0f,
-
-        -0.5f, -0.5f, -0.5f,  0.0f, 1.0f,
-         0.5f, -0.5f, -0.5f,  1.0f, 1.0f,
-         0.5f, -0.5f,  0.5f,  1.0f, 0.0f,
-         0.5f, -0.5f,  0.5f,  1.0f, 0.0f,
-        -0.5f, -0.5f,  0.5f,  0.0f, 0.0f,
-        -0.5f, -0.5f, -0.5f,  0.0f, 1.0f,
-
-        -0.5f,  0.5f, -0.5f,  0.0f, 1.0f,
-         0.5f,  0.5f, -0.5f,  1.0f, 1.0f,
-         0.5f,  0.5f,  0.5f,  1.0f, 0.0f,
-         0.5f,  0.5f,  0.5f,  1.0f, 0.0f,
-        -0.5f,  0.5f,  0.5f,  0.0f, 0.0f,
-        -0.5f,  0.5f, -0.5f,  0.0f, 1.0f
-    };
-
-    // VAO and VBO setup for the cube
-    glGenVertexArrays(1, &cubeVAO);
-    glGenBuffers(1, &VBO);
-
-    glBindVertexArray(cubeVAO);
-
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-
-    // Position attribute
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-
-    // Texture coordinate attribute
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-
     // Add a default cube to the scene at startup
     glm::vec3 startPosition = camera.Position + glm::vec3(0.0f, 0.5f, -3.0f); // Create the cube in front of the camera
-    objects.push_back({ startPosition, glm::vec3(1.0f), glm::vec4(1.0f), true });
+    objects.push_back({ startPosition, glm::vec3(1.0f), glm::vec4(1.0f), cubeMesh });
     Log("Default cube created at position " + glm::to_string(startPosition) + " with scale (1.0, 1.0, 1.0)");
 
 
     // Main render loop
     while (!glfwWindowShouldClose(window)) {
+        // Let the GPU catch up to the frame limit first, so the input read below is as fresh as possible when it is drawn
+        framePacer.WaitForGpu();
+        WaitForRedraw(window);
+        if (glfwWindowShouldClose(window)) {
+            break;
+        }
+        framePacer.InputSampled();
+        glfwGetCursorPos(window, &frameCursorX, &frameCursorY);
+
         // Calculate frame time
         float currentFrame = static_cast<float>(glfwGetTime());
         deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
         settingsDisplayed = false;
+        glState.BeginFrame();
+        glDebug.BeginFrame();
+        glDebug.LabelResources(gpuResources);
 
-        // Process input
+        // Process input, and move dragged objects before anything is drawn so they show up this frame
         processInput(window);
+        ApplyGizmoDrag();
+        ApplySculpt();
+
+        // Apply automation batches at the frame boundary
+        ProcessAutomation();
+        UpdateImports();
+
+        // Resume the running script within its frame budget
+        scripting.Update();
+
+        // Apply animated transforms before anything reads the objects
+        UpdateAnimation();
+        UpdateModifiers();
+        UpdateRegionSelect(window, idShader);
+        UpdateSelectionPivot();
+        UpdatePathTracer();
+        UpdateOcclusion();
+        UpdateAssetBrowser();
 
         // Start a new ImGui frame
         ImGui_ImplOpenGL3_NewFrame();
@@ -287,93 +686,74 @@ int main()
         ImGui::NewFrame();
 
         // Clear the screen for rendering
+        bool offscreen = viewProjection.Mode == DEPTH_REVERSE_Z;
+        if (offscreen) {
+            glState.BindFramebuffer(GL_FRAMEBUFFER, fbo.ID());
+        }
         glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
 
-        // Render the 3D scene
-        RenderScene(ourShader);
+        // The path traced preview stands in for every scene pass, gizmo included
+        if (pathTracerEnabled) {
+            GLDebugGroup group(glDebug, "Path tracer");
+            PresentPathTracer();
+        }
+        else {
+            // Render the 3D scene
+            {
+                GLDebugGroup group(glDebug, "Scene");
+                RenderScene(ourShader);
+            }
 
-        // Render the XYZ gizmo if an object is selected
-        if (selectedObject >= 0) {
-            switch (currentMode) {
-            case TRANSLATE:
-                RenderTranslationGizmo(gizmoShader, objects[selectedObject]);
-                break;
-            case ROTATE:
-                RenderRotationGizmo(objects[selectedObject], gizmoShader);
-                break;
-            case SCALE:
-                RenderScalingGizmo(gizmoShader, objects[selectedObject]);
-                break;
+            // Render scattered instances, one draw call per batch
+            if (!scatterBatches.empty()) {
+                GLDebugGroup group(glDebug, "Scatter");
+                RenderInstanceBatches(instancedShader);
             }
-        }
 
-        // Handle dragging and transformations
-        if (isDragging && selectedObject >= 0 && selectedAxis >= 0) {
-            double xpos, ypos;
-            glfwGetCursorPos(window, &xpos, &ypos);
+            // Render the XYZ gizmo at the selection pivot if anything is selected
+            if (selectedObject >= 0) {
+                GLDebugGroup group(glDebug, "Gizmo");
+                Object gizmoTarget = objects[selectedObject];
+                gizmoTarget.position = selectionPivot;
+                switch (currentMode) {
+                case TRANSLATE:
+                    RenderTranslationGizmo(gizmoShader, gizmoTarget);
+                    break;
+                case ROTATE:
+                    RenderRotationGizmo(gizmoTarget, gizmoShader);
+                    break;
+                case SCALE:
+                    RenderScalingGizmo(gizmoShader, gizmoTarget);
+                    break;
+                }
+            }
 
+            // Render the grid
+            glm::mat4 projection = GetProjectionMatrix();
             glm::mat4 view = camera.GetViewMatrix();
-            glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-
-            glm::vec3 ray_origin = camera.Position;
-            glm::vec3 ray_direction = ScreenToWorldRay(static_cast<float>(xpos), static_cast<float>(ypos), view, projection);
-            glm::vec3 currentRayPosition = ray_origin + ray_direction;
-
-            glm::vec3 axisDirection;
-            if (selectedAxis == 0) {
-                axisDirection = glm::vec3(1.0f, 0.0f, 0.0f);
-            }
-            else if (selectedAxis == 1) {
-                axisDirection = glm::vec3(0.0f, 1.0f, 0.0f);
-            }
-            else if (selectedAxis == 2) {
-                axisDirection = glm::vec3(0.0f, 0.0f, 1.0f);
+            {
+                GLDebugGroup group(glDebug, "Grid");
+                DrawGrid(gridShader, projection, view);
             }
 
-            // Calculate the movement and apply the sensitivity factor
-            glm::vec3 movement = glm::dot(currentRayPosition - initialClickPosition, axisDirection) * axisDirection * movementSensitivity;
-
-            // Apply the transformation based on the current mode
-            switch (currentMode) {
-            case TRANSLATE:
-                objects[selectedObject].position += movement;
-                Log("Translating along axis " + std::to_string(selectedAxis) +
-                    ", movement: " + glm::to_string(movement) +
-                    ", new position: " + glm::to_string(objects[selectedObject].position));
-                break;
-
-            case ROTATE: {
-                float angle = glm::length(movement) * 5.0f * movementSensitivity; // Apply sensitivity to the rotation
-                glm::vec3 rotationAxis = glm::normalize(axisDirection);
-                glm::quat rotation = glm::angleAxis(glm::radians(angle), rotationAxis);
-                glm::vec3 objectCenter = objects[selectedObject].position;
-                glm::vec3 newPosition = rotation * (objects[selectedObject].position - objectCenter) + objectCenter;
-                objects[selectedObject].position = newPosition;
-
-                Log("Rotating around axis " + std::to_string(selectedAxis) +
-                    ", angle: " + std::to_string(angle) +
-                    ", new position: " + glm::to_string(objects[selectedObject].position));
-                break;
+            // Simulate and draw particles after the opaque passes, since they blend without writing depth
+            if (particlesEnabled) {
+                GLDebugGroup group(glDebug, "Particles");
+                particles.Update(particleEmitter, std::min(deltaTime, 0.1f));
+                particles.Draw(particleEmitter, view, projection);
             }
 
-            case SCALE:
-                objects[selectedObject].scale += movement;
-                objects[selectedObject].scale = glm::max(objects[selectedObject].scale, glm::vec3(0.1f));
-                Log("Scaling along axis " + std::to_string(selectedAxis) +
-                    ", scale change: " + glm::to_string(movement) +
-                    ", new scale: " + glm::to_string(objects[selectedObject].scale));
-                break;
+            // Resolve the offscreen scene into the window before the UI is drawn on top
+            if (offscreen) {
+                GLDebugGroup group(glDebug, "Resolve");
+                glState.BindFramebuffer(GL_READ_FRAMEBUFFER, fbo.ID());
+                glState.BindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+                glBlitFramebuffer(0, 0, framebufferWidth, framebufferHeight, 0, 0, framebufferWidth, framebufferHeight, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+                glState.BindFramebuffer(GL_FRAMEBUFFER, 0);
             }
-
-            initialClickPosition = currentRayPosition;
         }
 
-        // Render the grid
-        glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-        glm::mat4 view = camera.GetViewMatrix();
-        DrawGrid(gridShader, projection, view);
-
         // Render ImGui interface
         RenderImGui(ourShader);
         RenderImGuiConsole();
@@ -381,7 +761,15 @@ int main()
 
         // End ImGui frame and render ImGui data
         ImGui::Render();
-        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        {
+            GLDebugGroup group(glDebug, "ImGui");
+            ImDrawData* drawData = ImGui::GetDrawData();
+            imguiVertices = drawData->TotalVtxCount;
+            imguiIndices = drawData->TotalIdxCount;
+            auto start = std::chrono::high_resolution_clock::now();
+            ImGui_ImplOpenGL3_RenderDrawData(drawData);
+            imguiRenderMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        }
 
         // Handle multi-viewports if enabled
         if (ImGui::GetIO().ConfigFlags & ImGuiConfigFlags_ViewportsEnable) {
@@ -391,26 +779,44 @@ int main()
             glfwMakeContextCurrent(backup_current_context);
         }
 
-        // Swap buffers and poll for events
+        // Decide whether the next frame is needed before presenting this one
+        RequestRedraws();
+
+        // Swap buffers; events are polled, or waited for, at the start of the next frame
         glfwSwapBuffers(window);
-        glfwPollEvents();
+        framePacer.FramePresented(glfwGetTime());
+        redraw.FrameRendered(glfwGetTime());
     }
 
-    // Cleanup
+    // Cleanup; stopping the server also disconnects a running benchmark client
+    automationServer.Stop();
+    if (automationBenchmarkThread.joinable()) {
+        automationBenchmarkThread.join();
+    }
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext();
+    ReleaseGpuResources();
     glfwTerminate();
     return 0;
 }
 
 // Framebuffer size callback for resizing the window
 void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
+    InputEvent();
     glViewport(0, 0, width, height);
+    if (width > 0 && height > 0) {
+        framebufferWidth = width;
+        framebufferHeight = height;
+        SetupFrameBuffer(); // Keep the offscreen depth/color targets in sync with the window
+    }
 }
 
 // Mouse callback for handling camera rotation
 void mouse_callback(GLFWwindow* window, double xposIn, double yposIn) {
+    InputEvent();
+    if (IsViewportWindow(window))
+        return;
     // Only rotate the camera if the right mouse button is pressed
     if (glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_RIGHT) == GLFW_PRESS) {
         float xpos = static_cast<float>(xposIn);
@@ -441,17 +847,40 @@ void mouse_callback(GLFWwindow* window, double xposIn, double yposIn) {
 
 // Mouse button callback for raycasting
 void mouse_button_callback(GLFWwindow* window, int button, int action, int mods) {
+    InputEvent();
+    if (IsViewportWindow(window))
+        return;
+
+    // Mouse look hides and captures the cursor, which is when GLFW can deliver raw, unaccelerated motion
+    if (button == GLFW_MOUSE_BUTTON_RIGHT && action == GLFW_PRESS && !ImGui::GetIO().WantCaptureMouse) {
+        glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+        if (rawMouseMotion) {
+            glfwSetInputMode(window, GLFW_RAW_MOUSE_MOTION, GLFW_TRUE);
+        }
+    }
+    else if (button == GLFW_MOUSE_BUTTON_RIGHT && action == GLFW_RELEASE) {
+        if (glfwRawMouseMotionSupported()) {
+            glfwSetInputMode(window, GLFW_RAW_MOUSE_MOTION, GLFW_FALSE);
+        }
+        glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
+    }
     if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS) {
         // Check if the mouse is over any ImGui window, and if so, don't perform object selection
         if (ImGui::GetIO().WantCaptureMouse) {
             return;
         }
 
+        // Sculpting takes the left button over from selection while the active object is editable
+        if (sculptMode && selectedObject >= 0 && FindEditableMesh(BaseMesh(selectedObject)) != nullptr) {
+            sculpting = true;
+            return;
+        }
+
         double xpos, ypos;
         glfwGetCursorPos(window, &xpos, &ypos);
 
         glm::mat4 view = camera.GetViewMatrix();
-        glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
+        glm::mat4 projection = GetProjectionMatrix();
 
         glm::vec3 ray_origin = camera.Position;
         glm::vec3 ray_direction = ScreenToWorldRay(static_cast<float>(xpos), static_cast<float>(ypos), view, projection);
@@ -461,22 +890,22 @@ void mouse_button_callback(GLFWwindow* window, int button, int action, int mods)
         // Check if a gizmo is clicked if an object is selected
         if (selectedObject >= 0) {
             const float gizmoClickRadius = 0.2f; // Fine-tune this value as needed
-            Object& obj = objects[selectedObject];
+            const glm::vec3& pivot = selectionPivot;
 
             // Check if the click is near the X axis arrow
-            if (DistanceFromRayToLineSegment(ray_origin, ray_direction, obj.position, obj.position + glm::vec3(1.0f, 0.0f, 0.0f)) < gizmoClickRadius) {
+            if (DistanceFromRayToLineSegment(ray_origin, ray_direction, pivot, pivot + glm::vec3(1.0f, 0.0f, 0.0f)) < gizmoClickRadius) {
                 selectedAxis = 0; // X-axis selected
                 isDragging = true;
                 Log("Selected X-axis for dragging");
             }
             // Check if the click is near the Y axis arrow
-            else if (DistanceFromRayToLineSegment(ray_origin, ray_direction, obj.position, obj.position + glm::vec3(0.0f, 1.0f, 0.0f)) < gizmoClickRadius) {
+            else if (DistanceFromRayToLineSegment(ray_origin, ray_direction, pivot, pivot + glm::vec3(0.0f, 1.0f, 0.0f)) < gizmoClickRadius) {
                 selectedAxis = 1; // Y-axis selected
                 isDragging = true;
                 Log("Selected Y-axis for dragging");
             }
             // Check if the click is near the Z axis arrow
-            else if (DistanceFromRayToLineSegment(ray_origin, ray_direction, obj.position, obj.position + glm::vec3(0.0f, 0.0f, 1.0f)) < gizmoClickRadius) {
+            else if (DistanceFromRayToLineSegment(ray_origin, ray_direction, pivot, pivot + glm::vec3(0.0f, 0.0f, 1.0f)) < gizmoClickRadius) {
                 selectedAxis = 2; // Z-axis selected
                 isDragging = true;
                 Log("Selected Z-axis for dragging");
@@ -485,6 +914,7 @@ void mouse_button_callback(GLFWwindow* window, int button, int action, int mods)
             // Store the initial click position if dragging started
             if (isDragging) {
                 initialClickPosition = ray_origin + ray_direction;
+                BeginSnapDrag();
                 Log("Started dragging along axis " + std::to_string(selectedAxis));
             }
             else {
@@ -492,33 +922,69 @@ void mouse_button_callback(GLFWwindow* window, int button, int action, int mods)
             }
         }
 
-        // Handle object selection if no gizmo is clicked or the selection failed
+        // Handle object selection if no gizmo is clicked or the selection failed; Shift adds or removes the hit object
         if (selectedObject == -1 || !isDragging) {
-            selectedObject = -1;
+            bool extend = (mods & GLFW_MOD_SHIFT) != 0;
+            int hit = -1;
             for (size_t i = 0; i < objects.size(); ++i) {
                 if (RayIntersectsObject(ray_origin, ray_direction, objects[i])) {
-                    selectedObject = static_cast<int>(i);
-                    Log("Object " + std::to_string(i) + " selected at position " + glm::to_string(objects[i].position));
+                    hit = static_cast<int>(i);
+                    Log("Object " + std::to_string(i) + " hit at position " + glm::to_string(objects[i].position));
                     break;
                 }
             }
+            if (hit >= 0 || !extend) {
+                SelectObject(hit, extend);
+            }
             if (selectedObject == -1) {
                 Log("No object selected");
             }
         }
+
+        // Without a gizmo grab the press may also start a box (or, with Ctrl, a lasso) selection; a plain click leaves it empty
+        if (!isDragging) {
+            regionSelecting = true;
+            regionExtend = (mods & GLFW_MOD_SHIFT) != 0;
+            regionShape = (mods & GLFW_MOD_CONTROL) ? REGION_LASSO : REGION_RECTANGLE;
+            regionStart = regionEnd = glm::vec2(static_cast<float>(xpos), static_cast<float>(ypos));
+            lassoPoints.assign(1, regionStart);
+        }
     }
     else if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_RELEASE) {
+        if (regionSelecting) {
+            double xpos, ypos;
+            glfwGetCursorPos(window, &xpos, &ypos);
+            regionEnd = glm::vec2(static_cast<float>(xpos), static_cast<float>(ypos));
+            lassoPoints.push_back(regionEnd);
+            regionSelecting = false;
+            regionPending = true;
+        }
         isDragging = false;
+        sculpting = false;
+        snapActive = false;
         selectedAxis = -1;
         Log("Stopped dragging");
     }
 }
 
 // Scroll callback for zooming
-void scroll_callback(GLFWwindow* window, double xoffset, double yoffset) {
+void scroll_callback(GLFWwindow* window, double /*xoffset*/, double yoffset) {
+    InputEvent();
+    if (IsViewportWindow(window))
+        return;
     camera.ProcessMouseScroll(static_cast<float>(yoffset));
 }
 
+// Key callback; keys are read in processInput and by ImGui, this only wakes the loop
+void key_callback(GLFWwindow* /*window*/, int /*key*/, int /*scancode*/, int /*action*/, int /*mods*/) {
+    InputEvent();
+}
+
+// Window refresh callback for when the window contents were damaged, e.g. uncovered
+void window_refresh_callback(GLFWwindow* /*window*/) {
+    InputEvent();
+}
+
 // Handle keyboard input
 void processInput(GLFWwindow* window) {
     if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
@@ -537,7 +1003,7 @@ void processInput(GLFWwindow* window) {
 glm::vec3 ScreenToWorldRay(float mouseX, float mouseY, const glm::mat4& view, const glm::mat4& projection) {
     float x = (2.0f * mouseX) / SCR_WIDTH - 1.0f;
     float y = 1.0f - (2.0f * mouseY) / SCR_HEIGHT;
-    glm::vec4 ray_clip = glm::vec4(x, y, -1.0f, 1.0f);
+    glm::vec4 ray_clip = glm::vec4(x, y, viewProjection.NearPlaneNdcZ(), 1.0f);
 
     glm::vec4 ray_eye = glm::inverse(projection) * ray_clip;
     ray_eye = glm::vec4(ray_eye.x, ray_eye.y, -1.0f, 0.0f);
@@ -549,7 +1015,7 @@ glm::vec3 ScreenToWorldRay(float mouseX, float mouseY, const glm::mat4& view, co
 // Improved collision detection for object selection
 bool RayIntersectsObject(const glm::vec3& ray_origin, const glm::vec3& ray_direction, const Object& object) {
     // Bounding sphere test
-    float radius = 0.5f * glm::length(object.scale); // Use object's scale as radius
+    float radius = object.mesh->Radius * glm::length(object.scale); // Use object's scale as radius
     glm::vec3 oc = ray_origin - object.position;
     float a = glm::dot(ray_direction, ray_direction);
     float b = 2.0f * glm::dot(oc, ray_direction);
@@ -563,21 +1029,21 @@ bool RayIntersectsObject(const glm::vec3& ray_origin, const glm::vec3& ray_direc
 }
 
 void RenderObjectWithOutline(Shader& shader, const Object& obj) {
-    shader.use();
+    glState.UseProgram(shader.ID);
 
     // Set up projection and view matrices
-    glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
+    glm::mat4 projection = GetProjectionMatrix();
     glm::mat4 view = camera.GetViewMatrix();
     shader.setMat4("projection", projection);
     shader.setMat4("view", view);
 
     // Enable stencil testing
-    glEnable(GL_STENCIL_TEST);
+    glState.Enable(GL_STENCIL_TEST);
 
     // First pass: Render the original object normally to set the stencil buffer
-    glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
-    glStencilFunc(GL_ALWAYS, 1, 0xFF);
-    glStencilMask(0xFF); // Write to the stencil buffer
+    glState.StencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
+    glState.StencilFunc(GL_ALWAYS, 1, 0xFF);
+    glState.StencilMask(0xFF); // Write to the stencil buffer
 
     // Render the original object
     glm::mat4 model = glm::mat4(1.0f);
@@ -586,15 +1052,13 @@ void RenderObjectWithOutline(Shader& shader, const Object& obj) {
     shader.setMat4("model", model);
     shader.setVec4("color", obj.color); // Use the object's original color
 
-    if (obj.isCube) {
-        glBindVertexArray(cubeVAO);
-        glDrawArrays(GL_TRIANGLES, 0, 36);
-    }
+    glState.BindVertexArray(obj.mesh->VAO.ID());
+    obj.mesh->Draw();
 
     // Second pass: Render the outline where the stencil buffer is not set
-    glStencilFunc(GL_NOTEQUAL, 1, 0xFF);
-    glStencilMask(0x00); // Disable writing to the stencil buffer
-    glDisable(GL_DEPTH_TEST); // Disable depth testing so the outline appears on top
+    glState.StencilFunc(GL_NOTEQUAL, 1, 0xFF);
+    glState.StencilMask(0x00); // Disable writing to the stencil buffer
+    glState.Disable(GL_DEPTH_TEST); // Disable depth testing so the outline appears on top
 
     // Render the scaled-up object in yellow as the outline
     model = glm::mat4(1.0f);
@@ -603,34 +1067,54 @@ void RenderObjectWithOutline(Shader& shader, const Object& obj) {
     shader.setMat4("model", model);
     shader.setVec4("color", glm::vec4(1.0f, 1.0f, 0.0f, 1.0f)); // Yellow color for the outline
 
-    if (obj.isCube) {
-        glBindVertexArray(cubeVAO);
-        glDrawArrays(GL_TRIANGLES, 0, 36);
-    }
+    obj.mesh->Draw();
 
     // Reset stencil settings
-    glEnable(GL_DEPTH_TEST);
-    glStencilMask(0xFF);
-    glDisable(GL_STENCIL_TEST);
+    glState.Enable(GL_DEPTH_TEST);
+    glState.StencilMask(0xFF);
+    glState.Disable(GL_STENCIL_TEST);
 }
 
 void RenderScene(Shader& shader) {
-    shader.use();
-    glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
+    glState.UseProgram(shader.ID);
+    glm::mat4 projection = GetProjectionMatrix();
     glm::mat4 view = camera.GetViewMatrix();
     shader.setMat4("projection", projection);
     shader.setMat4("view", view);
 
-    for (const auto& obj : objects) {
+    float fovy = glm::radians(camera.Zoom);
+    float aspect = (float)SCR_WIDTH / (float)SCR_HEIGHT;
+    std::vector<size_t> adaptiveObjects;
+    if (occlusionTexture.IsValid()) {
+        glState.ActiveTexture(GL_TEXTURE0 + OCCLUSION_TEXTURE_UNIT);
+        glState.BindTexture(GL_TEXTURE_BUFFER, occlusionTexture.ID());
+        glState.ActiveTexture(GL_TEXTURE0);
+    }
+
+    for (size_t i = 0; i < objects.size(); ++i) {
+        const Object& obj = objects[i];
+
+        // Skip objects whose bounding sphere lies outside the view frustum
+        glm::vec3 viewCenter = glm::vec3(view * glm::vec4(obj.position, 1.0f));
+        if (!viewProjection.IsSphereVisible(viewCenter, obj.mesh->Radius * glm::length(obj.scale), fovy, aspect)) {
+            continue;
+        }
+
+        // Adaptive surfaces are drawn after the loop with the tessellation program
+        if (obj.mesh->Adaptive && tessellation.IsAvailable()) {
+            adaptiveObjects.push_back(i);
+            continue;
+        }
+
         if (obj.textureID != 0) {
             // Use the texture
-            glBindTexture(GL_TEXTURE_2D, obj.textureID);
+            glState.BindTexture(GL_TEXTURE_2D, obj.textureID);
             shader.setBool("useTexture", true);
         }
         else {
             // No texture available; use a default color
             shader.setBool("useTexture", false);
-            shader.setVec4("color", glm::vec4(0.8f, 0.8f, 0.8f, 1.0f)); // Light gray color
+            shader.setVec4("color", selection.Contains(i) ? glm::vec4(1.0f, 0.65f, 0.2f, 1.0f) : glm::vec4(0.8f, 0.8f, 0.8f, 1.0f)); // Light gray color, orange when selected
         }
 
         // Set up the model matrix
@@ -638,20 +1122,23 @@ void RenderScene(Shader& shader) {
         model = glm::translate(model, obj.position);
         model = glm::scale(model, obj.scale);
         shader.setMat4("model", model);
+        shader.setInt("occlusionOffset", ObjectOcclusionOffset(i));
 
         // Render the object
-        if (obj.isCube) {
-            glBindVertexArray(cubeVAO);
-            glDrawArrays(GL_TRIANGLES, 0, 36);
-        }
-        else {
-            glBindVertexArray(sphereVAO);
-            glDrawElements(GL_TRIANGLES, sphereVertexCount, GL_UNSIGNED_INT, 0);
+        glState.BindVertexArray(obj.mesh->VAO.ID());
+        obj.mesh->Draw();
+    }
+    shader.setInt("occlusionOffset", -1); // later passes with this shader draw without occlusion
+
+    if (!adaptiveObjects.empty()) {
+        tessellation.Begin(view, projection, glm::vec2(static_cast<float>(framebufferWidth), static_cast<float>(framebufferHeight)));
+        for (size_t i : adaptiveObjects) {
+            const Object& obj = objects[i];
+            glm::mat4 model = glm::scale(glm::translate(glm::mat4(1.0f), obj.position), obj.scale);
+            glm::vec4 color = selection.Contains(i) ? glm::vec4(1.0f, 0.65f, 0.2f, 1.0f) : glm::vec4(0.8f, 0.8f, 0.8f, 1.0f);
+            tessellation.Draw(*obj.mesh, model, color, obj.textureID, ObjectOcclusionOffset(i));
         }
     }
-
-    glBindVertexArray(0);
-    glBindTexture(GL_TEXTURE_2D, 0); // Unbind the texture after rendering
 }
 
 // Render ImGui settings for creating and manipulating objects
@@ -691,30 +1178,80 @@ void RenderImGui(Shader ourShader) {
         currentMode = SCALE;
     }
 
+    // Snapping applies to moves; grid snapping uses the grid step
+    if (ImGui::BeginCombo("Snap", SnapModeName(snapMode))) {
+        for (int mode = 0; mode < SNAP_MODE_COUNT; ++mode) {
+            if (ImGui::Selectable(SnapModeName(static_cast<Snap_Mode>(mode)), snapMode == mode)) {
+                snapMode = static_cast<Snap_Mode>(mode);
+            }
+        }
+        ImGui::EndCombo();
+    }
+    if (snapMode == SNAP_OBJECT || snapMode == SNAP_VERTEX) {
+        ImGui::SliderFloat("Snap radius (px)", &snapRadiusPixels, 2.0f, 40.0f, "%.0f");
+    }
+
     ImGui::End();
 
+    RenderViewportSettings();
+    RenderStatistics();
+    RenderTimeline();
+    RenderParticleSettings();
+    RenderAutomation();
+    RenderScripting();
+    RenderScatter();
+    RenderMeshEdit();
+    RenderModifiers();
+    RenderBooleans();
+    RenderImport();
+    RenderExport();
+    RenderPathTracer();
+    RenderOcclusion();
+    RenderAssetBrowser();
+    RenderRegionOverlay();
+    RenderSnapMarker();
+
     // Object List window
     ImGui::Begin("Object List");
 
     // Add buttons for adding a cube or sphere above the object list
     if (ImGui::Button("Add Cube")) {
         // Add a cube to the scene at (0, 0.5, 0)
-        objects.push_back({ glm::vec3(0.0f, 0.5f, 0.0f), glm::vec3(1.0f), glm::vec4(1.0f), true });
-        Log("Added a new cube at position (0, 0.5, 0)");
+        AddPrimitive(PrimitiveDesc::Cube(), glm::vec3(0.0f, 0.5f, 0.0f));
     }
     ImGui::SameLine();
     if (ImGui::Button("Add Sphere")) {
         // Add a sphere to the scene at (0, 0.5, 0)
-        objects.push_back({ glm::vec3(0.0f, 0.5f, 0.0f), glm::vec3(1.0f), glm::vec4(1.0f), false });
-        Log("Added a new sphere at position (0, 0.5, 0)");
+        AddPrimitive(PrimitiveDesc::UVSphere(), glm::vec3(0.0f, 0.5f, 0.0f));
     }
+    RenderAddPrimitive();
 
-    // List all objects
-    for (size_t i = 0; i < objects.size(); ++i) {
-        std::string objName = "Object " + std::to_string(i);
-        if (ImGui::Selectable(objName.c_str(), selectedObject == static_cast<int>(i))) {
-            selectedObject = static_cast<int>(i); // Select the object
-            Log("Selected object " + objName);
+    // Whole-scene selection; the gizmo then transforms every selected object around their mean position
+    if (ImGui::Button("Select All")) {
+        selection.SelectAll(objects.size());
+        selectedObject = objects.empty() ? -1 : static_cast<int>(objects.size()) - 1;
+        Log("Selected all " + std::to_string(objects.size()) + " objects");
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Select None")) {
+        SelectObject(-1, false);
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Benchmark Transform")) {
+        BenchmarkSelectionTransform();
+    }
+    ImGui::Text("%zu selected", selection.Count());
+
+    // List all objects; only the visible rows are submitted, and Shift-click extends the selection
+    ImGuiListClipper clipper;
+    clipper.Begin(static_cast<int>(objects.size()));
+    while (clipper.Step()) {
+        for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; ++i) {
+            std::string objName = "Object " + std::to_string(i);
+            if (ImGui::Selectable(objName.c_str(), selection.Contains(i))) {
+                SelectObject(i, ImGui::GetIO().KeyShift);
+                Log("Selected object " + objName);
+            }
         }
     }
 
@@ -741,6 +1278,7 @@ void RenderImGuiConsole() {
 void Log(const std::string& message) {
     std::cout << message << std::endl;  // Standard console output
     debugMessages.push_back(message);   // Also add to in-app log
+    redraw.Request(REDRAW_UI, 2);       // The console scrolls to the new line on the frame after it appears
 }
 
 void SetupGrid(float size, float step) {
@@ -771,18 +1309,19 @@ void SetupGrid(float size, float step) {
     gridVertexCount = vertices.size() / 3; // Each vertex has 3 components (x, y, z)
 
     // Create VAO and VBO for the grid
-    glGenVertexArrays(1, &gridVAO);
-    glGenBuffers(1, &gridVBO);
-    glBindVertexArray(gridVAO);
+    gridVAO = GpuHandle::Create(gpuResources, GPU_VERTEX_ARRAY, "Grid");
+    gridVBO = GpuHandle::Create(gpuResources, GPU_BUFFER, "Grid");
+    glState.BindVertexArray(gridVAO.ID());
 
-    glBindBuffer(GL_ARRAY_BUFFER, gridVBO);
+    glState.BindBuffer(GL_ARRAY_BUFFER, gridVBO.ID());
     glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+    gridVBO.SetBytes(vertices.size() * sizeof(float));
 
     // Set vertex attribute pointers
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(0);
 
-    glBindVertexArray(0);
+    glState.BindVertexArray(0);
 
     // Check for errors after setting up the grid
     GLenum err = glGetError();
@@ -792,23 +1331,33 @@ void SetupGrid(float size, float step) {
 }
 
 void DrawGrid(Shader& shader, const glm::mat4& projection, const glm::mat4& view) {
-    shader.use();
+    glState.UseProgram(shader.ID);
     shader.setMat4("projection", projection);
     shader.setMat4("view", view);
 
     // Use an identity matrix for the grid's model matrix to keep it fixed
     glm::mat4 model = glm::mat4(1.0f); // Identity matrix
+
+    // Without a far plane the grid follows the camera and widens its spacing by powers of ten with altitude,
+    // so it stays visible and readable at kilometer scale
+    if (viewProjection.Mode == DEPTH_REVERSE_Z) {
+        float level = glm::max(0.0f, std::floor(std::log10(glm::max(std::abs(camera.Position.y), 1.0f))));
+        float scale = std::pow(10.0f, level);
+        float snap = gridStep * scale;
+        glm::vec3 center(std::floor(camera.Position.x / snap) * snap, 0.0f, std::floor(camera.Position.z / snap) * snap);
+        model = glm::translate(model, center);
+        model = glm::scale(model, glm::vec3(scale, 1.0f, scale));
+    }
     shader.setMat4("model", model);
 
-    glBindVertexArray(gridVAO);
+    glState.BindVertexArray(gridVAO.ID());
     glDrawArrays(GL_LINES, 0, gridVertexCount); // Use the updated gridVertexCount
-    glBindVertexArray(0);
 }
 
 void RenderGizmo(Shader& gizmoShader, const Object& obj) {
-    gizmoShader.use();
+    glState.UseProgram(gizmoShader.ID);
 
-    glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
+    glm::mat4 projection = GetProjectionMatrix();
     glm::mat4 view = camera.GetViewMatrix();
     gizmoShader.setMat4("projection", projection);
     gizmoShader.setMat4("view", view);
@@ -819,7 +1368,7 @@ void RenderGizmo(Shader& gizmoShader, const Object& obj) {
     gizmoShader.setMat4("model", model);
 
     // Set line width to make the gizmo wider
-    glLineWidth(3.0f); // Increase this value for thicker lines
+    glState.LineWidth(3.0f); // Increase this value for thicker lines
 
     // Draw the X axis (red)
     glm::vec4 xColor = (selectedAxis == 0 && isDragging) ? glm::vec4(1.0f, 0.5f, 0.5f, 1.0f) : glm::vec4(1.0f, 0.0f, 0.0f, 1.0f);
@@ -837,7 +1386,7 @@ void RenderGizmo(Shader& gizmoShader, const Object& obj) {
     DrawArrow(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
 
     // Restore line width to default (optional)
-    glLineWidth(1.0f);
+    glState.LineWidth(1.0f);
 }
 
 void DrawArrow(const glm::vec3& start, const glm::vec3& end) {
@@ -846,23 +1395,11 @@ void DrawArrow(const glm::vec3& start, const glm::vec3& end) {
         end.x, end.y, end.z
     };
 
-    unsigned int arrowVAO, arrowVBO;
-    glGenVertexArrays(1, &arrowVAO);
-    glGenBuffers(1, &arrowVBO);
-    glBindVertexArray(arrowVAO);
-
-    glBindBuffer(GL_ARRAY_BUFFER, arrowVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(arrowVertices), arrowVertices, GL_STATIC_DRAW);
-
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-
-    glBindVertexArray(arrowVAO);
+    // Stream the arrow into the shared gizmo line buffer
+    glState.BindVertexArray(gizmoLineVAO.ID());
+    glState.BindBuffer(GL_ARRAY_BUFFER, gizmoLineVBO.ID());
+    glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(arrowVertices), arrowVertices);
     glDrawArrays(GL_LINES, 0, 2);
-    glBindVertexArray(0);
-
-    glDeleteVertexArrays(1, &arrowVAO);
-    glDeleteBuffers(1, &arrowVBO);
 }
 
 // Function to calculate the shortest distance between a ray and a line segment
@@ -916,26 +1453,13 @@ void DrawCircle(const glm::vec3& objectPosition, const glm::vec3& axis, float ra
         points.push_back(finalPosition);
     }
 
-    // Create a VAO and VBO for the circle
-    unsigned int circleVAO, circleVBO;
-    glGenVertexArrays(1, &circleVAO);
-    glGenBuffers(1, &circleVBO);
-    glBindVertexArray(circleVAO);
-
-    glBindBuffer(GL_ARRAY_BUFFER, circleVBO);
-    glBufferData(GL_ARRAY_BUFFER, points.size() * sizeof(glm::vec3), &points[0], GL_STATIC_DRAW);
-
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
-    glEnableVertexAttribArray(0);
+    // Stream the circle into the shared gizmo line buffer
+    glState.BindVertexArray(gizmoLineVAO.ID());
+    glState.BindBuffer(GL_ARRAY_BUFFER, gizmoLineVBO.ID());
+    glBufferSubData(GL_ARRAY_BUFFER, 0, points.size() * sizeof(glm::vec3), &points[0]);
 
     // Draw the circle using GL_LINE_LOOP to connect the points
-    glBindVertexArray(circleVAO);
     glDrawArrays(GL_LINE_LOOP, 0, segments);
-    glBindVertexArray(0);
-
-    // Clean up the VBO and VAO
-    glDeleteVertexArrays(1, &circleVAO);
-    glDeleteBuffers(1, &circleVBO);
 }
 
 // Render the translation gizmo
@@ -945,10 +1469,10 @@ void RenderTranslationGizmo(Shader& shader, const Object& obj) {
 
 // Render the rotation gizmo
 void RenderRotationGizmo(const Object& obj, Shader& gizmoShader) {
-    gizmoShader.use();
+    glState.UseProgram(gizmoShader.ID);
 
     // Set up the projection and view matrices
-    glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
+    glm::mat4 projection = GetProjectionMatrix();
     glm::mat4 view = camera.GetViewMatrix();
     gizmoShader.setMat4("projection", projection);
     gizmoShader.setMat4("view", view);
@@ -970,6 +1494,9 @@ void RenderScalingGizmo(Shader& shader, const Object& obj) {
     glm::mat4 model;
     float cubeSize = 0.1f; // Size of the small cubes at the end of the gizmos
 
+    // All three handles share the cube mesh
+    glState.BindVertexArray(cubeMesh->VAO.ID());
+
     // Define positions for the small cubes at the end of the gizmos
     glm::vec3 xEnd = obj.position + glm::vec3(1.0f * obj.scale.x, 0.0f, 0.0f);
     glm::vec3 yEnd = obj.position + glm::vec3(0.0f, 1.0f * obj.scale.y, 0.0f);
@@ -980,26 +1507,21 @@ void RenderScalingGizmo(Shader& shader, const Object& obj) {
     model = glm::translate(glm::mat4(1.0f), xEnd);
     model = glm::scale(model, glm::vec3(cubeSize));
     shader.setMat4("model", model);
-    glBindVertexArray(cubeVAO);
-    glDrawArrays(GL_TRIANGLES, 0, 36);
+    cubeMesh->Draw();
 
     // Draw the small cube for the Y-axis
     shader.setVec4("color", glm::vec4(0.0f, 1.0f, 0.0f, 1.0f)); // Green color
     model = glm::translate(glm::mat4(1.0f), yEnd);
     model = glm::scale(model, glm::vec3(cubeSize));
     shader.setMat4("model", model);
-    glBindVertexArray(cubeVAO);
-    glDrawArrays(GL_TRIANGLES, 0, 36);
+    cubeMesh->Draw();
 
     // Draw the small cube for the Z-axis
     shader.setVec4("color", glm::vec4(0.0f, 0.0f, 1.0f, 1.0f)); // Blue color
     model = glm::translate(glm::mat4(1.0f), zEnd);
     model = glm::scale(model, glm::vec3(cubeSize));
     shader.setMat4("model", model);
-    glBindVertexArray(cubeVAO);
-    glDrawArrays(GL_TRIANGLES, 0, 36);
-
-    glBindVertexArray(0); // Unbind the VAO
+    cubeMesh->Draw();
 }
 
 void HandleGizmoInteraction(GLFWwindow* window) {
@@ -1008,7 +1530,7 @@ void HandleGizmoInteraction(GLFWwindow* window) {
     double xpos, ypos;
     glfwGetCursorPos(window, &xpos, &ypos);
     glm::vec3 ray_origin = camera.Position;
-    glm::vec3 ray_direction = ScreenToWorldRay(static_cast<float>(xpos), static_cast<float>(ypos), camera.GetViewMatrix(), glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f));
+    glm::vec3 ray_direction = ScreenToWorldRay(static_cast<float>(xpos), static_cast<float>(ypos), camera.GetViewMatrix(), GetProjectionMatrix());
 
     switch (currentMode) {
     case TRANSLATE:
@@ -1082,8 +1604,7 @@ void RenderObjectSettings() {
         ImGui::Text("\n");
         ImGui::Text("Texture Settings");
 
-        // Texture selection
-        static char texturePath[128] = "Source/textures/texture1.jpg";
+        // Texture selection; the asset browser fills the path in too
         if (ImGui::Button("Browse")) {
             const char* filePath = tinyfd_openFileDialog("Select Texture", "", 0, NULL, NULL, 0);
             if (filePath) {
@@ -1097,7 +1618,9 @@ void RenderObjectSettings() {
         
 
         if (ImGui::Button("Load Texture")) {
+            unsigned int previousTexture = obj.textureID;
             obj.textureID = LoadTexture(texturePath);
+            ReleaseTextureIfUnused(previousTexture);
             Log("Loaded texture: " + std::string(texturePath));
         }
     }
@@ -1107,35 +1630,42 @@ void RenderObjectSettings() {
 }
 
 void SetupFrameBuffer() {
-    // Generate framebuffer
-    glGenFramebuffers(1, &fbo);
-    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    // Generate framebuffer; replacing the handles releases the previous attachments when resizing
+    fbo = GpuHandle::Create(gpuResources, GPU_FRAMEBUFFER, "Viewport framebuffer");
+    glState.BindFramebuffer(GL_FRAMEBUFFER, fbo.ID());
 
     // Create a texture for color attachment
-    glGenTextures(1, &fboTexture);
-    glBindTexture(GL_TEXTURE_2D, fboTexture);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, SCR_WIDTH, SCR_HEIGHT, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
+    fboTexture = GpuHandle::Create(gpuResources, GPU_TEXTURE, "Viewport color");
+    glState.BindTexture(GL_TEXTURE_2D, fboTexture.ID());
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, framebufferWidth, framebufferHeight, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
+    fboTexture.SetBytes(EstimateTextureBytes(framebufferWidth, framebufferHeight, 4, false));
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, fboTexture, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, fboTexture.ID(), 0);
 
-    // Create a renderbuffer for depth and stencil attachment
-    glGenRenderbuffers(1, &rbo);
-    glBindRenderbuffer(GL_RENDERBUFFER, rbo);
-    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, SCR_WIDTH, SCR_HEIGHT);
-    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, rbo);
+    // Create a renderbuffer for depth and stencil attachment; float depth keeps reverse-Z precise out to infinity
+    rbo = GpuHandle::Create(gpuResources, GPU_RENDERBUFFER, "Viewport depth/stencil");
+    glBindRenderbuffer(GL_RENDERBUFFER, rbo.ID());
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH32F_STENCIL8, framebufferWidth, framebufferHeight);
+    rbo.SetBytes(EstimateTextureBytes(framebufferWidth, framebufferHeight, 8, false));
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, rbo.ID());
 
     // Check if the framebuffer is complete
     if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
         std::cout << "ERROR::FRAMEBUFFER:: Framebuffer is not complete!" << std::endl;
     }
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glState.BindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
 unsigned int LoadTexture(const char* path) {
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
-    glBindTexture(GL_TEXTURE_2D, textureID);
+    // Reuse the texture if this file was already loaded
+    auto existing = textureLibrary.find(path);
+    if (existing != textureLibrary.end()) {
+        return existing->second.ID();
+    }
+
+    GpuHandle texture = GpuHandle::Create(gpuResources, GPU_TEXTURE, std::string("Texture ") + path);
+    glState.BindTexture(GL_TEXTURE_2D, texture.ID());
 
     // Set texture wrapping/filtering options
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
@@ -1151,96 +1681,3044 @@ unsigned int LoadTexture(const char* path) {
         GLenum format = (nrChannels == 4) ? GL_RGBA : GL_RGB;
         glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
         glGenerateMipmap(GL_TEXTURE_2D);
+        texture.SetBytes(EstimateTextureBytes(width, height, 4, true));
     }
     else {
         std::cout << "Failed to load texture: " << path << std::endl;
+        return 0; // The handle releases the empty texture; the object falls back to its color
     }
     stbi_image_free(data);
 
+    unsigned int textureID = texture.ID();
+    textureLibrary[path] = std::move(texture);
     return textureID;
 }
 
-void SetupSphere() {
-    const int latitudeBands = 30;
-    const int longitudeBands = 30;
-    const float radius = 0.5f;
-    std::vector<float> vertices;
-    std::vector<unsigned int> indices;
+// Free a library texture once no object references it anymore
+void ReleaseTextureIfUnused(unsigned int textureID) {
+    if (textureID == 0) {
+        return;
+    }
+    for (const auto& obj : objects) {
+        if (obj.textureID == textureID) {
+            return;
+        }
+    }
+    for (auto it = textureLibrary.begin(); it != textureLibrary.end(); ++it) {
+        if (it->second.ID() == textureID) {
+            textureLibrary.erase(it);
+            return;
+        }
+    }
+}
+
+void DrawSmallCube(Shader& shader, const glm::vec3& position, const glm::vec4& color) {
+    shader.setVec4("color", color);
+
+    glm::mat4 model = glm::mat4(1.0f);
+    model = glm::translate(model, position);
+    model = glm::scale(model, glm::vec3(0.1f)); // Scale down for a small cube
+    shader.setMat4("model", model);
+
+    glState.BindVertexArray(cubeMesh->VAO.ID());
+    cubeMesh->Draw();
+}
+
+glm::mat4 GetProjectionMatrix() {
+    return viewProjection.GetMatrix(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT);
+}
+
+void SetDepthMode(Depth_Mode mode) {
+    if (mode == DEPTH_REVERSE_Z && !reverseZSupported) {
+        Log("Reverse-Z requires glClipControl (GL 4.5 or ARB_clip_control)");
+        mode = DEPTH_STANDARD;
+    }
+    viewProjection.Mode = mode;
+    viewProjection.ApplyDepthState();
+}
+
+// Render the viewport settings window for depth and clipping options
+void RenderViewportSettings() {
+    ImGui::Begin("Viewport");
+
+    bool reverseZ = viewProjection.Mode == DEPTH_REVERSE_Z;
+    if (!reverseZSupported) {
+        ImGui::BeginDisabled();
+    }
+    if (ImGui::Checkbox("Reverse-Z (infinite far plane)", &reverseZ)) {
+        SetDepthMode(reverseZ ? DEPTH_REVERSE_Z : DEPTH_STANDARD);
+        Log(std::string("Depth mode: ") + (reverseZ ? "reverse-Z" : "standard"));
+    }
+    if (!reverseZSupported) {
+        ImGui::EndDisabled();
+    }
+
+    ImGui::DragFloat("Near plane", &viewProjection.Near, 0.01f, 0.001f, 10.0f);
+    if (viewProjection.Mode == DEPTH_STANDARD) {
+        ImGui::DragFloat("Far plane", &viewProjection.Far, 1.0f, viewProjection.Near + 0.1f, 100000.0f);
+    }
+
+    if (ImGui::Checkbox("Render only when something changes", &redraw.OnDemand)) {
+        Log(std::string("Rendering: ") + (redraw.OnDemand ? "on demand" : "continuous"));
+    }
+
+    int framesInFlight = static_cast<int>(framePacer.MaxFramesInFlight);
+    if (ImGui::SliderInt("Max frames in flight", &framesInFlight, 0, 4, framesInFlight == 0 ? "Driver default" : "%d")) {
+        framePacer.MaxFramesInFlight = static_cast<unsigned int>(framesInFlight);
+        framePacer.ResetLatency();
+    }
+    bool rawSupported = glfwRawMouseMotionSupported() == GLFW_TRUE;
+    if (!rawSupported) {
+        ImGui::BeginDisabled();
+    }
+    ImGui::Checkbox("Raw mouse motion for mouse look", &rawMouseMotion);
+    if (!rawSupported) {
+        ImGui::EndDisabled();
+    }
+
+    ImGui::Checkbox("Box/lasso select visible objects only", &selectVisibleOnly);
+
+    ImGui_ImplOpenGL3_StreamingStats streaming = ImGui_ImplOpenGL3_GetStreamingStats();
+    if (!streaming.Available) {
+        ImGui::BeginDisabled();
+    }
+    if (ImGui::Checkbox("Stream UI geometry (persistent mapped rings)", &streaming.Enabled)) {
+        ImGui_ImplOpenGL3_SetStreaming(streaming.Enabled);
+        Log(std::string("ImGui uploads: ") + (streaming.Enabled ? "persistent mapped rings" : "glBufferData"));
+    }
+    if (!streaming.Available) {
+        ImGui::EndDisabled();
+    }
+
+    ImGui::End();
+}
+
+// Render frame statistics, including how many tracked GL calls the state cache let through
+void RenderStatistics() {
+    ImGui::Begin("Statistics");
+
+    ImGui::Text("Frame time: %.2f ms (%.0f FPS)", deltaTime * 1000.0f, deltaTime > 0.0f ? 1.0f / deltaTime : 0.0f);
+    const RedrawScheduler::Stats& redrawStats = redraw.GetStats();
+    ImGui::Text("Rendering %s: %.1f frames/s, CPU %.1f%%", redraw.OnDemand ? "on demand" : "continuously", redrawStats.FramesPerSecond, redrawStats.CpuPercent);
+    if (redrawStats.IdleCpuPercent >= 0.0) {
+        ImGui::Text("Idle CPU: %.2f%% of one core", redrawStats.IdleCpuPercent);
+    }
+    else {
+        ImGui::Text("Idle CPU: not measured yet (leave the window untouched for a second)");
+    }
+    std::string reasons;
+    for (int i = 0; i < REDRAW_REASON_COUNT; ++i) {
+        if (redrawStats.LastReasons & (1u << i)) {
+            reasons += std::string(reasons.empty() ? "" : ", ") + RedrawReasonName(static_cast<Redraw_Reason>(i));
+        }
+    }
+    ImGui::Text("Frames: %llu, wakeups: %llu, last redraw: %s", redrawStats.Frames, redrawStats.Wakeups, reasons.empty() ? "-" : reasons.c_str());
+    const FramePacer::Stats& pacing = framePacer.GetStats();
+    ImGui::Text("Frames in flight: %u, GPU wait: %.2f ms", pacing.FramesInFlight, pacing.WaitMs);
+    ImGui::Text("Input to swap: %.2f ms (avg %.2f, max %.2f over %llu frames)", pacing.LatencyMs, pacing.AverageLatencyMs, pacing.MaxLatencyMs, pacing.InputFrames);
+    ImGui::Separator();
+    const GLStateCache::Counters& calls = glState.LastFrame;
+    unsigned int total = calls.Issued + calls.Skipped;
+    ImGui::Text("GL state calls issued: %u", calls.Issued);
+    ImGui::Text("GL state calls skipped: %u (%.0f%%)", calls.Skipped, total > 0 ? 100.0f * calls.Skipped / total : 0.0f);
+    ImGui::Text("Objects: %zu, shared meshes: %zu (%u uploads, %u reuses)", objects.size(), meshPool.GetMeshCount(), meshPool.Uploads, meshPool.Hits);
+    size_t scatteredInstances = 0;
+    for (const auto& batch : scatterBatches) {
+        scatteredInstances += batch->GetCount();
+    }
+    ImGui::Text("Scattered instances: %zu in %zu instanced draws", scatteredInstances, scatterBatches.size());
+    ImGui::Text("Region select: %zu of %zu objects, mask %.2f ms, projection %.2f ms, ID pass %.2f ms",
+        regionStats.Selected, regionStats.Tested, regionStats.MaskMs, regionStats.ProjectMs, regionIdPassMs);
+    ImGui::Text("Snap index: %zu points in %zu cells of %.3g, last sync updated %zu objects in %.2f ms (%zu rebuilds)", snapIndex.Stats.Points,
+        snapIndex.Stats.Cells, snapIndex.Stats.CellSize, snapIndex.Stats.ObjectsUpdated, snapIndex.Stats.SyncMs, snapIndex.Stats.Rebuilds);
+    ImGui::Text("Snap queries: %zu, last %.2f us, slowest this drag %.2f us", snapIndex.Stats.Queries, snapIndex.Stats.LastQueryUs, snapIndex.Stats.MaxQueryUs);
+    ImGui::Separator();
+    ImGui_ImplOpenGL3_StreamingStats streaming = ImGui_ImplOpenGL3_GetStreamingStats();
+    ImGui::Text("ImGui draw: %.3f ms, %d vertices, %d indices", imguiRenderMs, imguiVertices, imguiIndices);
+    ImGui::Text("ImGui uploads: %s, %.1f KB per frame", streaming.Enabled ? "streaming rings" : "glBufferData", streaming.UploadBytes / 1024.0);
+    if (streaming.Enabled) {
+        ImGui::Text("  Rings: %.1f KB, %u GPU waits, %u resizes", streaming.RingBytes / 1024.0, streaming.Waits, streaming.Resizes);
+    }
+    ImGui::Separator();
+    RenderGpuMemory();
+    ImGui::Separator();
+    RenderGLDebugStatistics();
+
+    ImGui::End();
+}
 
-    for (int lat = 0; lat <= latitudeBands; ++lat) {
-        float theta = lat * glm::pi<float>() / latitudeBands;
-        float sinTheta = sin(theta);
-        float cosTheta = cos(theta);
+void SetupGizmoLines() {
+    gizmoLineVAO = GpuHandle::Create(gpuResources, GPU_VERTEX_ARRAY, "Gizmo lines");
+    gizmoLineVBO = GpuHandle::Create(gpuResources, GPU_BUFFER, "Gizmo lines");
+    glState.BindVertexArray(gizmoLineVAO.ID());
 
-        for (int lon = 0; lon <= longitudeBands; ++lon) {
-            float phi = lon * 2 * glm::pi<float>() / longitudeBands;
-            float sinPhi = sin(phi);
-            float cosPhi = cos(phi);
+    glState.BindBuffer(GL_ARRAY_BUFFER, gizmoLineVBO.ID());
+    glBufferData(GL_ARRAY_BUFFER, GIZMO_LINE_CAPACITY * sizeof(glm::vec3), NULL, GL_DYNAMIC_DRAW);
+    gizmoLineVBO.SetBytes(GIZMO_LINE_CAPACITY * sizeof(glm::vec3));
 
-            float x = cosPhi * sinTheta;
-            float y = cosTheta;
-            float z = sinPhi * sinTheta;
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
+    glEnableVertexAttribArray(0);
+
+    glState.BindVertexArray(0);
+}
 
-            float u = 1.0f - (float)lon / longitudeBands;
-            float v = 1.0f - (float)lat / latitudeBands;
+// Render live GPU memory per resource category, with the individual handles listed below
+void RenderGpuMemory() {
+    ImGui::Text("GPU memory: %.2f MB", gpuResources.GetTotalBytes() / (1024.0 * 1024.0));
+    for (int i = 0; i < GPU_RESOURCE_TYPE_COUNT; ++i) {
+        const GpuResourceRegistry::Totals& totals = gpuResources.GetTotals(static_cast<Gpu_Resource_Type>(i));
+        ImGui::Text("  %-14s %4zu  %8.2f MB", GpuResourceTypeName(static_cast<Gpu_Resource_Type>(i)), totals.Count, totals.Bytes / (1024.0 * 1024.0));
+    }
 
-            vertices.push_back(radius * x);
-            vertices.push_back(radius * y);
-            vertices.push_back(radius * z);
-            vertices.push_back(u);
-            vertices.push_back(v);
+    if (ImGui::TreeNode("Live GPU resources")) {
+        for (const auto& entry : gpuResources.GetLiveEntries()) {
+            ImGui::Text("%s #%u  %s  %.1f KB", GpuResourceTypeName(entry.Type), entry.ID, entry.Owner.c_str(), entry.Bytes / 1024.0);
         }
+        ImGui::TreePop();
     }
+}
 
-    for (int lat = 0; lat < latitudeBands; ++lat) {
-        for (int lon = 0; lon < longitudeBands; ++lon) {
-            int first = (lat * (longitudeBands + 1)) + lon;
-            int second = first + longitudeBands + 1;
+// Release every GL object the app owns, then report anything still registered as leaked
+void ReleaseGpuResources() {
+    texture1.Reset();
+    gridVAO.Reset();
+    gridVBO.Reset();
+    gizmoLineVAO.Reset();
+    gizmoLineVBO.Reset();
+    scatterBatches.clear();
+    framePacer.Clear();
+    idBuffer.Release();
+    snapIndex.Clear(); // holds pointers to mesh positions
+    pathTracer.Stop();
+    tracedScene.reset();
+    tracedMeshes.clear();
+    tracerFramebuffer.Reset();
+    tracerTexture.Reset();
+    occlusionTexture.Reset();
+    occlusionBuffer.Reset();
+    bakedOcclusion.clear();
+    assetViews.clear();
+    assetLibrary.reset();
+    thumbnailRenderer.Release();
+    objectModifiers.clear();
+    booleanResults.clear();
+    textureWorkers.Clear();
+    pendingImportTextures.clear();
+    importedScenes.clear();
+    editableMeshes.clear();
+    meshPool.Clear();
+    particles.Release();
+    tessellation.Release();
+    fbo.Reset();
+    fboTexture.Reset();
+    rbo.Reset();
+    shaderPrograms.clear();
+    textureLibrary.clear();
+
+    for (const auto& entry : gpuResources.GetLiveEntries()) {
+        Log(std::string("LEAK: ") + GpuResourceTypeName(entry.Type) + " #" + std::to_string(entry.ID) +
+            " owned by '" + entry.Owner + "' (" + std::to_string(entry.Bytes) + " bytes) was never released");
+    }
+}
 
-            indices.push_back(first);
-            indices.push_back(second);
-            indices.push_back(first + 1);
+// Render GL debug message counters per category and the deduplicated message list
+void RenderGLDebugStatistics() {
+    ImGui::Text("GL debug output: %s", glDebug.IsAvailable() ? "KHR_debug" : "glGetError polling");
+    for (int i = 0; i < GL_DEBUG_CATEGORY_COUNT; ++i) {
+        ImGui::Text("  %-18s %4u this frame  %6u total", GLDebugCategoryName(static_cast<GL_Debug_Category>(i)),
+            glDebug.LastFrameCounts[i], glDebug.TotalCounts[i]);
+    }
 
-            indices.push_back(second);
-            indices.push_back(second + 1);
-            indices.push_back(first + 1);
+    if (ImGui::TreeNode("GL debug messages")) {
+        for (const auto& message : glDebug.GetMessages()) {
+            ImGui::TextWrapped("[%s] x%u  %s", GLDebugCategoryName(message.Category), message.Count, message.Text.c_str());
         }
+        ImGui::TreePop();
     }
+}
+
+// Add an object using the pooled mesh for the given primitive parameters
+void AddPrimitive(const PrimitiveDesc& desc, const glm::vec3& position) {
+    objects.push_back({ position, glm::vec3(1.0f), glm::vec4(1.0f), meshPool.Acquire(desc) });
+    Log(std::string("Added a new ") + PrimitiveTypeName(desc.Type) + " at position " + glm::to_string(position));
+}
 
-    sphereVertexCount = indices.size();
+// Render the parametric primitive controls in the object list
+void RenderAddPrimitive() {
+    static int type = PRIMITIVE_CYLINDER;
+    static int segments = 32;
+    static int rings = 16;
+    static int subdivisions = 2;
+    static float minorRadius = 0.15f;
+    static int count = 1;
+
+    if (!ImGui::CollapsingHeader("Add Primitive")) {
+        return;
+    }
 
-    unsigned int VBO, EBO;
-    glGenVertexArrays(1, &sphereVAO);
-    glGenBuffers(1, &VBO);
-    glGenBuffers(1, &EBO);
+    const char* names[PRIMITIVE_TYPE_COUNT];
+    for (int i = 0; i < PRIMITIVE_TYPE_COUNT; ++i) {
+        names[i] = PrimitiveTypeName(static_cast<Primitive_Type>(i));
+    }
+    ImGui::Combo("Type", &type, names, PRIMITIVE_TYPE_COUNT);
 
-    glBindVertexArray(sphereVAO);
+    PrimitiveDesc desc;
+    switch (type) {
+    case PRIMITIVE_CUBE:
+        desc = PrimitiveDesc::Cube();
+        break;
+    case PRIMITIVE_UV_SPHERE:
+        ImGui::SliderInt("Segments", &segments, 3, 128);
+        ImGui::SliderInt("Rings", &rings, 2, 128);
+        desc = PrimitiveDesc::UVSphere(segments, rings);
+        break;
+    case PRIMITIVE_ICO_SPHERE:
+        ImGui::SliderInt("Subdivisions", &subdivisions, 0, 6);
+        desc = PrimitiveDesc::IcoSphere(subdivisions);
+        break;
+    case PRIMITIVE_CYLINDER:
+        ImGui::SliderInt("Segments", &segments, 3, 128);
+        desc = PrimitiveDesc::Cylinder(segments);
+        break;
+    case PRIMITIVE_CONE:
+        ImGui::SliderInt("Segments", &segments, 3, 128);
+        desc = PrimitiveDesc::Cone(segments);
+        break;
+    case PRIMITIVE_TORUS:
+        ImGui::SliderInt("Segments", &segments, 3, 128);
+        ImGui::SliderInt("Rings", &rings, 3, 64);
+        ImGui::SliderFloat("Tube radius", &minorRadius, 0.01f, 0.25f);
+        desc = PrimitiveDesc::Torus(segments, rings, minorRadius);
+        break;
+    case PRIMITIVE_PLANE:
+        ImGui::SliderInt("Subdivisions", &subdivisions, 1, 64);
+        desc = PrimitiveDesc::Plane(subdivisions);
+        break;
+    }
 
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+    ImGui::InputInt("Count", &count);
+    count = glm::clamp(count, 1, 100000);
+    if (ImGui::Button("Add")) {
+        // Lay copies out on a square grid; they all share one pooled mesh
+        int side = static_cast<int>(std::ceil(std::sqrt(static_cast<float>(count))));
+        const Mesh* mesh = meshPool.Acquire(desc);
+        for (int i = 0; i < count; ++i) {
+            glm::vec3 position(1.5f * (i % side), 0.5f, -1.5f * (i / side));
+            objects.push_back({ position, glm::vec3(1.0f), glm::vec4(1.0f), mesh });
+        }
+        Log("Added " + std::to_string(count) + " x " + PrimitiveTypeName(desc.Type) + " sharing one mesh (" +
+            std::to_string(mesh->VertexCount) + " vertices, " + std::to_string(mesh->IndexCount / 3) + " triangles)");
+    }
+}
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+// Float offset of an animated component of an object, relative to the start of the objects array
+size_t ObjectChannelTarget(size_t objectIndex, size_t component) {
+    size_t member = component < 3 ? offsetof(Object, position) / sizeof(float) + component
+                                  : offsetof(Object, scale) / sizeof(float) + component - 3;
+    return objectIndex * OBJECT_FLOATS + member;
+}
 
-    // Position attribute
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    // Texture coordinate attribute
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
+// Advance the timeline and write every animated channel straight into the objects array
+void UpdateAnimation() {
+    timeline.Advance(deltaTime);
+    if (timeline.GetChannelCount() == 0 || objects.empty() || timeline.Time == animationEvaluatedTime) {
+        return;
+    }
 
-    glBindVertexArray(0);
+    auto start = std::chrono::high_resolution_clock::now();
+    timeline.Evaluate(timeline.Time, reinterpret_cast<float*>(objects.data()), objects.size() * OBJECT_FLOATS, &jobs);
+    animationEvaluateMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    animationEvaluatedTime = timeline.Time;
 }
 
-void DrawSmallCube(Shader& shader, const glm::vec3& position, const glm::vec4& color) {
-    shader.setVec4("color", color);
+// Render the timeline window with playback, keying and benchmark controls
+void RenderTimeline() {
+    ImGui::Begin("Timeline");
 
-    glm::mat4 model = glm::mat4(1.0f);
-    model = glm::translate(model, position);
-    model = glm::scale(model, glm::vec3(0.1f)); // Scale down for a small cube
-    shader.setMat4("model", model);
+    if (ImGui::Button(timeline.Playing ? "Pause" : "Play")) {
+        timeline.Playing = !timeline.Playing;
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Stop")) {
+        timeline.Playing = false;
+        timeline.Time = 0.0f;
+    }
+    ImGui::SameLine();
+    ImGui::Checkbox("Loop", &timeline.Loop);
+
+    ImGui::SliderFloat("Time", &timeline.Time, 0.0f, timeline.Duration, "%.2f s");
+    ImGui::DragFloat("Duration", &timeline.Duration, 0.1f, 0.1f, 600.0f, "%.1f s");
+
+    int mode = keyMode;
+    if (ImGui::Combo("Interpolation", &mode, "Linear\0Bezier\0")) {
+        keyMode = static_cast<Interpolation_Mode>(mode);
+    }
+
+    if (ImGui::Button("Key Selected")) {
+        KeySelectedObject();
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Animate All")) {
+        AnimateAllObjects();
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Clear Keys")) {
+        timeline.Clear();
+        animationEvaluatedTime = -1.0f;
+        Log("Cleared all keyframes");
+    }
+
+    ImGui::Separator();
+    ImGui::Text("Channels: %zu, keys: %zu", timeline.GetChannelCount(), timeline.GetKeyCount());
+    ImGui::Text("Evaluate: %.3f ms (%.0f channels/ms on %u threads)", animationEvaluateMs,
+        animationEvaluateMs > 0.0f ? timeline.GetChannelCount() / animationEvaluateMs : 0.0f, jobs.GetThreadCount());
+    if (ImGui::Button("Benchmark")) {
+        BenchmarkTimeline();
+    }
+
+    ImGui::End();
+}
+
+// Key the position and scale of the selected object at the current time
+void KeySelectedObject() {
+    if (selectedObject < 0 || selectedObject >= static_cast<int>(objects.size())) {
+        Log("Select an object to key");
+        return;
+    }
+
+    const float* values = reinterpret_cast<const float*>(objects.data());
+    for (size_t component = 0; component < OBJECT_ANIMATED_COMPONENTS; ++component) {
+        size_t target = ObjectChannelTarget(selectedObject, component);
+        timeline.SetKey(timeline.GetOrAddChannel(target), timeline.Time, values[target], keyMode);
+    }
+    animationEvaluatedTime = -1.0f;
+    Log("Keyed object " + std::to_string(selectedObject) + " at " + std::to_string(timeline.Time) + " s (" + InterpolationModeName(keyMode) + ")");
+}
 
-    glBindVertexArray(cubeVAO);
-    glDrawArrays(GL_TRIANGLES, 0, 36);
-    glBindVertexArray(0);
-}
\ No newline at end of file
+// Give every object a looping bounce with a per-object phase, to preview motion on large scenes
+void AnimateAllObjects() {
+    float duration = timeline.Duration;
+    for (size_t i = 0; i < objects.size(); ++i) {
+        const Object& obj = objects[i];
+        float phase = 0.5f + 0.5f * std::sin(static_cast<float>(i) * 0.37f);
+        float peak = duration * (0.25f + 0.5f * phase);
+
+        int height = timeline.GetOrAddChannel(ObjectChannelTarget(i, 1));
+        timeline.SetKey(height, 0.0f, obj.position.y, keyMode);
+        timeline.SetKey(height, peak, obj.position.y + 1.0f + phase, keyMode);
+        timeline.SetKey(height, duration, obj.position.y, keyMode);
+
+        for (size_t axis = 0; axis < 3; ++axis) {
+            int scale = timeline.GetOrAddChannel(ObjectChannelTarget(i, 3 + axis));
+            float base = obj.scale[static_cast<int>(axis)];
+            float squash = axis == 1 ? 1.25f : 0.85f;
+            timeline.SetKey(scale, 0.0f, base, keyMode);
+            timeline.SetKey(scale, peak, base * squash, keyMode);
+            timeline.SetKey(scale, duration, base, keyMode);
+        }
+    }
+    timeline.Playing = true;
+    animationEvaluatedTime = -1.0f;
+    Log("Animated " + std::to_string(objects.size()) + " objects: " + std::to_string(timeline.GetChannelCount()) + " channels, " +
+        std::to_string(timeline.GetKeyCount()) + " keys");
+}
+
+// Measure channel throughput of the scalar reference, the batched pass and the batched pass on all threads
+void BenchmarkTimeline() {
+    const size_t channelCount = 1 << 20;
+    const int keysPerChannel = 8;
+    const int frames = 30;
+
+    Timeline bench;
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> value(-10.0f, 10.0f);
+    for (size_t c = 0; c < channelCount; ++c) {
+        int channel = bench.GetOrAddChannel(c);
+        for (int k = 0; k < keysPerChannel; ++k) {
+            bench.SetKey(channel, k * 0.5f, value(rng), (k + c) % 2 ? INTERPOLATION_BEZIER : INTERPOLATION_LINEAR);
+        }
+    }
+
+    std::vector<float> reference(channelCount);
+    std::vector<float> output(channelCount);
+    auto measure = [&](auto evaluate) {
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int frame = 0; frame < frames; ++frame) {
+            evaluate(frame / 60.0f);
+        }
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count() / frames;
+        return channelCount / ms;
+    };
+
+    double scalar = measure([&](float t) { bench.EvaluateScalar(t, reference.data(), channelCount); });
+    double batched = measure([&](float t) { bench.Evaluate(t, output.data(), channelCount); });
+    double threaded = measure([&](float t) { bench.Evaluate(t, output.data(), channelCount, &jobs); });
+
+    // both paths end on the same time, so the outputs must agree
+    float maxError = 0.0f;
+    for (size_t c = 0; c < channelCount; ++c) {
+        maxError = std::max(maxError, std::abs(output[c] - reference[c]));
+    }
+
+    Log("Timeline benchmark, " + std::to_string(channelCount) + " channels x " + std::to_string(keysPerChannel) + " keys:");
+    Log("  scalar:   " + std::to_string(static_cast<long long>(scalar)) + " channels/ms");
+    Log("  batched:  " + std::to_string(static_cast<long long>(batched)) + " channels/ms");
+    Log("  threaded: " + std::to_string(static_cast<long long>(threaded)) + " channels/ms (" + std::to_string(jobs.GetThreadCount()) + " threads)");
+    Log("  max difference to scalar: " + std::to_string(maxError));
+}
+
+// Render the particle emitter controls
+void RenderParticleSettings() {
+    ImGui::Begin("Particles");
+
+    if (!particles.IsReady()) {
+        ImGui::TextColored(ImVec4(1.0f, 0.7f, 0.2f, 1.0f), "The particle shaders failed to build; see the console");
+    }
+    ImGui::BeginDisabled(!particles.IsReady());
+    if (ImGui::Checkbox("Enabled", &particlesEnabled) && particlesEnabled && particles.GetCapacity() == 0) {
+        particles.SetCapacity(particleCapacity);
+        Log("Allocated " + std::to_string(particleCapacity) + " GPU particles (" + ParticleBackendName(particles.Backend) + ")");
+    }
+    ImGui::EndDisabled();
+
+    int backend = particles.Backend;
+    ImGui::BeginDisabled(!particles.IsComputeAvailable());
+    if (ImGui::Combo("Update", &backend, "Transform feedback\0Compute shader\0")) {
+        particles.Backend = static_cast<Particle_Backend>(backend);
+    }
+    ImGui::EndDisabled();
+
+    ImGui::SliderInt("Capacity", &particleCapacity, 1000, 4000000);
+    ImGui::SameLine();
+    if (ImGui::Button("Apply")) {
+        particles.SetCapacity(particleCapacity);
+        Log("Resized particle buffers to " + std::to_string(particleCapacity) + " particles");
+    }
+
+    if (ImGui::Button("Sparks")) {
+        particleEmitter = ParticleEmitter::Sparks();
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Dust")) {
+        particleEmitter = ParticleEmitter::Dust();
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("At Selected") && selectedObject >= 0) {
+        particleEmitter.Position = objects[selectedObject].position;
+    }
+
+    ImGui::DragFloat3("Position", glm::value_ptr(particleEmitter.Position), 0.05f);
+    ImGui::DragFloat("Radius", &particleEmitter.Radius, 0.01f, 0.0f, 50.0f);
+    ImGui::DragFloat3("Direction", glm::value_ptr(particleEmitter.Direction), 0.01f, -1.0f, 1.0f);
+    ImGui::SliderFloat("Spread", &particleEmitter.Spread, 0.0f, 1.0f);
+    ImGui::DragFloat("Speed", &particleEmitter.Speed, 0.05f, 0.0f, 100.0f);
+    ImGui::SliderFloat("Speed jitter", &particleEmitter.SpeedJitter, 0.0f, 1.0f);
+    ImGui::DragFloatRange2("Lifetime", &particleEmitter.Lifetime.x, &particleEmitter.Lifetime.y, 0.01f, 0.05f, 30.0f, "%.2f s");
+    ImGui::DragFloat("Rate", &particleEmitter.Rate, 1000.0f, 0.0f, 10000000.0f, "%.0f /s");
+    ImGui::DragFloat3("Gravity", glm::value_ptr(particleEmitter.Gravity), 0.05f);
+    ImGui::DragFloat("Drag", &particleEmitter.Drag, 0.01f, 0.0f, 20.0f);
+    ImGui::DragFloat("Size", &particleEmitter.Size, 0.001f, 0.001f, 1.0f);
+    ImGui::ColorEdit4("Start color", glm::value_ptr(particleEmitter.ColorStart));
+    ImGui::ColorEdit4("End color", glm::value_ptr(particleEmitter.ColorEnd));
+
+    // a slot is reused after capacity / rate seconds, so longer lifetimes get cut short
+    if (particleEmitter.Rate * particleEmitter.Lifetime.y > particles.GetCapacity()) {
+        ImGui::TextColored(ImVec4(1.0f, 0.7f, 0.2f, 1.0f), "Rate x lifetime exceeds capacity; particles are recycled early");
+    }
+
+    ImGui::Separator();
+    float updateMs = particles.GetLastUpdateMs();
+    ImGui::Text("GPU update: %.3f ms (%.0f particles/ms)", updateMs, updateMs > 0.0f ? particles.GetCapacity() / updateMs : 0.0f);
+    if (ImGui::Button("Benchmark") && particles.GetCapacity() > 0) {
+        BenchmarkParticles();
+    }
+
+    ImGui::End();
+}
+
+// Time a fixed number of update steps on every available backend, waiting for the GPU before and after
+void BenchmarkParticles() {
+    const int steps = 120;
+    Particle_Backend previous = particles.Backend;
+    int backendCount = particles.IsComputeAvailable() ? 2 : 1;
+
+    Log("Particle benchmark, " + std::to_string(particles.GetCapacity()) + " particles x " + std::to_string(steps) + " steps:");
+    for (int i = 0; i < backendCount; ++i) {
+        particles.Backend = static_cast<Particle_Backend>(i);
+        glFinish();
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int step = 0; step < steps; ++step) {
+            particles.Update(particleEmitter, 1.0f / 60.0f);
+        }
+        glFinish();
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        double perMs = static_cast<double>(particles.GetCapacity()) * steps / ms;
+        Log(std::string("  ") + ParticleBackendName(particles.Backend) + ": " + std::to_string(static_cast<long long>(perMs)) + " particles/ms");
+    }
+    particles.Backend = previous;
+}
+
+// Apply every automation batch that arrived since the last frame
+void ProcessAutomation() {
+    unsigned long long before = automationCommandsApplied;
+    automationServer.Poll(HandleAutomationBatch);
+    automationCommandsLastFrame = static_cast<unsigned int>(automationCommandsApplied - before);
+}
+
+// Validate a whole batch first, so a bad command rejects it before anything in the scene changes, then apply it
+void HandleAutomationBatch(const std::vector<uint8_t>& request, MessageWriter& reply) {
+    struct Command {
+        uint32_t id;
+        const uint8_t* payload;
+        uint32_t size;
+    };
+
+    MessageReader reader(request.data(), request.size());
+    std::vector<Command> commands;
+    Automation_Status status = AUTOMATION_OK;
+    size_t objectCount = objects.size();
+
+    uint32_t commandCount = 0;
+    if (!reader.ReadU32(commandCount)) {
+        status = AUTOMATION_ERROR_MALFORMED;
+    }
+    for (uint32_t i = 0; i < commandCount && status == AUTOMATION_OK; ++i) {
+        Command command;
+        if (!reader.ReadU32(command.id) || !reader.ReadU32(command.size) || !reader.ReadBytes(command.payload, command.size)) {
+            status = AUTOMATION_ERROR_MALFORMED;
+            break;
+        }
+        status = ValidateAutomationCommand(command.id, MessageReader(command.payload, command.size), objectCount);
+        commands.push_back(command);
+    }
+    if (status == AUTOMATION_OK && reader.Remaining() != 0) {
+        status = AUTOMATION_ERROR_MALFORMED;
+    }
+
+    reply.WriteU32(status);
+    if (status != AUTOMATION_OK) {
+        reply.WriteU32(0);
+        Log(std::string("Automation batch rejected: ") + AutomationStatusName(status) + " in command " + std::to_string(commands.size()));
+        return;
+    }
+
+    reply.WriteU32(static_cast<uint32_t>(commands.size()));
+    for (const Command& command : commands) {
+        reply.WriteU32(command.id);
+        reply.WriteU32(AUTOMATION_OK);
+        size_t size = reply.BeginSize();
+        ApplyAutomationCommand(command.id, MessageReader(command.payload, command.size), reply);
+        reply.EndSize(size);
+    }
+    automationCommandsApplied += commands.size();
+}
+
+// Check payload size and object indices of one command; objectCount grows with objects created earlier in the batch
+Automation_Status ValidateAutomationCommand(uint32_t command, MessageReader reader, size_t& objectCount) {
+    uint32_t count = 0;
+    switch (command) {
+    case AUTOMATION_CREATE_OBJECTS: {
+        uint32_t type = 0;
+        if (!reader.ReadU32(type) || !reader.ReadU32(count) || reader.Remaining() != count * 40ull) {
+            return AUTOMATION_ERROR_MALFORMED;
+        }
+        if (type >= PRIMITIVE_TYPE_COUNT) {
+            return AUTOMATION_ERROR_OUT_OF_RANGE;
+        }
+        objectCount += count;
+        return AUTOMATION_OK;
+    }
+    case AUTOMATION_SET_TRANSFORMS: {
+        if (!reader.ReadU32(count) || reader.Remaining() != count * 28ull) {
+            return AUTOMATION_ERROR_MALFORMED;
+        }
+        for (uint32_t i = 0; i < count; ++i) {
+            uint32_t index = 0;
+            const uint8_t* transform;
+            reader.ReadU32(index);
+            reader.ReadBytes(transform, 6 * sizeof(float));
+            if (index >= objectCount) {
+                return AUTOMATION_ERROR_OUT_OF_RANGE;
+            }
+        }
+        return AUTOMATION_OK;
+    }
+    case AUTOMATION_GET_TRANSFORMS: {
+        uint32_t first = 0;
+        if (!reader.ReadU32(first) || !reader.ReadU32(count) || reader.Remaining() != 0) {
+            return AUTOMATION_ERROR_MALFORMED;
+        }
+        return static_cast<uint64_t>(first) + count <= objectCount ? AUTOMATION_OK : AUTOMATION_ERROR_OUT_OF_RANGE;
+    }
+    case AUTOMATION_PICK:
+        return reader.Remaining() == 2 * sizeof(float) ? AUTOMATION_OK : AUTOMATION_ERROR_MALFORMED;
+    case AUTOMATION_GET_STATS:
+        return reader.Remaining() == 0 ? AUTOMATION_OK : AUTOMATION_ERROR_MALFORMED;
+    case AUTOMATION_SELECT: {
+        int32_t index = 0;
+        if (!reader.ReadI32(index) || reader.Remaining() != 0) {
+            return AUTOMATION_ERROR_MALFORMED;
+        }
+        return index >= -1 && index < static_cast<int64_t>(objectCount) ? AUTOMATION_OK : AUTOMATION_ERROR_OUT_OF_RANGE;
+    }
+    default:
+        return AUTOMATION_ERROR_UNKNOWN_COMMAND;
+    }
+}
+
+// Apply one validated command and write its result payload
+void ApplyAutomationCommand(uint32_t command, MessageReader reader, MessageWriter& reply) {
+    uint32_t count = 0;
+    switch (command) {
+    case AUTOMATION_CREATE_OBJECTS: {
+        uint32_t type = 0;
+        reader.ReadU32(type);
+        reader.ReadU32(count);
+        const Mesh* mesh = meshPool.Acquire(PrimitiveDesc::Default(static_cast<Primitive_Type>(type)));
+        uint32_t first = static_cast<uint32_t>(objects.size());
+        objects.reserve(objects.size() + count);
+        for (uint32_t i = 0; i < count; ++i) {
+            Object obj = { glm::vec3(0.0f), glm::vec3(1.0f), glm::vec4(1.0f), mesh, 0 };
+            reader.ReadFloats(glm::value_ptr(obj.position), 3);
+            reader.ReadFloats(glm::value_ptr(obj.scale), 3);
+            reader.ReadFloats(glm::value_ptr(obj.color), 4);
+            objects.push_back(obj);
+        }
+        reply.WriteU32(first);
+        reply.WriteU32(count);
+        break;
+    }
+    case AUTOMATION_SET_TRANSFORMS: {
+        // transforms are read straight into the object array
+        reader.ReadU32(count);
+        for (uint32_t i = 0; i < count; ++i) {
+            uint32_t index = 0;
+            reader.ReadU32(index);
+            reader.ReadFloats(glm::value_ptr(objects[index].position), 3);
+            reader.ReadFloats(glm::value_ptr(objects[index].scale), 3);
+        }
+        break;
+    }
+    case AUTOMATION_GET_TRANSFORMS: {
+        uint32_t first = 0;
+        reader.ReadU32(first);
+        reader.ReadU32(count);
+        for (uint32_t i = first; i < first + count; ++i) {
+            reply.WriteFloats(glm::value_ptr(objects[i].position), 3);
+            reply.WriteFloats(glm::value_ptr(objects[i].scale), 3);
+        }
+        break;
+    }
+    case AUTOMATION_PICK: {
+        float x = 0.0f, y = 0.0f;
+        reader.ReadF32(x);
+        reader.ReadF32(y);
+        glm::vec3 ray_direction = ScreenToWorldRay(x, y, camera.GetViewMatrix(), GetProjectionMatrix());
+        int32_t hit = -1;
+        for (size_t i = 0; i < objects.size(); ++i) {
+            if (RayIntersectsObject(camera.Position, ray_direction, objects[i])) {
+                hit = static_cast<int32_t>(i);
+                break;
+            }
+        }
+        reply.WriteI32(hit);
+        break;
+    }
+    case AUTOMATION_GET_STATS:
+        reply.WriteF32(deltaTime * 1000.0f);
+        reply.WriteU32(static_cast<uint32_t>(objects.size()));
+        reply.WriteU32(static_cast<uint32_t>(meshPool.GetMeshCount()));
+        reply.WriteU32(glState.LastFrame.Issued);
+        reply.WriteU32(glState.LastFrame.Skipped);
+        reply.WriteU64(gpuResources.GetTotalBytes());
+        reply.WriteU64(automationCommandsApplied);
+        break;
+    case AUTOMATION_SELECT: {
+        int32_t index = -1;
+        reader.ReadI32(index);
+        SelectObject(index >= 0 && index < static_cast<int32_t>(objects.size()) ? index : -1, false);
+        break;
+    }
+    }
+}
+
+// Render the automation socket controls
+void RenderAutomation() {
+    ImGui::Begin("Automation");
+
+    ImGui::BeginDisabled(automationServer.IsRunning());
+    ImGui::InputText("Socket", automationSocketPath, IM_ARRAYSIZE(automationSocketPath));
+    ImGui::EndDisabled();
+
+    if (!automationServer.IsRunning()) {
+        if (ImGui::Button("Start")) {
+            if (automationServer.Start(automationSocketPath)) {
+                Log(std::string("Automation socket listening on ") + automationSocketPath);
+            }
+            else {
+                Log("Automation socket failed: " + automationServer.GetLastError());
+            }
+        }
+    }
+    else if (ImGui::Button("Stop")) {
+        automationServer.Stop();
+        Log("Automation socket stopped");
+    }
+
+    ImGui::Text("Clients: %u", automationServer.GetClientCount());
+    ImGui::Text("Commands: %u this frame, %llu total", automationCommandsLastFrame, automationCommandsApplied);
+
+    bool benchmarkRunning = automationBenchmarkThread.joinable();
+    ImGui::BeginDisabled(!automationServer.IsRunning() || benchmarkRunning);
+    if (ImGui::Button("Benchmark")) {
+        BenchmarkAutomation();
+    }
+    ImGui::EndDisabled();
+
+    if (benchmarkRunning && automationBenchmarkDone) {
+        automationBenchmarkThread.join();
+        std::lock_guard<std::mutex> lock(automationBenchmarkMutex);
+        Log(automationBenchmarkResult);
+    }
+
+    ImGui::End();
+}
+
+// Stream batches of transform updates through the socket from a client thread and measure commands per second
+void BenchmarkAutomation() {
+    if (objects.empty()) {
+        Log("Add objects before running the automation benchmark");
+        return;
+    }
+
+    const uint32_t batches = 200;
+    const uint32_t commandsPerBatch = 500;
+    const uint32_t transformsPerCommand = 16;
+    uint32_t objectCount = static_cast<uint32_t>(objects.size());
+    std::vector<glm::vec3> positions(objectCount);
+    std::vector<glm::vec3> scales(objectCount);
+    for (uint32_t i = 0; i < objectCount; ++i) {
+        positions[i] = objects[i].position;
+        scales[i] = objects[i].scale;
+    }
+    std::string path = automationSocketPath;
+
+    automationBenchmarkDone = false;
+    automationBenchmarkThread = std::thread([=]() {
+        std::string result;
+        AutomationClient client;
+        if (!client.Connect(path)) {
+            result = "Automation benchmark could not connect to " + path;
+        }
+        else {
+            // Every command rewrites the current transforms, so the benchmark leaves the scene unchanged
+            std::vector<std::vector<uint8_t>> requests(batches);
+            for (uint32_t b = 0; b < batches; ++b) {
+                MessageWriter writer;
+                writer.WriteU32(commandsPerBatch);
+                for (uint32_t c = 0; c < commandsPerBatch; ++c) {
+                    writer.WriteU32(AUTOMATION_SET_TRANSFORMS);
+                    size_t size = writer.BeginSize();
+                    writer.WriteU32(transformsPerCommand);
+                    for (uint32_t t = 0; t < transformsPerCommand; ++t) {
+                        uint32_t index = (b * commandsPerBatch * transformsPerCommand + c * transformsPerCommand + t) % objectCount;
+                        writer.WriteU32(index);
+                        writer.WriteFloats(glm::value_ptr(positions[index]), 3);
+                        writer.WriteFloats(glm::value_ptr(scales[index]), 3);
+                    }
+                    writer.EndSize(size);
+                }
+                requests[b] = std::move(writer.Data);
+            }
+
+            // Pipeline all batches, then collect the replies
+            auto start = std::chrono::high_resolution_clock::now();
+            bool ok = true;
+            for (const std::vector<uint8_t>& request : requests) {
+                ok = ok && client.Send(request);
+            }
+            std::vector<uint8_t> reply;
+            for (uint32_t b = 0; b < batches && ok; ++b) {
+                uint32_t status = AUTOMATION_ERROR_MALFORMED;
+                ok = client.Receive(reply);
+                MessageReader replyReader(reply.data(), reply.size());
+                ok = ok && replyReader.ReadU32(status) && status == AUTOMATION_OK;
+            }
+            double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+            if (!ok) {
+                result = "Automation benchmark failed while waiting for replies";
+            }
+            else {
+                double commands = static_cast<double>(batches) * commandsPerBatch;
+                result = "Automation benchmark: " + std::to_string(batches) + " batches x " + std::to_string(commandsPerBatch) + " commands in " +
+                    std::to_string(seconds * 1000.0) + " ms, " + std::to_string(static_cast<long long>(commands / seconds)) + " commands/s, " +
+                    std::to_string(static_cast<long long>(commands * transformsPerCommand / seconds)) + " transforms/s";
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(automationBenchmarkMutex);
+            automationBenchmarkResult = result;
+            automationBenchmarkDone = true;
+        }
+        WakeMainLoop();
+    });
+}
+
+// Give scripts typed views over the object array and the object creation and selection hooks
+void BindScripting() {
+    ScriptScene scene;
+    scene.Data = []() { return reinterpret_cast<float*>(objects.data()); };
+    scene.Count = []() { return objects.size(); };
+    scene.Stride = OBJECT_FLOATS;
+    scene.PositionOffset = offsetof(Object, position) / sizeof(float);
+    scene.ScaleOffset = offsetof(Object, scale) / sizeof(float);
+    scene.ColorOffset = offsetof(Object, color) / sizeof(float);
+    scene.Create = [](const std::string& primitive, size_t count) -> size_t {
+        // primitive names are the display names in lower case with underscores, e.g. "uv_sphere"
+        for (int type = 0; type < PRIMITIVE_TYPE_COUNT; ++type) {
+            std::string name = PrimitiveTypeName(static_cast<Primitive_Type>(type));
+            for (char& c : name) {
+                c = c == ' ' ? '_' : static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+            }
+            if (name == primitive) {
+                const Mesh* mesh = meshPool.Acquire(PrimitiveDesc::Default(static_cast<Primitive_Type>(type)));
+                size_t first = objects.size();
+                objects.resize(first + count, { glm::vec3(0.0f, 0.5f, 0.0f), glm::vec3(1.0f), glm::vec4(1.0f), mesh, 0 });
+                return first;
+            }
+        }
+        return static_cast<size_t>(-1);
+    };
+    scene.Select = [](int index) { SelectObject(index >= 0 && index < static_cast<int>(objects.size()) ? index : -1, false); };
+    scene.Log = Log;
+    scripting.Bind(scene);
+}
+
+// Render the script editor, the run controls and the profiler readout
+void RenderScripting() {
+    static const char* exampleNames[] = { "Grid of cubes", "Random colors", "Wave over frames" };
+    static const char* exampleSources[] = {
+        "-- Create 10000 cubes and lay them out on a grid with range calls\n"
+        "local count = 10000\n"
+        "local first = scene.create(\"cube\", count)\n"
+        "scene.positions:grid(first, count, 100, 1.5)\n"
+        "scene.scales:fill(first, count, 0.5, 0.5, 0.5)\n"
+        "scene.colors:random(first, count, 0.2, 1.0, 7)\n"
+        "print(\"created \" .. count .. \" cubes starting at \" .. first)\n",
+
+        "-- Recolor every object, keeping alpha at 1\n"
+        "local n = scene.count()\n"
+        "scene.colors:random(0, n, 0.0, 1.0, os.time())\n"
+        "scene.colors:multiply(0, n, 1, 1, 1, 0)\n"
+        "scene.colors:offset(0, n, 0, 0, 0, 1)\n",
+
+        "-- Per-object edits from Lua; coroutine.yield() continues next frame,\n"
+        "-- and the frame budget splits anything longer automatically\n"
+        "local n = scene.count()\n"
+        "for step = 1, 300 do\n"
+        "  for i = 0, n - 1 do\n"
+        "    local x, y, z = scene.positions:get(i)\n"
+        "    scene.positions:set(i, x, 0.5 + 0.5 * math.sin(step * 0.1 + x * 0.3 + z * 0.2), z)\n"
+        "  end\n"
+        "  coroutine.yield()\n"
+        "end\n"
+    };
+    static int example = 0;
+    static bool initialized = false;
+    if (!initialized) {
+        strncpy(scriptSource, exampleSources[0], sizeof(scriptSource) - 1);
+        initialized = true;
+    }
+
+    ImGui::Begin("Scripting");
+
+    if (!ScriptRuntime::IsAvailable()) {
+        ImGui::TextColored(ImVec4(1.0f, 0.7f, 0.2f, 1.0f), "Built without Lua; run a Scripts/Setup script to fetch the Lua sources into Vendor/Lua/lua");
+    }
+
+    if (ImGui::Combo("Example", &example, exampleNames, IM_ARRAYSIZE(exampleNames))) {
+        strncpy(scriptSource, exampleSources[example], sizeof(scriptSource) - 1);
+    }
+    ImGui::InputTextMultiline("##source", scriptSource, sizeof(scriptSource), ImVec2(-1.0f, ImGui::GetTextLineHeight() * 14), ImGuiInputTextFlags_AllowTabInput);
+
+    if (ImGui::Button("Run")) {
+        if (scripting.Run(example >= 0 ? exampleNames[example] : "script", scriptSource)) {
+            Log("Started script");
+        }
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Stop")) {
+        scripting.Stop();
+        Log("Stopped script");
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Load")) {
+        const char* filters[] = { "*.lua" };
+        const char* filePath = tinyfd_openFileDialog("Open Script", "", 1, filters, "Lua scripts", 0);
+        if (filePath) {
+            std::ifstream file(filePath);
+            std::stringstream stream;
+            stream << file.rdbuf();
+            strncpy(scriptSource, stream.str().c_str(), sizeof(scriptSource) - 1);
+            example = -1;
+        }
+    }
+    ImGui::SliderFloat("Budget", &scripting.BudgetMs, 0.5f, 33.0f, "%.1f ms/frame");
+
+    // Report status changes once in the console
+    const ScriptRuntime::Profile& profile = scripting.GetProfile();
+    if (profile.Status != lastScriptStatus) {
+        if (profile.Status == SCRIPT_FINISHED) {
+            Log("Script '" + profile.Name + "' finished after " + std::to_string(profile.Frames) + " frames, " + std::to_string(profile.TotalMs) + " ms");
+        }
+        else if (profile.Status == SCRIPT_FAILED) {
+            Log("Script '" + profile.Name + "' failed: " + profile.Error);
+        }
+        lastScriptStatus = profile.Status;
+    }
+
+    ImGui::Separator();
+    ImGui::Text("Status: %s", ScriptStatusName(profile.Status));
+    ImGui::Text("Frames: %u, budget yields: %u", profile.Frames, profile.BudgetYields);
+    ImGui::Text("Time: %.2f ms last frame, %.2f ms max, %.2f ms total", profile.LastFrameMs, profile.MaxFrameMs, profile.TotalMs);
+    if (profile.Status == SCRIPT_FAILED) {
+        ImGui::TextWrapped("%s", profile.Error.c_str());
+    }
+
+    if (ImGui::BeginTable("ScriptApi", 4, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+        ImGui::TableSetupColumn("Call");
+        ImGui::TableSetupColumn("Calls");
+        ImGui::TableSetupColumn("Objects");
+        ImGui::TableSetupColumn("ms");
+        ImGui::TableHeadersRow();
+        for (const ScriptRuntime::ApiStats& stats : scripting.GetApiStats()) {
+            if (stats.Calls == 0) {
+                continue;
+            }
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::Text("%s", stats.Name);
+            ImGui::TableNextColumn();
+            ImGui::Text("%llu", stats.Calls);
+            ImGui::TableNextColumn();
+            ImGui::Text("%llu", stats.Elements);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", stats.Ms);
+        }
+        ImGui::EndTable();
+    }
+    if (ImGui::Button("Reset Profile")) {
+        scripting.ResetApiStats();
+    }
+
+    ImGui::End();
+}
+
+// Build the triangles of the current scatter target in world space; fails if the target is the selection and nothing is selected
+bool BuildScatterSurface(ScatterSurface& surface) {
+    if (scatterTarget == 0) {
+        surface = ScatterSurface::Plane(gridSize, 0.0f);
+        return true;
+    }
+    if (selectedObject < 0) {
+        return false;
+    }
+    const Object& target = objects[selectedObject];
+    surface = ScatterSurface::FromMesh(BaseMeshData(target.mesh), target.position, target.scale);
+    return true;
+}
+
+// Scatter a new batch over the target, with the jobs writing straight into the mapped instance buffer
+void ScatterInstancesOnTarget() {
+    ScatterSurface surface;
+    if (!BuildScatterSurface(surface)) {
+        Log("Select an object to scatter onto");
+        return;
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    const Mesh* mesh = meshPool.Acquire(PrimitiveDesc::Default(static_cast<Primitive_Type>(scatterPrimitive)));
+    std::string name = std::string("Scatter ") + std::to_string(scatterBatches.size()) + " (" + PrimitiveTypeName(mesh->Desc.Type) + ")";
+    std::unique_ptr<InstanceBatch> batch = std::make_unique<InstanceBatch>(gpuResources, glState, mesh, scatterSettings.Count, name);
+
+    ScatterStats stats;
+    ScatterInstance* instances = batch->Map();
+    size_t written = instances ? ScatterInstances(surface, scatterSettings, jobs, instances, &stats) : 0;
+    if (!batch->Unmap(written)) {
+        Log("Instance buffer contents were lost while mapped; scatter again");
+        return;
+    }
+    double totalMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+    Log("Scattered " + std::to_string(written) + " of " + std::to_string(stats.Samples) + " samples over " +
+        std::to_string(surface.TriangleCount()) + " triangles in " + std::to_string(totalMs) + " ms (sample " +
+        std::to_string(stats.SampleMs) + " ms, blue noise " + std::to_string(stats.FilterMs) + " ms, compact " +
+        std::to_string(stats.WriteMs) + " ms) on " + std::to_string(jobs.GetThreadCount()) + " threads, " +
+        std::to_string(static_cast<long long>(written / std::max(totalMs, 0.001) * 1000.0)) + " instances/s");
+    scatterSettings.Seed++;
+    scatterBatches.push_back(std::move(batch));
+}
+
+// Draw every scatter batch with one instanced call each
+void RenderInstanceBatches(Shader& shader) {
+    glState.UseProgram(shader.ID);
+    shader.setMat4("projection", GetProjectionMatrix());
+    shader.setMat4("view", camera.GetViewMatrix());
+    for (const auto& batch : scatterBatches) {
+        batch->Draw();
+    }
+}
+
+// Render the scatter tool settings and the list of scattered batches
+void RenderScatter() {
+    ImGui::Begin("Scatter");
+
+    ImGui::Combo("Target", &scatterTarget, "Grid plane\0Selected object\0");
+    const char* names[PRIMITIVE_TYPE_COUNT];
+    for (int i = 0; i < PRIMITIVE_TYPE_COUNT; ++i) {
+        names[i] = PrimitiveTypeName(static_cast<Primitive_Type>(i));
+    }
+    ImGui::Combo("Instance", &scatterPrimitive, names, PRIMITIVE_TYPE_COUNT);
+
+    int count = static_cast<int>(scatterSettings.Count);
+    if (ImGui::InputInt("Samples", &count, 10000, 100000)) {
+        scatterSettings.Count = static_cast<size_t>(glm::clamp(count, 1, 10000000));
+    }
+    ImGui::DragFloat("Min distance", &scatterSettings.MinDistance, 0.001f, 0.0f, 10.0f, "%.4f");
+    ImGui::SameLine();
+    if (ImGui::Button("Auto")) {
+        ScatterSurface surface;
+        if (BuildScatterSurface(surface)) {
+            scatterSettings.MinDistance = SuggestScatterDistance(surface, scatterSettings.Count);
+        }
+    }
+    ImGui::TextDisabled(scatterSettings.MinDistance > 0.0f ? "Blue noise: samples closer than the distance are dropped" : "White noise: every sample is kept");
+
+    int seed = static_cast<int>(scatterSettings.Seed);
+    if (ImGui::InputInt("Seed", &seed)) {
+        scatterSettings.Seed = static_cast<uint32_t>(seed);
+    }
+    ImGui::DragFloatRange2("Scale", &scatterSettings.ScaleMin, &scatterSettings.ScaleMax, 0.001f, 0.001f, 10.0f, "%.3f");
+    ImGui::ColorEdit4("Color A", glm::value_ptr(scatterSettings.ColorA));
+    ImGui::ColorEdit4("Color B", glm::value_ptr(scatterSettings.ColorB));
+    ImGui::Checkbox("Rest on surface", &scatterSettings.RestOnSurface);
+
+    if (ImGui::Button("Scatter")) {
+        ScatterInstancesOnTarget();
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Clear All")) {
+        scatterBatches.clear();
+    }
+
+    ImGui::Separator();
+    for (size_t i = 0; i < scatterBatches.size(); ++i) {
+        ImGui::PushID(static_cast<int>(i));
+        ImGui::Text("%s: %zu instances, %.1f MB", scatterBatches[i]->Name.c_str(), scatterBatches[i]->GetCount(),
+            scatterBatches[i]->GetCapacity() * sizeof(ScatterInstance) / (1024.0 * 1024.0));
+        ImGui::SameLine();
+        if (ImGui::SmallButton("Delete")) {
+            scatterBatches.erase(scatterBatches.begin() + i);
+            ImGui::PopID();
+            break;
+        }
+        ImGui::PopID();
+    }
+
+    ImGui::End();
+}
+
+// Every window, mouse and keyboard event renders a few frames so ImGui can settle hover state and layout
+void InputEvent() {
+    redraw.Request(REDRAW_INPUT, redraw.InputFrames);
+    lastInputTime = glfwGetTime();
+    framePacer.InputEvent(lastInputTime);
+}
+
+// Input in a detached ImGui viewport only wakes the loop; camera and picking belong to the main window
+bool IsViewportWindow(GLFWwindow* window) {
+    return window != ImGui::GetMainViewport()->PlatformHandle;
+}
+
+// Request a frame from any thread, waking the loop if it is sleeping in glfwWaitEvents
+void WakeMainLoop() {
+    redraw.Wake();
+    glfwPostEmptyEvent();
+}
+
+// Keep rendering while something changes on its own, and schedule the frames ImGui still needs
+void RequestRedraws() {
+    double now = glfwGetTime();
+
+    if (timeline.Playing || particlesEnabled || scripting.IsRunning() || (pathTracerEnabled && pathTracer.Running())) {
+        redraw.Request(REDRAW_ANIMATION);
+    }
+    if (automationCommandsLastFrame > 0) {
+        redraw.Request(REDRAW_SCENE);
+    }
+
+    // Held movement keys produce no events, so a camera that moved this frame keeps the loop running
+    if (camera.Position != renderedCamera.Position || camera.Yaw != renderedCamera.Yaw ||
+        camera.Pitch != renderedCamera.Pitch || camera.Zoom != renderedCamera.Zoom) {
+        redraw.Request(REDRAW_CAMERA);
+        renderedCamera = camera;
+    }
+
+    // A text field blinks its cursor, other active widgets (held buttons, drags) animate while held,
+    // and a hovered item shows its tooltip once the mouse has rested for the hover delay
+    ImGuiIO& io = ImGui::GetIO();
+    if (io.WantTextInput) {
+        redraw.RequestAfter(REDRAW_UI, 0.4, now);
+    }
+    else if (ImGui::IsAnyItemActive()) {
+        redraw.Request(REDRAW_UI);
+    }
+    float hoverDelay = ImGui::GetStyle().HoverDelayNormal + ImGui::GetStyle().HoverStationaryDelay;
+    if (ImGui::IsAnyItemHovered() && now - lastInputTime < hoverDelay) {
+        redraw.RequestAfter(REDRAW_UI, lastInputTime + hoverDelay + 0.02 - now, now);
+    }
+}
+
+// Poll events, then sleep in the event wait for as long as nothing needs a new frame
+void WaitForRedraw(GLFWwindow* window) {
+    glfwPollEvents();
+
+    bool waited = false;
+    for (;;) {
+        double timeout = redraw.GetWaitTimeout(glfwGetTime());
+        if (timeout == 0.0 || glfwWindowShouldClose(window)) {
+            break;
+        }
+        if (timeout > 0.0) {
+            glfwWaitEventsTimeout(timeout);
+        }
+        else {
+            glfwWaitEvents();
+        }
+        redraw.Waited(glfwGetTime());
+        waited = true;
+    }
+
+    // Time spent asleep is not frame time; keep the last delta so movement and simulations don't jump
+    if (waited) {
+        lastFrame = static_cast<float>(glfwGetTime()) - deltaTime;
+    }
+}
+
+// Apply the active gizmo drag to the selected object, using the cursor position sampled at the start of the frame
+void ApplyGizmoDrag() {
+    if (!isDragging || selectedObject < 0 || selectedAxis < 0) {
+        return;
+    }
+
+    double xpos = frameCursorX;
+    double ypos = frameCursorY;
+
+    glm::mat4 view = camera.GetViewMatrix();
+    glm::mat4 projection = GetProjectionMatrix();
+
+    glm::vec3 ray_origin = camera.Position;
+    glm::vec3 ray_direction = ScreenToWorldRay(static_cast<float>(xpos), static_cast<float>(ypos), view, projection);
+    glm::vec3 currentRayPosition = ray_origin + ray_direction;
+
+    glm::vec3 axisDirection;
+    if (selectedAxis == 0) {
+        axisDirection = glm::vec3(1.0f, 0.0f, 0.0f);
+    }
+    else if (selectedAxis == 1) {
+        axisDirection = glm::vec3(0.0f, 1.0f, 0.0f);
+    }
+    else if (selectedAxis == 2) {
+        axisDirection = glm::vec3(0.0f, 0.0f, 1.0f);
+    }
+
+    // Calculate the movement and apply the sensitivity factor
+    glm::vec3 movement = glm::dot(currentRayPosition - initialClickPosition, axisDirection) * axisDirection * movementSensitivity;
+
+    // Apply the transformation to every selected object around the shared pivot
+    SelectionTransform transform;
+    switch (currentMode) {
+    case TRANSLATE:
+        dragOffset += movement;
+        transform = SelectionTransform::Translate(SnapDragTarget(dragStartPivot + dragOffset) - selectionPivot);
+        Log("Translating " + std::to_string(selection.Count()) + " objects along axis " + std::to_string(selectedAxis) +
+            ", movement: " + glm::to_string(movement));
+        break;
+
+    case ROTATE: {
+        float angle = glm::dot(movement, axisDirection) * 5.0f * movementSensitivity; // Apply sensitivity to the rotation
+        transform = SelectionTransform::Rotate(selectionPivot, axisDirection, glm::radians(angle));
+        Log("Rotating " + std::to_string(selection.Count()) + " objects around axis " + std::to_string(selectedAxis) +
+            ", angle: " + std::to_string(angle));
+        break;
+    }
+
+    case SCALE:
+        transform = SelectionTransform::Scale(selectionPivot, glm::max(glm::vec3(1.0f) + movement, glm::vec3(0.01f)));
+        Log("Scaling " + std::to_string(selection.Count()) + " objects along axis " + std::to_string(selectedAxis) +
+            ", scale change: " + glm::to_string(movement));
+        break;
+    }
+    ApplySelectionTransform(reinterpret_cast<float*>(objects.data()), OBJECT_LAYOUT, selection.Indices(), transform, jobs);
+
+    initialClickPosition = currentRayPosition;
+}
+
+// Make index the active object. Without extend it replaces the selection (-1 clears it); with extend it is toggled,
+// and removing the active object hands that role to the most recently selected remaining one
+void SelectObject(int index, bool extend) {
+    if (!extend) {
+        selection.Clear();
+        if (index >= 0) {
+            selection.Add(index);
+        }
+        selectedObject = index;
+    }
+    else if (index >= 0) {
+        if (selection.Toggle(index)) {
+            selectedObject = index;
+        }
+        else if (selectedObject == index) {
+            selectedObject = selection.Empty() ? -1 : static_cast<int>(selection.Indices().back());
+        }
+    }
+    UpdateSelectionPivot();
+}
+
+// Place the gizmo at the mean position of the selection
+void UpdateSelectionPivot() {
+    if (selection.Count() == 1) {
+        selectionPivot = objects[selection.Indices()[0]].position;
+    }
+    else if (!selection.Empty()) {
+        selectionPivot = SelectionCentroid(reinterpret_cast<const float*>(objects.data()), OBJECT_LAYOUT, selection.Indices(), jobs);
+    }
+}
+
+// Time gizmo-style transform steps over the current selection; the selected objects are restored afterwards
+void BenchmarkSelectionTransform() {
+    if (selection.Empty()) {
+        Log("Select objects before running the transform benchmark");
+        return;
+    }
+
+    // Translation and rotation steps do not commute, so alternating directions alone would leave the scene moved
+    std::vector<Object> snapshot;
+    snapshot.reserve(selection.Count());
+    for (uint32_t index : selection.Indices()) {
+        snapshot.push_back(objects[index]);
+    }
+
+    const int steps = 100;
+    float* data = reinterpret_cast<float*>(objects.data());
+    double translateMs = 0.0;
+    double rotateMs = 0.0;
+    for (int step = 0; step < steps; ++step) {
+        float direction = (step % 2 == 0) ? 1.0f : -1.0f;
+
+        auto start = std::chrono::high_resolution_clock::now();
+        ApplySelectionTransform(data, OBJECT_LAYOUT, selection.Indices(), SelectionTransform::Translate(glm::vec3(0.01f * direction, 0.0f, 0.0f)), jobs);
+        auto middle = std::chrono::high_resolution_clock::now();
+        ApplySelectionTransform(data, OBJECT_LAYOUT, selection.Indices(), SelectionTransform::Rotate(selectionPivot, glm::vec3(0.0f, 1.0f, 0.0f), 0.01f * direction), jobs);
+        auto end = std::chrono::high_resolution_clock::now();
+
+        translateMs += std::chrono::duration<double, std::milli>(middle - start).count();
+        rotateMs += std::chrono::duration<double, std::milli>(end - middle).count();
+    }
+    translateMs /= steps;
+    rotateMs /= steps;
+
+    for (size_t i = 0; i < snapshot.size(); ++i) {
+        objects[selection.Indices()[i]] = snapshot[i];
+    }
+    UpdateSelectionPivot();
+
+    Log("Transform benchmark: " + std::to_string(selection.Count()) + " selected objects on " + std::to_string(jobs.GetThreadCount()) + " threads, translate " +
+        std::to_string(translateMs) + " ms, rotate " + std::to_string(rotateMs) + " ms per drag step (" +
+        std::to_string(static_cast<long long>(selection.Count() / (rotateMs / 1000.0))) + " objects/s)");
+}
+
+// Track the lasso outline while the button is held, and apply a released box or lasso selection
+void UpdateRegionSelect(GLFWwindow* window, Shader& idShader) {
+    if (regionSelecting) {
+        regionEnd = glm::vec2(static_cast<float>(frameCursorX), static_cast<float>(frameCursorY));
+        if (regionShape == REGION_LASSO && glm::length(regionEnd - lassoPoints.back()) >= 2.0f) {
+            lassoPoints.push_back(regionEnd);
+        }
+    }
+    if (!regionPending) {
+        return;
+    }
+    regionPending = false;
+
+    SelectionRegion region = regionShape == REGION_LASSO ? SelectionRegion::Lasso(lassoPoints) : SelectionRegion::Rectangle(regionStart, regionEnd);
+    if (region.IsEmpty()) {
+        return; // A click, already handled when the button was pressed
+    }
+
+    int windowWidth, windowHeight;
+    glfwGetWindowSize(window, &windowWidth, &windowHeight);
+    glm::vec2 windowSize(static_cast<float>(windowWidth), static_cast<float>(windowHeight));
+
+    // modifier results such as arrays reach past the unit primitive, so each object is bounded by its own mesh
+    std::vector<float> radii(objects.size());
+    for (size_t i = 0; i < objects.size(); ++i) {
+        radii[i] = objects[i].mesh->Radius;
+    }
+
+    std::vector<uint32_t> hits;
+    SelectObjectsInRegion(reinterpret_cast<const float*>(objects.data()), OBJECT_LAYOUT, radii.data(), objects.size(), camera.GetViewMatrix(),
+        GetProjectionMatrix(), windowSize, region, jobs, hits, &regionStats);
+    regionIdPassMs = 0.0;
+    if (selectVisibleOnly && !hits.empty()) {
+        FilterVisibleInRegion(idShader, region, windowSize, hits);
+        regionStats.Selected = hits.size();
+    }
+
+    if (!regionExtend) {
+        SelectObject(-1, false);
+    }
+    for (uint32_t index : hits) {
+        selection.Add(index);
+    }
+    if (!hits.empty() && selectedObject < 0) {
+        selectedObject = static_cast<int>(hits.back());
+    }
+    UpdateSelectionPivot();
+
+    Log(std::string(regionShape == REGION_LASSO ? "Lasso" : "Box") + " selected " + std::to_string(hits.size()) + " of " + std::to_string(objects.size()) +
+        " objects in " + std::to_string(regionStats.MaskMs + regionStats.ProjectMs + regionIdPassMs) + " ms");
+}
+
+// Drop hits that have no visible pixel inside the region: draw every object's index + 1 into the ID buffer
+// with depth testing, read back the region and keep the objects whose IDs survived
+void FilterVisibleInRegion(Shader& idShader, const SelectionRegion& region, const glm::vec2& windowSize, std::vector<uint32_t>& hits) {
+    auto start = std::chrono::high_resolution_clock::now();
+
+    glm::mat4 view = camera.GetViewMatrix();
+    glm::mat4 projection = GetProjectionMatrix();
+    float fovy = glm::radians(camera.Zoom);
+    float aspect = (float)SCR_WIDTH / (float)SCR_HEIGHT;
+
+    {
+        GLDebugGroup group(glDebug, "Object IDs");
+        idBuffer.Begin(framebufferWidth, framebufferHeight);
+        glState.UseProgram(idShader.ID);
+        idShader.setMat4("projection", projection);
+        idShader.setMat4("view", view);
+        for (size_t i = 0; i < objects.size(); ++i) {
+            const Object& obj = objects[i];
+            glm::vec3 viewCenter = glm::vec3(view * glm::vec4(obj.position, 1.0f));
+            if (!viewProjection.IsSphereVisible(viewCenter, obj.mesh->Radius * glm::length(obj.scale), fovy, aspect)) {
+                continue;
+            }
+            glm::mat4 model = glm::scale(glm::translate(glm::mat4(1.0f), obj.position), obj.scale);
+            idShader.setMat4("model", model);
+            idShader.setInt("objectId", static_cast<int>(i + 1));
+            glState.BindVertexArray(obj.mesh->VAO.ID());
+            obj.mesh->Draw();
+        }
+        idBuffer.End(0, framebufferWidth, framebufferHeight);
+    }
+
+    // The region is in window coordinates with the origin at the top; the ID buffer is in framebuffer pixels from the bottom
+    float scaleX = framebufferWidth / windowSize.x;
+    float scaleY = framebufferHeight / windowSize.y;
+    int left = std::max(0, static_cast<int>(std::floor(region.Min.x * scaleX)));
+    int right = std::min(framebufferWidth, static_cast<int>(std::ceil(region.Max.x * scaleX)));
+    int bottom = std::max(0, framebufferHeight - static_cast<int>(std::ceil(region.Max.y * scaleY)));
+    int top = std::min(framebufferHeight, framebufferHeight - static_cast<int>(std::floor(region.Min.y * scaleY)));
+    if (right <= left || top <= bottom) {
+        hits.clear();
+        return;
+    }
+
+    std::vector<uint32_t> ids;
+    idBuffer.Read(left, bottom, right - left, top - bottom, ids);
+
+    RegionMask mask;
+    mask.Build(region, windowSize, jobs);
+    std::vector<uint8_t> visible(objects.size(), 0);
+    int width = right - left;
+    for (int y = bottom; y < top; ++y) {
+        float windowY = (framebufferHeight - (y + 0.5f)) / scaleY;
+        const uint32_t* row = ids.data() + static_cast<size_t>(y - bottom) * width;
+        for (int x = 0; x < width; ++x) {
+            uint32_t id = row[x];
+            if (id != 0 && id <= objects.size() && mask.Contains((left + x + 0.5f) / scaleX, windowY)) {
+                visible[id - 1] = 1;
+            }
+        }
+    }
+    hits.erase(std::remove_if(hits.begin(), hits.end(), [&](uint32_t index) { return visible[index] == 0; }), hits.end());
+
+    regionIdPassMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+// Draw the rectangle or lasso being dragged on top of everything
+void RenderRegionOverlay() {
+    if (!regionSelecting) {
+        return;
+    }
+    ImGuiViewport* viewport = ImGui::GetMainViewport();
+    ImDrawList* drawList = ImGui::GetForegroundDrawList(viewport);
+    ImVec2 origin = viewport->Pos;
+    ImU32 fill = IM_COL32(255, 165, 50, 40);
+    ImU32 outline = IM_COL32(255, 165, 50, 220);
+    if (regionShape == REGION_RECTANGLE) {
+        ImVec2 a(origin.x + std::min(regionStart.x, regionEnd.x), origin.y + std::min(regionStart.y, regionEnd.y));
+        ImVec2 b(origin.x + std::max(regionStart.x, regionEnd.x), origin.y + std::max(regionStart.y, regionEnd.y));
+        drawList->AddRectFilled(a, b, fill);
+        drawList->AddRect(a, b, outline);
+    }
+    else {
+        std::vector<ImVec2> points;
+        points.reserve(lassoPoints.size() + 1);
+        for (const glm::vec2& point : lassoPoints) {
+            points.push_back(ImVec2(origin.x + point.x, origin.y + point.y));
+        }
+        points.push_back(ImVec2(origin.x + regionEnd.x, origin.y + regionEnd.y));
+        drawList->AddPolyline(points.data(), static_cast<int>(points.size()), outline, ImDrawFlags_Closed, 1.5f);
+    }
+}
+
+// World-space size of snapRadiusPixels at the point's depth; 0 behind the camera
+float SnapRadiusAt(const glm::vec3& point) {
+    float depth = -(camera.GetViewMatrix() * glm::vec4(point, 1.0f)).z;
+    float viewportHeight = ImGui::GetIO().DisplaySize.y;
+    if (depth <= 0.0f || viewportHeight <= 0.0f) {
+        return 0.0f;
+    }
+    return snapRadiusPixels * 2.0f * depth * std::tan(glm::radians(camera.Zoom) * 0.5f) / viewportHeight;
+}
+
+// Remember where the gizmo started and bring the snap index up to date; only objects changed since the last drag are re-indexed
+void BeginSnapDrag() {
+    dragStartPivot = selectionPivot;
+    dragOffset = glm::vec3(0.0f);
+    snapActive = false;
+    if (snapMode != SNAP_OBJECT && snapMode != SNAP_VERTEX) {
+        return;
+    }
+    snapIndex.Sync(snapMode, SnapRadiusAt(selectionPivot), objects.size(), [](size_t i) {
+        SnapObject object;
+        object.Position = objects[i].position;
+        object.Scale = objects[i].scale;
+        object.Radius = objects[i].mesh->Radius;
+        object.Vertices = &objects[i].mesh->Positions;
+        // sculpting rewrites the positions of an editable mesh without moving the vector
+        if (const EditableMesh* editable = FindEditableMesh(objects[i].mesh)) {
+            object.Revision = editable->Stats.Syncs;
+        }
+        return object;
+    });
+    Log("Snap index synced: " + std::to_string(snapIndex.Stats.ObjectsUpdated) + " objects updated in " + std::to_string(snapIndex.Stats.SyncMs) + " ms");
+}
+
+// Snap the dragged pivot along the active axis, to the grid or to the nearest target within the snap radius on screen
+glm::vec3 SnapDragTarget(glm::vec3 target) {
+    snapActive = false;
+    if (snapMode == SNAP_GRID && gridStep > 0.0f) {
+        target[selectedAxis] = std::round(target[selectedAxis] / gridStep) * gridStep;
+    }
+    else if (snapMode == SNAP_OBJECT || snapMode == SNAP_VERTEX) {
+        float radius = SnapRadiusAt(target);
+        if (radius <= 0.0f) {
+            return target;
+        }
+
+        SnapHit hit;
+        if (snapIndex.Nearest(target, radius, [](uint32_t owner) { return selection.Contains(owner); }, hit)) {
+            target[selectedAxis] = hit.Position[selectedAxis];
+            snapActive = true;
+            snapPoint = hit.Position;
+        }
+    }
+    return target;
+}
+
+// Mark the point the drag snapped to
+void RenderSnapMarker() {
+    if (!isDragging || !snapActive) {
+        return;
+    }
+    glm::vec4 clip = GetProjectionMatrix() * camera.GetViewMatrix() * glm::vec4(snapPoint, 1.0f);
+    if (clip.w <= 0.0f) {
+        return;
+    }
+    ImGuiViewport* viewport = ImGui::GetMainViewport();
+    glm::vec2 ndc = glm::vec2(clip) / clip.w;
+    ImVec2 center(viewport->Pos.x + (ndc.x * 0.5f + 0.5f) * viewport->Size.x, viewport->Pos.y + (0.5f - ndc.y * 0.5f) * viewport->Size.y);
+    ImGui::GetForegroundDrawList(viewport)->AddCircle(center, 6.0f, IM_COL32(255, 220, 60, 255), 16, 2.0f);
+}
+
+// Editable mesh an object is drawing, if any
+EditableMesh* FindEditableMesh(const Mesh* mesh) {
+    for (const std::unique_ptr<EditableMesh>& editable : editableMeshes) {
+        if (&editable->Gpu == mesh) {
+            return editable.get();
+        }
+    }
+    return nullptr;
+}
+
+// Give the object its own half-edge copy of its primitive, regenerated at editDensity times the resolution
+void MakeObjectEditable(int index) {
+    Object& obj = objects[index];
+    PrimitiveDesc desc = obj.mesh->Desc;
+    if (desc.Type == PRIMITIVE_ICO_SPHERE) {
+        // Each subdivision level quadruples the triangles, so density adds levels rather than multiplying them
+        desc.Rings += static_cast<int>(std::log2(static_cast<float>(editDensity)));
+    }
+    else {
+        desc.Segments *= editDensity;
+        desc.Rings *= editDensity;
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    // Imported meshes have no description to regenerate from, so they are edited at their own resolution
+    bool imported = FindImportedScene(obj.mesh) != nullptr;
+    MeshData data = imported ? BaseMeshData(obj.mesh) : GeneratePrimitive(desc);
+    std::unique_ptr<EditableMesh> editable = std::make_unique<EditableMesh>(gpuResources, glState);
+    editable->Build(HalfEdgeMesh::FromTriangles(data), desc, imported ? std::string("Editable import") : std::string("Editable ") + PrimitiveTypeName(desc.Type), jobs);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+    obj.mesh = &editable->Gpu;
+    Log("Object " + std::to_string(index) + " is editable: " + std::to_string(editable->Topology.VertexCount()) + " vertices, " +
+        std::to_string(editable->Topology.FaceCount()) + " faces, built in " + std::to_string(ms) + " ms");
+    editableMeshes.push_back(std::move(editable));
+}
+
+// Push (or with Shift pull) the front-facing vertices of the active editable mesh that lie within brushRadius of
+// the cursor ray, then let the mesh refresh the normals around them and upload the touched pages
+void ApplySculpt() {
+    if (!sculpting || selectedObject < 0) {
+        return;
+    }
+    EditableMesh* editable = FindEditableMesh(BaseMesh(selectedObject));
+    if (editable == nullptr) {
+        return;
+    }
+    const Object& obj = objects[selectedObject];
+    HalfEdgeMesh& mesh = editable->Topology;
+
+    glm::vec3 origin = camera.Position;
+    glm::vec3 direction = ScreenToWorldRay(static_cast<float>(frameCursorX), static_cast<float>(frameCursorY), camera.GetViewMatrix(), GetProjectionMatrix());
+    float amount = (ImGui::GetIO().KeyShift ? -1.0f : 1.0f) * brushStrength * deltaTime;
+    float radiusSquared = brushRadius * brushRadius;
+
+    // Each chunk owns its vertices, so positions are written in place; the touched ones are collected per chunk
+    const size_t grain = 16384;
+    size_t chunks = (mesh.VertexCount() + grain - 1) / grain;
+    std::vector<std::vector<uint32_t>> touched(chunks);
+    jobs.ParallelFor(chunks, 1, [&](size_t begin, size_t end) {
+        for (size_t chunk = begin; chunk < end; ++chunk) {
+            size_t last = std::min(mesh.VertexCount(), (chunk + 1) * grain);
+            for (size_t v = chunk * grain; v < last; ++v) {
+                glm::vec3 toVertex = obj.position + obj.scale * mesh.Positions[v] - origin;
+                float along = glm::dot(toVertex, direction);
+                float distanceSquared = glm::dot(toVertex, toVertex) - along * along;
+                if (along <= 0.0f || distanceSquared >= radiusSquared) {
+                    continue;
+                }
+                glm::vec3 worldNormal = glm::normalize(mesh.Normals[v] / obj.scale);
+                if (glm::dot(worldNormal, direction) >= 0.0f) {
+                    continue;
+                }
+                float falloff = 1.0f - distanceSquared / radiusSquared;
+                mesh.Positions[v] += worldNormal * (amount * falloff * falloff) / obj.scale;
+                touched[chunk].push_back(static_cast<uint32_t>(v));
+            }
+        }
+    });
+
+    for (const std::vector<uint32_t>& vertices : touched) {
+        for (uint32_t v : vertices) {
+            mesh.MarkDirty(v);
+        }
+    }
+    editable->Sync(jobs);
+}
+
+// Mesh Edit window: make the active object's mesh editable and sculpt it
+void RenderMeshEdit() {
+    ImGui::Begin("Mesh Edit");
+
+    if (selectedObject < 0) {
+        ImGui::Text("Select an object to edit its mesh");
+        ImGui::End();
+        return;
+    }
+
+    EditableMesh* editable = FindEditableMesh(BaseMesh(selectedObject));
+    if (editable == nullptr) {
+        ImGui::Text("%s with %u vertices", PrimitiveTypeName(objects[selectedObject].mesh->Desc.Type), objects[selectedObject].mesh->VertexCount);
+        ImGui::SliderInt("Density", &editDensity, 1, 40);
+        if (ImGui::Button("Make editable")) {
+            MakeObjectEditable(selectedObject);
+        }
+        ImGui::End();
+        return;
+    }
+
+    const HalfEdgeMesh& mesh = editable->Topology;
+    ImGui::Text("Vertices: %zu (%zu drawn wedges), faces: %zu, half-edges: %zu, boundary edges: %zu", mesh.VertexCount(), mesh.WedgeCount(),
+        mesh.FaceCount(), mesh.EdgeCount(), mesh.BoundaryEdgeCount());
+    ImGui::Checkbox("Sculpt (left drag pushes, Shift pulls)", &sculptMode);
+    ImGui::SliderFloat("Brush radius", &brushRadius, 0.01f, 1.0f);
+    ImGui::SliderFloat("Brush strength", &brushStrength, 0.05f, 5.0f);
+
+    const EditableMeshStats& stats = editable->Stats;
+    ImGui::Text("Last edit: %zu vertices refreshed, normals %.3f ms", stats.ChangedVertices, stats.NormalsMs);
+    ImGui::Text("Upload: %zu ranges, %.1f KB of %.1f KB in %.3f ms", stats.UploadRanges, stats.UploadedBytes / 1024.0,
+        editable->Gpu.VBO.GetBytes() / 1024.0, stats.UploadMs);
+
+    if (ImGui::Button("Benchmark full normal recompute")) {
+        auto start = std::chrono::high_resolution_clock::now();
+        editable->Topology.ComputeNormals(jobs);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        Log("Recomputed normals of " + std::to_string(mesh.VertexCount()) + " vertices on " + std::to_string(jobs.GetThreadCount()) +
+            " threads in " + std::to_string(ms) + " ms");
+    }
+
+    ImGui::End();
+}
+
+// Mesh an object was given before its modifier stack took over, which is what editing tools work on
+const Mesh* BaseMesh(int index) {
+    auto it = objectModifiers.find(index);
+    if (it != objectModifiers.end() && it->second.Base != nullptr) {
+        return it->second.Base;
+    }
+    return objects[index].mesh;
+}
+
+// Content key of a base mesh: pooled meshes are defined by their description, editable ones change with every sync
+uint64_t BaseMeshKey(const Mesh* mesh) {
+    for (const BooleanResult& result : booleanResults) {
+        if (result.Gpu == mesh) {
+            return result.Key;
+        }
+    }
+    if (FindImportedScene(mesh) != nullptr) {
+        // imported meshes never change, and their pointers stay unique for as long as the scene lives
+        return HashCombine(4, reinterpret_cast<uintptr_t>(mesh));
+    }
+    if (EditableMesh* editable = FindEditableMesh(mesh)) {
+        return HashCombine(HashCombine(2, reinterpret_cast<uintptr_t>(editable)), editable->Stats.Syncs);
+    }
+    return HashCombine(1, PrimitiveDescHash()(mesh->Desc));
+}
+
+// CPU copy of a base mesh; pooled meshes are regenerated from their description, editable ones read from the topology,
+// boolean results are kept as they were computed and imported ones are read again from their mapped file
+MeshData BaseMeshData(const Mesh* mesh) {
+    for (const BooleanResult& result : booleanResults) {
+        if (result.Gpu == mesh) {
+            return *result.Data;
+        }
+    }
+    if (const GltfScene* scene = FindImportedScene(mesh)) {
+        MeshData data;
+        scene->ReadMesh(mesh, data);
+        return data;
+    }
+    const EditableMesh* editable = FindEditableMesh(mesh);
+    if (editable == nullptr) {
+        return GeneratePrimitive(mesh->Desc);
+    }
+    return editable->Topology.ToMeshData();
+}
+
+// CPU copy of the geometry an object shows: the result of its modifier stack, or else its base mesh
+MeshData DrawnMeshData(int index) {
+    auto it = objectModifiers.find(index);
+    if (it == objectModifiers.end() || it->second.MeshKey == 0) {
+        return BaseMeshData(BaseMesh(index));
+    }
+    // A stack that picked up another object's identical mesh never ran itself; this only runs its stale stages
+    ObjectModifiers& mods = it->second;
+    if (!mods.BaseData) {
+        mods.BaseData = std::make_shared<const MeshData>(BaseMeshData(mods.Base));
+    }
+    mods.Stack.Evaluate(mods.BaseData, mods.BaseKey, jobs);
+    return *mods.Stack.Result();
+}
+
+// Bring every object's mesh up to date with its modifier stack. Stacks are only evaluated when the key of their
+// result changed and no other object already uploaded a mesh with that key; the evaluations of different objects
+// run in parallel and only the uploads stay on the main thread.
+void UpdateModifiers() {
+    std::vector<std::pair<int, ObjectModifiers*>> pending;
+    for (auto it = objectModifiers.begin(); it != objectModifiers.end();) {
+        Object& obj = objects[it->first];
+        ObjectModifiers& mods = it->second;
+
+        // Anything else that replaced the object's mesh (a new primitive, edit mode) becomes the new base
+        const Mesh* current = mods.MeshKey != 0 ? meshPool.FindDerived(mods.MeshKey) : mods.Base;
+        if (obj.mesh != current) {
+            mods.Base = obj.mesh;
+        }
+        uint64_t baseKey = BaseMeshKey(mods.Base);
+        if (baseKey != mods.BaseKey) {
+            mods.BaseKey = baseKey;
+            mods.BaseData.reset();
+        }
+
+        uint64_t key = mods.Stack.ResultKey(baseKey);
+        if (key == baseKey) {
+            // Nothing enabled: draw the base mesh again, and forget stacks that have no stages left
+            if (mods.MeshKey != 0) {
+                meshPool.ReleaseDerived(mods.MeshKey);
+                mods.MeshKey = 0;
+            }
+            obj.mesh = mods.Base;
+            it = mods.Stack.Stages.empty() ? objectModifiers.erase(it) : std::next(it);
+            continue;
+        }
+        if (key != mods.MeshKey) {
+            if (const Mesh* shared = meshPool.AcquireDerived(key)) {
+                if (mods.MeshKey != 0) {
+                    meshPool.ReleaseDerived(mods.MeshKey);
+                }
+                mods.MeshKey = key;
+                obj.mesh = shared;
+            }
+            else {
+                pending.push_back({ it->first, &mods });
+            }
+        }
+        ++it;
+    }
+    if (pending.empty()) {
+        return;
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    jobs.ParallelFor(pending.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            ObjectModifiers& mods = *pending[i].second;
+            if (!mods.BaseData) {
+                mods.BaseData = std::make_shared<const MeshData>(BaseMeshData(mods.Base));
+            }
+            mods.Stack.Evaluate(mods.BaseData, mods.BaseKey, jobs);
+        }
+    });
+    for (auto& [index, mods] : pending) {
+        uint64_t key = mods->Stack.ResultKey(mods->BaseKey);
+        const Mesh* mesh = meshPool.AcquireDerived(key, *mods->Stack.Result(), mods->Base->Desc, std::string("Modified ") + PrimitiveTypeName(mods->Base->Desc.Type),
+            mods->Stack.IsAdaptive());
+        if (mods->MeshKey != 0) {
+            meshPool.ReleaseDerived(mods->MeshKey);
+        }
+        mods->MeshKey = key;
+        objects[index].mesh = mesh;
+    }
+    modifierUpdateMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    modifierUpdateStacks = pending.size();
+}
+
+// Modifiers window: the active object's modifier stack with per-stage timings
+void RenderModifiers() {
+    ImGui::Begin("Modifiers");
+
+    if (selectedObject < 0) {
+        ImGui::Text("Select an object to add modifiers");
+        ImGui::End();
+        return;
+    }
+
+    if (ImGui::BeginCombo("##type", ModifierTypeName(newModifierType))) {
+        for (int type = 0; type < MODIFIER_TYPE_COUNT; ++type) {
+            if (ImGui::Selectable(ModifierTypeName(static_cast<Modifier_Type>(type)), newModifierType == type)) {
+                newModifierType = static_cast<Modifier_Type>(type);
+            }
+        }
+        ImGui::EndCombo();
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Add modifier")) {
+        ObjectModifiers& mods = objectModifiers[selectedObject];
+        if (mods.Base == nullptr) {
+            mods.Base = objects[selectedObject].mesh;
+        }
+        mods.Stack.Add(Modifier::Default(newModifierType));
+    }
+
+    auto it = objectModifiers.find(selectedObject);
+    if (it == objectModifiers.end()) {
+        ImGui::End();
+        return;
+    }
+    ModifierStack& stack = it->second.Stack;
+
+    // Edits to the list are applied after drawing it so the loop never sees a shifted vector
+    int moveFrom = -1, moveTo = -1, remove = -1;
+    const char* axes[] = { "X", "Y", "Z" };
+    for (size_t i = 0; i < stack.Stages.size(); ++i) {
+        ModifierStage& stage = stack.Stages[i];
+        Modifier& params = stage.Params;
+        ImGui::PushID(static_cast<int>(i));
+        ImGui::Separator();
+        ImGui::Checkbox("##enabled", &params.Enabled);
+        ImGui::SameLine();
+        ImGui::Text("%zu. %s", i + 1, ModifierTypeName(params.Type));
+        ImGui::SameLine();
+        if (ImGui::ArrowButton("##up", ImGuiDir_Up) && i > 0) {
+            moveFrom = static_cast<int>(i);
+            moveTo = static_cast<int>(i) - 1;
+        }
+        ImGui::SameLine();
+        if (ImGui::ArrowButton("##down", ImGuiDir_Down) && i + 1 < stack.Stages.size()) {
+            moveFrom = static_cast<int>(i);
+            moveTo = static_cast<int>(i) + 1;
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Remove")) {
+            remove = static_cast<int>(i);
+        }
+
+        switch (params.Type) {
+        case MODIFIER_ARRAY:
+            ImGui::SliderInt("Count", &params.Count, 1, 100);
+            ImGui::DragFloat3("Offset", glm::value_ptr(params.Offset), 0.01f);
+            break;
+        case MODIFIER_MIRROR:
+            ImGui::Combo("Axis", &params.Axis, axes, 3);
+            break;
+        case MODIFIER_SUBDIVIDE:
+            ImGui::SliderInt("Levels", &params.Levels, 1, 4);
+            break;
+        case MODIFIER_SUBDIVISION_SURFACE:
+            ImGui::SliderInt("Levels", &params.Levels, 1, 4);
+            if (tessellation.IsAvailable()) {
+                ImGui::Checkbox("Adaptive GPU tessellation", &params.Adaptive);
+            }
+            else {
+                ImGui::TextDisabled("Adaptive GPU tessellation needs OpenGL 4.0");
+            }
+            if (stage.Surface) {
+                const SubdivisionSurface& surface = stage.Surface->Surface;
+                ImGui::Text("Stencils: %zu control points -> %zu vertices, %zu weights, built in %.1f ms", surface.ControlCount(),
+                    surface.RefinedCount(), surface.Weights.size(), surface.BuildMs);
+                ImGui::Text("Last evaluation: stencils %.2f ms, normals %.2f ms", surface.ApplyMs, surface.NormalsMs);
+            }
+            break;
+        case MODIFIER_DECIMATE:
+            ImGui::SliderFloat("Ratio", &params.Ratio, 0.01f, 1.0f);
+            break;
+        default:
+            break;
+        }
+
+        if (!params.Enabled) {
+            ImGui::TextDisabled("Disabled");
+        }
+        else if (stage.Output) {
+            ImGui::Text("%.2f ms %s, %zu vertices, %zu triangles", stage.Ms, stage.Reused ? "(cached)" : "(ran)",
+                stage.Output->VertexCount(), stage.Output->Indices.size() / 3);
+        }
+        ImGui::PopID();
+    }
+
+    if (remove >= 0) {
+        stack.Remove(static_cast<size_t>(remove));
+    }
+    else if (moveFrom >= 0) {
+        stack.Move(static_cast<size_t>(moveFrom), static_cast<size_t>(moveTo));
+    }
+
+    ImGui::Separator();
+    ImGui::Text("Stack: %.2f ms last evaluation", stack.LastEvaluationMs());
+    ImGui::Text("Last update: %zu stacks in %.2f ms on %u threads", modifierUpdateStacks, modifierUpdateMs, jobs.GetThreadCount());
+    ImGui::Text("Derived meshes in pool: %zu", meshPool.GetDerivedCount());
+    if (tessellation.IsAvailable()) {
+        ImGui::SliderFloat("Pixels per tessellated edge", &tessellation.PixelsPerEdge, 2.0f, 64.0f);
+        ImGui::Text("Tessellated patches last frame: %u", tessellation.DrawnPatches);
+    }
+
+    ImGui::End();
+}
+
+// Replace the target object's mesh with the boolean of it and the cutter. The cutter is brought into the target's
+// object space, so the result draws with the target's transform; the cutter object itself is left in place.
+void ApplyBoolean(Boolean_Operation operation, int target, int cutter) {
+    const Object& a = objects[target];
+    const Object& b = objects[cutter];
+    MeshData dataA = DrawnMeshData(target);
+    MeshData dataB = DrawnMeshData(cutter);
+    for (size_t v = 0; v < dataB.VertexCount(); ++v) {
+        float* p = &dataB.Vertices[v * MeshData::STRIDE];
+        glm::vec3 local = (b.position + b.scale * glm::vec3(p[0], p[1], p[2]) - a.position) / a.scale;
+        p[0] = local.x; p[1] = local.y; p[2] = local.z;
+    }
+
+    auto result = std::make_shared<const MeshData>(BooleanMesh(dataA, dataB, operation, jobs, &booleanStats));
+    if (result->Indices.empty()) {
+        Log(std::string(BooleanOperationName(operation)) + " of objects " + std::to_string(target) + " and " + std::to_string(cutter) + " is empty, nothing changed");
+        return;
+    }
+
+    // The result already contains the target's modifiers, so its stack is applied and dropped; a boolean result
+    // it replaces has no other user and is freed with its CPU copy
+    const Mesh* previous = BaseMesh(target);
+    PrimitiveDesc desc = previous->Desc;
+    auto mods = objectModifiers.find(target);
+    if (mods != objectModifiers.end()) {
+        if (mods->second.MeshKey != 0) {
+            meshPool.ReleaseDerived(mods->second.MeshKey);
+        }
+        objectModifiers.erase(mods);
+    }
+    for (auto it = booleanResults.begin(); it != booleanResults.end(); ++it) {
+        if (it->Gpu == previous) {
+            meshPool.ReleaseDerived(it->Key);
+            booleanResults.erase(it);
+            break;
+        }
+    }
+
+    uint64_t key = HashCombine(3, booleanCount++);
+    const Mesh* mesh = meshPool.AcquireDerived(key, *result, desc, std::string("Boolean ") + BooleanOperationName(operation));
+    booleanResults.push_back({ key, result, mesh });
+    objects[target].mesh = mesh;
+    Log(std::string(BooleanOperationName(operation)) + " of objects " + std::to_string(target) + " and " + std::to_string(cutter) + ": " +
+        std::to_string(booleanStats.OutputTriangles) + " triangles in " + std::to_string(booleanStats.TotalMs) + " ms");
+}
+
+// Time every operation on two overlapping spheres of about 100k triangles each
+void BenchmarkBooleans() {
+    PrimitiveDesc desc = PrimitiveDesc::Default(PRIMITIVE_UV_SPHERE);
+    desc.Segments = 317;
+    desc.Rings = 158;
+    MeshData a = GeneratePrimitive(desc);
+    MeshData b = a;
+    for (size_t v = 0; v < b.VertexCount(); ++v) {
+        b.Vertices[v * MeshData::STRIDE] += 0.3f;
+        b.Vertices[v * MeshData::STRIDE + 1] += 0.1f;
+    }
+
+    Log("Boolean benchmark: " + std::to_string(a.Indices.size() / 3) + " x " + std::to_string(b.Indices.size() / 3) + " triangles on " +
+        std::to_string(jobs.GetThreadCount()) + " threads");
+    for (int operation = 0; operation < BOOLEAN_OPERATION_COUNT; ++operation) {
+        BooleanStats stats;
+        BooleanMesh(a, b, static_cast<Boolean_Operation>(operation), jobs, &stats);
+        Log(std::string(BooleanOperationName(static_cast<Boolean_Operation>(operation))) + ": " + std::to_string(stats.TotalMs) + " ms (trees " +
+            std::to_string(stats.BvhMs) + ", pairs " + std::to_string(stats.PairsMs) + ", intersect " + std::to_string(stats.IntersectMs) + ", split " +
+            std::to_string(stats.SplitMs) + ", classify " + std::to_string(stats.ClassifyMs) + ", assemble " + std::to_string(stats.AssembleMs) + "), " +
+            std::to_string(stats.CandidatePairs) + " candidate pairs, " + std::to_string(stats.IntersectingPairs) + " intersecting, " + std::to_string(stats.CoplanarPairs) + " coplanar");
+    }
+    booleanStats = BooleanStats();
+}
+
+// Booleans window: combine the active object with the one other selected object
+void RenderBooleans() {
+    ImGui::Begin("Booleans");
+
+    int cutter = -1;
+    if (selectedObject >= 0 && selection.Count() == 2) {
+        for (uint32_t index : selection.Indices()) {
+            if (static_cast<int>(index) != selectedObject) {
+                cutter = static_cast<int>(index);
+            }
+        }
+    }
+
+    if (cutter < 0) {
+        ImGui::Text("Select two objects; the active one receives the result");
+    }
+    else {
+        ImGui::Text("Object %d with object %d", selectedObject, cutter);
+        for (int operation = 0; operation < BOOLEAN_OPERATION_COUNT; ++operation) {
+            if (operation > 0) {
+                ImGui::SameLine();
+            }
+            if (ImGui::Button(BooleanOperationName(static_cast<Boolean_Operation>(operation)))) {
+                ApplyBoolean(static_cast<Boolean_Operation>(operation), selectedObject, cutter);
+            }
+        }
+    }
+
+    if (booleanStats.TotalMs > 0.0) {
+        const BooleanStats& stats = booleanStats;
+        ImGui::Separator();
+        ImGui::Text("Last: %.1f ms, %zu triangles", stats.TotalMs, stats.OutputTriangles);
+        ImGui::Text("Trees %.1f ms, pairs %.1f ms (%zu candidates, %zu intersecting, %zu coplanar)", stats.BvhMs, stats.PairsMs, stats.CandidatePairs,
+            stats.IntersectingPairs, stats.CoplanarPairs);
+        ImGui::Text("Intersect %.1f ms, split %.1f ms (%zu triangles into %zu pieces)", stats.IntersectMs, stats.SplitMs, stats.CutTriangles, stats.Pieces);
+        ImGui::Text("Classify %.1f ms (%zu regions), assemble %.1f ms", stats.ClassifyMs, stats.Regions, stats.AssembleMs);
+    }
+    if (ImGui::Button("Benchmark 100k x 100k")) {
+        BenchmarkBooleans();
+    }
+
+    ImGui::End();
+}
+
+// Scene an imported mesh belongs to, nullptr for meshes that were not imported
+const GltfScene* FindImportedScene(const Mesh* mesh) {
+    for (const ImportedScene& imported : importedScenes) {
+        if (imported.Scene->Owns(mesh)) {
+            return imported.Scene.get();
+        }
+    }
+    return nullptr;
+}
+
+// Import a glTF asset as one object per node primitive; embedded images decode on the texture workers
+bool ImportGltf(const std::string& path) {
+    std::unique_ptr<GltfScene> scene = std::make_unique<GltfScene>(gpuResources, glState);
+    std::string error;
+    if (!scene->Load(path, jobs, error)) {
+        Log("Import of " + path + " failed: " + error);
+        return false;
+    }
+
+    ImportedScene imported;
+    imported.FirstObject = objects.size();
+    imported.NodeObjects.resize(scene->Asset->Nodes.size());
+    for (const GltfInstance& instance : scene->Instances) {
+        imported.NodeObjects[instance.Node].push_back(objects.size());
+        objects.push_back({ instance.Position, instance.Scale, instance.Color, instance.Gpu, 0 });
+    }
+
+    // One decode per image however many objects use it; ticket 0 marks images that will not arrive
+    std::unordered_map<int, uint64_t> tickets;
+    for (size_t i = 0; i < scene->Instances.size(); ++i) {
+        int image = scene->Instances[i].Image;
+        if (image < 0) {
+            continue;
+        }
+        std::string key = path + "#image" + std::to_string(image);
+        auto existing = textureLibrary.find(key);
+        if (existing != textureLibrary.end()) {
+            objects[imported.FirstObject + i].textureID = existing->second.ID();
+            continue;
+        }
+        auto ticket = tickets.find(image);
+        if (ticket == tickets.end()) {
+            const uint8_t* data = nullptr;
+            size_t size = 0;
+            uint64_t submitted = 0;
+            if (scene->Asset->ImageData(image, data, size, error)) {
+                // glTF puts the first row of an image at v = 0, which is where GL puts the first row it is given
+                submitted = textureWorkers.Submit(data, size, scene->Asset, false);
+                pendingImportTextures[submitted].Key = key;
+            }
+            else {
+                Log("Image " + std::to_string(image) + " of " + path + " skipped: " + error);
+            }
+            ticket = tickets.emplace(image, submitted).first;
+        }
+        if (ticket->second != 0) {
+            pendingImportTextures[ticket->second].Objects.push_back(imported.FirstObject + i);
+        }
+    }
+
+    const GltfImportStats& stats = scene->Stats;
+    const GltfAsset& asset = *scene->Asset;
+    double megabytes = asset.FileBytes / (1024.0 * 1024.0);
+    Log("Imported " + path + ": " + std::to_string(scene->Instances.size()) + " objects from " + std::to_string(asset.Nodes.size()) + " nodes, " +
+        std::to_string(stats.Primitives) + " meshes (" + std::to_string(stats.ZeroCopy) + " as stored, " + std::to_string(stats.Converted) + " converted, " +
+        std::to_string(stats.Baked) + " with a baked rotation, " + std::to_string(stats.Skipped) + " skipped), " + std::to_string(tickets.size()) + " images decoding");
+    Log("  " + std::to_string(megabytes) + " MB in " + std::to_string(stats.TotalMs) + " ms (" + std::to_string(megabytes / (stats.TotalMs / 1000.0)) +
+        " MB/s): map " + std::to_string(asset.MapMs) + ", parse " + std::to_string(asset.ParseMs) + ", convert " + std::to_string(stats.ConvertMs) +
+        ", upload " + std::to_string(stats.UploadMs) + " ms");
+    if (!stats.FirstError.empty()) {
+        Log("  First skipped primitive: " + stats.FirstError);
+    }
+
+    imported.Scene = std::move(scene);
+    importedScenes.push_back(std::move(imported));
+    return true;
+}
+
+// Upload images the texture workers finished, within a per-frame budget so a large import does not stall a frame
+void UpdateImports() {
+    const double BUDGET_MS = 4.0;
+    auto start = std::chrono::high_resolution_clock::now();
+    DecodedImage image;
+    while (std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count() < BUDGET_MS &&
+        textureWorkers.Poll(image)) {
+        auto pending = pendingImportTextures.find(image.Ticket);
+        if (pending == pendingImportTextures.end()) {
+            continue;
+        }
+        if (!image.Pixels) {
+            Log("Failed to decode " + pending->second.Key + ": " + image.Error);
+            pendingImportTextures.erase(pending);
+            continue;
+        }
+
+        GpuHandle texture = GpuHandle::Create(gpuResources, GPU_TEXTURE, "Texture " + pending->second.Key);
+        glState.BindTexture(GL_TEXTURE_2D, texture.ID());
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, image.Width, image.Height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image.Pixels.get());
+        glGenerateMipmap(GL_TEXTURE_2D);
+        texture.SetBytes(EstimateTextureBytes(image.Width, image.Height, 4, true));
+
+        // Objects given another texture while this one decoded keep theirs
+        unsigned int textureID = texture.ID();
+        textureLibrary[pending->second.Key] = std::move(texture);
+        for (size_t index : pending->second.Objects) {
+            if (index < objects.size() && objects[index].textureID == 0) {
+                objects[index].textureID = textureID;
+            }
+        }
+        pendingImportTextures.erase(pending);
+        redraw.Request(REDRAW_ASYNC);
+    }
+    if (!pendingImportTextures.empty() && textureWorkers.Pending() > 0) {
+        redraw.Request(REDRAW_ASYNC);
+    }
+    importTexturesMs += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+// Write a 1 GB GLB to the temp directory and time importing it, including the driver finishing the uploads
+void BenchmarkGltfImport() {
+    std::string path = (std::filesystem::temp_directory_path() / "mixergl_import_benchmark.glb").string();
+    std::string error;
+    auto start = std::chrono::high_resolution_clock::now();
+    if (!WriteBenchmarkGlb(path, size_t(1) << 30, error)) {
+        Log("Import benchmark failed: " + error);
+        return;
+    }
+    double writeMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+    // The file was just written, so most of it is still in the page cache; this measures the importer, not the disk
+    start = std::chrono::high_resolution_clock::now();
+    {
+        GltfScene scene(gpuResources, glState);
+        if (!scene.Load(path, jobs, error)) {
+            Log("Import benchmark failed: " + error);
+        }
+        else {
+            glFinish();
+            double totalMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+            const GltfImportStats& stats = scene.Stats;
+            double megabytes = scene.Asset->FileBytes / (1024.0 * 1024.0);
+            Log("Import benchmark: " + std::to_string(megabytes) + " MB written in " + std::to_string(writeMs) + " ms, imported in " +
+                std::to_string(totalMs) + " ms (" + std::to_string(megabytes / (totalMs / 1000.0)) + " MB/s) on " + std::to_string(jobs.GetThreadCount()) + " threads");
+            Log("  map " + std::to_string(scene.Asset->MapMs) + ", parse " + std::to_string(scene.Asset->ParseMs) + ", convert " + std::to_string(stats.ConvertMs) +
+                ", upload " + std::to_string(stats.UploadMs) + ", GPU finish " + std::to_string(totalMs - stats.TotalMs) + " ms; " + std::to_string(stats.ZeroCopy) +
+                " meshes as stored (" + std::to_string(stats.ZeroCopyBytes / (1024 * 1024)) + " MB), " + std::to_string(stats.Converted) + " converted (" +
+                std::to_string(stats.ConvertedBytes / (1024 * 1024)) + " MB)");
+        }
+    }
+    std::error_code ignored;
+    std::filesystem::remove(path, ignored);
+}
+
+// Import window: file selection, statistics of the last import and the node hierarchy of every imported scene
+void RenderImport() {
+    ImGui::Begin("Import");
+
+    if (ImGui::Button("Browse")) {
+        const char* filters[] = { "*.glb", "*.gltf" };
+        const char* filePath = tinyfd_openFileDialog("Import glTF", "", 2, filters, "glTF 2.0", 0);
+        if (filePath) {
+            strncpy(importPath, filePath, sizeof(importPath) - 1);
+            importPath[sizeof(importPath) - 1] = '\0';
+        }
+    }
+    ImGui::SameLine();
+    ImGui::InputText("##importPath", importPath, IM_ARRAYSIZE(importPath));
+    if (ImGui::Button("Import") && importPath[0] != '\0') {
+        ImportGltf(importPath);
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Benchmark 1 GB")) {
+        BenchmarkGltfImport();
+    }
+    ImGui::Text("Texture workers: %zu images pending, %.1f ms uploading", textureWorkers.Pending(), importTexturesMs);
+
+    if (!importedScenes.empty()) {
+        const GltfScene& last = *importedScenes.back().Scene;
+        const GltfImportStats& stats = last.Stats;
+        ImGui::Separator();
+        ImGui::Text("Last: %.1f MB in %.1f ms", last.Asset->FileBytes / (1024.0 * 1024.0), stats.TotalMs);
+        ImGui::Text("Map %.2f ms, parse %.1f ms, convert %.1f ms, upload %.1f ms", last.Asset->MapMs, last.Asset->ParseMs, stats.ConvertMs, stats.UploadMs);
+        ImGui::Text("%zu meshes: %zu as stored (%.1f MB), %zu converted, %zu baked, %zu skipped", stats.Primitives, stats.ZeroCopy,
+            stats.ZeroCopyBytes / (1024.0 * 1024.0), stats.Converted, stats.Baked, stats.Skipped);
+    }
+
+    // Nodes as a tree with the objects they became as leaves; Shift-click extends the selection
+    for (size_t s = 0; s < importedScenes.size(); ++s) {
+        const ImportedScene& imported = importedScenes[s];
+        const GltfAsset& asset = *imported.Scene->Asset;
+        std::string sceneName = asset.Path.substr(asset.Path.find_last_of("/\\") + 1);
+        if (!ImGui::TreeNode(reinterpret_cast<void*>(s), "%s", sceneName.c_str())) {
+            continue;
+        }
+        std::function<void(int)> renderNode = [&](int node) {
+            const GltfNode& gltfNode = asset.Nodes[node];
+            std::string label = gltfNode.Name.empty() ? "Node " + std::to_string(node) : gltfNode.Name;
+            if (!ImGui::TreeNode(reinterpret_cast<void*>(static_cast<intptr_t>(node)), "%s", label.c_str())) {
+                return;
+            }
+            for (size_t index : imported.NodeObjects[node]) {
+                std::string objName = "Object " + std::to_string(index);
+                if (ImGui::Selectable(objName.c_str(), selection.Contains(index))) {
+                    SelectObject(static_cast<int>(index), ImGui::GetIO().KeyShift);
+                }
+            }
+            for (int child : gltfNode.Children) {
+                if (imported.Scene->Parents[child] == node) {
+                    renderNode(child);
+                }
+            }
+            ImGui::TreePop();
+        };
+        for (int root : asset.Roots) {
+            if (imported.Scene->Parents[root] < 0) {
+                renderNode(root);
+            }
+        }
+        ImGui::TreePop();
+    }
+
+    ImGui::End();
+}
+
+// Export description of the object array: every distinct mesh once, objects as instances of it. Objects with a
+// modifier stack export its result, everything else its base mesh.
+ExportScene BuildExportScene() {
+    std::unordered_map<const Mesh*, std::shared_ptr<const MeshData>> derived;
+    std::unordered_map<const Mesh*, bool> topDown;
+    for (const auto& [index, mods] : objectModifiers) {
+        const Mesh* mesh = objects[index].mesh;
+        if (mods.MeshKey != 0 && mods.Stack.Result() && mesh != mods.Base) {
+            derived[mesh] = mods.Stack.Result();
+            topDown[mesh] = FindImportedScene(mods.Base) != nullptr;
+        }
+    }
+
+    ExportScene scene;
+    std::unordered_map<const Mesh*, uint32_t> meshIndices;
+    std::vector<const Mesh*> meshes;
+    for (const Object& obj : objects) {
+        auto [it, added] = meshIndices.emplace(obj.mesh, static_cast<uint32_t>(meshes.size()));
+        if (added) {
+            meshes.push_back(obj.mesh);
+            auto flipped = topDown.find(obj.mesh);
+            scene.MeshNames.push_back(std::string(PrimitiveTypeName(obj.mesh->Desc.Type)) + " " + std::to_string(meshes.size() - 1));
+            scene.TopDownTexCoords.push_back(flipped != topDown.end() ? flipped->second : FindImportedScene(obj.mesh) != nullptr);
+        }
+        scene.Instances.push_back({ it->second, obj.position, obj.scale });
+    }
+
+    // The export runs on the job threads while the main thread waits in it, so nothing read here changes meanwhile
+    scene.ReadMesh = [meshes, derived](uint32_t index) {
+        auto found = derived.find(meshes[index]);
+        return found != derived.end() ? *found->second : BaseMeshData(meshes[index]);
+    };
+    return scene;
+}
+
+// Write every object to path, logging throughput and how far the export raised the process's peak memory
+bool ExportObjects(const std::string& path, Export_Format format) {
+    ExportScene scene = BuildExportScene();
+    std::string error;
+    exportPeakBeforeBytes = ProcessPeakResidentBytes();
+    bool exported = ExportToFile(scene, path, format, jobs, error, &exportStats);
+    exportPeakResidentBytes = ProcessPeakResidentBytes();
+    if (!exported) {
+        Log("Export to " + path + " failed: " + error);
+        return false;
+    }
+    double megabytes = exportStats.Bytes / (1024.0 * 1024.0);
+    Log("Exported " + std::to_string(exportStats.Instances) + " objects (" + std::to_string(exportStats.Meshes) + " meshes, " +
+        std::to_string(exportStats.InstancedMeshes) + " instanced) to " + path + ": " + std::to_string(megabytes) + " MB in " +
+        std::to_string(exportStats.TotalMs) + " ms (" + std::to_string(megabytes / (exportStats.TotalMs / 1000.0)) + " MB/s), peak memory " +
+        std::to_string(exportPeakResidentBytes / (1024 * 1024)) + " MB");
+    return true;
+}
+
+// Export a synthetic scene of about 1 GB of mesh data to the temp directory in the selected format. Meshes are
+// generated as the exporter asks for them, so the peak memory shows what the exporter itself holds.
+void BenchmarkExport() {
+    const uint32_t MESHES = 5632; // 64x64 UV spheres take about 183 KB each in glTF
+    ExportScene scene;
+    for (uint32_t m = 0; m < MESHES; ++m) {
+        scene.MeshNames.push_back("Sphere " + std::to_string(m));
+        scene.TopDownTexCoords.push_back(false);
+        // every fourth mesh is shared by eight objects, which glTF writes as one instanced node
+        uint32_t copies = m % 4 == 0 ? 8 : 1;
+        for (uint32_t c = 0; c < copies; ++c) {
+            scene.Instances.push_back({ m, glm::vec3(float(m % 64) * 2.0f, float(c) * 2.0f, float(m / 64) * 2.0f), glm::vec3(1.0f) });
+        }
+    }
+    scene.ReadMesh = [](uint32_t) { return GeneratePrimitive(PrimitiveDesc::UVSphere(64, 64)); };
+
+    Export_Format format = static_cast<Export_Format>(exportFormat);
+    std::string path = (std::filesystem::temp_directory_path() / (std::string("mixergl_export_benchmark") + ExportFormatExtension(format))).string();
+    std::string error;
+    exportPeakBeforeBytes = ProcessPeakResidentBytes();
+    bool exported = ExportToFile(scene, path, format, jobs, error, &exportStats);
+    exportPeakResidentBytes = ProcessPeakResidentBytes();
+    if (!exported) {
+        Log("Export benchmark failed: " + error);
+    }
+    else {
+        double megabytes = exportStats.Bytes / (1024.0 * 1024.0);
+        Log("Export benchmark (" + std::string(ExportFormatName(format)) + "): " + std::to_string(megabytes) + " MB in " + std::to_string(exportStats.TotalMs) +
+            " ms (" + std::to_string(megabytes / (exportStats.TotalMs / 1000.0)) + " MB/s) on " + std::to_string(jobs.GetThreadCount()) + " threads");
+        Log("  serialize " + std::to_string(exportStats.SerializeMs) + ", write " + std::to_string(exportStats.WriteMs) + " ms; at most " +
+            std::to_string(exportStats.PeakChunkBytes / (1024 * 1024)) + " MB buffered, process peak " + std::to_string(exportPeakBeforeBytes / (1024 * 1024)) +
+            " -> " + std::to_string(exportPeakResidentBytes / (1024 * 1024)) + " MB");
+    }
+    std::error_code ignored;
+    std::filesystem::remove(path, ignored);
+    if (format == EXPORT_GLTF) {
+        std::filesystem::remove(std::filesystem::path(path).replace_extension(".bin"), ignored);
+    }
+}
+
+// Export window: format, destination and statistics of the last export
+void RenderExport() {
+    ImGui::Begin("Export");
+
+    const char* formatNames[EXPORT_FORMAT_COUNT];
+    for (int f = 0; f < EXPORT_FORMAT_COUNT; ++f) {
+        formatNames[f] = ExportFormatName(static_cast<Export_Format>(f));
+    }
+    ImGui::Combo("Format", &exportFormat, formatNames, EXPORT_FORMAT_COUNT);
+    Export_Format format = static_cast<Export_Format>(exportFormat);
+
+    if (ImGui::Button("Browse")) {
+        std::string pattern = std::string("*") + ExportFormatExtension(format);
+        const char* filters[] = { pattern.c_str() };
+        const char* filePath = tinyfd_saveFileDialog("Export objects", "", 1, filters, ExportFormatName(format));
+        if (filePath) {
+            strncpy(exportPath, filePath, sizeof(exportPath) - 1);
+            exportPath[sizeof(exportPath) - 1] = '\0';
+        }
+    }
+    ImGui::SameLine();
+    ImGui::InputText("##exportPath", exportPath, IM_ARRAYSIZE(exportPath));
+    if (ImGui::Button("Export") && exportPath[0] != '\0') {
+        ExportObjects(exportPath, format);
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Benchmark 1 GB")) {
+        BenchmarkExport();
+    }
+
+    if (exportStats.TotalMs > 0.0) {
+        double megabytes = exportStats.Bytes / (1024.0 * 1024.0);
+        ImGui::Separator();
+        ImGui::Text("Last: %.1f MB in %.1f ms (%.0f MB/s)", megabytes, exportStats.TotalMs, megabytes / (exportStats.TotalMs / 1000.0));
+        ImGui::Text("Serialize %.1f ms, write %.1f ms", exportStats.SerializeMs, exportStats.WriteMs);
+        ImGui::Text("%zu objects, %zu meshes, %zu instanced", exportStats.Instances, exportStats.Meshes, exportStats.InstancedMeshes);
+        ImGui::Text("Buffered at most %.1f MB, process peak %.1f -> %.1f MB", exportStats.PeakChunkBytes / (1024.0 * 1024.0),
+            exportPeakBeforeBytes / (1024.0 * 1024.0), exportPeakResidentBytes / (1024.0 * 1024.0));
+    }
+
+    ImGui::End();
+}
+
+// Content key of the mesh an object draws: its modifier result, or else its base mesh
+uint64_t DrawnMeshKey(size_t index) {
+    auto mods = objectModifiers.find(static_cast<int>(index));
+    return mods != objectModifiers.end() && mods->second.MeshKey != 0 ? mods->second.MeshKey : BaseMeshKey(objects[index].mesh);
+}
+
+// Content key of everything the path tracer sees: each object's mesh, transform and color
+uint64_t TracedSceneKey() {
+    uint64_t key = HashCombine(5, objects.size());
+    for (size_t i = 0; i < objects.size(); ++i) {
+        const Object& obj = objects[i];
+        key = HashCombine(key, DrawnMeshKey(i));
+        float values[9] = { obj.position.x, obj.position.y, obj.position.z, obj.scale.x, obj.scale.y, obj.scale.z, obj.color.r, obj.color.g, obj.color.b };
+        for (float value : values) {
+            uint32_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            key = HashCombine(key, bits);
+        }
+    }
+    return key;
+}
+
+// Instances of the current objects over their meshes' BVHs. Meshes already traced are reused; the missing ones are
+// built in parallel, each from the modifier result the object draws or else its base mesh.
+void RebuildTracedScene() {
+    auto start = std::chrono::high_resolution_clock::now();
+    std::vector<uint64_t> keys(objects.size());
+    std::unordered_map<uint64_t, std::shared_ptr<const TracedMesh>> used;
+    std::vector<size_t> missing; // first object using each mesh to build
+    for (size_t i = 0; i < objects.size(); ++i) {
+        keys[i] = DrawnMeshKey(i);
+        if (used.count(keys[i]) != 0) {
+            continue;
+        }
+        auto cached = tracedMeshes.find(keys[i]);
+        used[keys[i]] = cached != tracedMeshes.end() ? cached->second : nullptr;
+        if (cached == tracedMeshes.end()) {
+            missing.push_back(i);
+        }
+    }
+
+    // The main thread waits here, so the meshes read on the jobs do not change meanwhile
+    std::vector<std::shared_ptr<TracedMesh>> built(missing.size());
+    jobs.ParallelFor(missing.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t m = begin; m < end; ++m) {
+            size_t index = missing[m];
+            auto mods = objectModifiers.find(static_cast<int>(index));
+            bool derived = mods != objectModifiers.end() && mods->second.MeshKey != 0 && mods->second.Stack.Result();
+            built[m] = std::make_shared<TracedMesh>();
+            built[m]->Build(derived ? *mods->second.Stack.Result() : BaseMeshData(objects[index].mesh), jobs);
+        }
+    });
+    for (size_t m = 0; m < missing.size(); ++m) {
+        used[keys[missing[m]]] = built[m];
+    }
+
+    std::shared_ptr<TracedScene> scene = std::make_shared<TracedScene>();
+    scene->Instances.reserve(objects.size());
+    for (size_t i = 0; i < objects.size(); ++i) {
+        const Object& obj = objects[i];
+        scene->Instances.push_back({ used[keys[i]], obj.position, obj.scale, glm::vec3(obj.color) });
+    }
+    scene->Build();
+    tracedMeshes = std::move(used);
+    tracedScene = scene;
+    tracedSceneGeneration++;
+    tracerMeshesBuilt = missing.size();
+    tracerSceneMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+// Rebuild the traced scene if the objects changed since it was built; true when it did
+bool SyncTracedScene() {
+    uint64_t key = TracedSceneKey();
+    if (tracedScene && key == tracedSceneKey) {
+        return false;
+    }
+    RebuildTracedScene();
+    tracedSceneKey = key;
+    return true;
+}
+
+// Restart the path tracer when the camera, the scene or a setting changed, and upload the tiles it finished
+void UpdatePathTracer() {
+    if (!pathTracerEnabled) {
+        return;
+    }
+    int width = std::max(1, static_cast<int>(framebufferWidth * tracerResolutionScale));
+    int height = std::max(1, static_cast<int>(framebufferHeight * tracerResolutionScale));
+    TracerCamera view;
+    view.Position = camera.Position;
+    view.Forward = camera.Front;
+    view.Right = camera.Right;
+    view.Up = camera.Up;
+    view.TanHalfFov = std::tan(glm::radians(camera.Zoom) * 0.5f);
+    view.Aspect = (float)SCR_WIDTH / (float)SCR_HEIGHT; // same as the raster projection
+
+    SyncTracedScene();
+    bool sceneChanged = tracedSceneGeneration != tracerSceneGeneration;
+    if (sceneChanged || !(view == tracedCamera) || !(tracerSettings == tracedSettings) || width != pathTracer.GetWidth() || height != pathTracer.GetHeight()) {
+        pathTracer.Restart(tracedScene, view, tracerSettings, width, height);
+        tracedCamera = view;
+        tracedSettings = tracerSettings;
+        tracerSceneGeneration = tracedSceneGeneration;
+    }
+
+    if (!pathTracer.CopyUpdated(tracerPixels)) {
+        return;
+    }
+    if (width != tracerTextureWidth || height != tracerTextureHeight) {
+        tracerTexture = GpuHandle::Create(gpuResources, GPU_TEXTURE, "Path tracer image");
+        glState.BindTexture(GL_TEXTURE_2D, tracerTexture.ID());
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        tracerTexture.SetBytes(EstimateTextureBytes(width, height, 4, false));
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        tracerFramebuffer = GpuHandle::Create(gpuResources, GPU_FRAMEBUFFER, "Path tracer framebuffer");
+        glState.BindFramebuffer(GL_FRAMEBUFFER, tracerFramebuffer.ID());
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, tracerTexture.ID(), 0);
+        glState.BindFramebuffer(GL_FRAMEBUFFER, 0);
+        tracerTextureWidth = width;
+        tracerTextureHeight = height;
+    }
+    glState.BindTexture(GL_TEXTURE_2D, tracerTexture.ID());
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, tracerPixels.data());
+}
+
+// Stretch the path traced image over the window
+void PresentPathTracer() {
+    if (tracerTextureWidth == 0) {
+        return;
+    }
+    glState.BindFramebuffer(GL_READ_FRAMEBUFFER, tracerFramebuffer.ID());
+    glState.BindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    glBlitFramebuffer(0, 0, tracerTextureWidth, tracerTextureHeight, 0, 0, framebufferWidth, framebufferHeight, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+    glState.BindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+// Path tracer window: preview toggle, lighting and progress
+void RenderPathTracer() {
+    ImGui::Begin("Path Tracer");
+
+    if (ImGui::Checkbox("Preview", &pathTracerEnabled) && !pathTracerEnabled) {
+        // drop the image and the BVHs; the next preview starts from scratch
+        pathTracer.Stop();
+        tracedScene.reset();
+        tracedMeshes.clear();
+        tracerFramebuffer.Reset();
+        tracerTexture.Reset();
+        tracerTextureWidth = 0;
+        tracerTextureHeight = 0;
+        tracerPixels.clear();
+    }
+    ImGui::SliderFloat("Resolution", &tracerResolutionScale, 0.125f, 1.0f, "%.3f");
+    ImGui::SliderInt("Bounces", &tracerSettings.MaxBounces, 0, 12);
+    int maxSamples = static_cast<int>(tracerSettings.MaxSamples);
+    if (ImGui::DragInt("Max samples", &maxSamples, 4.0f, 1, 65536)) {
+        tracerSettings.MaxSamples = static_cast<uint32_t>(std::max(maxSamples, 1));
+    }
+    ImGui::Checkbox("Ground plane", &tracerSettings.GroundPlane);
+    ImGui::DragFloat3("Sun direction", &tracerSettings.SunDirection.x, 0.01f, -1.0f, 1.0f);
+    ImGui::SliderFloat("Sun", &tracerSettings.SunIntensity, 0.0f, 10.0f);
+    ImGui::SliderFloat("Sky", &tracerSettings.SkyIntensity, 0.0f, 4.0f);
+    ImGui::SliderFloat("Exposure", &tracerSettings.Exposure, 0.1f, 4.0f);
+    if (glm::length(tracerSettings.SunDirection) < 1.0e-3f) {
+        tracerSettings.SunDirection = glm::vec3(0.0f, 1.0f, 0.0f);
+    }
+
+    if (pathTracerEnabled) {
+        TracerStats stats = pathTracer.GetStats();
+        ImGui::Separator();
+        ImGui::Text("%d x %d, %u / %u samples in %.1f s", pathTracer.GetWidth(), pathTracer.GetHeight(), stats.Samples, tracerSettings.MaxSamples, stats.ElapsedMs / 1000.0);
+        ImGui::Text("%.2f Mrays/s on %u threads, %.2f Mrays/s per core", stats.RaysPerSecond() / 1.0e6, stats.Threads, stats.RaysPerSecondPerCore() / 1.0e6);
+        if (tracedScene) {
+            ImGui::Text("%zu instances, %zu meshes (%zu built), scene %.1f ms, top level %.2f ms", tracedScene->Instances.size(), tracedMeshes.size(),
+                tracerMeshesBuilt, tracerSceneMs, tracedScene->BuildMs);
+        }
+    }
+
+    ImGui::End();
+}
+
+// Bake ambient occlusion for the objects an edit reached since the last bake, or for all of them
+void BakeOcclusion(bool incremental) {
+    auto start = std::chrono::high_resolution_clock::now();
+    SyncTracedScene();
+
+    // What each object's occlusion depends on: its mesh and transform, and the world bounds its own geometry covers
+    std::vector<AoBakeRecord> records(objects.size());
+    std::vector<uint64_t> meshKeys(objects.size());
+    for (size_t i = 0; i < objects.size(); ++i) {
+        const Object& obj = objects[i];
+        meshKeys[i] = DrawnMeshKey(i);
+        const TracedMesh& traced = *tracedMeshes[meshKeys[i]];
+        if (traced.Bvh.Nodes.empty()) {
+            continue; // nothing to bake, and nothing it occludes
+        }
+        uint64_t key = meshKeys[i];
+        float values[6] = { obj.position.x, obj.position.y, obj.position.z, obj.scale.x, obj.scale.y, obj.scale.z };
+        for (float value : values) {
+            uint32_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            key = HashCombine(key, bits);
+        }
+        glm::vec3 a = traced.Bvh.Nodes[0].Min * obj.scale + obj.position;
+        glm::vec3 b = traced.Bvh.Nodes[0].Max * obj.scale + obj.position;
+        records[i].Key = std::max<uint64_t>(key, 1);
+        records[i].Min = glm::min(a, b);
+        records[i].Max = glm::max(a, b);
+    }
+
+    std::vector<AoBakeRecord> previous;
+    previous.reserve(bakedOcclusion.size());
+    for (const BakedOcclusion& baked : bakedOcclusion) {
+        previous.push_back(baked.Record);
+    }
+    bool full = !incremental || bakedOcclusion.empty() || !(aoSettings == bakedAoSettings);
+    std::vector<size_t> affected = AffectedByEdit(full ? std::vector<AoBakeRecord>() : previous, records, aoSettings.Distance);
+
+    // Affected objects sharing a mesh bake from one CPU copy of it
+    std::unordered_map<uint64_t, std::shared_ptr<const MeshData>> meshData;
+    std::vector<AoBakeTarget> targets;
+    targets.reserve(affected.size());
+    for (size_t i : affected) {
+        std::shared_ptr<const MeshData>& data = meshData[meshKeys[i]];
+        if (!data) {
+            auto mods = objectModifiers.find(static_cast<int>(i));
+            bool derived = mods != objectModifiers.end() && mods->second.MeshKey != 0 && mods->second.Stack.Result();
+            data = derived ? mods->second.Stack.Result() : std::make_shared<const MeshData>(BaseMeshData(objects[i].mesh));
+        }
+        targets.push_back({ data, objects[i].position, objects[i].scale });
+    }
+    std::vector<std::vector<float>> values;
+    BakeAmbientOcclusion(*tracedScene, targets, aoSettings, jobs, values, &aoStats);
+
+    // The buffer is laid out again when an object's value count changed or objects were added
+    bool relayout = bakedOcclusion.size() != objects.size();
+    bakedOcclusion.resize(objects.size());
+    for (size_t t = 0; t < affected.size(); ++t) {
+        BakedOcclusion& baked = bakedOcclusion[affected[t]];
+        relayout = relayout || baked.Values.size() != values[t].size();
+        baked.MeshKey = meshKeys[affected[t]];
+        baked.VertexCount = objects[affected[t]].mesh->VertexCount;
+        baked.Values.resize(values[t].size());
+        for (size_t v = 0; v < values[t].size(); ++v) {
+            baked.Values[v] = static_cast<uint8_t>(std::lround(glm::clamp(values[t][v], 0.0f, 1.0f) * 255.0f));
+        }
+    }
+    for (size_t i = 0; i < objects.size(); ++i) {
+        if (records[i].Key == 0 && !bakedOcclusion[i].Values.empty()) {
+            bakedOcclusion[i].Values.clear();
+            relayout = true;
+        }
+        bakedOcclusion[i].Record = records[i];
+    }
+    UploadOcclusion(affected, relayout);
+
+    bakedAoSettings = aoSettings;
+    aoSceneKey = tracedSceneKey;
+    aoBakeMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    if (!affected.empty()) {
+        Log("Baked ambient occlusion of " + std::to_string(affected.size()) + " objects in " + std::to_string(static_cast<int>(aoBakeMs)) + " ms");
+    }
+}
+
+// Write the baked values to the occlusion buffer: all of them after a layout change, else only the changed objects' ranges
+void UploadOcclusion(const std::vector<size_t>& changed, bool relayout) {
+    aoUploadedBytes = 0;
+    if (relayout) {
+        std::vector<uint8_t> all;
+        for (BakedOcclusion& baked : bakedOcclusion) {
+            baked.Offset = all.size();
+            all.insert(all.end(), baked.Values.begin(), baked.Values.end());
+        }
+        GLint maxTexels = 0;
+        glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+        if (all.empty() || all.size() > static_cast<size_t>(maxTexels)) {
+            if (!all.empty()) {
+                Log("Ambient occlusion of " + std::to_string(all.size()) + " vertices exceeds the buffer texture limit of " + std::to_string(maxTexels));
+            }
+            occlusionTexture.Reset();
+            occlusionBuffer.Reset();
+            bakedOcclusion.clear();
+            return;
+        }
+        if (!occlusionBuffer.IsValid()) {
+            occlusionBuffer = GpuHandle::Create(gpuResources, GPU_BUFFER, "Baked occlusion");
+            occlusionTexture = GpuHandle::Create(gpuResources, GPU_TEXTURE, "Baked occlusion");
+        }
+        glState.BindBuffer(GL_TEXTURE_BUFFER, occlusionBuffer.ID());
+        glBufferData(GL_TEXTURE_BUFFER, all.size(), all.data(), GL_STATIC_DRAW);
+        occlusionBuffer.SetBytes(all.size());
+        glState.ActiveTexture(GL_TEXTURE0 + OCCLUSION_TEXTURE_UNIT);
+        glState.BindTexture(GL_TEXTURE_BUFFER, occlusionTexture.ID());
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_R8, occlusionBuffer.ID());
+        glState.ActiveTexture(GL_TEXTURE0);
+        aoUploadedBytes = all.size();
+        return;
+    }
+    glState.BindBuffer(GL_TEXTURE_BUFFER, occlusionBuffer.ID());
+    for (size_t i : changed) {
+        const BakedOcclusion& baked = bakedOcclusion[i];
+        if (!baked.Values.empty()) {
+            glBufferSubData(GL_TEXTURE_BUFFER, baked.Offset, baked.Values.size(), baked.Values.data());
+            aoUploadedBytes += baked.Values.size();
+        }
+    }
+}
+
+// Rebake after edits once they are done; a drag or stroke in progress waits for its release
+void UpdateOcclusion() {
+    if (!aoAutoRebake || bakedOcclusion.empty() || isDragging || sculpting) {
+        return;
+    }
+    if (TracedSceneKey() != aoSceneKey) {
+        BakeOcclusion(true);
+    }
+}
+
+// First value of an object's baked occlusion, or -1 when it has none for the mesh it draws now
+GLint ObjectOcclusionOffset(size_t index) {
+    if (index >= bakedOcclusion.size() || !occlusionTexture.IsValid()) {
+        return -1;
+    }
+    const BakedOcclusion& baked = bakedOcclusion[index];
+    if (baked.Values.empty() || baked.VertexCount != objects[index].mesh->VertexCount) {
+        return -1;
+    }
+    return static_cast<GLint>(baked.Offset);
+}
+
+// Ambient occlusion window: bake settings, rebakes and their cost
+void RenderOcclusion() {
+    ImGui::Begin("Bake AO");
+
+    ImGui::SliderInt("Rays", &aoSettings.Rays, 4, 512);
+    ImGui::SliderFloat("Distance", &aoSettings.Distance, 0.05f, 10.0f, "%.2f", ImGuiSliderFlags_Logarithmic);
+    ImGui::SliderInt("Denoise passes", &aoSettings.DenoisePasses, 0, 8);
+    ImGui::Checkbox("Ground plane", &aoSettings.GroundPlane);
+    ImGui::Checkbox("Rebake after edits", &aoAutoRebake);
+    if (ImGui::Button("Bake")) {
+        BakeOcclusion(false);
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Clear")) {
+        bakedOcclusion.clear();
+        occlusionTexture.Reset();
+        occlusionBuffer.Reset();
+    }
+
+    if (!bakedOcclusion.empty()) {
+        ImGui::Separator();
+        ImGui::Text("Last: %zu objects, %zu vertices, %.1f ms", aoStats.Objects, aoStats.Vertices, aoBakeMs);
+        double seconds = aoStats.TraceMs / 1000.0;
+        ImGui::Text("Trace %.1f ms (%.2f Mrays/s), denoise %.1f ms", aoStats.TraceMs, seconds > 0.0 ? aoStats.Rays / seconds / 1.0e6 : 0.0, aoStats.DenoiseMs);
+        ImGui::Text("Uploaded %.1f KB of %.1f KB", aoUploadedBytes / 1024.0, occlusionBuffer.GetBytes() / 1024.0);
+    }
+
+    ImGui::End();
+}
+
+// Index the asset directory from scratch; the views fill in again as the indexer hands entries over
+void RescanAssets() {
+    assetViews.clear();
+    assetTextureCount = 0;
+    assetLibrary->Rescan({ assetRoot });
+    assetGeneration = assetLibrary->GetGeneration();
+}
+
+// Take newly indexed entries, upload finished thumbnails and render waiting meshes, all within the frame budget
+void UpdateAssetBrowser() {
+    if (!assetLibrary) {
+        return;
+    }
+    assetFrame++;
+    if (assetLibrary->GetGeneration() != assetGeneration) {
+        assetViews.clear();
+        assetTextureCount = 0;
+        assetGeneration = assetLibrary->GetGeneration();
+    }
+    std::vector<AssetEntry> entries;
+    if (assetLibrary->TakeEntries(entries)) {
+        for (AssetEntry& entry : entries) {
+            AssetView view;
+            view.Entry = std::move(entry);
+            assetViews.push_back(std::move(view));
+        }
+        redraw.Request(REDRAW_ASYNC);
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    auto elapsedMs = [&]() { return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count(); };
+    auto upload = [&](size_t index, int width, int height, const std::vector<uint8_t>& pixels) {
+        AssetView& view = assetViews[index];
+        if (!view.Texture.IsValid()) {
+            assetTextureCount++;
+        }
+        view.Texture = GpuHandle::Create(gpuResources, GPU_TEXTURE, "Thumbnail " + view.Entry.Name);
+        glState.BindTexture(GL_TEXTURE_2D, view.Texture.ID());
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+        view.Texture.SetBytes(EstimateTextureBytes(width, height, 4, false));
+        view.Width = width;
+        view.Height = height;
+        view.State = THUMBNAIL_READY;
+    };
+
+    // Thumbnails of an older scan are dropped by the library, so every index here is current
+    bool busy = false;
+    AssetThumbnail thumbnail;
+    while (!(busy = elapsedMs() >= assetBudgetMs) && assetLibrary->PollThumbnail(thumbnail)) {
+        if (thumbnail.Entry >= assetViews.size()) {
+            continue;
+        }
+        if (thumbnail.Pixels.empty()) {
+            assetViews[thumbnail.Entry].State = THUMBNAIL_FAILED;
+            Log("No thumbnail for " + assetViews[thumbnail.Entry].Entry.Path + ": " + thumbnail.Error);
+            continue;
+        }
+        upload(thumbnail.Entry, thumbnail.Width, thumbnail.Height, thumbnail.Pixels);
+    }
+
+    AssetMeshJob job;
+    bool rendered = false;
+    std::vector<uint8_t> pixels;
+    glm::mat4 projection = viewProjection.GetMatrix(ThumbnailRenderer::FieldOfView(), 1.0f);
+    while (!busy && !(busy = elapsedMs() >= assetBudgetMs) && assetLibrary->PollMeshJob(job)) {
+        if (job.Entry >= assetViews.size()) {
+            continue;
+        }
+        GLDebugGroup group(glDebug, "Thumbnail");
+        thumbnailRenderer.Render(job.Mesh, AssetLibrary::THUMBNAIL_SIZE, projection, pixels);
+        upload(job.Entry, AssetLibrary::THUMBNAIL_SIZE, AssetLibrary::THUMBNAIL_SIZE, pixels);
+        assetLibrary->StoreRendered(job.Key, AssetLibrary::THUMBNAIL_SIZE, AssetLibrary::THUMBNAIL_SIZE, std::move(pixels));
+        assetMeshesRendered++;
+        rendered = true;
+    }
+    if (rendered) {
+        thumbnailRenderer.End(0, framebufferWidth, framebufferHeight);
+    }
+
+    // Drop the thumbnails out of view the longest; cells scrolled back to request them again from the disk cache
+    if (assetTextureCount > MAX_THUMBNAIL_TEXTURES) {
+        std::vector<size_t> unseen;
+        for (size_t i = 0; i < assetViews.size(); ++i) {
+            if (assetViews[i].Texture.IsValid() && assetViews[i].LastVisibleFrame + 1 < assetFrame) {
+                unseen.push_back(i);
+            }
+        }
+        size_t evict = std::min(unseen.size(), assetTextureCount - MAX_THUMBNAIL_TEXTURES);
+        std::nth_element(unseen.begin(), unseen.begin() + evict, unseen.end(), [](size_t a, size_t b) {
+            return assetViews[a].LastVisibleFrame < assetViews[b].LastVisibleFrame;
+        });
+        for (size_t e = 0; e < evict; ++e) {
+            AssetView& view = assetViews[unseen[e]];
+            view.Texture.Reset();
+            view.State = THUMBNAIL_NONE;
+            assetTextureCount--;
+        }
+    }
+
+    double ms = elapsedMs();
+    if (ms > 0.05) {
+        assetFrameMs = ms;
+    }
+    if (busy || rendered) {
+        redraw.Request(REDRAW_ASYNC); // more may be waiting than one frame's budget took
+    }
+}
+
+// Give the selected objects the texture at path, releasing textures nothing uses anymore
+void ApplyTextureToSelection(const std::string& path) {
+    strncpy(texturePath, path.c_str(), sizeof(texturePath) - 1);
+    texturePath[sizeof(texturePath) - 1] = '\0';
+    if (selection.Empty()) {
+        return;
+    }
+    unsigned int textureID = LoadTexture(path.c_str());
+    if (textureID == 0) {
+        Log("Failed to load texture: " + path);
+        return;
+    }
+    for (uint32_t index : selection.Indices()) {
+        unsigned int previousTexture = objects[index].textureID;
+        objects[index].textureID = textureID;
+        ReleaseTextureIfUnused(previousTexture);
+    }
+    Log("Applied texture " + path + " to " + std::to_string(selection.Count()) + " objects");
+}
+
+// Assets window: directory, filters and a thumbnail grid; clicking an image textures the selection, a mesh is imported
+void RenderAssetBrowser() {
+    ImGui::Begin("Assets");
+
+    if (ImGui::Button("Browse")) {
+        const char* folder = tinyfd_selectFolderDialog("Asset directory", assetRoot);
+        if (folder) {
+            strncpy(assetRoot, folder, sizeof(assetRoot) - 1);
+            assetRoot[sizeof(assetRoot) - 1] = '\0';
+            RescanAssets();
+        }
+    }
+    ImGui::SameLine();
+    ImGui::InputText("##assetRoot", assetRoot, IM_ARRAYSIZE(assetRoot));
+    ImGui::SameLine();
+    if (ImGui::Button("Rescan")) {
+        RescanAssets();
+    }
+    ImGui::InputText("Filter", assetFilter, IM_ARRAYSIZE(assetFilter));
+    const char* kinds[] = { "All", AssetKindName(ASSET_IMAGE), AssetKindName(ASSET_MESH) };
+    int kindChoice = assetKindFilter + 1;
+    if (ImGui::Combo("Kind", &kindChoice, kinds, IM_ARRAYSIZE(kinds))) {
+        assetKindFilter = kindChoice - 1;
+    }
+    ImGui::SliderFloat("Budget (ms/frame)", &assetBudgetMs, 0.5f, 16.0f, "%.1f");
+
+    AssetLibraryStats stats = assetLibrary->GetStats();
+    ImGui::Text("%zu assets%s, %zu thumbnails loaded, %zu waiting", assetViews.size(), stats.Indexing ? " (indexing)" : "", assetTextureCount, stats.Requested);
+    ImGui::Text("Cache hits %zu (%.1f ms reading), decoded %zu, rendered %zu, failed %zu", stats.CacheHits, stats.CacheReadMs, stats.Decoded, stats.Rendered, stats.Failed);
+    ImGui::Text("Hashed %.1f MB in %.1f ms, last busy frame %.2f ms", stats.HashedBytes / (1024.0 * 1024.0), stats.HashMs, assetFrameMs);
+    ImGui::Separator();
+
+    std::vector<size_t> shown;
+    shown.reserve(assetViews.size());
+    for (size_t i = 0; i < assetViews.size(); ++i) {
+        const AssetEntry& entry = assetViews[i].Entry;
+        if ((assetKindFilter < 0 || entry.Kind == assetKindFilter) && (assetFilter[0] == '\0' || entry.Name.find(assetFilter) != std::string::npos)) {
+            shown.push_back(i);
+        }
+    }
+
+    // Rows of cells; only the rows in view are laid out, and only their cells ask for thumbnails
+    const float cell = 96.0f;
+    ImGui::BeginChild("##assetGrid");
+    ImGuiStyle& style = ImGui::GetStyle();
+    ImVec2 button(cell + style.FramePadding.x * 2.0f, cell + style.FramePadding.y * 2.0f);
+    int columns = std::max(1, static_cast<int>((ImGui::GetContentRegionAvail().x + style.ItemSpacing.x) / (button.x + style.ItemSpacing.x)));
+    int rows = static_cast<int>((shown.size() + columns - 1) / columns);
+    ImGuiListClipper clipper;
+    clipper.Begin(rows, button.y + style.ItemSpacing.y + ImGui::GetTextLineHeightWithSpacing());
+    while (clipper.Step()) {
+        for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; ++row) {
+            for (int column = 0; column < columns; ++column) {
+                size_t slot = static_cast<size_t>(row) * columns + column;
+                if (slot >= shown.size()) {
+                    break;
+                }
+                size_t index = shown[slot];
+                AssetView& view = assetViews[index];
+                view.LastVisibleFrame = assetFrame;
+                if (view.State == THUMBNAIL_NONE) {
+                    assetLibrary->Request(index);
+                    view.State = THUMBNAIL_REQUESTED;
+                }
+
+                if (column > 0) {
+                    ImGui::SameLine(column * (button.x + style.ItemSpacing.x));
+                }
+                ImGui::BeginGroup();
+                ImGui::PushID(static_cast<int>(index));
+                bool clicked;
+                if (view.State == THUMBNAIL_READY) {
+                    // fit the thumbnail into the cell, keeping its aspect
+                    float scale = cell / static_cast<float>(std::max(view.Width, view.Height));
+                    ImVec2 size(view.Width * scale, view.Height * scale);
+                    ImVec2 origin = ImGui::GetCursorPos();
+                    ImGui::SetCursorPos(ImVec2(origin.x + (cell - size.x) * 0.5f, origin.y + (cell - size.y) * 0.5f));
+                    clicked = ImGui::ImageButton("##thumbnail", reinterpret_cast<ImTextureID>(static_cast<intptr_t>(view.Texture.ID())), size, ImVec2(0, 0), ImVec2(1, 1));
+                    ImGui::SetCursorPos(ImVec2(origin.x, origin.y + button.y + style.ItemSpacing.y));
+                }
+                else {
+                    clicked = ImGui::Button(view.State == THUMBNAIL_FAILED ? "?" : AssetKindName(view.Entry.Kind), button);
+                }
+                if (ImGui::IsItemHovered()) {
+                    ImGui::SetTooltip("%s\n%.1f KB\n%s", view.Entry.Path.c_str(), view.Entry.Bytes / 1024.0,
+                        view.Entry.Kind == ASSET_IMAGE ? "Click to texture the selection" : "Click to import");
+                }
+                std::string label = view.Entry.Name.size() > 14 ? view.Entry.Name.substr(0, 12) + ".." : view.Entry.Name;
+                ImGui::TextUnformatted(label.c_str());
+                ImGui::PopID();
+                ImGui::EndGroup();
+
+                if (clicked) {
+                    if (view.Entry.Kind == ASSET_IMAGE) {
+                        ApplyTextureToSelection(view.Entry.Path);
+                    }
+                    else {
+                        ImportGltf(view.Entry.Path);
+                    }
+                }
+            }
+        }
+    }
+    ImGui::EndChild();
+
+    ImGui::End();
+}
@@ -1,15 +1,24 @@
 #version 330 core
 in vec2 TexCoords;  // Texture coordinates from vertex shader
+in vec3 Normal;     // World-space normal from vertex shader
+in float Occlusion; // Baked ambient occlusion, 1 where nothing is baked
 uniform sampler2D texture1; // Texture sampler
 uniform bool useTexture;    // Boolean indicating whether to use texture or color
 uniform vec4 color;         // The color to use if not using texture
 out vec4 FragColor;         // Output color
 
+const vec3 LIGHT_DIRECTION = vec3(0.371391, 0.742781, 0.557086); // normalized, towards the light
+const float AMBIENT = 0.35;
+
 void main()
 {
+    vec4 baseColor;
     if (useTexture) {
-        FragColor = texture(texture1, TexCoords); // Sample the texture
+        baseColor = texture(texture1, TexCoords); // Sample the texture
     } else {
-        FragColor = color; // Use the specified color if no texture
+        baseColor = color; // Use the specified color if no texture
     }
+    // Two-sided Lambert so open meshes such as planes are lit from both sides
+    float diffuse = abs(dot(normalize(Normal), LIGHT_DIRECTION));
+    FragColor = vec4(baseColor.rgb * (AMBIENT + (1.0 - AMBIENT) * diffuse) * Occlusion, baseColor.a);
 }
\ No newline at end of file
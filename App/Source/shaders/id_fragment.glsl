@@ -0,0 +1,8 @@
+#version 330 core
+uniform int objectId;   // Object index + 1; 0 is the background
+out uint FragId;
+
+void main()
+{
+    FragId = uint(objectId);
+}
@@ -0,0 +1,14 @@
+#version 330 core
+in vec2 TexCoords;
+in vec3 Normal;
+in vec4 InstanceColor; // Color of the instance this fragment belongs to
+out vec4 FragColor;
+
+const vec3 LIGHT_DIRECTION = vec3(0.371391, 0.742781, 0.557086); // same light as fragment.glsl
+const float AMBIENT = 0.35;
+
+void main()
+{
+    float diffuse = abs(dot(normalize(Normal), LIGHT_DIRECTION));
+    FragColor = vec4(InstanceColor.rgb * (AMBIENT + (1.0 - AMBIENT) * diffuse), InstanceColor.a);
+}
\ No newline at end of file
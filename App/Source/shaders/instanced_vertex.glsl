@@ -0,0 +1,22 @@
+#version 330 core
+layout(location = 0) in vec3 aPos; // Position attribute
+layout(location = 1) in vec2 aTexCoords; // Texture coordinates attribute
+layout(location = 2) in vec3 aNormal; // Normal attribute
+layout(location = 3) in vec3 aInstancePosition; // Per-instance attributes, advanced once per instance
+layout(location = 4) in vec3 aInstanceScale;
+layout(location = 5) in vec4 aInstanceColor;
+
+out vec2 TexCoords;
+out vec3 Normal;
+out vec4 InstanceColor;
+
+uniform mat4 view;
+uniform mat4 projection;
+
+void main()
+{
+    TexCoords = aTexCoords;
+    Normal = aNormal / aInstanceScale; // inverse transpose of the per-instance scale
+    InstanceColor = aInstanceColor;
+    gl_Position = projection * view * vec4(aPos * aInstanceScale + aInstancePosition, 1.0);
+}
@@ -0,0 +1,62 @@
+// Particle simulation shared by the transform feedback and compute update shaders.
+// The loader puts the #version line in front of this file.
+// A particle is two vec4s: position + age, velocity + lifetime. It is dead once age >= lifetime.
+
+uniform float deltaTime;
+uniform uint seed;          // changes every step so respawned particles differ
+uniform uint capacity;
+uniform uint spawnStart;    // particles [spawnStart, spawnStart + spawnCount) modulo capacity respawn this step
+uniform uint spawnCount;
+
+uniform vec3 emitterPosition;
+uniform float emitterRadius;
+uniform vec3 emitterDirection;
+uniform float emitterSpread;    // 0 = straight along the direction, 1 = any direction
+uniform float speed;
+uniform float speedJitter;
+uniform vec2 lifetimeRange;
+uniform vec3 gravity;
+uniform float drag;
+
+uint hash(uint x) {
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+}
+
+float random01(inout uint state) {
+    state = hash(state);
+    return float(state) * (1.0 / 4294967295.0);
+}
+
+vec3 randomUnitVector(inout uint state) {
+    float z = random01(state) * 2.0 - 1.0;
+    float angle = random01(state) * 6.2831853;
+    float r = sqrt(max(0.0, 1.0 - z * z));
+    return vec3(r * cos(angle), r * sin(angle), z);
+}
+
+void simulate(uint index, inout vec4 posAge, inout vec4 velLife) {
+    uint offset = (index + capacity - spawnStart) % capacity;
+    if (offset < spawnCount) {
+        uint state = hash(index ^ seed);
+        vec3 direction = normalize(emitterDirection + emitterSpread * 2.0 * randomUnitVector(state) + vec3(0.0, 1e-5, 0.0));
+        float particleSpeed = speed * (1.0 + speedJitter * (random01(state) * 2.0 - 1.0));
+        vec3 position = emitterPosition + randomUnitVector(state) * emitterRadius * random01(state);
+        float lifetime = mix(lifetimeRange.x, lifetimeRange.y, random01(state));
+        posAge = vec4(position, 0.0);
+        velLife = vec4(direction * particleSpeed, lifetime);
+        return;
+    }
+
+    if (posAge.w >= velLife.w) {
+        return;
+    }
+
+    vec3 velocity = (velLife.xyz + gravity * deltaTime) / (1.0 + drag * deltaTime);
+    posAge = vec4(posAge.xyz + velocity * deltaTime, posAge.w + deltaTime);
+    velLife.xyz = velocity;
+}
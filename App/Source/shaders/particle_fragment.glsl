@@ -0,0 +1,18 @@
+#version 330 core
+in vec2 Corner;
+in float LifeFraction;
+out vec4 FragColor;
+
+uniform vec4 colorStart;
+uniform vec4 colorEnd;
+
+void main()
+{
+    // Soft round dot that fades over the particle's life
+    float falloff = 1.0 - dot(Corner, Corner);
+    if (falloff <= 0.0) {
+        discard;
+    }
+    vec4 color = mix(colorStart, colorEnd, LifeFraction);
+    FragColor = vec4(color.rgb, color.a * falloff);
+}
@@ -0,0 +1,22 @@
+// Compute update (GL 4.3+): particles are updated in place in the storage buffer
+layout(local_size_x = 256) in;
+
+struct Particle {
+    vec4 posAge;
+    vec4 velLife;
+};
+
+layout(std430, binding = 0) buffer Particles {
+    Particle particles[];
+};
+
+void main()
+{
+    uint index = gl_GlobalInvocationID.x;
+    if (index >= capacity) {
+        return;
+    }
+    Particle particle = particles[index];
+    simulate(index, particle.posAge, particle.velLife);
+    particles[index] = particle;
+}
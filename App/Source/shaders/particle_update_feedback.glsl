@@ -0,0 +1,15 @@
+// Transform feedback update (GL 3.3): one point per particle, results captured into the other buffer
+layout(location = 0) in vec4 aPosAge;
+layout(location = 1) in vec4 aVelLife;
+
+out vec4 outPosAge;
+out vec4 outVelLife;
+
+void main()
+{
+    vec4 posAge = aPosAge;
+    vec4 velLife = aVelLife;
+    simulate(uint(gl_VertexID), posAge, velLife);
+    outPosAge = posAge;
+    outVelLife = velLife;
+}
@@ -0,0 +1,28 @@
+#version 330 core
+layout(location = 0) in vec4 aPosAge;   // per instance: position, age
+layout(location = 1) in vec4 aVelLife;  // per instance: velocity, lifetime
+
+out vec2 Corner;
+out float LifeFraction;
+
+uniform mat4 view;
+uniform mat4 projection;
+uniform float size;
+
+void main()
+{
+    // Dead particles are moved outside the clip volume
+    if (aPosAge.w >= aVelLife.w) {
+        gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+        Corner = vec2(0.0);
+        LifeFraction = 1.0;
+        return;
+    }
+
+    // Camera facing quad from the vertex index of a 4 vertex strip
+    Corner = vec2(gl_VertexID & 1, gl_VertexID >> 1) * 2.0 - 1.0;
+    LifeFraction = aPosAge.w / aVelLife.w;
+    vec4 viewPosition = view * vec4(aPosAge.xyz, 1.0);
+    viewPosition.xy += Corner * size;
+    gl_Position = projection * viewPosition;
+}
@@ -0,0 +1,76 @@
+#version 400 core
+layout(vertices = 3) out;
+
+in vec3 ControlPosition[];
+in vec2 ControlTexCoords[];
+in vec3 ControlNormal[];
+in float ControlOcclusion[];
+
+out vec3 PatchPosition[];
+out vec2 PatchTexCoords[];
+out vec3 PatchNormal[];
+out float PatchOcclusion[];
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+uniform vec2 viewportSize;   // in pixels
+uniform float pixelsPerEdge; // target projected length of a tessellated edge
+uniform float maxLevel;
+
+const float CULL_MARGIN = 1.2; // the curved patch bulges past its flat triangle
+
+vec4 project(vec3 position)
+{
+    return projection * view * model * vec4(position, 1.0);
+}
+
+// Projected length of the edge divided by the target length; an edge crossing the camera plane gets the
+// maximum level, since its projection means nothing
+float edgeLevel(vec4 a, vec4 b)
+{
+    if (a.w <= 0.0 || b.w <= 0.0) {
+        return maxLevel;
+    }
+    vec2 screenA = a.xy / a.w * 0.5 * viewportSize;
+    vec2 screenB = b.xy / b.w * 0.5 * viewportSize;
+    return clamp(distance(screenA, screenB) / pixelsPerEdge, 1.0, maxLevel);
+}
+
+// True when all three corners lie beyond the same side plane of the view
+bool outsideView(vec4 a, vec4 b, vec4 c)
+{
+    vec3 x = vec3(a.x, b.x, c.x);
+    vec3 y = vec3(a.y, b.y, c.y);
+    vec3 w = vec3(a.w, b.w, c.w) * CULL_MARGIN;
+    return all(greaterThan(x, w)) || all(lessThan(x, -w)) || all(greaterThan(y, w)) || all(lessThan(y, -w)) || all(lessThanEqual(w, vec3(0.0)));
+}
+
+void main()
+{
+    PatchPosition[gl_InvocationID] = ControlPosition[gl_InvocationID];
+    PatchTexCoords[gl_InvocationID] = ControlTexCoords[gl_InvocationID];
+    PatchNormal[gl_InvocationID] = ControlNormal[gl_InvocationID];
+    PatchOcclusion[gl_InvocationID] = ControlOcclusion[gl_InvocationID];
+
+    if (gl_InvocationID == 0) {
+        vec4 a = project(ControlPosition[0]);
+        vec4 b = project(ControlPosition[1]);
+        vec4 c = project(ControlPosition[2]);
+        if (outsideView(a, b, c)) {
+            // a zero outer level discards the patch
+            gl_TessLevelOuter[0] = 0.0;
+            gl_TessLevelOuter[1] = 0.0;
+            gl_TessLevelOuter[2] = 0.0;
+            gl_TessLevelInner[0] = 0.0;
+        }
+        else {
+            // outer level i belongs to the edge opposite corner i; shared edges get the same level from both
+            // patches, so no cracks open between them
+            gl_TessLevelOuter[0] = edgeLevel(b, c);
+            gl_TessLevelOuter[1] = edgeLevel(c, a);
+            gl_TessLevelOuter[2] = edgeLevel(a, b);
+            gl_TessLevelInner[0] = max(gl_TessLevelOuter[0], max(gl_TessLevelOuter[1], gl_TessLevelOuter[2]));
+        }
+    }
+}
@@ -0,0 +1,54 @@
+#version 400 core
+layout(triangles, fractional_odd_spacing, ccw) in;
+
+in vec3 PatchPosition[];
+in vec2 PatchTexCoords[];
+in vec3 PatchNormal[];
+in float PatchOcclusion[];
+
+out vec2 TexCoords; // Pass the texture coordinates to the fragment shader
+out vec3 Normal; // World-space normal
+out float Occlusion; // Baked ambient occlusion
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+
+// Control point a third of the way from corner i towards corner j, moved onto the tangent plane at i
+vec3 edgeControl(int i, int j)
+{
+    vec3 from = PatchPosition[i];
+    vec3 to = PatchPosition[j];
+    return (2.0 * from + to - dot(to - from, PatchNormal[i]) * PatchNormal[i]) / 3.0;
+}
+
+// Cubic PN triangle (Vlachos et al.) through the three corners
+void main()
+{
+    float u = gl_TessCoord.x;
+    float v = gl_TessCoord.y;
+    float w = gl_TessCoord.z;
+
+    vec3 b300 = PatchPosition[0];
+    vec3 b030 = PatchPosition[1];
+    vec3 b003 = PatchPosition[2];
+    vec3 b210 = edgeControl(0, 1);
+    vec3 b120 = edgeControl(1, 0);
+    vec3 b021 = edgeControl(1, 2);
+    vec3 b012 = edgeControl(2, 1);
+    vec3 b102 = edgeControl(2, 0);
+    vec3 b201 = edgeControl(0, 2);
+    vec3 edges = (b210 + b120 + b021 + b012 + b102 + b201) / 6.0;
+    vec3 corners = (b300 + b030 + b003) / 3.0;
+    vec3 b111 = edges + (edges - corners) * 0.5;
+
+    vec3 position = b300 * u * u * u + b030 * v * v * v + b003 * w * w * w
+        + 3.0 * (b210 * u * u * v + b120 * u * v * v + b201 * u * u * w + b021 * v * v * w + b102 * u * w * w + b012 * v * w * w)
+        + 6.0 * b111 * u * v * w;
+
+    TexCoords = u * PatchTexCoords[0] + v * PatchTexCoords[1] + w * PatchTexCoords[2];
+    Occlusion = u * PatchOcclusion[0] + v * PatchOcclusion[1] + w * PatchOcclusion[2];
+    vec3 normal = normalize(u * PatchNormal[0] + v * PatchNormal[1] + w * PatchNormal[2]);
+    Normal = transpose(inverse(mat3(model))) * normal; // scaling must not tilt the normals
+    gl_Position = projection * view * model * vec4(position, 1.0);
+}
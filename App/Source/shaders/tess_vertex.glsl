@@ -0,0 +1,21 @@
+#version 400 core
+layout(location = 0) in vec3 aPos; // Position attribute
+layout(location = 1) in vec2 aTexCoords; // Texture coordinates attribute
+layout(location = 2) in vec3 aNormal; // Normal attribute
+
+// Patch corners stay in object space; the curved surface is built before the model transform
+out vec3 ControlPosition;
+out vec2 ControlTexCoords;
+out vec3 ControlNormal;
+out float ControlOcclusion;
+
+uniform samplerBuffer occlusion; // Baked per-vertex occlusion, see vertex.glsl
+uniform int occlusionOffset;
+
+void main()
+{
+    ControlPosition = aPos;
+    ControlTexCoords = aTexCoords;
+    ControlNormal = normalize(aNormal);
+    ControlOcclusion = occlusionOffset < 0 ? 1.0 : texelFetch(occlusion, occlusionOffset + gl_VertexID).r;
+}
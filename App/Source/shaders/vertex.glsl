@@ -1,15 +1,22 @@
 #version 330 core
 layout(location = 0) in vec3 aPos; // Position attribute
 layout(location = 1) in vec2 aTexCoords; // Texture coordinates attribute
+layout(location = 2) in vec3 aNormal; // Normal attribute
 
 out vec2 TexCoords; // Pass the texture coordinates to the fragment shader
+out vec3 Normal; // World-space normal
+out float Occlusion; // Baked ambient occlusion, 1 when none is baked
 
 uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
+uniform samplerBuffer occlusion; // Baked per-vertex occlusion of all objects, one value per vertex
+uniform int occlusionOffset;     // First value of this object's vertices, -1 when it has none
 
 void main()
 {
     TexCoords = aTexCoords;
+    Normal = transpose(inverse(mat3(model))) * aNormal; // scaling must not tilt the normals
+    Occlusion = occlusionOffset < 0 ? 1.0 : texelFetch(occlusion, occlusionOffset + gl_VertexID).r;
     gl_Position = projection * view * model * vec4(aPos, 1.0);
 }
@@ -10,6 +10,16 @@ workspace "MixerGL"
 
 OutputDir = "%{cfg.system}-%{cfg.architecture}/%{cfg.buildcfg}"
 
+-- Lua scripting is built when the Lua sources are in Vendor/Lua/lua (the setup scripts fetch them); without them Core
+-- builds its scripting stub
+WithLua = os.isfile("Vendor/Lua/lua/lapi.c")
+
+if WithLua then
+group "Dependencies"
+	include "Vendor/Lua/Build-Lua.lua"
+group ""
+end
+
 group "Core"
 	include "Core/Build-Core.lua"
 group ""
@@ -12,6 +12,12 @@ project "Core"
       "Source"
    }
 
+   -- Scripting runs on the vendored Lua 5.4 (Vendor/Lua), reached as <lua/lua.hpp>
+   if WithLua then
+      includedirs { "../Vendor/Lua" }
+      defines { "MIXERGL_WITH_LUA" }
+   end
+
    targetdir ("../Binaries/" .. OutputDir .. "/%{prj.name}")
    objdir ("../Binaries/Intermediates/" .. OutputDir .. "/%{prj.name}")
 
@@ -0,0 +1,283 @@
+#include "ao_baker.h"
+#include "ray_sampling.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <unordered_map>
+
+namespace
+{
+    const float PI = 3.14159265f;
+    const size_t VERTEX_GRAIN = 64;
+    const float SMOOTHING_SHARPNESS = 8.0f;     // power of the normal agreement a neighbour is weighted with
+
+    // cosine weighted directions around +z from a Hammersley set; each vertex turns them by its own angle, so
+    // neighbours sample different directions and the denoiser has independent noise to average
+    std::vector<glm::vec3> hemisphereSet(int count)
+    {
+        std::vector<glm::vec3> directions(count);
+        for (int i = 0; i < count; ++i)
+        {
+            uint32_t bits = static_cast<uint32_t>(i);
+            bits = (bits << 16u) | (bits >> 16u);
+            bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+            bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+            bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+            bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+            float u = (i + 0.5f) / count;
+            float v = bits * 2.3283064365386963e-10f;
+            float r = std::sqrt(u);
+            float phi = 2.0f * PI * v;
+            directions[i] = glm::vec3(r * std::cos(phi), r * std::sin(phi), std::sqrt(std::max(1.0f - u, 0.0f)));
+        }
+        return directions;
+    }
+
+    // share of the hemisphere above point that is open within distance
+    float traceVertex(const TracedScene& scene, const std::vector<glm::vec3>& directions, const AoBakeSettings& settings,
+        const glm::vec3& point, const glm::vec3& normal, uint32_t seed)
+    {
+        glm::vec3 t, b;
+        Tangents(normal, t, b);
+        float angle = (HashRandom(seed) >> 8) * (2.0f * PI / 16777216.0f);
+        glm::vec3 turnedT = t * std::cos(angle) + b * std::sin(angle);
+        glm::vec3 turnedB = glm::cross(normal, turnedT);
+        glm::vec3 origin = point + normal * SurfaceOffset(point);
+
+        int open = 0;
+        for (size_t first = 0; first < directions.size(); first += 4)
+        {
+            float x[4], y[4], z[4];
+            for (int lane = 0; lane < 4; ++lane)
+            {
+                const glm::vec3& local = directions[first + lane];
+                glm::vec3 direction = turnedT * local.x + turnedB * local.y + normal * local.z;
+                x[lane] = direction.x;
+                y[lane] = direction.y;
+                z[lane] = direction.z;
+            }
+            RayPacket packet;
+            packet.OriginX = Float4::Set1(origin.x);
+            packet.OriginY = Float4::Set1(origin.y);
+            packet.OriginZ = Float4::Set1(origin.z);
+            packet.DirectionX = Float4::Load(x);
+            packet.DirectionY = Float4::Load(y);
+            packet.DirectionZ = Float4::Load(z);
+            packet.Distance = Float4::Set1(settings.Distance);
+            packet.Active = 0xF;
+            packet.Prepare();
+            uint32_t instance[4];
+            int blocked = scene.IntersectPacket(packet, instance);
+            for (int lane = 0; lane < 4; ++lane)
+            {
+                bool ground = settings.GroundPlane && origin.y > 0.0f && y[lane] < 0.0f && -origin.y / y[lane] < settings.Distance;
+                if (!(blocked & (1 << lane)) && !ground)
+                    open++;
+            }
+        }
+        return float(open) / float(directions.size());
+    }
+
+    // neighbours of every vertex: along triangle edges, plus other vertices at the same position
+    void vertexNeighbours(const MeshData& mesh, std::vector<uint32_t>& first, std::vector<uint32_t>& neighbours)
+    {
+        size_t count = mesh.VertexCount();
+        std::vector<std::pair<uint32_t, uint32_t>> pairs;
+        pairs.reserve(mesh.Indices.size() * 2);
+        for (size_t t = 0; t + 2 < mesh.Indices.size(); t += 3)
+        {
+            for (int corner = 0; corner < 3; ++corner)
+            {
+                uint32_t a = mesh.Indices[t + corner];
+                uint32_t b = mesh.Indices[t + (corner + 1) % 3];
+                pairs.push_back({ a, b });
+                pairs.push_back({ b, a });
+            }
+        }
+        std::unordered_map<uint64_t, std::vector<uint32_t>> positions;
+        for (size_t v = 0; v < count; ++v)
+        {
+            const float* p = &mesh.Vertices[v * MeshData::STRIDE];
+            uint64_t key = 0;
+            for (int c = 0; c < 3; ++c)
+                key = key * 0x100000001B3ull ^ static_cast<uint64_t>(static_cast<int64_t>(std::llround(p[c] * 1.0e5f)));
+            positions[key].push_back(static_cast<uint32_t>(v));
+        }
+        for (const auto& [key, group] : positions)
+        {
+            for (uint32_t a : group)
+            {
+                for (uint32_t b : group)
+                {
+                    if (a != b)
+                        pairs.push_back({ a, b });
+                }
+            }
+        }
+        std::sort(pairs.begin(), pairs.end());
+        pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+
+        first.assign(count + 1, 0);
+        neighbours.resize(pairs.size());
+        for (size_t i = 0; i < pairs.size(); ++i)
+        {
+            first[pairs[i].first + 1]++;
+            neighbours[i] = pairs[i].second;
+        }
+        for (size_t v = 0; v < count; ++v)
+            first[v + 1] += first[v];
+    }
+
+    glm::vec3 vertexNormal(const MeshData& mesh, size_t v, const glm::vec3& scale)
+    {
+        const float* vertex = &mesh.Vertices[v * MeshData::STRIDE];
+        glm::vec3 normal = glm::vec3(vertex[5], vertex[6], vertex[7]) / scale;
+        float length = glm::length(normal);
+        return length > 1.0e-12f ? normal / length : glm::vec3(0.0f, 1.0f, 0.0f);
+    }
+
+    bool overlaps(const glm::vec3& minA, const glm::vec3& maxA, const glm::vec3& minB, const glm::vec3& maxB)
+    {
+        return minA.x <= maxB.x && minB.x <= maxA.x && minA.y <= maxB.y && minB.y <= maxA.y && minA.z <= maxB.z && minB.z <= maxA.z;
+    }
+}
+
+void BakeAmbientOcclusion(const TracedScene& scene, const std::vector<AoBakeTarget>& targets, const AoBakeSettings& settings, JobSystem& jobs,
+    std::vector<std::vector<float>>& out, AoBakeStats* stats)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    AoBakeStats local;
+    std::vector<glm::vec3> directions = hemisphereSet((std::max(settings.Rays, 4) + 3) / 4 * 4);
+
+    // every vertex of every target in one range, so small and large objects spread over the jobs alike
+    out.assign(targets.size(), std::vector<float>());
+    std::vector<size_t> firstVertex(targets.size() + 1, 0);
+    for (size_t t = 0; t < targets.size(); ++t)
+    {
+        size_t count = targets[t].Mesh ? targets[t].Mesh->VertexCount() : 0;
+        out[t].assign(count, 1.0f);
+        firstVertex[t + 1] = firstVertex[t] + count;
+    }
+    local.Objects = targets.size();
+    local.Vertices = firstVertex.back();
+
+    jobs.ParallelFor(local.Vertices, VERTEX_GRAIN, [&](size_t begin, size_t end)
+    {
+        size_t t = std::upper_bound(firstVertex.begin(), firstVertex.end(), begin) - firstVertex.begin() - 1;
+        for (size_t i = begin; i < end; ++i)
+        {
+            while (i >= firstVertex[t + 1])
+                t++;
+            const AoBakeTarget& target = targets[t];
+            size_t v = i - firstVertex[t];
+            const float* vertex = &target.Mesh->Vertices[v * MeshData::STRIDE];
+            glm::vec3 point = glm::vec3(vertex[0], vertex[1], vertex[2]) * target.Scale + target.Position;
+            out[t][v] = traceVertex(scene, directions, settings, point, vertexNormal(*target.Mesh, v, target.Scale), static_cast<uint32_t>(i));
+        }
+    });
+    local.Rays = uint64_t(local.Vertices) * directions.size();
+    local.TraceMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+    // targets sharing a mesh share its neighbour lists
+    auto denoiseStart = std::chrono::high_resolution_clock::now();
+    if (settings.DenoisePasses > 0)
+    {
+        std::unordered_map<const MeshData*, size_t> meshSlots;
+        std::vector<const MeshData*> meshes;
+        for (const AoBakeTarget& target : targets)
+        {
+            if (target.Mesh && meshSlots.emplace(target.Mesh.get(), meshes.size()).second)
+                meshes.push_back(target.Mesh.get());
+        }
+        std::vector<std::vector<uint32_t>> first(meshes.size()), neighbours(meshes.size());
+        jobs.ParallelFor(meshes.size(), 1, [&](size_t begin, size_t end)
+        {
+            for (size_t m = begin; m < end; ++m)
+                vertexNeighbours(*meshes[m], first[m], neighbours[m]);
+        });
+
+        jobs.ParallelFor(targets.size(), 1, [&](size_t begin, size_t end)
+        {
+            std::vector<float> smoothed;
+            std::vector<glm::vec3> normals;
+            for (size_t t = begin; t < end; ++t)
+            {
+                if (!targets[t].Mesh)
+                    continue;
+                const MeshData& mesh = *targets[t].Mesh;
+                size_t slot = meshSlots.at(&mesh);
+                normals.resize(mesh.VertexCount());
+                for (size_t v = 0; v < normals.size(); ++v)
+                    normals[v] = vertexNormal(mesh, v, targets[t].Scale);
+                std::vector<float>& values = out[t];
+                for (int pass = 0; pass < settings.DenoisePasses; ++pass)
+                {
+                    smoothed.resize(values.size());
+                    for (size_t v = 0; v < values.size(); ++v)
+                    {
+                        float sum = values[v];
+                        float weight = 1.0f;
+                        for (uint32_t n = first[slot][v]; n < first[slot][v + 1]; ++n)
+                        {
+                            uint32_t other = neighbours[slot][n];
+                            float w = std::pow(std::max(glm::dot(normals[v], normals[other]), 0.0f), SMOOTHING_SHARPNESS);
+                            sum += values[other] * w;
+                            weight += w;
+                        }
+                        smoothed[v] = sum / weight;
+                    }
+                    values.swap(smoothed);
+                }
+            }
+        });
+    }
+    local.DenoiseMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - denoiseStart).count();
+    local.TotalMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    if (stats != nullptr)
+        *stats = local;
+}
+
+std::vector<size_t> AffectedByEdit(const std::vector<AoBakeRecord>& baked, const std::vector<AoBakeRecord>& current, float distance)
+{
+    // bounds that changed: where edited objects were and where they are now
+    std::vector<std::pair<glm::vec3, glm::vec3>> changed;
+    std::vector<bool> affected(current.size(), false);
+    for (size_t i = 0; i < std::max(baked.size(), current.size()); ++i)
+    {
+        bool had = i < baked.size() && baked[i].Key != 0;
+        bool has = i < current.size() && current[i].Key != 0;
+        if (had && has && baked[i].Key == current[i].Key)
+            continue;
+        if (had)
+            changed.push_back({ baked[i].Min, baked[i].Max });
+        if (has)
+        {
+            changed.push_back({ current[i].Min, current[i].Max });
+            affected[i] = true;
+        }
+    }
+
+    std::vector<size_t> result;
+    if (changed.size() > current.size() / 2)
+    {
+        for (size_t i = 0; i < current.size(); ++i)
+        {
+            if (current[i].Key != 0)
+                result.push_back(i);
+        }
+        return result;
+    }
+    glm::vec3 reach(distance);
+    for (size_t i = 0; i < current.size(); ++i)
+    {
+        if (current[i].Key == 0)
+            continue;
+        for (size_t c = 0; c < changed.size() && !affected[i]; ++c)
+            affected[i] = overlaps(current[i].Min - reach, current[i].Max + reach, changed[c].first, changed[c].second);
+        if (affected[i])
+            result.push_back(i);
+    }
+    return result;
+}
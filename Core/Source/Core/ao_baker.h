@@ -0,0 +1,67 @@
+#ifndef AO_BAKER_H
+#define AO_BAKER_H
+
+#include "path_tracer.h"
+#include "primitives.h"
+#include "job_system.h"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+struct AoBakeSettings
+{
+    int Rays = 64;                  // per vertex, rounded up to a multiple of four
+    float Distance = 1.0f;          // occluders further away do not darken, in world units
+    int DenoisePasses = 2;
+    bool GroundPlane = true;        // the plane at y = 0 occludes, like in the path tracer
+
+    bool operator==(const AoBakeSettings& other) const
+    {
+        return Rays == other.Rays && Distance == other.Distance && DenoisePasses == other.DenoisePasses && GroundPlane == other.GroundPlane;
+    }
+};
+
+// an object to bake: its mesh in object space and where it sits in the scene
+struct AoBakeTarget
+{
+    std::shared_ptr<const MeshData> Mesh;
+    glm::vec3 Position = glm::vec3(0.0f);
+    glm::vec3 Scale = glm::vec3(1.0f);
+};
+
+// what a bake of one object depended on, to tell which objects a later edit reaches
+struct AoBakeRecord
+{
+    uint64_t Key = 0;               // mesh content and transform; 0 for objects that were not baked
+    glm::vec3 Min = glm::vec3(0.0f);
+    glm::vec3 Max = glm::vec3(0.0f);
+};
+
+struct AoBakeStats
+{
+    size_t Objects = 0;
+    size_t Vertices = 0;
+    uint64_t Rays = 0;
+    double TraceMs = 0.0;
+    double DenoiseMs = 0.0;
+    double TotalMs = 0.0;
+};
+
+// Per-vertex ambient occlusion of each target against the whole scene. Every vertex casts Rays cosine weighted
+// rays over the hemisphere around its normal, four at a time as one packet through the scene BVH, and keeps the
+// share that escapes within Distance; vertices are spread over the job system. Denoising then averages each vertex
+// with its mesh neighbours and the other vertices at its position, weighted by how alike their normals are, so
+// hard edges stay sharp while texture seams close. out receives one value per vertex and target, 1 where open.
+void BakeAmbientOcclusion(const TracedScene& scene, const std::vector<AoBakeTarget>& targets, const AoBakeSettings& settings, JobSystem& jobs,
+    std::vector<std::vector<float>>& out, AoBakeStats* stats = nullptr);
+
+// Objects a rebake has to cover: those whose record changed or that are new, and those whose bounds, grown by the
+// occlusion distance, reach the old or new bounds of a changed or removed one. Falls back to every object when
+// most of them changed.
+std::vector<size_t> AffectedByEdit(const std::vector<AoBakeRecord>& baked, const std::vector<AoBakeRecord>& current, float distance);
+
+#endif
@@ -0,0 +1,589 @@
+#include "asset_library.h"
+#include "gltf.h"
+#include "mapped_file.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <sstream>
+
+namespace
+{
+    const uint32_t CACHE_VERSION = 1;           // bump when thumbnails are made differently
+    const char THUMBNAIL_MAGIC[4] = { 'M', 'G', 'T', 'H' };
+    const size_t INDEX_BATCH = 256;             // entries handed over at once while indexing
+    const size_t MAX_DECODES_IN_FLIGHT = 8;     // so later requests are not stuck behind a long decoder queue
+
+    uint64_t mix(uint64_t value)
+    {
+        value ^= value >> 33;
+        value *= 0xFF51AFD7ED558CCDull;
+        value ^= value >> 33;
+        value *= 0xC4CEB9FE1A85EC53ull;
+        value ^= value >> 33;
+        return value;
+    }
+
+    // 64-bit hash of a file's bytes, four independent lanes of eight bytes so it runs near memory speed
+    uint64_t contentHash(const uint8_t* data, size_t size)
+    {
+        const uint64_t PRIME = 0x9E3779B97F4A7C15ull;
+        uint64_t lanes[4] = { PRIME, PRIME * 3, PRIME * 5, PRIME * 7 };
+        size_t offset = 0;
+        for (; offset + 32 <= size; offset += 32)
+        {
+            for (int lane = 0; lane < 4; ++lane)
+            {
+                uint64_t word;
+                std::memcpy(&word, data + offset + lane * 8, sizeof(word));
+                lanes[lane] = (lanes[lane] ^ word) * PRIME;
+                lanes[lane] ^= lanes[lane] >> 29;
+            }
+        }
+        uint64_t hash = size;
+        for (uint64_t lane : lanes)
+            hash = mix(hash ^ lane);
+        for (; offset < size; ++offset)
+            hash = (hash ^ data[offset]) * PRIME;
+        return mix(hash);
+    }
+
+    int64_t fileTime(const std::filesystem::directory_entry& entry, std::error_code& error)
+    {
+        return static_cast<int64_t>(entry.last_write_time(error).time_since_epoch().count());
+    }
+}
+
+const char* AssetKindName(Asset_Kind kind)
+{
+    switch (kind)
+    {
+    case ASSET_IMAGE: return "Image";
+    case ASSET_MESH: return "Mesh";
+    default: return "Unknown";
+    }
+}
+
+bool AssetKindFromPath(const std::string& path, Asset_Kind& kind)
+{
+    std::string extension = std::filesystem::path(path).extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    // what stb_image decodes, and what the glTF importer reads
+    static const char* images[] = { ".png", ".jpg", ".jpeg", ".tga", ".bmp", ".gif", ".psd", ".hdr", ".pic", ".pnm", ".ppm", ".pgm" };
+    for (const char* image : images)
+    {
+        if (extension == image)
+        {
+            kind = ASSET_IMAGE;
+            return true;
+        }
+    }
+    if (extension == ".glb" || extension == ".gltf")
+    {
+        kind = ASSET_MESH;
+        return true;
+    }
+    return false;
+}
+
+bool ReadThumbnailMesh(const std::string& path, MeshData& out, std::string& error, size_t maxTriangles)
+{
+    GltfAsset asset;
+    if (!asset.Load(path, error))
+        return false;
+    std::vector<glm::mat4> world;
+    std::vector<int> parents;
+    asset.WorldTransforms(world, parents);
+
+    out = MeshData();
+    MeshData primitive;
+    for (size_t node = 0; node < asset.Nodes.size() && out.Indices.size() / 3 < maxTriangles; ++node)
+    {
+        int mesh = asset.Nodes[node].Mesh;
+        // nodes outside the default scene keep a zero matrix
+        if (mesh < 0 || mesh >= static_cast<int>(asset.Meshes.size()) || world[node][3][3] == 0.0f)
+            continue;
+        glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(world[node])));
+        for (const GltfPrimitive& part : asset.Meshes[mesh].Primitives)
+        {
+            std::string skipped;
+            if (out.Indices.size() / 3 >= maxTriangles || !asset.ReadPrimitive(part, primitive, skipped))
+                continue;
+            unsigned int base = static_cast<unsigned int>(out.VertexCount());
+            for (size_t v = 0; v < primitive.VertexCount(); ++v)
+            {
+                float* vertex = &primitive.Vertices[v * MeshData::STRIDE];
+                glm::vec3 position = glm::vec3(world[node] * glm::vec4(vertex[0], vertex[1], vertex[2], 1.0f));
+                glm::vec3 normal = normalMatrix * glm::vec3(vertex[5], vertex[6], vertex[7]);
+                float length = glm::length(normal);
+                normal = length > 0.0f ? normal / length : glm::vec3(0.0f, 1.0f, 0.0f);
+                float converted[MeshData::STRIDE] = { position.x, position.y, position.z, vertex[3], vertex[4], normal.x, normal.y, normal.z };
+                out.Vertices.insert(out.Vertices.end(), converted, converted + MeshData::STRIDE);
+            }
+            for (unsigned int index : primitive.Indices)
+                out.Indices.push_back(base + index);
+        }
+    }
+    if (out.Indices.empty())
+    {
+        error = "no triangles to show";
+        return false;
+    }
+
+    glm::vec3 low(INFINITY), high(-INFINITY);
+    for (size_t v = 0; v < out.VertexCount(); ++v)
+    {
+        glm::vec3 position = glm::make_vec3(&out.Vertices[v * MeshData::STRIDE]);
+        low = glm::min(low, position);
+        high = glm::max(high, position);
+    }
+    glm::vec3 center = (low + high) * 0.5f;
+    float radius = glm::length(high - low) * 0.5f;
+    float scale = radius > 0.0f ? 1.0f / radius : 1.0f;
+    for (size_t v = 0; v < out.VertexCount(); ++v)
+    {
+        float* vertex = &out.Vertices[v * MeshData::STRIDE];
+        for (int c = 0; c < 3; ++c)
+            vertex[c] = (vertex[c] - center[c]) * scale;
+    }
+    return true;
+}
+
+AssetLibrary::AssetLibrary(const std::string& cacheDirectory, unsigned int decodeWorkers)
+    : cacheDirectory(cacheDirectory), decoder(decodeWorkers)
+{
+    std::error_code ignored;
+    std::filesystem::create_directories(cacheDirectory, ignored);
+    loadHashLog();
+    decoder.OnDecoded = [this]()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            decoded = true;
+        }
+        workWake.notify_one();
+    };
+    indexer = std::thread(&AssetLibrary::indexLoop, this);
+    worker = std::thread(&AssetLibrary::workLoop, this);
+}
+
+AssetLibrary::~AssetLibrary()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    indexWake.notify_all();
+    workWake.notify_all();
+    indexer.join();
+    worker.join();
+}
+
+void AssetLibrary::Rescan(const std::vector<std::string>& newRoots)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        roots = newRoots;
+        rootsChanged = true;
+        generation++;
+        entries.clear();
+        entriesTaken = 0;
+        requests.clear();
+        thumbnails.clear();
+        meshJobs.clear();
+        stats.Indexed = 0;
+        stats.Requested = 0;
+    }
+    indexWake.notify_one();
+}
+
+bool AssetLibrary::TakeEntries(std::vector<AssetEntry>& out)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (entriesTaken == entries.size())
+        return false;
+    out.insert(out.end(), entries.begin() + entriesTaken, entries.end());
+    entriesTaken = entries.size();
+    return true;
+}
+
+void AssetLibrary::Request(size_t entry)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        requests.push_back(entry);
+        stats.Requested = requests.size();
+    }
+    workWake.notify_one();
+}
+
+bool AssetLibrary::PollThumbnail(AssetThumbnail& out)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (thumbnails.empty())
+        return false;
+    out = std::move(thumbnails.front());
+    thumbnails.pop_front();
+    return true;
+}
+
+bool AssetLibrary::PollMeshJob(AssetMeshJob& out)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (meshJobs.empty())
+        return false;
+    out = std::move(meshJobs.front());
+    meshJobs.pop_front();
+    return true;
+}
+
+void AssetLibrary::StoreRendered(uint64_t key, int width, int height, std::vector<uint8_t> pixels)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        writes.push_back({ key, width, height, std::move(pixels) });
+    }
+    workWake.notify_one();
+}
+
+AssetLibraryStats AssetLibrary::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats;
+}
+
+void AssetLibrary::indexLoop()
+{
+    for (;;)
+    {
+        std::vector<std::string> scan;
+        uint64_t forGeneration;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            indexWake.wait(lock, [this]() { return stopping || rootsChanged; });
+            if (stopping)
+                return;
+            scan = roots;
+            rootsChanged = false;
+            forGeneration = generation;
+            stats.Indexing = true;
+        }
+
+        // hands a batch over; false once a newer scan or shutdown made this one pointless
+        auto start = std::chrono::high_resolution_clock::now();
+        std::vector<AssetEntry> batch;
+        auto flush = [&]()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (stopping || generation != forGeneration)
+                    return false;
+                entries.insert(entries.end(), batch.begin(), batch.end());
+                stats.Indexed = entries.size();
+            }
+            batch.clear();
+            if (OnReady)
+                OnReady();
+            return true;
+        };
+
+        bool current = true;
+        for (size_t r = 0; r < scan.size() && current; ++r)
+        {
+            std::error_code error;
+            std::filesystem::recursive_directory_iterator it(scan[r], std::filesystem::directory_options::skip_permission_denied, error);
+            for (; !error && it != std::filesystem::recursive_directory_iterator() && current; it.increment(error))
+            {
+                std::error_code fileError;
+                AssetEntry entry;
+                if (!it->is_regular_file(fileError) || !AssetKindFromPath(it->path().string(), entry.Kind))
+                    continue;
+                entry.Path = it->path().string();
+                entry.Name = it->path().filename().string();
+                entry.Bytes = it->file_size(fileError);
+                entry.Modified = fileTime(*it, fileError);
+                if (fileError)
+                    continue;
+                batch.push_back(std::move(entry));
+                if (batch.size() >= INDEX_BATCH)
+                    current = flush();
+            }
+        }
+        if (current)
+            flush();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (generation == forGeneration)
+        {
+            stats.Indexing = false;
+            stats.IndexMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        }
+    }
+}
+
+void AssetLibrary::workLoop()
+{
+    for (;;)
+    {
+        PendingWrite write;
+        bool hasWrite = false;
+        bool poll = false;
+        bool hasRequest = false;
+        size_t entry = 0;
+        AssetEntry asset;
+        uint64_t forGeneration;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            workWake.wait(lock, [this]()
+            {
+                return stopping || !writes.empty() || decoded || (!requests.empty() && decodes.size() < MAX_DECODES_IN_FLIGHT);
+            });
+            if (stopping)
+                return;
+            forGeneration = generation;
+            // decodes still running for an older scan are forgotten; their results find no ticket and are dropped
+            if (decodesGeneration != forGeneration)
+            {
+                decodes.clear();
+                decodesGeneration = forGeneration;
+            }
+            if (!writes.empty())
+            {
+                write = std::move(writes.front());
+                writes.pop_front();
+                hasWrite = true;
+            }
+            else if (decoded)
+            {
+                decoded = false;
+                poll = true;
+            }
+            else
+            {
+                entry = requests.back();
+                requests.pop_back();
+                stats.Requested = requests.size();
+                if (entry < entries.size())
+                {
+                    asset = entries[entry];
+                    hasRequest = true;
+                }
+            }
+        }
+
+        if (hasWrite)
+        {
+            writeThumbnail(write);
+            std::lock_guard<std::mutex> lock(mutex);
+            stats.Rendered++;
+        }
+        DecodedImage image;
+        while (poll && decoder.Poll(image))
+            finishDecode(image);
+        if (hasRequest)
+            serve(entry, asset, forGeneration);
+    }
+}
+
+void AssetLibrary::serve(size_t entry, const AssetEntry& asset, uint64_t forGeneration)
+{
+    AssetThumbnail thumbnail;
+    thumbnail.Entry = entry;
+    uint64_t key = 0;
+    if (!contentKey(asset, key))
+    {
+        thumbnail.Error = "cannot be read";
+        publish(std::move(thumbnail), forGeneration);
+        return;
+    }
+    if (readThumbnail(key, thumbnail))
+    {
+        thumbnail.Cached = true;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stats.CacheHits++;
+        }
+        publish(std::move(thumbnail), forGeneration);
+        return;
+    }
+
+    if (asset.Kind == ASSET_IMAGE)
+    {
+        // the mapping stays alive until the decoder is done with it
+        std::shared_ptr<MappedFile> file = std::make_shared<MappedFile>();
+        if (!file->Open(asset.Path))
+        {
+            thumbnail.Error = "cannot be read";
+            publish(std::move(thumbnail), forGeneration);
+            return;
+        }
+        const uint8_t* data = file->Data();
+        size_t size = file->Size();
+        uint64_t ticket = decoder.Submit(data, size, std::move(file), false, THUMBNAIL_SIZE);
+        decodes[ticket] = { entry, key, forGeneration };
+        return;
+    }
+
+    AssetMeshJob job;
+    job.Entry = entry;
+    job.Key = key;
+    if (!ReadThumbnailMesh(asset.Path, job.Mesh, thumbnail.Error))
+    {
+        publish(std::move(thumbnail), forGeneration);
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (generation != forGeneration)
+            return;
+        meshJobs.push_back(std::move(job));
+    }
+    if (OnReady)
+        OnReady();
+}
+
+bool AssetLibrary::contentKey(const AssetEntry& asset, uint64_t& key)
+{
+    uint64_t hash;
+    auto known = knownHashes.find(asset.Path);
+    if (known != knownHashes.end() && known->second.Bytes == asset.Bytes && known->second.Modified == asset.Modified)
+    {
+        hash = known->second.Hash;
+    }
+    else
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        MappedFile file;
+        if (!file.Open(asset.Path))
+            return false;
+        hash = contentHash(file.Data(), file.Size());
+        knownHashes[asset.Path] = { asset.Bytes, asset.Modified, hash };
+        if (hashLog)
+            hashLog << std::hex << hash << std::dec << ' ' << asset.Bytes << ' ' << asset.Modified << ' ' << asset.Path << '\n' << std::flush;
+        std::lock_guard<std::mutex> lock(mutex);
+        stats.HashedBytes += file.Size();
+        stats.HashMs += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+    key = mix(hash ^ mix((uint64_t(CACHE_VERSION) << 40) ^ (uint64_t(THUMBNAIL_SIZE) << 8) ^ uint64_t(asset.Kind)));
+    return true;
+}
+
+// publishes under the generation the decode was submitted for, so a scan that started meanwhile drops it
+void AssetLibrary::finishDecode(DecodedImage& image)
+{
+    auto pending = decodes.find(image.Ticket);
+    if (pending == decodes.end())
+        return;
+    AssetThumbnail thumbnail;
+    thumbnail.Entry = pending->second.Entry;
+    uint64_t key = pending->second.Key;
+    uint64_t forGeneration = pending->second.Generation;
+    decodes.erase(pending);
+    if (!image.Pixels)
+    {
+        thumbnail.Error = image.Error;
+        publish(std::move(thumbnail), forGeneration);
+        return;
+    }
+    thumbnail.Width = image.Width;
+    thumbnail.Height = image.Height;
+    thumbnail.Pixels.assign(image.Pixels.get(), image.Pixels.get() + size_t(image.Width) * image.Height * 4);
+    writeThumbnail({ key, thumbnail.Width, thumbnail.Height, thumbnail.Pixels });
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stats.Decoded++;
+    }
+    publish(std::move(thumbnail), forGeneration);
+}
+
+void AssetLibrary::publish(AssetThumbnail thumbnail, uint64_t forGeneration)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (generation != forGeneration)
+            return;
+        if (thumbnail.Pixels.empty())
+            stats.Failed++;
+        thumbnails.push_back(std::move(thumbnail));
+    }
+    if (OnReady)
+        OnReady();
+}
+
+// thumbnails are spread over subdirectories named by the first byte of their key
+std::string AssetLibrary::thumbnailPath(uint64_t key) const
+{
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(key));
+    return (std::filesystem::path(cacheDirectory) / std::string(name, 2) / (std::string(name) + ".thumb")).string();
+}
+
+bool AssetLibrary::readThumbnail(uint64_t key, AssetThumbnail& out)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    std::ifstream file(thumbnailPath(key), std::ios::binary);
+    if (!file)
+        return false;
+    char magic[4];
+    int32_t size[2];
+    if (!file.read(magic, sizeof(magic)) || std::memcmp(magic, THUMBNAIL_MAGIC, sizeof(magic)) != 0 || !file.read(reinterpret_cast<char*>(size), sizeof(size)) ||
+        size[0] <= 0 || size[1] <= 0 || size[0] > THUMBNAIL_SIZE || size[1] > THUMBNAIL_SIZE)
+        return false;
+    out.Width = size[0];
+    out.Height = size[1];
+    out.Pixels.resize(size_t(out.Width) * out.Height * 4);
+    if (!file.read(reinterpret_cast<char*>(out.Pixels.data()), out.Pixels.size()))
+    {
+        out.Pixels.clear();
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    stats.CacheReadMs += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    return true;
+}
+
+// written under a temporary name and renamed, so a reader never sees half a thumbnail
+void AssetLibrary::writeThumbnail(const PendingWrite& write) const
+{
+    std::string path = thumbnailPath(write.Key);
+    std::error_code error;
+    std::filesystem::create_directories(std::filesystem::path(path).parent_path(), error);
+    {
+        std::ofstream file(path + ".tmp", std::ios::binary | std::ios::trunc);
+        int32_t size[2] = { write.Width, write.Height };
+        file.write(THUMBNAIL_MAGIC, sizeof(THUMBNAIL_MAGIC));
+        file.write(reinterpret_cast<const char*>(size), sizeof(size));
+        file.write(reinterpret_cast<const char*>(write.Pixels.data()), write.Pixels.size());
+        if (!file)
+            return;
+    }
+    std::filesystem::rename(path + ".tmp", path, error);
+}
+
+// one line per hashed file: hash, size, time and path; later lines win
+void AssetLibrary::loadHashLog()
+{
+    std::string path = (std::filesystem::path(cacheDirectory) / "hashes.txt").string();
+    {
+        std::ifstream file(path);
+        std::string line;
+        while (std::getline(file, line))
+        {
+            std::istringstream fields(line);
+            KnownHash known;
+            std::string assetPath;
+            if (!(fields >> std::hex >> known.Hash >> std::dec >> known.Bytes >> known.Modified) || fields.get() != ' ' || !std::getline(fields, assetPath))
+                continue;
+            knownHashes[assetPath] = known;
+        }
+    }
+    hashLog.open(path, std::ios::app);
+}
@@ -0,0 +1,184 @@
+#ifndef ASSET_LIBRARY_H
+#define ASSET_LIBRARY_H
+
+#include "image_decoder.h"
+#include "primitives.h"
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <fstream>
+#include <cstdint>
+#include <cstddef>
+
+enum Asset_Kind
+{
+    ASSET_IMAGE,
+    ASSET_MESH,
+    ASSET_KIND_COUNT
+};
+
+const char* AssetKindName(Asset_Kind kind);
+
+// a file found under one of the indexed directories
+struct AssetEntry
+{
+    std::string Path;
+    std::string Name;           // file name, for display and filtering
+    Asset_Kind Kind = ASSET_IMAGE;
+    uint64_t Bytes = 0;
+    int64_t Modified = 0;       // file time, only compared for equality
+};
+
+// RGBA8 thumbnail pixels, top row first, at most AssetLibrary::THUMBNAIL_SIZE on the longer side
+struct AssetThumbnail
+{
+    size_t Entry = 0;
+    int Width = 0;
+    int Height = 0;
+    std::vector<uint8_t> Pixels;    // empty if the asset could not be read
+    std::string Error;
+    bool Cached = false;            // read from the disk cache instead of being made
+};
+
+// a mesh asset waiting for the GL thread to render its thumbnail; Key goes back with the pixels to StoreRendered
+struct AssetMeshJob
+{
+    size_t Entry = 0;
+    uint64_t Key = 0;
+    MeshData Mesh;              // every primitive in world space, centered and scaled to fit the unit sphere
+};
+
+struct AssetLibraryStats
+{
+    size_t Indexed = 0;
+    bool Indexing = false;
+    double IndexMs = 0.0;       // of the last completed scan
+    size_t Requested = 0;       // thumbnails waiting for the worker
+    size_t CacheHits = 0;
+    size_t Decoded = 0;         // images decoded and downscaled
+    size_t Rendered = 0;        // mesh thumbnails stored after rendering
+    size_t Failed = 0;
+    size_t HashedBytes = 0;     // read to address the cache; files seen before reuse their recorded hash
+    double HashMs = 0.0;
+    double CacheReadMs = 0.0;
+};
+
+// Background index of asset directories with a content-addressed thumbnail cache on disk. An indexer thread walks
+// the directories; entries are handed to the GL thread in batches with TakeEntries. Thumbnails are made on request
+// only, newest request first, so whatever is on screen comes first however many files there are. A thumbnail thread
+// hashes each file's content (reusing the hash recorded for an unchanged path, size and time) and reads the
+// thumbnail stored under that hash. On a miss, images are decoded and downscaled on the decoder's workers, and glTF
+// meshes are flattened into one mesh for the GL thread to render and hand back. Either way the result is written
+// to the cache, so the next visit reads every thumbnail straight from disk.
+class AssetLibrary
+{
+public:
+    static const int THUMBNAIL_SIZE = 128;
+
+    // called on a background thread when entries, thumbnails or mesh jobs become ready, e.g. to wake an idle main loop
+    std::function<void()> OnReady;
+
+    // cacheDirectory is created if missing
+    explicit AssetLibrary(const std::string& cacheDirectory, unsigned int decodeWorkers = 2);
+    ~AssetLibrary();
+
+    AssetLibrary(const AssetLibrary&) = delete;
+    AssetLibrary& operator=(const AssetLibrary&) = delete;
+
+    // forgets every entry and request and indexes roots from scratch; entry indices start again at 0
+    void Rescan(const std::vector<std::string>& roots);
+    // changes with every Rescan; results of an older one are dropped, so callers reset their view when it changes
+    uint64_t GetGeneration() const { return generation.load(); }
+
+    // appends entries indexed since the last call; false if there were none
+    bool TakeEntries(std::vector<AssetEntry>& out);
+
+    // asks for an entry's thumbnail; the latest request is served first
+    void Request(size_t entry);
+    bool PollThumbnail(AssetThumbnail& out);
+    bool PollMeshJob(AssetMeshJob& out);
+    // pixels the GL thread rendered for a mesh job, top row first; written to the cache on the thumbnail thread
+    void StoreRendered(uint64_t key, int width, int height, std::vector<uint8_t> pixels);
+
+    AssetLibraryStats GetStats() const;
+    const std::string& GetCacheDirectory() const { return cacheDirectory; }
+
+private:
+    struct KnownHash
+    {
+        uint64_t Bytes = 0;
+        int64_t Modified = 0;
+        uint64_t Hash = 0;
+    };
+
+    struct PendingDecode
+    {
+        size_t Entry = 0;
+        uint64_t Key = 0;
+        uint64_t Generation = 0;    // the entry index is only meaningful in the scan it was requested in
+    };
+
+    struct PendingWrite
+    {
+        uint64_t Key = 0;
+        int Width = 0;
+        int Height = 0;
+        std::vector<uint8_t> Pixels;
+    };
+
+    // the decoder comes after what its callback uses, so it is destroyed first
+    std::string cacheDirectory;
+    mutable std::mutex mutex;
+    std::condition_variable indexWake;
+    std::condition_variable workWake;
+    ImageDecoder decoder;
+    std::thread indexer;
+    std::thread worker;
+    bool stopping = false;
+    std::atomic<uint64_t> generation{ 0 };
+
+    // guarded by mutex
+    std::vector<std::string> roots;
+    bool rootsChanged = false;
+    std::vector<AssetEntry> entries;
+    size_t entriesTaken = 0;
+    std::vector<size_t> requests;               // served from the back
+    std::deque<AssetThumbnail> thumbnails;
+    std::deque<AssetMeshJob> meshJobs;
+    std::deque<PendingWrite> writes;
+    bool decoded = false;                       // the decoder has results to poll
+    AssetLibraryStats stats;
+
+    // thumbnail thread only
+    std::unordered_map<uint64_t, PendingDecode> decodes;   // by decoder ticket
+    uint64_t decodesGeneration = 0;                         // scan the entries of decodes belong to
+    std::unordered_map<std::string, KnownHash> knownHashes;
+    std::ofstream hashLog;
+
+    void indexLoop();
+    void workLoop();
+    void serve(size_t entry, const AssetEntry& asset, uint64_t forGeneration);
+    bool contentKey(const AssetEntry& asset, uint64_t& key);
+    void finishDecode(DecodedImage& image);
+    void publish(AssetThumbnail thumbnail, uint64_t forGeneration);
+    std::string thumbnailPath(uint64_t key) const;
+    bool readThumbnail(uint64_t key, AssetThumbnail& out);
+    void writeThumbnail(const PendingWrite& write) const;
+    void loadHashLog();
+};
+
+// classifies a file by extension; false for files that are not assets
+bool AssetKindFromPath(const std::string& path, Asset_Kind& kind);
+
+// Every primitive of a glTF file in world space, merged into one mesh centered on its bounds and scaled to fit the
+// unit sphere, so any asset frames the same way in a thumbnail. Stops adding primitives after maxTriangles.
+bool ReadThumbnailMesh(const std::string& path, MeshData& out, std::string& error, size_t maxTriangles = size_t(1) << 20);
+
+#endif
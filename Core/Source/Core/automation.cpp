@@ -0,0 +1,421 @@
+#include "automation.h"
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <poll.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <cerrno>
+
+// macOS has no MSG_NOSIGNAL; a write to a closed peer is rare there and only ends the app when SIGPIPE is not ignored
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+#endif
+
+#include <unordered_map>
+
+const char* AutomationStatusName(Automation_Status status)
+{
+    switch (status)
+    {
+    case AUTOMATION_OK: return "OK";
+    case AUTOMATION_ERROR_MALFORMED: return "Malformed message";
+    case AUTOMATION_ERROR_UNKNOWN_COMMAND: return "Unknown command";
+    case AUTOMATION_ERROR_OUT_OF_RANGE: return "Out of range";
+    default: return "Unknown status";
+    }
+}
+
+AutomationServer::~AutomationServer()
+{
+    Stop();
+}
+
+AutomationClient::~AutomationClient()
+{
+    Close();
+}
+
+#ifdef _WIN32
+
+bool AutomationServer::Start(const std::string& socketPath)
+{
+    lastError = "The automation socket is only available on Linux and macOS";
+    return false;
+}
+
+void AutomationServer::Stop()
+{
+}
+
+void AutomationServer::ioLoop()
+{
+}
+
+void AutomationServer::wakeIOThread()
+{
+}
+
+bool AutomationClient::Connect(const std::string& socketPath)
+{
+    return false;
+}
+
+void AutomationClient::Close()
+{
+}
+
+bool AutomationClient::Send(const std::vector<uint8_t>& message)
+{
+    return false;
+}
+
+bool AutomationClient::Receive(std::vector<uint8_t>& message)
+{
+    return false;
+}
+
+#else
+
+namespace
+{
+    bool setNonBlocking(int fd)
+    {
+        int flags = fcntl(fd, F_GETFL, 0);
+        return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+    }
+
+    bool makeAddress(const std::string& path, sockaddr_un& address)
+    {
+        std::memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        if (path.size() >= sizeof(address.sun_path))
+            return false;
+        std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+        return true;
+    }
+
+    // blocking helpers for the client side
+    bool writeAll(int fd, const void* data, size_t size)
+    {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        while (size > 0)
+        {
+            ssize_t written = send(fd, bytes, size, MSG_NOSIGNAL);
+            if (written < 0 && errno == EINTR)
+                continue;
+            if (written <= 0)
+                return false;
+            bytes += written;
+            size -= written;
+        }
+        return true;
+    }
+
+    bool readAll(int fd, void* data, size_t size)
+    {
+        uint8_t* bytes = static_cast<uint8_t*>(data);
+        while (size > 0)
+        {
+            ssize_t received = recv(fd, bytes, size, 0);
+            if (received < 0 && errno == EINTR)
+                continue;
+            if (received <= 0)
+                return false;
+            bytes += received;
+            size -= received;
+        }
+        return true;
+    }
+
+    // per connection stream state owned by the IO thread
+    struct Connection
+    {
+        int Fd = -1;
+        std::vector<uint8_t> Input;
+        std::vector<uint8_t> Output;
+        size_t OutputOffset = 0;
+    };
+}
+
+bool AutomationServer::Start(const std::string& socketPath)
+{
+    Stop();
+
+    sockaddr_un address;
+    if (!makeAddress(socketPath, address))
+    {
+        lastError = "Socket path is too long";
+        return false;
+    }
+
+    listenSocket = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenSocket < 0)
+    {
+        lastError = std::string("socket failed: ") + std::strerror(errno);
+        return false;
+    }
+
+    // a socket file left behind by a crashed instance would make bind fail
+    unlink(socketPath.c_str());
+    if (bind(listenSocket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(listenSocket, 8) != 0)
+    {
+        lastError = std::string("bind failed: ") + std::strerror(errno);
+        close(listenSocket);
+        listenSocket = -1;
+        return false;
+    }
+    setNonBlocking(listenSocket);
+
+    int wake[2];
+    if (pipe(wake) != 0)
+    {
+        lastError = std::string("pipe failed: ") + std::strerror(errno);
+        close(listenSocket);
+        listenSocket = -1;
+        unlink(socketPath.c_str());
+        return false;
+    }
+    wakeRead = wake[0];
+    wakeWrite = wake[1];
+    setNonBlocking(wakeRead);
+    setNonBlocking(wakeWrite);
+
+    path = socketPath;
+    lastError.clear();
+    running = true;
+    ioThread = std::thread(&AutomationServer::ioLoop, this);
+    return true;
+}
+
+void AutomationServer::Stop()
+{
+    if (!running)
+        return;
+
+    running = false;
+    wakeIOThread();
+    ioThread.join();
+
+    close(listenSocket);
+    close(wakeRead);
+    close(wakeWrite);
+    listenSocket = wakeRead = wakeWrite = -1;
+    unlink(path.c_str());
+
+    std::lock_guard<std::mutex> lock(mutex);
+    inbox.clear();
+    outbox.clear();
+}
+
+void AutomationServer::wakeIOThread()
+{
+    uint8_t byte = 1;
+    ssize_t ignored = write(wakeWrite, &byte, 1); // a full pipe already guarantees a wakeup
+    (void)ignored;
+}
+
+void AutomationServer::ioLoop()
+{
+    // keyed by a running id rather than the descriptor, which the system hands to the next client once closed
+    std::unordered_map<uint64_t, Connection> connections;
+    uint64_t nextConnection = 1;
+    std::vector<pollfd> fds;
+    std::vector<uint64_t> polled;   // connection behind each client entry of fds
+    uint8_t buffer[64 * 1024];
+
+    auto disconnect = [&](uint64_t id)
+    {
+        close(connections[id].Fd);
+        connections.erase(id);
+        clientCount = static_cast<unsigned int>(connections.size());
+    };
+
+    while (running)
+    {
+        // Move queued replies into their connection's output stream
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (Pending& reply : outbox)
+            {
+                auto it = connections.find(reply.Connection);
+                if (it == connections.end())
+                    continue;
+                uint32_t size = static_cast<uint32_t>(reply.Data.size());
+                std::vector<uint8_t>& output = it->second.Output;
+                output.insert(output.end(), reinterpret_cast<uint8_t*>(&size), reinterpret_cast<uint8_t*>(&size) + sizeof(size));
+                output.insert(output.end(), reply.Data.begin(), reply.Data.end());
+            }
+            outbox.clear();
+        }
+
+        fds.clear();
+        fds.push_back({ wakeRead, POLLIN, 0 });
+        fds.push_back({ listenSocket, POLLIN, 0 });
+        polled.clear();
+        for (auto& entry : connections)
+        {
+            short events = POLLIN;
+            if (entry.second.OutputOffset < entry.second.Output.size())
+                events |= POLLOUT;
+            fds.push_back({ entry.second.Fd, events, 0 });
+            polled.push_back(entry.first);
+        }
+
+        if (poll(fds.data(), fds.size(), -1) < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+
+        if (fds[0].revents & POLLIN)
+        {
+            while (read(wakeRead, buffer, sizeof(buffer)) > 0)
+            {
+            }
+        }
+
+        if (fds[1].revents & POLLIN)
+        {
+            for (int client = accept(listenSocket, nullptr, nullptr); client >= 0; client = accept(listenSocket, nullptr, nullptr))
+            {
+                setNonBlocking(client);
+                connections[nextConnection++].Fd = client;
+                clientCount = static_cast<unsigned int>(connections.size());
+            }
+        }
+
+        for (size_t i = 2; i < fds.size(); ++i)
+        {
+            int fd = fds[i].fd;
+            uint64_t id = polled[i - 2];
+            Connection& connection = connections[id];
+            bool closed = (fds[i].revents & (POLLERR | POLLHUP | POLLNVAL)) != 0 && !(fds[i].revents & POLLIN);
+
+            if (fds[i].revents & POLLIN)
+            {
+                for (;;)
+                {
+                    ssize_t received = recv(fd, buffer, sizeof(buffer), 0);
+                    if (received > 0)
+                    {
+                        connection.Input.insert(connection.Input.end(), buffer, buffer + received);
+                        continue;
+                    }
+                    if (received == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR))
+                        closed = true;
+                    if (received < 0 && errno == EINTR)
+                        continue;
+                    break;
+                }
+
+                // Split the stream into complete messages
+                size_t offset = 0;
+                std::vector<Pending> complete;
+                while (connection.Input.size() - offset >= sizeof(uint32_t))
+                {
+                    uint32_t size;
+                    std::memcpy(&size, connection.Input.data() + offset, sizeof(size));
+                    if (size > MAX_MESSAGE_BYTES)
+                    {
+                        closed = true;
+                        break;
+                    }
+                    if (connection.Input.size() - offset - sizeof(uint32_t) < size)
+                        break;
+                    const uint8_t* begin = connection.Input.data() + offset + sizeof(uint32_t);
+                    complete.push_back({ id, std::vector<uint8_t>(begin, begin + size) });
+                    offset += sizeof(uint32_t) + size;
+                }
+                connection.Input.erase(connection.Input.begin(), connection.Input.begin() + offset);
+
+                if (!complete.empty())
+                {
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        for (Pending& request : complete)
+                            inbox.push_back(std::move(request));
+                    }
+                    if (OnRequest)
+                        OnRequest();
+                }
+            }
+
+            if (!closed && (fds[i].revents & POLLOUT))
+            {
+                while (connection.OutputOffset < connection.Output.size())
+                {
+                    ssize_t written = send(fd, connection.Output.data() + connection.OutputOffset, connection.Output.size() - connection.OutputOffset, MSG_NOSIGNAL);
+                    if (written > 0)
+                    {
+                        connection.OutputOffset += written;
+                        continue;
+                    }
+                    if (written < 0 && errno == EINTR)
+                        continue;
+                    if (written < 0 && errno != EAGAIN && errno != EWOULDBLOCK)
+                        closed = true;
+                    break;
+                }
+                if (connection.OutputOffset == connection.Output.size())
+                {
+                    connection.Output.clear();
+                    connection.OutputOffset = 0;
+                }
+            }
+
+            if (closed)
+                disconnect(id);
+        }
+    }
+
+    for (auto& entry : connections)
+        close(entry.second.Fd);
+    clientCount = 0;
+}
+
+bool AutomationClient::Connect(const std::string& socketPath)
+{
+    Close();
+
+    sockaddr_un address;
+    if (!makeAddress(socketPath, address))
+        return false;
+
+    socketHandle = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (socketHandle < 0)
+        return false;
+    if (connect(socketHandle, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0)
+    {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void AutomationClient::Close()
+{
+    if (socketHandle >= 0)
+        close(socketHandle);
+    socketHandle = -1;
+}
+
+bool AutomationClient::Send(const std::vector<uint8_t>& message)
+{
+    uint32_t size = static_cast<uint32_t>(message.size());
+    return socketHandle >= 0 && writeAll(socketHandle, &size, sizeof(size)) && writeAll(socketHandle, message.data(), message.size());
+}
+
+bool AutomationClient::Receive(std::vector<uint8_t>& message)
+{
+    uint32_t size;
+    if (socketHandle < 0 || !readAll(socketHandle, &size, sizeof(size)) || size > AutomationServer::MAX_MESSAGE_BYTES)
+        return false;
+    message.resize(size);
+    return readAll(socketHandle, message.data(), size);
+}
+
+#endif
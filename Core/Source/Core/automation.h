@@ -0,0 +1,216 @@
+#ifndef AUTOMATION_H
+#define AUTOMATION_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <utility>
+
+// Local automation protocol. Every message on the socket is a uint32 byte length followed by that many bytes;
+// all integers and floats are 32-bit little-endian unless noted.
+//
+// A request is one batch:    u32 commandCount, then per command: u32 command, u32 byteCount, payload
+// The reply to a batch:      u32 status, u32 resultCount, then per command: u32 command, u32 status, u32 byteCount, payload
+//
+// A batch is validated as a whole before anything is applied and is then applied in one go between two frames,
+// so a script never observes a half-applied batch. If validation fails the reply carries the error and no results.
+enum Automation_Command : uint32_t {
+    AUTOMATION_CREATE_OBJECTS = 1,  // u32 primitive type, u32 count, count x (pos xyz, scale xyz, color rgba) -> u32 first index, u32 count
+    AUTOMATION_SET_TRANSFORMS = 2,  // u32 count, count x (u32 index, pos xyz, scale xyz) -> nothing
+    AUTOMATION_GET_TRANSFORMS = 3,  // u32 first, u32 count -> count x (pos xyz, scale xyz)
+    AUTOMATION_PICK = 4,            // f32 x, f32 y in window pixels -> i32 object index or -1
+    AUTOMATION_GET_STATS = 5,       // nothing -> f32 frame ms, u32 objects, u32 meshes, u32 GL calls issued, u32 GL calls skipped, u64 GPU bytes, u64 commands applied
+    AUTOMATION_SELECT = 6           // i32 object index or -1 -> nothing
+};
+
+enum Automation_Status : uint32_t {
+    AUTOMATION_OK = 0,
+    AUTOMATION_ERROR_MALFORMED = 1,     // truncated message or payload size mismatch
+    AUTOMATION_ERROR_UNKNOWN_COMMAND = 2,
+    AUTOMATION_ERROR_OUT_OF_RANGE = 3   // object index or primitive type outside the scene
+};
+
+const char* AutomationStatusName(Automation_Status status);
+
+// Appends little-endian values to a message buffer
+class MessageWriter
+{
+public:
+    std::vector<uint8_t> Data;
+
+    void WriteU32(uint32_t value) { append(&value, sizeof(value)); }
+    void WriteI32(int32_t value) { append(&value, sizeof(value)); }
+    void WriteU64(uint64_t value) { append(&value, sizeof(value)); }
+    void WriteF32(float value) { append(&value, sizeof(value)); }
+    void WriteFloats(const float* values, size_t count) { append(values, count * sizeof(float)); }
+
+    // reserves a u32 and returns its offset, for sizes known only after the payload is written
+    size_t BeginSize()
+    {
+        size_t offset = Data.size();
+        WriteU32(0);
+        return offset;
+    }
+
+    void EndSize(size_t offset)
+    {
+        uint32_t size = static_cast<uint32_t>(Data.size() - offset - sizeof(uint32_t));
+        std::memcpy(Data.data() + offset, &size, sizeof(size));
+    }
+
+private:
+    void append(const void* bytes, size_t size)
+    {
+        const uint8_t* begin = static_cast<const uint8_t*>(bytes);
+        Data.insert(Data.end(), begin, begin + size);
+    }
+};
+
+// Bounds-checked reads from a message; once a read runs past the end every further read fails as well
+class MessageReader
+{
+public:
+    MessageReader(const uint8_t* data, size_t size) : data(data), size(size)
+    {
+    }
+
+    bool ReadU32(uint32_t& value) { return read(&value, sizeof(value)); }
+    bool ReadI32(int32_t& value) { return read(&value, sizeof(value)); }
+    bool ReadU64(uint64_t& value) { return read(&value, sizeof(value)); }
+    bool ReadF32(float& value) { return read(&value, sizeof(value)); }
+    bool ReadFloats(float* values, size_t count) { return read(values, count * sizeof(float)); }
+
+    // hands out a view of the next bytes without copying them
+    bool ReadBytes(const uint8_t*& bytes, size_t count)
+    {
+        if (failed || count > size - offset)
+        {
+            failed = true;
+            return false;
+        }
+        bytes = data + offset;
+        offset += count;
+        return true;
+    }
+
+    size_t Remaining() const { return size - offset; }
+    bool Failed() const { return failed; }
+
+private:
+    const uint8_t* data;
+    size_t size;
+    size_t offset = 0;
+    bool failed = false;
+
+    bool read(void* value, size_t count)
+    {
+        const uint8_t* bytes;
+        if (!ReadBytes(bytes, count))
+            return false;
+        std::memcpy(value, bytes, count);
+        return true;
+    }
+};
+
+// Unix domain socket endpoint. An IO thread accepts clients and splits their streams into messages;
+// the main thread drains complete requests with Poll at a frame boundary and queues the replies,
+// which the IO thread writes back. Not available on Windows builds.
+class AutomationServer
+{
+public:
+    static const uint32_t MAX_MESSAGE_BYTES = 256u << 20;
+
+    // called on the IO thread whenever new requests are queued, so a main loop sleeping in an event wait can wake up; set before Start
+    std::function<void()> OnRequest;
+
+    AutomationServer() = default;
+    ~AutomationServer();
+
+    AutomationServer(const AutomationServer&) = delete;
+    AutomationServer& operator=(const AutomationServer&) = delete;
+
+    // binds the socket at path, replacing a stale socket file; returns false and sets LastError on failure
+    bool Start(const std::string& path);
+    void Stop();
+    bool IsRunning() const { return running; }
+    const std::string& GetLastError() const { return lastError; }
+    unsigned int GetClientCount() const { return clientCount.load(); }
+
+    // calls handler(request, reply) for every complete request in arrival order, then hands the replies to the IO thread.
+    // Returns the number of requests handled.
+    template <typename Handler>
+    size_t Poll(Handler handler)
+    {
+        std::deque<Pending> requests;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            requests.swap(inbox);
+        }
+        if (requests.empty())
+            return 0;
+
+        std::vector<Pending> replies;
+        replies.reserve(requests.size());
+        for (Pending& request : requests)
+        {
+            MessageWriter reply;
+            handler(request.Data, reply);
+            replies.push_back({ request.Connection, std::move(reply.Data) });
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (Pending& reply : replies)
+                outbox.push_back(std::move(reply));
+        }
+        wakeIOThread();
+        return requests.size();
+    }
+
+private:
+    struct Pending
+    {
+        uint64_t Connection;        // id the IO thread gave the connection; never reused, unlike its descriptor
+        std::vector<uint8_t> Data;
+    };
+
+    std::string path;
+    std::string lastError;
+    std::thread ioThread;
+    std::atomic<bool> running{ false };
+    std::atomic<unsigned int> clientCount{ 0 };
+    std::mutex mutex;
+    std::deque<Pending> inbox;      // requests waiting for the next frame
+    std::deque<Pending> outbox;     // replies waiting for the IO thread; those for closed connections are dropped
+    int listenSocket = -1;
+    int wakeRead = -1;
+    int wakeWrite = -1;
+
+    void ioLoop();
+    void wakeIOThread();
+};
+
+// Blocking client for the automation socket, used by the built-in benchmark and by native tools
+class AutomationClient
+{
+public:
+    ~AutomationClient();
+
+    bool Connect(const std::string& path);
+    void Close();
+
+    // sends one framed message
+    bool Send(const std::vector<uint8_t>& message);
+    // waits for the next framed message
+    bool Receive(std::vector<uint8_t>& message);
+
+private:
+    int socketHandle = -1;
+};
+
+#endif
@@ -0,0 +1,75 @@
+#include "buffered_writer.h"
+
+#include <cstring>
+
+bool BufferedWriter::Open(const std::string& path)
+{
+    Close();
+    file = std::fopen(path.c_str(), "wb");
+    used = 0;
+    written = 0;
+    failed = file == nullptr;
+    // the FILE's own buffer would only copy everything a second time
+    if (file != nullptr)
+        std::setvbuf(file, nullptr, _IONBF, 0);
+    return file != nullptr;
+}
+
+void BufferedWriter::Write(const void* data, size_t size)
+{
+    if (failed || size == 0)
+        return;
+    if (used + size > buffer.size())
+    {
+        flush();
+        if (size >= buffer.size())
+        {
+            failed = failed || std::fwrite(data, 1, size, file) != size;
+            written += size;
+            return;
+        }
+    }
+    std::memcpy(buffer.data() + used, data, size);
+    used += size;
+    written += size;
+}
+
+void BufferedWriter::Append(const std::string& path)
+{
+    if (failed)
+        return;
+    std::FILE* source = std::fopen(path.c_str(), "rb");
+    if (source == nullptr)
+    {
+        failed = true;
+        return;
+    }
+    flush();
+    for (;;)
+    {
+        size_t read = std::fread(buffer.data(), 1, buffer.size(), source);
+        if (read == 0)
+            break;
+        failed = failed || std::fwrite(buffer.data(), 1, read, file) != read;
+        written += read;
+    }
+    failed = failed || std::ferror(source) != 0;
+    std::fclose(source);
+}
+
+bool BufferedWriter::Close()
+{
+    if (file == nullptr)
+        return !failed;
+    flush();
+    failed = std::fclose(file) != 0 || failed;
+    file = nullptr;
+    return !failed;
+}
+
+void BufferedWriter::flush()
+{
+    if (used > 0 && !failed)
+        failed = std::fwrite(buffer.data(), 1, used, file) != used;
+    used = 0;
+}
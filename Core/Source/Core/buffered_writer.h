@@ -0,0 +1,51 @@
+#ifndef BUFFERED_WRITER_H
+#define BUFFERED_WRITER_H
+
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstdint>
+#include <cstddef>
+
+// Sequential file output through one fixed buffer. Small writes are gathered until the buffer is full, writes
+// larger than the buffer go straight to the file, so memory stays at the buffer size whatever is written.
+// Errors are sticky: once a write fails every later one is skipped and Close reports the failure.
+class BufferedWriter
+{
+public:
+    explicit BufferedWriter(size_t capacity = 1 << 20) : buffer(capacity)
+    {
+    }
+
+    ~BufferedWriter() { Close(); }
+
+    BufferedWriter(const BufferedWriter&) = delete;
+    BufferedWriter& operator=(const BufferedWriter&) = delete;
+
+    // creates or truncates path
+    bool Open(const std::string& path);
+
+    void Write(const void* data, size_t size);
+    void Write(const std::string& text) { Write(text.data(), text.size()); }
+
+    // copies the whole content of another file, one buffer at a time
+    void Append(const std::string& path);
+
+    // flushes and closes the file; false if anything failed since Open
+    bool Close();
+
+    bool Failed() const { return failed; }
+    uint64_t BytesWritten() const { return written; }
+    size_t Capacity() const { return buffer.size(); }
+
+private:
+    std::FILE* file = nullptr;
+    std::vector<char> buffer;
+    size_t used = 0;
+    uint64_t written = 0;
+    bool failed = false;
+
+    void flush();
+};
+
+#endif
@@ -0,0 +1,499 @@
+#include "bvh.h"
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+
+namespace
+{
+    const int BIN_COUNT = 16;
+    const size_t BOUNDS_GRAIN = 16384;
+    const float TRAVERSAL_COST = 1.0f;      // relative to one triangle test
+    const float RAY_EPSILON = 1.0e-7f;
+    const int MAX_DEPTH = 60;               // keeps the fixed traversal stacks below from overflowing
+    const int STACK_SIZE = MAX_DEPTH + 4;
+
+    struct Bounds
+    {
+        glm::vec3 Min = glm::vec3(std::numeric_limits<float>::max());
+        glm::vec3 Max = glm::vec3(-std::numeric_limits<float>::max());
+
+        void Grow(const glm::vec3& point)
+        {
+            Min = glm::min(Min, point);
+            Max = glm::max(Max, point);
+        }
+
+        void Grow(const Bounds& other)
+        {
+            Min = glm::min(Min, other.Min);
+            Max = glm::max(Max, other.Max);
+        }
+
+        float HalfArea() const
+        {
+            glm::vec3 size = glm::max(Max - Min, glm::vec3(0.0f));
+            return size.x * size.y + size.y * size.z + size.z * size.x;
+        }
+    };
+
+    struct BuildContext
+    {
+        std::vector<Bounds> TriangleBounds;
+        std::vector<glm::vec3> Centers;
+        std::vector<uint32_t> Order;
+        std::vector<BvhNode>& Nodes;
+    };
+
+    bool overlaps(const glm::vec3& minA, const glm::vec3& maxA, const glm::vec3& minB, const glm::vec3& maxB)
+    {
+        return minA.x <= maxB.x && minB.x <= maxA.x && minA.y <= maxB.y && minB.y <= maxA.y && minA.z <= maxB.z && minB.z <= maxA.z;
+    }
+
+    // entry distance of the ray into the box, or infinity if it misses within maxDistance
+    float rayBox(const BvhNode& node, const glm::vec3& origin, const glm::vec3& inverseDirection, float maxDistance)
+    {
+        glm::vec3 t0 = (node.Min - origin) * inverseDirection;
+        glm::vec3 t1 = (node.Max - origin) * inverseDirection;
+        glm::vec3 near = glm::min(t0, t1);
+        glm::vec3 far = glm::max(t0, t1);
+        float enter = std::max(std::max(near.x, near.y), std::max(near.z, 0.0f));
+        float exit = std::min(std::min(far.x, far.y), std::min(far.z, maxDistance));
+        return enter <= exit ? enter : std::numeric_limits<float>::infinity();
+    }
+
+    // Moller-Trumbore, two-sided
+    bool rayTriangle(const glm::vec3& origin, const glm::vec3& direction, const glm::vec3* corners, float& t, glm::vec2& barycentric)
+    {
+        glm::vec3 edge1 = corners[1] - corners[0];
+        glm::vec3 edge2 = corners[2] - corners[0];
+        glm::vec3 p = glm::cross(direction, edge2);
+        float determinant = glm::dot(edge1, p);
+        if (std::abs(determinant) < 1.0e-12f)
+            return false;
+        float inverse = 1.0f / determinant;
+        glm::vec3 s = origin - corners[0];
+        float u = glm::dot(s, p) * inverse;
+        if (u < 0.0f || u > 1.0f)
+            return false;
+        glm::vec3 q = glm::cross(s, edge1);
+        float v = glm::dot(direction, q) * inverse;
+        if (v < 0.0f || u + v > 1.0f)
+            return false;
+        t = glm::dot(edge2, q) * inverse;
+        barycentric = glm::vec2(u, v);
+        return t > RAY_EPSILON;
+    }
+
+    // the same test on four rays against one triangle; returns the active lanes hitting it closer than their
+    // Distance and moves their hit there
+    int packetTriangle(RayPacket& packet, const glm::vec3* corners)
+    {
+        glm::vec3 e1 = corners[1] - corners[0];
+        glm::vec3 e2 = corners[2] - corners[0];
+        Float4 e1x = Float4::Set1(e1.x), e1y = Float4::Set1(e1.y), e1z = Float4::Set1(e1.z);
+        Float4 e2x = Float4::Set1(e2.x), e2y = Float4::Set1(e2.y), e2z = Float4::Set1(e2.z);
+        Float4 px = packet.DirectionY * e2z - packet.DirectionZ * e2y;
+        Float4 py = packet.DirectionZ * e2x - packet.DirectionX * e2z;
+        Float4 pz = packet.DirectionX * e2y - packet.DirectionY * e2x;
+        Float4 determinant = e1x * px + e1y * py + e1z * pz;
+        Float4 zero = Float4::Set1(0.0f);
+        Float4 inverse = Float4::Set1(1.0f) / determinant;
+        Float4 sx = packet.OriginX - Float4::Set1(corners[0].x);
+        Float4 sy = packet.OriginY - Float4::Set1(corners[0].y);
+        Float4 sz = packet.OriginZ - Float4::Set1(corners[0].z);
+        Float4 u = (sx * px + sy * py + sz * pz) * inverse;
+        Float4 qx = sy * e1z - sz * e1y;
+        Float4 qy = sz * e1x - sx * e1z;
+        Float4 qz = sx * e1y - sy * e1x;
+        Float4 v = (packet.DirectionX * qx + packet.DirectionY * qy + packet.DirectionZ * qz) * inverse;
+        Float4 t = (e2x * qx + e2y * qy + e2z * qz) * inverse;
+
+        // a degenerate determinant makes u NaN, which fails every comparison
+        Float4 hit = Less(Float4::Set1(1.0e-12f), Max(determinant, zero - determinant));
+        hit = And(hit, And(LessEqual(zero, u), LessEqual(zero, v)));
+        hit = And(hit, LessEqual(u + v, Float4::Set1(1.0f)));
+        hit = And(hit, And(Less(Float4::Set1(RAY_EPSILON), t), Less(t, packet.Distance)));
+        int lanes = MoveMask(hit) & packet.Active;
+        if (lanes != 0)
+        {
+            Float4 mask = Float4::FromBits(lanes);
+            packet.Distance = Select(mask, t, packet.Distance);
+            packet.U = Select(mask, u, packet.U);
+            packet.V = Select(mask, v, packet.V);
+        }
+        return lanes;
+    }
+
+    // nearest entry among the given lanes
+    float nearestLane(Float4 enter, int lanes)
+    {
+        float values[4];
+        enter.Store(values);
+        float nearest = std::numeric_limits<float>::infinity();
+        for (int lane = 0; lane < 4; ++lane)
+        {
+            if (lanes & (1 << lane))
+                nearest = std::min(nearest, values[lane]);
+        }
+        return nearest;
+    }
+
+    uint32_t buildNode(BuildContext& context, uint32_t begin, uint32_t end, int depth)
+    {
+        uint32_t index = static_cast<uint32_t>(context.Nodes.size());
+        context.Nodes.push_back(BvhNode());
+
+        Bounds bounds, centers;
+        for (uint32_t i = begin; i < end; ++i)
+        {
+            bounds.Grow(context.TriangleBounds[context.Order[i]]);
+            centers.Grow(context.Centers[context.Order[i]]);
+        }
+        context.Nodes[index].Min = bounds.Min;
+        context.Nodes[index].Max = bounds.Max;
+
+        uint32_t count = end - begin;
+        glm::vec3 extent = centers.Max - centers.Min;
+        int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+        if (count <= TriangleBvh::MAX_LEAF_SIZE || extent[axis] <= 0.0f || depth >= MAX_DEPTH)
+        {
+            context.Nodes[index].Start = begin;
+            context.Nodes[index].Count = count;
+            return index;
+        }
+
+        // bin the centers along the widest axis and take the cheapest boundary between bins
+        Bounds binBounds[BIN_COUNT];
+        uint32_t binCounts[BIN_COUNT] = {};
+        float scale = BIN_COUNT / extent[axis];
+        auto binOf = [&](uint32_t triangle) {
+            return std::min(BIN_COUNT - 1, static_cast<int>((context.Centers[triangle][axis] - centers.Min[axis]) * scale));
+        };
+        for (uint32_t i = begin; i < end; ++i)
+        {
+            int bin = binOf(context.Order[i]);
+            binBounds[bin].Grow(context.TriangleBounds[context.Order[i]]);
+            binCounts[bin]++;
+        }
+
+        float leftArea[BIN_COUNT - 1];
+        uint32_t leftCount[BIN_COUNT - 1];
+        Bounds running;
+        uint32_t runningCount = 0;
+        for (int bin = 0; bin < BIN_COUNT - 1; ++bin)
+        {
+            running.Grow(binBounds[bin]);
+            runningCount += binCounts[bin];
+            leftArea[bin] = running.HalfArea();
+            leftCount[bin] = runningCount;
+        }
+        int bestSplit = -1;
+        float bestCost = std::numeric_limits<float>::max();
+        running = Bounds();
+        runningCount = 0;
+        for (int bin = BIN_COUNT - 1; bin > 0; --bin)
+        {
+            running.Grow(binBounds[bin]);
+            runningCount += binCounts[bin];
+            if (leftCount[bin - 1] == 0 || runningCount == 0)
+                continue;
+            float cost = leftArea[bin - 1] * leftCount[bin - 1] + running.HalfArea() * runningCount;
+            if (cost < bestCost)
+            {
+                bestCost = cost;
+                bestSplit = bin;
+            }
+        }
+
+        float leafCost = bounds.HalfArea() * count;
+        if (bestSplit < 0 || (bestCost + TRAVERSAL_COST * bounds.HalfArea() >= leafCost && count <= 4 * TriangleBvh::MAX_LEAF_SIZE))
+        {
+            context.Nodes[index].Start = begin;
+            context.Nodes[index].Count = count;
+            return index;
+        }
+
+        uint32_t* middle = std::partition(context.Order.data() + begin, context.Order.data() + end, [&](uint32_t triangle) {
+            return binOf(triangle) < bestSplit;
+        });
+        uint32_t split = static_cast<uint32_t>(middle - context.Order.data());
+
+        buildNode(context, begin, split, depth + 1);
+        uint32_t second = buildNode(context, split, end, depth + 1);
+        context.Nodes[index].Start = second;
+        context.Nodes[index].Count = 0;
+        return index;
+    }
+
+    // both trees descend together; the side with the bigger box splits first so the pairs stay balanced
+    void walkPairs(const TriangleBvh& a, const TriangleBvh& b, uint32_t nodeA, uint32_t nodeB, std::vector<std::pair<uint32_t, uint32_t>>& pairs)
+    {
+        std::vector<std::pair<uint32_t, uint32_t>> stack;
+        stack.push_back({ nodeA, nodeB });
+        while (!stack.empty())
+        {
+            auto [i, j] = stack.back();
+            stack.pop_back();
+            const BvhNode& x = a.Nodes[i];
+            const BvhNode& y = b.Nodes[j];
+            if (!overlaps(x.Min, x.Max, y.Min, y.Max))
+                continue;
+
+            if (x.IsLeaf() && y.IsLeaf())
+            {
+                for (uint32_t s = x.Start; s < x.Start + x.Count; ++s)
+                {
+                    const glm::vec3* p = &a.Corners[s * 3];
+                    glm::vec3 minP = glm::min(p[0], glm::min(p[1], p[2]));
+                    glm::vec3 maxP = glm::max(p[0], glm::max(p[1], p[2]));
+                    for (uint32_t t = y.Start; t < y.Start + y.Count; ++t)
+                    {
+                        const glm::vec3* q = &b.Corners[t * 3];
+                        if (overlaps(minP, maxP, glm::min(q[0], glm::min(q[1], q[2])), glm::max(q[0], glm::max(q[1], q[2]))))
+                            pairs.push_back({ a.Triangles[s], b.Triangles[t] });
+                    }
+                }
+                continue;
+            }
+
+            glm::vec3 sizeX = x.Max - x.Min;
+            glm::vec3 sizeY = y.Max - y.Min;
+            bool splitA = !x.IsLeaf() && (y.IsLeaf() || glm::dot(sizeX, sizeX) >= glm::dot(sizeY, sizeY));
+            if (splitA)
+            {
+                stack.push_back({ i + 1, j });
+                stack.push_back({ x.Start, j });
+            }
+            else
+            {
+                stack.push_back({ i, j + 1 });
+                stack.push_back({ i, y.Start });
+            }
+        }
+    }
+}
+
+void TriangleBvh::Build(const std::vector<glm::vec3>& corners, JobSystem& jobs)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    size_t triangleCount = corners.size() / 3;
+    Nodes.clear();
+    Corners.clear();
+    Triangles.clear();
+    if (triangleCount == 0)
+        return;
+
+    BuildContext context{ std::vector<Bounds>(triangleCount), std::vector<glm::vec3>(triangleCount), std::vector<uint32_t>(triangleCount), Nodes };
+    jobs.ParallelFor(triangleCount, BOUNDS_GRAIN, [&](size_t begin, size_t end) {
+        for (size_t t = begin; t < end; ++t)
+        {
+            Bounds bounds;
+            bounds.Grow(corners[t * 3]);
+            bounds.Grow(corners[t * 3 + 1]);
+            bounds.Grow(corners[t * 3 + 2]);
+            context.TriangleBounds[t] = bounds;
+            context.Centers[t] = (bounds.Min + bounds.Max) * 0.5f;
+            context.Order[t] = static_cast<uint32_t>(t);
+        }
+    });
+
+    Nodes.reserve(triangleCount * 2 / MAX_LEAF_SIZE + 1);
+    buildNode(context, 0, static_cast<uint32_t>(triangleCount), 0);
+
+    Triangles = std::move(context.Order);
+    Corners.resize(triangleCount * 3);
+    jobs.ParallelFor(triangleCount, BOUNDS_GRAIN, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+            std::copy(&corners[Triangles[i] * 3], &corners[Triangles[i] * 3] + 3, &Corners[i * 3]);
+    });
+    BuildMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+uint32_t TriangleBvh::Intersect(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, float& distance, glm::vec2& barycentric) const
+{
+    if (Nodes.empty())
+        return INVALID;
+    glm::vec3 inverseDirection = 1.0f / direction;
+    uint32_t hit = INVALID;
+    float closest = maxDistance;
+
+    uint32_t stack[STACK_SIZE];
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0)
+    {
+        const BvhNode& node = Nodes[stack[--top]];
+        if (rayBox(node, origin, inverseDirection, closest) == std::numeric_limits<float>::infinity())
+            continue;
+        if (node.IsLeaf())
+        {
+            for (uint32_t i = node.Start; i < node.Start + node.Count; ++i)
+            {
+                float t;
+                glm::vec2 uv;
+                if (rayTriangle(origin, direction, &Corners[i * 3], t, uv) && t < closest)
+                {
+                    closest = t;
+                    barycentric = uv;
+                    hit = Triangles[i];
+                }
+            }
+            continue;
+        }
+
+        // nearer child on top of the stack, so the far one is usually culled by the shortened ray
+        uint32_t first = static_cast<uint32_t>(&node - Nodes.data()) + 1;
+        uint32_t second = node.Start;
+        float nearFirst = rayBox(Nodes[first], origin, inverseDirection, closest);
+        float nearSecond = rayBox(Nodes[second], origin, inverseDirection, closest);
+        if (nearFirst > nearSecond)
+        {
+            std::swap(first, second);
+            std::swap(nearFirst, nearSecond);
+        }
+        if (nearSecond != std::numeric_limits<float>::infinity())
+            stack[top++] = second;
+        if (nearFirst != std::numeric_limits<float>::infinity())
+            stack[top++] = first;
+    }
+    if (hit != INVALID)
+        distance = closest;
+    return hit;
+}
+
+int TriangleBvh::IntersectPacket(RayPacket& packet) const
+{
+    if (Nodes.empty() || packet.Active == 0)
+        return 0;
+    int updated = 0;
+    uint32_t stack[STACK_SIZE];
+    int top = 0;
+    stack[top++] = 0;
+    Float4 enter;
+    while (top > 0)
+    {
+        uint32_t index = stack[--top];
+        const BvhNode& node = Nodes[index];
+        if (packet.EntersBox(node.Min, node.Max, enter) == 0)
+            continue;
+        if (node.IsLeaf())
+        {
+            for (uint32_t i = node.Start; i < node.Start + node.Count; ++i)
+            {
+                int hit = packetTriangle(packet, &Corners[i * 3]);
+                for (int lane = 0; lane < 4; ++lane)
+                {
+                    if (hit & (1 << lane))
+                        packet.Triangle[lane] = Triangles[i];
+                }
+                updated |= hit;
+            }
+            continue;
+        }
+
+        // child the packet reaches first on top of the stack
+        uint32_t first = index + 1;
+        uint32_t second = node.Start;
+        Float4 enterFirst, enterSecond;
+        int lanesFirst = packet.EntersBox(Nodes[first].Min, Nodes[first].Max, enterFirst);
+        int lanesSecond = packet.EntersBox(Nodes[second].Min, Nodes[second].Max, enterSecond);
+        if (nearestLane(enterFirst, lanesFirst) > nearestLane(enterSecond, lanesSecond))
+        {
+            std::swap(first, second);
+            std::swap(lanesFirst, lanesSecond);
+        }
+        if (lanesSecond != 0)
+            stack[top++] = second;
+        if (lanesFirst != 0)
+            stack[top++] = first;
+    }
+    return updated;
+}
+
+uint32_t TriangleBvh::CountCrossings(const glm::vec3& origin, const glm::vec3& direction) const
+{
+    if (Nodes.empty())
+        return 0;
+    glm::vec3 inverseDirection = 1.0f / direction;
+    uint32_t crossings = 0;
+    uint32_t stack[STACK_SIZE];
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0)
+    {
+        uint32_t index = stack[--top];
+        const BvhNode& node = Nodes[index];
+        if (rayBox(node, origin, inverseDirection, std::numeric_limits<float>::max()) == std::numeric_limits<float>::infinity())
+            continue;
+        if (node.IsLeaf())
+        {
+            for (uint32_t i = node.Start; i < node.Start + node.Count; ++i)
+            {
+                float t;
+                glm::vec2 uv;
+                if (rayTriangle(origin, direction, &Corners[i * 3], t, uv))
+                    crossings++;
+            }
+            continue;
+        }
+        stack[top++] = node.Start;
+        stack[top++] = index + 1;
+    }
+    return crossings;
+}
+
+std::vector<std::pair<uint32_t, uint32_t>> TriangleBvh::OverlappingPairs(const TriangleBvh& other, JobSystem& jobs) const
+{
+    std::vector<std::pair<uint32_t, uint32_t>> result;
+    if (Nodes.empty() || other.Nodes.empty())
+        return result;
+
+    // expand the top of the walk breadth first until there is enough independent work to spread out
+    const size_t targetTasks = 64 * jobs.GetThreadCount();
+    std::vector<std::pair<uint32_t, uint32_t>> tasks = { { 0u, 0u } };
+    for (int round = 0; round < 16 && tasks.size() < targetTasks; ++round)
+    {
+        std::vector<std::pair<uint32_t, uint32_t>> next;
+        bool expanded = false;
+        for (auto [i, j] : tasks)
+        {
+            const BvhNode& x = Nodes[i];
+            const BvhNode& y = other.Nodes[j];
+            if (!overlaps(x.Min, x.Max, y.Min, y.Max))
+                continue;
+            if (x.IsLeaf() && y.IsLeaf())
+            {
+                next.push_back({ i, j });
+                continue;
+            }
+            expanded = true;
+            if (!x.IsLeaf())
+            {
+                next.push_back({ i + 1, j });
+                next.push_back({ x.Start, j });
+            }
+            else
+            {
+                next.push_back({ i, j + 1 });
+                next.push_back({ i, y.Start });
+            }
+        }
+        tasks = std::move(next);
+        if (!expanded)
+            break;
+    }
+
+    std::vector<std::vector<std::pair<uint32_t, uint32_t>>> found(tasks.size());
+    jobs.ParallelFor(tasks.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t task = begin; task < end; ++task)
+            walkPairs(*this, other, tasks[task].first, tasks[task].second, found[task]);
+    });
+    size_t total = 0;
+    for (const auto& pairs : found)
+        total += pairs.size();
+    result.reserve(total);
+    for (const auto& pairs : found)
+        result.insert(result.end(), pairs.begin(), pairs.end());
+    return result;
+}
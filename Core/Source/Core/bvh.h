@@ -0,0 +1,98 @@
+#ifndef BVH_H
+#define BVH_H
+
+#include "job_system.h"
+#include "simd.h"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <utility>
+#include <cstdint>
+#include <cstddef>
+
+// 32 bytes, so two nodes share a cache line
+struct BvhNode
+{
+    glm::vec3 Min;
+    uint32_t Start;     // leaves: first triangle in leaf order; interior nodes: second child (the first follows the node)
+    glm::vec3 Max;
+    uint32_t Count;     // triangles in a leaf, 0 for interior nodes
+
+    bool IsLeaf() const { return Count != 0; }
+};
+
+// Four rays traced together, one per SIMD lane; lanes outside Active are never changed
+struct RayPacket
+{
+    Float4 OriginX, OriginY, OriginZ;
+    Float4 DirectionX, DirectionY, DirectionZ;
+    Float4 InverseX, InverseY, InverseZ;    // set by Prepare
+    Float4 Distance;                        // how far each ray looks; shortened to the closest hit
+    Float4 U, V;                            // barycentric coordinates of the hit towards the second and third corner
+    uint32_t Triangle[4] = {};              // input triangle hit per lane
+    int Active = 0;                         // bit per lane
+
+    // call after setting the directions
+    void Prepare()
+    {
+        Float4 one = Float4::Set1(1.0f);
+        InverseX = one / DirectionX;
+        InverseY = one / DirectionY;
+        InverseZ = one / DirectionZ;
+    }
+
+    // active lanes that enter the box in front of their origin and within their Distance, and where they enter
+    int EntersBox(const glm::vec3& min, const glm::vec3& max, Float4& enter) const
+    {
+        Float4 x0 = (Float4::Set1(min.x) - OriginX) * InverseX;
+        Float4 x1 = (Float4::Set1(max.x) - OriginX) * InverseX;
+        Float4 y0 = (Float4::Set1(min.y) - OriginY) * InverseY;
+        Float4 y1 = (Float4::Set1(max.y) - OriginY) * InverseY;
+        Float4 z0 = (Float4::Set1(min.z) - OriginZ) * InverseZ;
+        Float4 z1 = (Float4::Set1(max.z) - OriginZ) * InverseZ;
+        enter = Max(Max(Min(x0, x1), Min(y0, y1)), Max(Min(z0, z1), Float4::Set1(0.0f)));
+        Float4 exit = Min(Min(Max(x0, x1), Max(y0, y1)), Min(Max(z0, z1), Distance));
+        return MoveMask(LessEqual(enter, exit)) & Active;
+    }
+};
+
+// Bounding volume hierarchy over a triangle soup, built top-down with binned SAH splits. Nodes are stored
+// depth first in one array and the triangle corners are copied into leaf order, so traversal touches memory
+// mostly forwards and never goes back to the caller's vertex arrays.
+class TriangleBvh
+{
+public:
+    static constexpr uint32_t INVALID = 0xFFFFFFFFu;
+    static const uint32_t MAX_LEAF_SIZE = 4;
+
+    std::vector<BvhNode> Nodes;
+    std::vector<glm::vec3> Corners;     // three per triangle, in leaf order
+    std::vector<uint32_t> Triangles;    // leaf order -> input triangle
+
+    double BuildMs = 0.0;
+
+    // corners holds three positions per triangle
+    void Build(const std::vector<glm::vec3>& corners, JobSystem& jobs);
+
+    size_t TriangleCount() const { return Triangles.size(); }
+    bool Empty() const { return Nodes.empty(); }
+
+    // closest triangle the ray hits within maxDistance; returns the input triangle index or INVALID, and on a hit
+    // sets distance and the barycentric coordinates of the hit towards the second and third corner
+    uint32_t Intersect(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, float& distance, glm::vec2& barycentric) const;
+
+    // closest hits of the packet's active lanes; lanes that hit something nearer than their Distance get the hit's
+    // distance, barycentric coordinates and input triangle. Returns the lanes that were updated. The packet visits
+    // every node any of its rays enters, so it pays off for rays that start and point alike, like camera and sun rays.
+    int IntersectPacket(RayPacket& packet) const;
+
+    // number of triangles the ray crosses in front of its origin; odd means inside a closed mesh
+    uint32_t CountCrossings(const glm::vec3& origin, const glm::vec3& direction) const;
+
+    // pairs of input triangles (this, other) whose bounding boxes overlap, found by walking both trees together;
+    // the top of the walk is split into independent node pairs that run on the job system
+    std::vector<std::pair<uint32_t, uint32_t>> OverlappingPairs(const TriangleBvh& other, JobSystem& jobs) const;
+};
+
+#endif
@@ -0,0 +1,669 @@
+#include "csg.h"
+#include "bvh.h"
+#include "half_edge.h"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+
+const char* BooleanOperationName(Boolean_Operation operation)
+{
+    switch (operation)
+    {
+    case BOOLEAN_UNION: return "Union";
+    case BOOLEAN_DIFFERENCE: return "Difference";
+    case BOOLEAN_INTERSECTION: return "Intersection";
+    default: return "Unknown";
+    }
+}
+
+namespace
+{
+    // distances below this count as zero; operands are expected at roughly unit scale
+    const double EPSILON = 1.0e-9;
+    const size_t PAIR_GRAIN = 2048;
+    const size_t CUT_GRAIN = 64;
+    const size_t REGION_GRAIN = 16;
+    const uint32_t INVALID = 0xFFFFFFFFu;
+
+    // pieces of the result closer than this share a position; about a millionth of a unit, as in the half-edge weld
+    const double WELD_DISTANCE = 1.0 / 1048576.0;
+
+    using Polygon = std::vector<glm::dvec3>;
+
+    struct Cut
+    {
+        uint32_t Triangle;
+        glm::dvec3 From;
+        glm::dvec3 To;
+        uint32_t Partner = INVALID;     // for an edge of a coplanar triangle of the other operand, that triangle
+    };
+
+    // where a piece lies relative to the other operand; pieces on a coplanar face of it record which way it faces
+    enum Piece_Side : uint8_t {
+        SIDE_OUTSIDE,
+        SIDE_INSIDE,
+        SIDE_SAME,
+        SIDE_OPPOSITE
+    };
+
+    // a triangle of one operand with every cut the other operand made in it, and what they split it into
+    struct CutTriangle
+    {
+        uint32_t Triangle;
+        uint32_t FirstCut;
+        uint32_t CutCount;
+        std::vector<Polygon> Pieces;
+        std::vector<uint8_t> Side;
+    };
+
+    struct Operand
+    {
+        const MeshData* Mesh = nullptr;
+        std::vector<glm::vec3> Corners;         // three per triangle
+        TriangleBvh Bvh;
+        HalfEdgeMesh Topology;                  // face i is triangle i; its twins join regions of uncut triangles
+        std::vector<Cut> Cuts;                  // sorted by triangle
+        std::vector<CutTriangle> CutTriangles;
+        std::vector<uint32_t> Region;           // per triangle; INVALID for cut triangles
+        std::vector<uint32_t> RegionSeeds;      // a triangle of each region
+        std::vector<uint8_t> RegionInside;
+
+        size_t TriangleCount() const { return Mesh->Indices.size() / 3; }
+
+        glm::dvec3 Corner(uint32_t triangle, int k) const
+        {
+            return glm::dvec3(Corners[triangle * 3 + k]);
+        }
+    };
+
+    double elapsedMs(std::chrono::high_resolution_clock::time_point since)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - since).count();
+    }
+
+    void prepare(Operand& operand, const MeshData& mesh, JobSystem& jobs)
+    {
+        operand.Mesh = &mesh;
+        operand.Corners.resize(mesh.Indices.size());
+        for (size_t i = 0; i < mesh.Indices.size(); ++i)
+        {
+            const float* vertex = &mesh.Vertices[static_cast<size_t>(mesh.Indices[i]) * MeshData::STRIDE];
+            operand.Corners[i] = glm::vec3(vertex[0], vertex[1], vertex[2]);
+        }
+        operand.Bvh.Build(operand.Corners, jobs);
+        operand.Topology = HalfEdgeMesh::FromTriangles(mesh);
+    }
+
+    // The segment where the plane with signed corner distances d crosses triangle p, ordered along direction
+    bool planeCut(const glm::dvec3* p, const double* d, const glm::dvec3& direction, glm::dvec3& from, glm::dvec3& to)
+    {
+        glm::dvec3 points[3];
+        int count = 0;
+        for (int i = 0; i < 3; ++i)
+        {
+            int j = (i + 1) % 3;
+            if (d[i] == 0.0)
+                points[count++] = p[i];
+            else if (d[j] != 0.0 && (d[i] > 0.0) != (d[j] > 0.0))
+                points[count++] = p[i] + (p[j] - p[i]) * (d[i] / (d[i] - d[j]));
+        }
+        if (count < 2)
+            return false;
+        from = to = points[0];
+        for (int k = 1; k < count; ++k)
+        {
+            if (glm::dot(direction, points[k]) < glm::dot(direction, from))
+                from = points[k];
+            if (glm::dot(direction, points[k]) > glm::dot(direction, to))
+                to = points[k];
+        }
+        return true;
+    }
+
+    // distances of p's corners to the plane of q; false when p lies entirely on one side or in the plane
+    bool planeDistances(const glm::dvec3* p, const glm::dvec3* q, glm::dvec3& normal, double* d)
+    {
+        normal = glm::cross(q[1] - q[0], q[2] - q[0]);
+        double length = glm::length(normal);
+        if (length < EPSILON * EPSILON)
+            return false;
+        normal /= length;
+        int positive = 0, negative = 0;
+        for (int i = 0; i < 3; ++i)
+        {
+            d[i] = glm::dot(normal, p[i] - q[0]);
+            if (std::abs(d[i]) < EPSILON)
+                d[i] = 0.0;
+            positive += d[i] > 0.0;
+            negative += d[i] < 0.0;
+        }
+        return positive < 3 && negative < 3 && positive + negative > 0;
+    }
+
+    // Intersection segment of two triangles, from the overlap of their cuts along the line both planes share
+    bool intersectTriangles(const glm::dvec3* p, const glm::dvec3* q, glm::dvec3& from, glm::dvec3& to)
+    {
+        glm::dvec3 normalP, normalQ;
+        double dp[3], dq[3];
+        if (!planeDistances(p, q, normalQ, dp) || !planeDistances(q, p, normalP, dq))
+            return false;
+        glm::dvec3 direction = glm::cross(normalP, normalQ);
+        double length = glm::length(direction);
+        if (length < EPSILON)
+            return false;
+        direction /= length;
+
+        glm::dvec3 fromP, toP, fromQ, toQ;
+        if (!planeCut(p, dp, direction, fromP, toP) || !planeCut(q, dq, direction, fromQ, toQ))
+            return false;
+        from = glm::dot(direction, fromP) > glm::dot(direction, fromQ) ? fromP : fromQ;
+        to = glm::dot(direction, toP) < glm::dot(direction, toQ) ? toP : toQ;
+        return glm::dot(direction, to - from) > EPSILON;
+    }
+
+    // Triangles in one plane whose interiors overlap, found by the separating axis test on their edges' in-plane normals
+    bool coplanarOverlap(const glm::dvec3* p, const glm::dvec3* q)
+    {
+        glm::dvec3 normal = glm::cross(q[1] - q[0], q[2] - q[0]);
+        double length = glm::length(normal);
+        if (length < EPSILON * EPSILON || glm::length(glm::cross(p[1] - p[0], p[2] - p[0])) < EPSILON * EPSILON)
+            return false;
+        normal /= length;
+        for (int i = 0; i < 3; ++i)
+        {
+            if (std::abs(glm::dot(normal, p[i] - q[0])) >= EPSILON)
+                return false;
+        }
+        for (const glm::dvec3* triangle : { p, q })
+        {
+            for (int i = 0; i < 3; ++i)
+            {
+                glm::dvec3 axis = glm::cross(normal, triangle[(i + 1) % 3] - triangle[i]);
+                double lowP = glm::dot(axis, p[0]), highP = lowP, lowQ = glm::dot(axis, q[0]), highQ = lowQ;
+                for (int k = 1; k < 3; ++k)
+                {
+                    lowP = std::min(lowP, glm::dot(axis, p[k]));
+                    highP = std::max(highP, glm::dot(axis, p[k]));
+                    lowQ = std::min(lowQ, glm::dot(axis, q[k]));
+                    highQ = std::max(highQ, glm::dot(axis, q[k]));
+                }
+                double margin = EPSILON * glm::length(axis);
+                if (highP <= lowQ + margin || highQ <= lowP + margin)
+                    return false;
+            }
+        }
+        return true;
+    }
+
+    // true when part of the segment longer than EPSILON lies inside the convex piece (counter-clockwise around normal)
+    bool segmentCrosses(const Polygon& piece, const glm::dvec3& normal, const glm::dvec3& from, const glm::dvec3& to)
+    {
+        glm::dvec3 d = to - from;
+        double t0 = 0.0, t1 = 1.0;
+        for (size_t i = 0; i < piece.size(); ++i)
+        {
+            const glm::dvec3& a = piece[i];
+            const glm::dvec3& b = piece[(i + 1) % piece.size()];
+            glm::dvec3 inward = glm::cross(normal, b - a);
+            double start = glm::dot(inward, from - a);
+            double rate = glm::dot(inward, d);
+            if (std::abs(rate) < EPSILON * EPSILON)
+            {
+                if (start < 0.0)
+                    return false;
+                continue;
+            }
+            double t = -start / rate;
+            if (rate > 0.0)
+                t0 = std::max(t0, t);
+            else
+                t1 = std::min(t1, t);
+        }
+        return (t1 - t0) * glm::length(d) > EPSILON;
+    }
+
+    // splits a convex polygon by a plane; false if the plane does not pass through its interior
+    bool splitPolygon(const Polygon& polygon, const glm::dvec3& normal, double offset, Polygon& front, Polygon& back)
+    {
+        std::vector<double> distance(polygon.size());
+        bool positive = false, negative = false;
+        for (size_t i = 0; i < polygon.size(); ++i)
+        {
+            distance[i] = glm::dot(normal, polygon[i]) - offset;
+            if (std::abs(distance[i]) < EPSILON)
+                distance[i] = 0.0;
+            positive = positive || distance[i] > 0.0;
+            negative = negative || distance[i] < 0.0;
+        }
+        if (!positive || !negative)
+            return false;
+
+        for (size_t i = 0; i < polygon.size(); ++i)
+        {
+            size_t j = (i + 1) % polygon.size();
+            if (distance[i] >= 0.0)
+                front.push_back(polygon[i]);
+            if (distance[i] <= 0.0)
+                back.push_back(polygon[i]);
+            if ((distance[i] > 0.0 && distance[j] < 0.0) || (distance[i] < 0.0 && distance[j] > 0.0))
+            {
+                glm::dvec3 crossing = polygon[i] + (polygon[j] - polygon[i]) * (distance[i] / (distance[i] - distance[j]));
+                front.push_back(crossing);
+                back.push_back(crossing);
+            }
+        }
+        return front.size() >= 3 && back.size() >= 3;
+    }
+
+    // Cuts the triangle along the line of every segment that crosses a piece, so the intersection curve ends up
+    // on piece boundaries and each piece lies wholly inside or outside the other operand
+    std::vector<Polygon> splitTriangle(const glm::dvec3* corners, const Cut* cuts, size_t cutCount)
+    {
+        std::vector<Polygon> pieces = { Polygon(corners, corners + 3) };
+        glm::dvec3 normal = glm::cross(corners[1] - corners[0], corners[2] - corners[0]);
+        double area = glm::length(normal);
+        if (area < EPSILON * EPSILON)
+            return pieces;
+        normal /= area;
+
+        for (size_t c = 0; c < cutCount; ++c)
+        {
+            glm::dvec3 d = cuts[c].To - cuts[c].From;
+            if (glm::length(d) < EPSILON)
+                continue;
+            glm::dvec3 side = glm::normalize(glm::cross(d, normal));
+            double offset = glm::dot(side, cuts[c].From);
+            size_t existing = pieces.size();
+            for (size_t i = 0; i < existing; ++i)
+            {
+                if (!segmentCrosses(pieces[i], normal, cuts[c].From, cuts[c].To))
+                    continue;
+                Polygon front, back;
+                if (splitPolygon(pieces[i], side, offset, front, back))
+                {
+                    pieces[i] = std::move(front);
+                    pieces.push_back(std::move(back));
+                }
+            }
+        }
+        return pieces;
+    }
+
+    // majority of three ray parity tests, so a ray grazing an edge or vertex cannot flip the answer alone
+    bool isInside(const TriangleBvh& bvh, const glm::dvec3& point)
+    {
+        static const glm::vec3 directions[3] = {
+            glm::normalize(glm::vec3(0.5370f, 0.6411f, 0.5484f)),
+            glm::normalize(glm::vec3(-0.7127f, 0.2291f, 0.6631f)),
+            glm::normalize(glm::vec3(0.1953f, -0.8817f, 0.4297f))
+        };
+        glm::vec3 origin(point);
+        int votes = 0;
+        for (const glm::vec3& direction : directions)
+            votes += bvh.CountCrossings(origin, direction) & 1;
+        return votes >= 2;
+    }
+
+    glm::dvec3 centroid(const Polygon& polygon)
+    {
+        glm::dvec3 sum(0.0);
+        for (const glm::dvec3& point : polygon)
+            sum += point;
+        return sum / static_cast<double>(polygon.size());
+    }
+
+    glm::dvec3 barycentric(const glm::dvec3* corners, const glm::dvec3& point)
+    {
+        glm::dvec3 v1 = corners[1] - corners[0];
+        glm::dvec3 v2 = corners[2] - corners[0];
+        glm::dvec3 w = point - corners[0];
+        double d11 = glm::dot(v1, v1), d12 = glm::dot(v1, v2), d22 = glm::dot(v2, v2);
+        double w1 = glm::dot(w, v1), w2 = glm::dot(w, v2);
+        double denominator = d11 * d22 - d12 * d12;
+        if (std::abs(denominator) < EPSILON * EPSILON)
+            return glm::dvec3(1.0, 0.0, 0.0);
+        double b1 = (d22 * w1 - d12 * w2) / denominator;
+        double b2 = (d11 * w2 - d12 * w1) / denominator;
+        return glm::dvec3(1.0 - b1 - b2, b1, b2);
+    }
+
+    // Side of a piece: pieces were split along the edges of every coplanar triangle of the other operand, so each
+    // lies wholly on or off such a triangle, and one on it takes the facing of the pair instead of a parity test
+    uint8_t classifyPiece(const Operand& operand, const CutTriangle& cut, const Polygon& piece, const Operand& other)
+    {
+        glm::dvec3 center = centroid(piece);
+        for (uint32_t c = cut.FirstCut; c < cut.FirstCut + cut.CutCount; ++c)
+        {
+            uint32_t partner = operand.Cuts[c].Partner;
+            if (partner == INVALID || (c > cut.FirstCut && operand.Cuts[c - 1].Partner == partner))
+                continue;
+            glm::dvec3 corners[3] = { other.Corner(partner, 0), other.Corner(partner, 1), other.Corner(partner, 2) };
+            glm::dvec3 weights = barycentric(corners, center);
+            if (weights.x <= EPSILON || weights.y <= EPSILON || weights.z <= EPSILON)
+                continue;
+            glm::dvec3 own = glm::cross(operand.Corner(cut.Triangle, 1) - operand.Corner(cut.Triangle, 0), operand.Corner(cut.Triangle, 2) - operand.Corner(cut.Triangle, 0));
+            glm::dvec3 theirs = glm::cross(corners[1] - corners[0], corners[2] - corners[0]);
+            return glm::dot(own, theirs) > 0.0 ? SIDE_SAME : SIDE_OPPOSITE;
+        }
+        return isInside(other.Bvh, center) ? SIDE_INSIDE : SIDE_OUTSIDE;
+    }
+
+    void splitAndClassify(Operand& operand, const Operand& other, JobSystem& jobs, double& splitMs, double& classifyMs)
+    {
+        // group the sorted cuts by triangle
+        operand.CutTriangles.clear();
+        for (uint32_t c = 0; c < operand.Cuts.size();)
+        {
+            uint32_t end = c;
+            while (end < operand.Cuts.size() && operand.Cuts[end].Triangle == operand.Cuts[c].Triangle)
+                end++;
+            operand.CutTriangles.push_back({ operand.Cuts[c].Triangle, c, end - c, {}, {} });
+            c = end;
+        }
+
+        auto start = std::chrono::high_resolution_clock::now();
+        jobs.ParallelFor(operand.CutTriangles.size(), CUT_GRAIN, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i)
+            {
+                CutTriangle& cut = operand.CutTriangles[i];
+                glm::dvec3 corners[3] = { operand.Corner(cut.Triangle, 0), operand.Corner(cut.Triangle, 1), operand.Corner(cut.Triangle, 2) };
+                cut.Pieces = splitTriangle(corners, &operand.Cuts[cut.FirstCut], cut.CutCount);
+            }
+        });
+        splitMs += elapsedMs(start);
+
+        start = std::chrono::high_resolution_clock::now();
+        jobs.ParallelFor(operand.CutTriangles.size(), CUT_GRAIN, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i)
+            {
+                CutTriangle& cut = operand.CutTriangles[i];
+                cut.Side.resize(cut.Pieces.size());
+                for (size_t p = 0; p < cut.Pieces.size(); ++p)
+                    cut.Side[p] = classifyPiece(operand, cut, cut.Pieces[p], other);
+            }
+        });
+
+        // uncut triangles joined across shared edges form regions that are inside or outside as a whole
+        const size_t triangleCount = operand.TriangleCount();
+        operand.Region.assign(triangleCount, INVALID);
+        std::vector<uint8_t> isCut(triangleCount, 0);
+        for (const CutTriangle& cut : operand.CutTriangles)
+            isCut[cut.Triangle] = 1;
+        operand.RegionSeeds.clear();
+        std::vector<uint32_t> queue;
+        const HalfEdgeMesh& topology = operand.Topology;
+        for (uint32_t seed = 0; seed < triangleCount; ++seed)
+        {
+            if (isCut[seed] || operand.Region[seed] != INVALID)
+                continue;
+            uint32_t region = static_cast<uint32_t>(operand.RegionSeeds.size());
+            operand.RegionSeeds.push_back(seed);
+            operand.Region[seed] = region;
+            queue.assign(1, seed);
+            while (!queue.empty())
+            {
+                uint32_t face = queue.back();
+                queue.pop_back();
+                uint32_t first = topology.FaceEdge[face];
+                uint32_t edge = first;
+                do
+                {
+                    uint32_t twin = topology.EdgeTwin[edge];
+                    if (twin != HalfEdgeMesh::INVALID)
+                    {
+                        uint32_t neighbour = topology.EdgeFace[twin];
+                        if (!isCut[neighbour] && operand.Region[neighbour] == INVALID)
+                        {
+                            operand.Region[neighbour] = region;
+                            queue.push_back(neighbour);
+                        }
+                    }
+                    edge = topology.EdgeNext[edge];
+                } while (edge != first);
+            }
+        }
+
+        operand.RegionInside.resize(operand.RegionSeeds.size());
+        jobs.ParallelFor(operand.RegionSeeds.size(), REGION_GRAIN, [&](size_t begin, size_t end) {
+            for (size_t r = begin; r < end; ++r)
+            {
+                uint32_t seed = operand.RegionSeeds[r];
+                glm::dvec3 center = (operand.Corner(seed, 0) + operand.Corner(seed, 1) + operand.Corner(seed, 2)) / 3.0;
+                operand.RegionInside[r] = isInside(other.Bvh, center);
+            }
+        });
+        classifyMs += elapsedMs(start);
+    }
+
+    // which pieces and regions of an operand go into the result
+    struct Keep
+    {
+        bool Inside;            // inside the other operand rather than outside
+        bool Same;              // on a coplanar face of the other operand facing the same way
+        bool Opposite;          // on one facing the other way
+        bool Flip;              // reversed winding, so the part faces out of the result
+
+        bool Piece(uint8_t side) const
+        {
+            switch (side)
+            {
+            case SIDE_INSIDE: return Inside;
+            case SIDE_OUTSIDE: return !Inside;
+            case SIDE_SAME: return Same;
+            default: return Opposite;
+            }
+        }
+    };
+
+    // appends the kept part of an operand. Pieces of one triangle share the vertices on the lines that split them;
+    // weldVertices later joins pieces of neighbouring triangles and of the two operands
+    void appendKept(const Operand& operand, const Keep& keep, MeshData& result)
+    {
+        const MeshData& mesh = *operand.Mesh;
+        std::vector<uint32_t> remap(mesh.VertexCount(), INVALID);
+        auto copyVertex = [&](unsigned int vertex) {
+            if (remap[vertex] == INVALID)
+            {
+                const float* source = &mesh.Vertices[static_cast<size_t>(vertex) * MeshData::STRIDE];
+                remap[vertex] = result.AddVertex(source[0], source[1], source[2], source[3], source[4]);
+            }
+            return remap[vertex];
+        };
+        auto addTriangle = [&](unsigned int a, unsigned int b, unsigned int c) {
+            if (keep.Flip)
+                result.AddTriangle(a, c, b);
+            else
+                result.AddTriangle(a, b, c);
+        };
+
+        for (uint32_t t = 0; t < operand.TriangleCount(); ++t)
+        {
+            uint32_t region = operand.Region[t];
+            if (region == INVALID || (operand.RegionInside[region] != 0) != keep.Inside)
+                continue;
+            addTriangle(copyVertex(mesh.Indices[t * 3]), copyVertex(mesh.Indices[t * 3 + 1]), copyVertex(mesh.Indices[t * 3 + 2]));
+        }
+
+        std::vector<std::pair<glm::dvec3, unsigned int>> shared;
+        std::vector<unsigned int> indices;
+        for (const CutTriangle& cut : operand.CutTriangles)
+        {
+            glm::dvec3 corners[3] = { operand.Corner(cut.Triangle, 0), operand.Corner(cut.Triangle, 1), operand.Corner(cut.Triangle, 2) };
+            glm::vec2 uvs[3];
+            for (int k = 0; k < 3; ++k)
+            {
+                const float* source = &mesh.Vertices[static_cast<size_t>(mesh.Indices[cut.Triangle * 3 + k]) * MeshData::STRIDE];
+                uvs[k] = glm::vec2(source[3], source[4]);
+            }
+            shared.clear();
+            for (size_t p = 0; p < cut.Pieces.size(); ++p)
+            {
+                if (!keep.Piece(cut.Side[p]))
+                    continue;
+                const Polygon& piece = cut.Pieces[p];
+                indices.clear();
+                for (const glm::dvec3& point : piece)
+                {
+                    auto found = std::find_if(shared.begin(), shared.end(), [&](const std::pair<glm::dvec3, unsigned int>& entry) {
+                        return glm::length(entry.first - point) < EPSILON;
+                    });
+                    if (found != shared.end())
+                    {
+                        indices.push_back(found->second);
+                        continue;
+                    }
+                    glm::dvec3 weights = barycentric(corners, point);
+                    glm::vec2 uv = static_cast<float>(weights.x) * uvs[0] + static_cast<float>(weights.y) * uvs[1] + static_cast<float>(weights.z) * uvs[2];
+                    unsigned int index = result.AddVertex(static_cast<float>(point.x), static_cast<float>(point.y), static_cast<float>(point.z), uv.x, uv.y);
+                    shared.push_back({ point, index });
+                    indices.push_back(index);
+                }
+                for (size_t k = 1; k + 1 < indices.size(); ++k)
+                    addTriangle(indices[0], indices[k], indices[k + 1]);
+            }
+        }
+    }
+
+    // Moves every vertex within WELD_DISTANCE of an earlier one onto it, so the pieces of neighbouring triangles
+    // and of both operands meet exactly along their cut segments; ComputeNormals then smooths across them. Vertices
+    // are bucketed in cells of the weld distance and compared with the 27 cells around them.
+    void weldVertices(MeshData& mesh)
+    {
+        struct CellHash
+        {
+            size_t operator()(const glm::i64vec3& cell) const
+            {
+                uint64_t h = static_cast<uint64_t>(cell.x) * 0x9E3779B97F4A7C15ull;
+                h ^= static_cast<uint64_t>(cell.y) * 0xC2B2AE3D27D4EB4Full + (h << 6) + (h >> 2);
+                h ^= static_cast<uint64_t>(cell.z) * 0x165667B19E3779F9ull + (h << 6) + (h >> 2);
+                return static_cast<size_t>(h);
+            }
+        };
+        std::unordered_map<glm::i64vec3, uint32_t, CellHash> cells;
+        cells.reserve(mesh.VertexCount());
+        for (size_t v = 0; v < mesh.VertexCount(); ++v)
+        {
+            float* position = &mesh.Vertices[v * MeshData::STRIDE];
+            glm::dvec3 point(position[0], position[1], position[2]);
+            glm::i64vec3 cell(glm::floor(point / WELD_DISTANCE));
+            bool welded = false;
+            for (int dz = -1; dz <= 1 && !welded; ++dz)
+            {
+                for (int dy = -1; dy <= 1 && !welded; ++dy)
+                {
+                    for (int dx = -1; dx <= 1 && !welded; ++dx)
+                    {
+                        auto found = cells.find(cell + glm::i64vec3(dx, dy, dz));
+                        if (found == cells.end())
+                            continue;
+                        const float* target = &mesh.Vertices[static_cast<size_t>(found->second) * MeshData::STRIDE];
+                        if (glm::length(glm::dvec3(target[0], target[1], target[2]) - point) <= WELD_DISTANCE)
+                        {
+                            std::copy(target, target + 3, position);
+                            welded = true;
+                        }
+                    }
+                }
+            }
+            if (!welded)
+                cells.emplace(cell, static_cast<uint32_t>(v));
+        }
+    }
+}
+
+MeshData BooleanMesh(const MeshData& a, const MeshData& b, Boolean_Operation operation, JobSystem& jobs, BooleanStats* stats)
+{
+    BooleanStats local;
+    BooleanStats& s = stats != nullptr ? *stats : local;
+    s = BooleanStats();
+    auto total = std::chrono::high_resolution_clock::now();
+
+    Operand operands[2];
+    auto start = std::chrono::high_resolution_clock::now();
+    jobs.ParallelFor(2, 1, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+            prepare(operands[i], i == 0 ? a : b, jobs);
+    });
+    s.BvhMs = elapsedMs(start);
+
+    start = std::chrono::high_resolution_clock::now();
+    std::vector<std::pair<uint32_t, uint32_t>> pairs = operands[0].Bvh.OverlappingPairs(operands[1].Bvh, jobs);
+    s.CandidatePairs = pairs.size();
+    s.PairsMs = elapsedMs(start);
+
+    start = std::chrono::high_resolution_clock::now();
+    size_t chunks = (pairs.size() + PAIR_GRAIN - 1) / PAIR_GRAIN;
+    std::vector<std::vector<Cut>> cutsA(chunks), cutsB(chunks);
+    std::vector<size_t> intersecting(chunks, 0), coplanar(chunks, 0);
+    jobs.ParallelFor(chunks, 1, [&](size_t begin, size_t end) {
+        for (size_t chunk = begin; chunk < end; ++chunk)
+        {
+            size_t last = std::min(pairs.size(), (chunk + 1) * PAIR_GRAIN);
+            for (size_t i = chunk * PAIR_GRAIN; i < last; ++i)
+            {
+                uint32_t ta = pairs[i].first, tb = pairs[i].second;
+                glm::dvec3 p[3] = { operands[0].Corner(ta, 0), operands[0].Corner(ta, 1), operands[0].Corner(ta, 2) };
+                glm::dvec3 q[3] = { operands[1].Corner(tb, 0), operands[1].Corner(tb, 1), operands[1].Corner(tb, 2) };
+                glm::dvec3 from, to;
+                if (intersectTriangles(p, q, from, to))
+                {
+                    cutsA[chunk].push_back({ ta, from, to });
+                    cutsB[chunk].push_back({ tb, from, to });
+                    intersecting[chunk]++;
+                }
+                else if (coplanarOverlap(p, q))
+                {
+                    // each triangle is cut along the other's edges, which bound the overlap
+                    for (int k = 0; k < 3; ++k)
+                    {
+                        cutsA[chunk].push_back({ ta, q[k], q[(k + 1) % 3], tb });
+                        cutsB[chunk].push_back({ tb, p[k], p[(k + 1) % 3], ta });
+                    }
+                    coplanar[chunk]++;
+                }
+            }
+        }
+    });
+    for (size_t chunk = 0; chunk < chunks; ++chunk)
+    {
+        operands[0].Cuts.insert(operands[0].Cuts.end(), cutsA[chunk].begin(), cutsA[chunk].end());
+        operands[1].Cuts.insert(operands[1].Cuts.end(), cutsB[chunk].begin(), cutsB[chunk].end());
+        s.IntersectingPairs += intersecting[chunk];
+        s.CoplanarPairs += coplanar[chunk];
+    }
+    for (Operand& operand : operands)
+    {
+        std::stable_sort(operand.Cuts.begin(), operand.Cuts.end(), [](const Cut& x, const Cut& y) { return x.Triangle < y.Triangle; });
+    }
+    s.IntersectMs = elapsedMs(start);
+
+    splitAndClassify(operands[0], operands[1], jobs, s.SplitMs, s.ClassifyMs);
+    splitAndClassify(operands[1], operands[0], jobs, s.SplitMs, s.ClassifyMs);
+    for (const Operand& operand : operands)
+    {
+        s.CutTriangles += operand.CutTriangles.size();
+        s.Regions += operand.RegionSeeds.size();
+        for (const CutTriangle& cut : operand.CutTriangles)
+            s.Pieces += cut.Pieces.size();
+    }
+
+    start = std::chrono::high_resolution_clock::now();
+    // a coplanar overlap stays once: the first operand's face where both face the same way, except in a difference,
+    // and none where they face each other, except that a difference keeps the first operand's face
+    MeshData result;
+    bool difference = operation == BOOLEAN_DIFFERENCE;
+    appendKept(operands[0], { operation == BOOLEAN_INTERSECTION, !difference, difference, false }, result);
+    appendKept(operands[1], { operation != BOOLEAN_UNION, false, false, difference }, result);
+    weldVertices(result);
+    ComputeNormals(result);
+    s.OutputTriangles = result.Indices.size() / 3;
+    s.AssembleMs = elapsedMs(start);
+    s.TotalMs = elapsedMs(total);
+    return result;
+}
@@ -0,0 +1,45 @@
+#ifndef CSG_H
+#define CSG_H
+
+#include "primitives.h"
+#include "job_system.h"
+
+#include <cstddef>
+
+enum Boolean_Operation {
+    BOOLEAN_UNION,
+    BOOLEAN_DIFFERENCE,     // first operand minus the second
+    BOOLEAN_INTERSECTION,
+    BOOLEAN_OPERATION_COUNT
+};
+
+const char* BooleanOperationName(Boolean_Operation operation);
+
+struct BooleanStats
+{
+    size_t CandidatePairs = 0;      // triangle pairs whose bounding boxes overlap
+    size_t IntersectingPairs = 0;
+    size_t CoplanarPairs = 0;       // pairs overlapping in one plane, resolved by which way the two faces point
+    size_t CutTriangles = 0;
+    size_t Pieces = 0;              // convex pieces the cut triangles were split into
+    size_t Regions = 0;             // connected groups of uncut triangles, each classified by one inside test
+    size_t OutputTriangles = 0;
+    double BvhMs = 0.0;             // trees and adjacency of both operands
+    double PairsMs = 0.0;
+    double IntersectMs = 0.0;
+    double SplitMs = 0.0;
+    double ClassifyMs = 0.0;
+    double AssembleMs = 0.0;
+    double TotalMs = 0.0;
+};
+
+// Boolean of two closed triangle meshes given in the same space. Candidate triangle pairs come from walking the
+// operands' BVHs together; each pair is intersected in double precision and the resulting segments cut their
+// triangles into convex pieces along the intersection curve. Pieces, and connected regions of uncut triangles,
+// are kept or dropped by a majority of ray parity tests against the other operand. Coplanar overlaps are cut
+// along the other triangle's edges and kept or dropped by which way the faces point. Piece vertices are welded
+// along the cut segments, though pieces still meet their uncut neighbours with T-junctions. Every stage runs on
+// the job system.
+MeshData BooleanMesh(const MeshData& a, const MeshData& b, Boolean_Operation operation, JobSystem& jobs, BooleanStats* stats = nullptr);
+
+#endif
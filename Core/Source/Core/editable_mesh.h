@@ -0,0 +1,161 @@
+#ifndef EDITABLE_MESH_H
+#define EDITABLE_MESH_H
+
+#include <glad/glad.h>
+
+#include "half_edge.h"
+#include "mesh_pool.h"
+#include "job_system.h"
+#include "gpu_resources.h"
+#include "gl_state_cache.h"
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <cstdint>
+
+struct EditableMeshStats
+{
+    size_t ChangedVertices = 0;     // by the last Sync
+    size_t UploadedBytes = 0;
+    size_t UploadRanges = 0;        // glBufferSubData calls
+    double NormalsMs = 0.0;
+    double UploadMs = 0.0;
+    size_t Syncs = 0;
+};
+
+// A mesh in edit mode: half-edge topology on the CPU and a GPU copy of its wedges laid out like pooled meshes,
+// so objects draw it through the same Mesh interface with its seams and hard edges intact. The vertex buffer is
+// split into pages; Sync refreshes the normals around the edited vertices and re-uploads only the runs of pages
+// holding their wedges.
+class EditableMesh
+{
+public:
+    static const size_t PAGE_VERTICES = 1024;
+
+    HalfEdgeMesh Topology;
+    Mesh Gpu;
+    EditableMeshStats Stats;
+
+    EditableMesh(GpuResourceRegistry& registry, GLStateCache& state) : registry(registry), state(state)
+    {
+    }
+
+    EditableMesh(const EditableMesh&) = delete;
+    EditableMesh& operator=(const EditableMesh&) = delete;
+
+    // takes over the topology, computes its normals and uploads everything; desc records what it was made from
+    void Build(HalfEdgeMesh&& topology, const PrimitiveDesc& desc, const std::string& name, JobSystem& jobs)
+    {
+        Topology = std::move(topology);
+        Topology.ComputeNormals(jobs);
+        std::vector<unsigned int> indices = Topology.Triangulate();
+
+        Gpu.Desc = desc;
+        Gpu.VAO = GpuHandle::Create(registry, GPU_VERTEX_ARRAY, name);
+        Gpu.VBO = GpuHandle::Create(registry, GPU_BUFFER, name);
+        Gpu.EBO = GpuHandle::Create(registry, GPU_BUFFER, name + " indices");
+        Gpu.VertexCount = static_cast<unsigned int>(Topology.WedgeCount());
+        Gpu.IndexCount = static_cast<unsigned int>(indices.size());
+        Gpu.Positions.resize(Topology.VertexCount() * 3);
+        for (size_t v = 0; v < Topology.VertexCount(); ++v)
+            std::copy(&Topology.Positions[v].x, &Topology.Positions[v].x + 3, &Gpu.Positions[v * 3]);
+        Gpu.Radius = PositionsRadius(Gpu.Positions.data(), Topology.VertexCount(), 3);
+
+        staging.resize(Topology.WedgeCount() * MeshData::STRIDE);
+        Topology.WriteWedges(0, Topology.WedgeCount(), staging.data());
+
+        // wedges of each vertex in compressed rows, for finding the pages an edited vertex touches
+        wedgeStart.assign(Topology.VertexCount() + 1, 0);
+        for (uint32_t vertex : Topology.WedgeVertex)
+            wedgeStart[vertex + 1]++;
+        for (size_t v = 0; v < Topology.VertexCount(); ++v)
+            wedgeStart[v + 1] += wedgeStart[v];
+        vertexWedges.resize(Topology.WedgeCount());
+        std::vector<uint32_t> fill(wedgeStart.begin(), wedgeStart.end() - 1);
+        for (size_t w = 0; w < Topology.WedgeCount(); ++w)
+            vertexWedges[fill[Topology.WedgeVertex[w]]++] = static_cast<uint32_t>(w);
+
+        state.BindVertexArray(Gpu.VAO.ID());
+        state.BindBuffer(GL_ARRAY_BUFFER, Gpu.VBO.ID());
+        glBufferData(GL_ARRAY_BUFFER, staging.size() * sizeof(float), staging.data(), GL_DYNAMIC_DRAW);
+        Gpu.VBO.SetBytes(staging.size() * sizeof(float));
+        state.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, Gpu.EBO.ID());
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+        Gpu.EBO.SetBytes(indices.size() * sizeof(unsigned int));
+
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, MeshData::STRIDE * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, MeshData::STRIDE * sizeof(float), (void*)(3 * sizeof(float)));
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, MeshData::STRIDE * sizeof(float), (void*)(5 * sizeof(float)));
+        glEnableVertexAttribArray(2);
+        state.BindVertexArray(0);
+
+        dirtyPages.assign((Topology.WedgeCount() + PAGE_VERTICES - 1) / PAGE_VERTICES, 0);
+    }
+
+    // call after editing Topology through SetPosition/MarkDirty; returns false if nothing changed
+    bool Sync(JobSystem& jobs)
+    {
+        if (!Topology.HasDirty())
+            return false;
+
+        auto start = std::chrono::high_resolution_clock::now();
+        changed.clear();
+        Topology.UpdateNormals(jobs, changed);
+        for (uint32_t vertex : changed)
+        {
+            for (uint32_t k = wedgeStart[vertex]; k < wedgeStart[vertex + 1]; ++k)
+                dirtyPages[vertexWedges[k] / PAGE_VERTICES] = 1;
+            std::copy(&Topology.Positions[vertex].x, &Topology.Positions[vertex].x + 3, &Gpu.Positions[vertex * 3]);
+        }
+        // culling and picking bound the object by the radius, so it follows the sculpt both ways
+        if (!changed.empty())
+            Gpu.Radius = PositionsRadius(Gpu.Positions.data(), Topology.VertexCount(), 3);
+        auto normalsDone = std::chrono::high_resolution_clock::now();
+
+        // each run of consecutive dirty pages becomes one sub-upload
+        Stats.UploadedBytes = 0;
+        Stats.UploadRanges = 0;
+        state.BindBuffer(GL_ARRAY_BUFFER, Gpu.VBO.ID());
+        for (size_t page = 0; page < dirtyPages.size();)
+        {
+            if (!dirtyPages[page])
+            {
+                page++;
+                continue;
+            }
+            size_t end = page;
+            while (end < dirtyPages.size() && dirtyPages[end])
+                dirtyPages[end++] = 0;
+
+            size_t first = page * PAGE_VERTICES;
+            size_t count = std::min(end * PAGE_VERTICES, Topology.WedgeCount()) - first;
+            float* data = staging.data() + first * MeshData::STRIDE;
+            Topology.WriteWedges(first, count, data);
+            glBufferSubData(GL_ARRAY_BUFFER, first * MeshData::STRIDE * sizeof(float), count * MeshData::STRIDE * sizeof(float), data);
+            Stats.UploadedBytes += count * MeshData::STRIDE * sizeof(float);
+            Stats.UploadRanges++;
+            page = end;
+        }
+
+        Stats.ChangedVertices = changed.size();
+        Stats.NormalsMs = std::chrono::duration<double, std::milli>(normalsDone - start).count();
+        Stats.UploadMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - normalsDone).count();
+        Stats.Syncs++;
+        return true;
+    }
+
+private:
+    GpuResourceRegistry& registry;
+    GLStateCache& state;
+    std::vector<float> staging;         // interleaved copy of the whole vertex buffer
+    std::vector<uint8_t> dirtyPages;
+    std::vector<uint32_t> changed;
+    std::vector<uint32_t> wedgeStart;   // per vertex, its first entry in vertexWedges
+    std::vector<uint32_t> vertexWedges;
+};
+
+#endif
@@ -0,0 +1,591 @@
+#include "exporter.h"
+#include "buffered_writer.h"
+#include "json.h"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <unordered_map>
+
+namespace
+{
+    // items serialized per thread in each round; more keeps threads busy when items differ in size, fewer
+    // holds less output in memory
+    const size_t ITEMS_PER_THREAD = 4;
+
+    const uint32_t GLB_MAGIC = 0x46546C67;
+    const uint32_t GLB_CHUNK_JSON = 0x4E4F534A;
+    const uint32_t GLB_CHUNK_BIN = 0x004E4942;
+    const size_t VERTEX_STRIDE = MeshData::STRIDE * sizeof(float);
+
+    double millisecondsSince(std::chrono::high_resolution_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+
+    // shortest text that reads back as the same float
+    void appendNumber(std::string& out, float value)
+    {
+        char text[32];
+        auto result = std::to_chars(text, text + sizeof(text), std::isfinite(value) ? value : 0.0f);
+        out.append(text, result.ptr);
+    }
+
+    void appendNumber(std::string& out, uint64_t value)
+    {
+        char text[32];
+        auto result = std::to_chars(text, text + sizeof(text), value);
+        out.append(text, result.ptr);
+    }
+
+    void appendVector(std::string& out, const glm::vec3& value)
+    {
+        out += '[';
+        for (int c = 0; c < 3; ++c)
+        {
+            if (c > 0)
+                out += ',';
+            appendNumber(out, value[c]);
+        }
+        out += ']';
+    }
+
+    void appendBytes(std::string& out, const void* data, size_t size)
+    {
+        out.append(static_cast<const char*>(data), size);
+    }
+
+    void appendPadding(std::string& out)
+    {
+        out.append((4 - out.size() % 4) % 4, '\0');
+    }
+
+    // Serializes items in rounds of a few per thread and writes each round in order before serializing the next,
+    // so at most one round of output is in memory. beginRound(first, count) runs before each round on the calling
+    // thread; serialize(item, out) runs on the jobs; write(item, out) runs on the calling thread.
+    template <typename BeginRound, typename Serialize, typename Write>
+    void streamRounds(size_t count, JobSystem& jobs, ExportStats& stats, const BeginRound& beginRound, const Serialize& serialize, const Write& write)
+    {
+        size_t round = jobs.GetThreadCount() * ITEMS_PER_THREAD;
+        std::vector<std::string> chunks(round);
+        for (size_t first = 0; first < count; first += round)
+        {
+            size_t items = std::min(round, count - first);
+            auto start = std::chrono::high_resolution_clock::now();
+            beginRound(first, items);
+            jobs.ParallelFor(items, 1, [&](size_t begin, size_t end)
+            {
+                for (size_t i = begin; i < end; ++i)
+                    serialize(first + i, chunks[i]);
+            });
+            stats.SerializeMs += millisecondsSince(start);
+
+            size_t held = 0;
+            for (size_t i = 0; i < items; ++i)
+                held += chunks[i].capacity();
+            stats.PeakChunkBytes = std::max(stats.PeakChunkBytes, held);
+
+            start = std::chrono::high_resolution_clock::now();
+            for (size_t i = 0; i < items; ++i)
+            {
+                write(first + i, chunks[i]);
+                std::string().swap(chunks[i]);
+            }
+            stats.WriteMs += millisecondsSince(start);
+        }
+    }
+
+    // where a mesh's data landed in the binary buffer, and what the JSON needs to describe it
+    struct GltfMeshRecord
+    {
+        uint64_t Offset = 0;
+        uint32_t VertexCount = 0;
+        uint32_t IndexCount = 0;
+        bool ShortIndices = false;
+        size_t IndexOffset = 0;         // relative to Offset, like the ones below
+        size_t InstanceOffset = 0;      // translations, then scales
+        glm::vec3 Min = glm::vec3(0.0f);
+        glm::vec3 Max = glm::vec3(0.0f);
+    };
+
+    // interleaved vertices in the MeshData layout, then the indices (16 bit when they fit), then for meshes with
+    // several instances their translations and scales; every block starts on a multiple of four
+    void serializeGltfMesh(const MeshData& data, bool topDown, const std::vector<const ExportInstance*>& instances, std::string& out, GltfMeshRecord& record)
+    {
+        record.VertexCount = static_cast<uint32_t>(data.VertexCount());
+        record.IndexCount = static_cast<uint32_t>(data.Indices.size());
+        record.ShortIndices = record.VertexCount <= 0xFFFF;
+        size_t indexBytes = record.IndexCount * (record.ShortIndices ? 2 : 4);
+        size_t instanceBytes = instances.size() > 1 ? instances.size() * 2 * sizeof(glm::vec3) : 0;
+        out.reserve(data.Vertices.size() * sizeof(float) + indexBytes + 4 + instanceBytes);
+
+        record.Min = glm::vec3(INFINITY);
+        record.Max = glm::vec3(-INFINITY);
+        for (size_t v = 0; v < data.VertexCount(); ++v)
+        {
+            float vertex[MeshData::STRIDE];
+            std::memcpy(vertex, &data.Vertices[v * MeshData::STRIDE], sizeof(vertex));
+            if (!topDown)
+                vertex[4] = 1.0f - vertex[4];
+            glm::vec3 position(vertex[0], vertex[1], vertex[2]);
+            record.Min = glm::min(record.Min, position);
+            record.Max = glm::max(record.Max, position);
+            appendBytes(out, vertex, sizeof(vertex));
+        }
+
+        record.IndexOffset = out.size();
+        if (record.ShortIndices)
+        {
+            for (unsigned int index : data.Indices)
+            {
+                uint16_t value = static_cast<uint16_t>(index);
+                appendBytes(out, &value, sizeof(value));
+            }
+        }
+        else
+            appendBytes(out, data.Indices.data(), indexBytes);
+        appendPadding(out);
+
+        record.InstanceOffset = out.size();
+        if (instances.size() > 1)
+        {
+            for (const ExportInstance* instance : instances)
+                appendBytes(out, &instance->Position, sizeof(glm::vec3));
+            for (const ExportInstance* instance : instances)
+                appendBytes(out, &instance->Scale, sizeof(glm::vec3));
+        }
+    }
+
+    void appendBufferView(std::string& json, bool& first, uint64_t offset, uint64_t length, size_t stride, int target)
+    {
+        json += first ? "{\"buffer\":0,\"byteOffset\":" : ",{\"buffer\":0,\"byteOffset\":";
+        first = false;
+        appendNumber(json, offset);
+        json += ",\"byteLength\":";
+        appendNumber(json, length);
+        if (stride != 0)
+        {
+            json += ",\"byteStride\":";
+            appendNumber(json, static_cast<uint64_t>(stride));
+        }
+        if (target != 0)
+        {
+            json += ",\"target\":";
+            appendNumber(json, static_cast<uint64_t>(target));
+        }
+        json += '}';
+    }
+
+    void appendAccessor(std::string& json, bool& first, size_t view, size_t offset, int componentType, uint64_t count, const char* type)
+    {
+        json += first ? "{\"bufferView\":" : ",{\"bufferView\":";
+        first = false;
+        appendNumber(json, static_cast<uint64_t>(view));
+        if (offset != 0)
+        {
+            json += ",\"byteOffset\":";
+            appendNumber(json, static_cast<uint64_t>(offset));
+        }
+        json += ",\"componentType\":";
+        appendNumber(json, static_cast<uint64_t>(componentType));
+        json += ",\"count\":";
+        appendNumber(json, count);
+        json += ",\"type\":\"";
+        json += type;
+        json += '"';
+    }
+
+    bool exportGltf(const ExportScene& scene, const std::string& path, bool binary, JobSystem& jobs, std::string& error, ExportStats& stats)
+    {
+        // meshes in first use order, each with the instances placing it
+        std::vector<uint32_t> meshes;
+        std::vector<std::vector<const ExportInstance*>> placements(scene.MeshNames.size());
+        for (const ExportInstance& instance : scene.Instances)
+        {
+            if (placements[instance.Mesh].empty())
+                meshes.push_back(instance.Mesh);
+            placements[instance.Mesh].push_back(&instance);
+        }
+
+        // .gltf keeps the binary data next to it for good; GLB only until it is copied in behind the JSON
+        size_t dot = path.find_last_of('.');
+        size_t slash = path.find_last_of("/\\");
+        std::string stem = dot != std::string::npos && (slash == std::string::npos || dot > slash) ? path.substr(0, dot) : path;
+        std::string binaryPath = binary ? path + ".bin.tmp" : stem + ".bin";
+        BufferedWriter data;
+        if (!data.Open(binaryPath))
+        {
+            error = "cannot write " + binaryPath;
+            return false;
+        }
+
+        std::vector<GltfMeshRecord> records(meshes.size());
+        streamRounds(meshes.size(), jobs, stats,
+            [](size_t, size_t) {},
+            [&](size_t i, std::string& out)
+            {
+                uint32_t mesh = meshes[i];
+                MeshData meshData = scene.ReadMesh(mesh);
+                bool topDown = mesh < scene.TopDownTexCoords.size() && scene.TopDownTexCoords[mesh];
+                serializeGltfMesh(meshData, topDown, placements[mesh], out, records[i]);
+            },
+            [&](size_t i, const std::string& out)
+            {
+                records[i].Offset = data.BytesWritten();
+                data.Write(out);
+            });
+        uint64_t binaryBytes = data.BytesWritten();
+        if (!data.Close())
+        {
+            error = "writing " + binaryPath + " failed";
+            std::remove(binaryPath.c_str());
+            return false;
+        }
+        auto start = std::chrono::high_resolution_clock::now();
+
+        // glTF allows no empty buffer views or accessors, so meshes without triangles are left out
+        std::vector<size_t> kept;
+        for (size_t i = 0; i < meshes.size(); ++i)
+        {
+            if (records[i].VertexCount > 0 && records[i].IndexCount > 0)
+                kept.push_back(i);
+        }
+
+        std::string json = "{\"asset\":{\"version\":\"2.0\",\"generator\":\"MixerGL\"}";
+        bool instancing = false;
+        for (size_t i : kept)
+            instancing = instancing || placements[meshes[i]].size() > 1;
+        if (instancing)
+            json += ",\"extensionsUsed\":[\"EXT_mesh_gpu_instancing\"]";
+        json += ",\"buffers\":[{\"byteLength\":";
+        appendNumber(json, binaryBytes);
+        if (!binary)
+        {
+            json += ",\"uri\":";
+            AppendJsonString(json, binaryPath.substr(slash == std::string::npos ? 0 : slash + 1));
+        }
+        json += "}]";
+
+        // four views per mesh at most: vertices, indices, instance translations and scales
+        std::vector<size_t> firstView(meshes.size());
+        std::vector<size_t> firstAccessor(meshes.size());
+        json += ",\"bufferViews\":[";
+        bool first = true;
+        size_t views = 0;
+        for (size_t i : kept)
+        {
+            const GltfMeshRecord& record = records[i];
+            size_t instances = placements[meshes[i]].size();
+            firstView[i] = views;
+            appendBufferView(json, first, record.Offset, uint64_t(record.VertexCount) * VERTEX_STRIDE, VERTEX_STRIDE, 34962);
+            appendBufferView(json, first, record.Offset + record.IndexOffset, uint64_t(record.IndexCount) * (record.ShortIndices ? 2 : 4), 0, 34963);
+            views += 2;
+            if (instances > 1)
+            {
+                uint64_t bytes = instances * sizeof(glm::vec3);
+                appendBufferView(json, first, record.Offset + record.InstanceOffset, bytes, 0, 0);
+                appendBufferView(json, first, record.Offset + record.InstanceOffset + bytes, bytes, 0, 0);
+                views += 2;
+            }
+        }
+        json += "],\"accessors\":[";
+        first = true;
+        size_t accessors = 0;
+        for (size_t i : kept)
+        {
+            const GltfMeshRecord& record = records[i];
+            size_t instances = placements[meshes[i]].size();
+            size_t view = firstView[i];
+            firstAccessor[i] = accessors;
+            appendAccessor(json, first, view, 0, 5126, record.VertexCount, "VEC3");
+            json += ",\"min\":";
+            appendVector(json, record.Min);
+            json += ",\"max\":";
+            appendVector(json, record.Max);
+            json += '}';
+            appendAccessor(json, first, view, 3 * sizeof(float), 5126, record.VertexCount, "VEC2");
+            json += '}';
+            appendAccessor(json, first, view, 5 * sizeof(float), 5126, record.VertexCount, "VEC3");
+            json += '}';
+            appendAccessor(json, first, view + 1, 0, record.ShortIndices ? 5123 : 5125, record.IndexCount, "SCALAR");
+            json += '}';
+            accessors += 4;
+            if (instances > 1)
+            {
+                appendAccessor(json, first, view + 2, 0, 5126, instances, "VEC3");
+                json += '}';
+                appendAccessor(json, first, view + 3, 0, 5126, instances, "VEC3");
+                json += '}';
+                accessors += 2;
+            }
+        }
+        json += "],\"meshes\":[";
+        for (size_t k = 0; k < kept.size(); ++k)
+        {
+            size_t i = kept[k];
+            size_t a = firstAccessor[i];
+            json += k > 0 ? ",{\"name\":" : "{\"name\":";
+            AppendJsonString(json, scene.MeshNames[meshes[i]]);
+            json += ",\"primitives\":[{\"attributes\":{\"POSITION\":";
+            appendNumber(json, static_cast<uint64_t>(a));
+            json += ",\"TEXCOORD_0\":";
+            appendNumber(json, static_cast<uint64_t>(a + 1));
+            json += ",\"NORMAL\":";
+            appendNumber(json, static_cast<uint64_t>(a + 2));
+            json += "},\"indices\":";
+            appendNumber(json, static_cast<uint64_t>(a + 3));
+            json += "}]}";
+        }
+
+        // a mesh with one instance gets a plain node, one with several a single instanced node
+        json += "],\"nodes\":[";
+        size_t nodes = 0;
+        for (size_t k = 0; k < kept.size(); ++k)
+        {
+            size_t i = kept[k];
+            const std::vector<const ExportInstance*>& instances = placements[meshes[i]];
+            json += nodes > 0 ? ",{\"mesh\":" : "{\"mesh\":";
+            appendNumber(json, static_cast<uint64_t>(k));
+            if (instances.size() > 1)
+            {
+                size_t a = firstAccessor[i] + 4;
+                json += ",\"extensions\":{\"EXT_mesh_gpu_instancing\":{\"attributes\":{\"TRANSLATION\":";
+                appendNumber(json, static_cast<uint64_t>(a));
+                json += ",\"SCALE\":";
+                appendNumber(json, static_cast<uint64_t>(a + 1));
+                json += "}}}}";
+                stats.InstancedMeshes++;
+            }
+            else
+            {
+                json += ",\"translation\":";
+                appendVector(json, instances[0]->Position);
+                json += ",\"scale\":";
+                appendVector(json, instances[0]->Scale);
+                json += '}';
+            }
+            nodes++;
+        }
+        json += "],\"scene\":0,\"scenes\":[{\"nodes\":[";
+        for (size_t n = 0; n < nodes; ++n)
+        {
+            if (n > 0)
+                json += ',';
+            appendNumber(json, static_cast<uint64_t>(n));
+        }
+        json += "]}]}";
+
+        BufferedWriter file;
+        if (!file.Open(path))
+        {
+            error = "cannot write " + path;
+            std::remove(binaryPath.c_str());
+            return false;
+        }
+        if (binary)
+        {
+            // GLB lengths are 32 bit
+            json.append((4 - json.size() % 4) % 4, ' ');
+            uint64_t total = 12 + 8 + json.size() + 8 + binaryBytes;
+            if (total > 0xFFFFFFFFu)
+            {
+                error = "scene too large for GLB, export as .gltf instead";
+                file.Close();
+                std::remove(path.c_str());
+                std::remove(binaryPath.c_str());
+                return false;
+            }
+            uint32_t header[5] = { GLB_MAGIC, 2, static_cast<uint32_t>(total), static_cast<uint32_t>(json.size()), GLB_CHUNK_JSON };
+            file.Write(header, sizeof(header));
+            file.Write(json);
+            uint32_t chunk[2] = { static_cast<uint32_t>(binaryBytes), GLB_CHUNK_BIN };
+            file.Write(chunk, sizeof(chunk));
+            file.Append(binaryPath);
+            std::remove(binaryPath.c_str());
+        }
+        else
+            file.Write(json);
+        bool written = file.Close();
+        stats.WriteMs += millisecondsSince(start);
+        stats.Bytes = file.BytesWritten() + (binary ? 0 : binaryBytes);
+        stats.Meshes = kept.size();
+        if (!written)
+            error = "writing " + path + " failed";
+        return written;
+    }
+
+    void appendObjTriple(std::string& out, uint64_t index)
+    {
+        appendNumber(out, index);
+        out += '/';
+        appendNumber(out, index);
+        out += '/';
+        appendNumber(out, index);
+    }
+
+    bool exportObj(const ExportScene& scene, const std::string& path, JobSystem& jobs, std::string& error, ExportStats& stats)
+    {
+        BufferedWriter file;
+        if (!file.Open(path))
+        {
+            error = "cannot write " + path;
+            return false;
+        }
+        file.Write(std::string("# MixerGL export, ") + std::to_string(scene.Instances.size()) + " objects\n");
+
+        // instances grouped by mesh, so a mesh read for one round usually serves the next one too
+        std::vector<uint32_t> order(scene.Instances.size());
+        for (size_t i = 0; i < order.size(); ++i)
+            order[i] = static_cast<uint32_t>(i);
+        std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return scene.Instances[a].Mesh < scene.Instances[b].Mesh; });
+
+        // OBJ indices count every vertex before them in the file, so each round needs its meshes before formatting
+        std::unordered_map<uint32_t, MeshData> roundMeshes;
+        std::vector<uint64_t> firstVertex(order.size() + 1, 1);
+        streamRounds(order.size(), jobs, stats,
+            [&](size_t first, size_t count)
+            {
+                std::unordered_map<uint32_t, MeshData> kept;
+                std::vector<uint32_t> missing;
+                for (size_t i = first; i < first + count; ++i)
+                {
+                    uint32_t mesh = scene.Instances[order[i]].Mesh;
+                    if (kept.count(mesh) != 0)
+                        continue;
+                    auto previous = roundMeshes.find(mesh);
+                    if (previous != roundMeshes.end())
+                        kept[mesh] = std::move(previous->second);
+                    else
+                    {
+                        kept[mesh];
+                        missing.push_back(mesh);
+                    }
+                }
+                jobs.ParallelFor(missing.size(), 1, [&](size_t begin, size_t end)
+                {
+                    for (size_t m = begin; m < end; ++m)
+                        kept.find(missing[m])->second = scene.ReadMesh(missing[m]);
+                });
+                stats.Meshes += missing.size();
+                roundMeshes = std::move(kept);
+                for (size_t i = first; i < first + count; ++i)
+                    firstVertex[i + 1] = firstVertex[i] + roundMeshes[scene.Instances[order[i]].Mesh].VertexCount();
+            },
+            [&](size_t i, std::string& out)
+            {
+                const ExportInstance& instance = scene.Instances[order[i]];
+                const MeshData& data = roundMeshes.find(instance.Mesh)->second;
+                bool topDown = instance.Mesh < scene.TopDownTexCoords.size() && scene.TopDownTexCoords[instance.Mesh];
+                // normals follow the inverse of the scale; a mirroring scale turns the triangles inside out
+                glm::vec3 normalScale = 1.0f / instance.Scale;
+                bool mirrored = instance.Scale.x * instance.Scale.y * instance.Scale.z < 0.0f;
+                out.reserve(data.VertexCount() * 96 + data.Indices.size() * 12);
+
+                out += "o object_";
+                appendNumber(out, static_cast<uint64_t>(order[i]));
+                out += '\n';
+                for (size_t v = 0; v < data.VertexCount(); ++v)
+                {
+                    const float* vertex = &data.Vertices[v * MeshData::STRIDE];
+                    glm::vec3 position = glm::vec3(vertex[0], vertex[1], vertex[2]) * instance.Scale + instance.Position;
+                    out += "v ";
+                    appendNumber(out, position.x);
+                    out += ' ';
+                    appendNumber(out, position.y);
+                    out += ' ';
+                    appendNumber(out, position.z);
+                    out += "\nvt ";
+                    appendNumber(out, vertex[3]);
+                    out += ' ';
+                    appendNumber(out, topDown ? 1.0f - vertex[4] : vertex[4]);
+                    glm::vec3 normal = glm::vec3(vertex[5], vertex[6], vertex[7]) * normalScale;
+                    float length = glm::length(normal);
+                    normal = length > 0.0f ? normal / length : normal;
+                    out += "\nvn ";
+                    appendNumber(out, normal.x);
+                    out += ' ';
+                    appendNumber(out, normal.y);
+                    out += ' ';
+                    appendNumber(out, normal.z);
+                    out += '\n';
+                }
+                uint64_t base = firstVertex[i];
+                for (size_t t = 0; t + 2 < data.Indices.size(); t += 3)
+                {
+                    unsigned int b = data.Indices[t + (mirrored ? 2 : 1)];
+                    unsigned int c = data.Indices[t + (mirrored ? 1 : 2)];
+                    out += "f ";
+                    appendObjTriple(out, base + data.Indices[t]);
+                    out += ' ';
+                    appendObjTriple(out, base + b);
+                    out += ' ';
+                    appendObjTriple(out, base + c);
+                    out += '\n';
+                }
+            },
+            [&](size_t, const std::string& out)
+            {
+                file.Write(out);
+            });
+
+        auto start = std::chrono::high_resolution_clock::now();
+        bool written = file.Close();
+        stats.WriteMs += millisecondsSince(start);
+        stats.Bytes = file.BytesWritten();
+        if (!written)
+            error = "writing " + path + " failed";
+        return written;
+    }
+}
+
+const char* ExportFormatName(Export_Format format)
+{
+    switch (format)
+    {
+    case EXPORT_GLB: return "glTF binary";
+    case EXPORT_GLTF: return "glTF with .bin";
+    case EXPORT_OBJ: return "Wavefront OBJ";
+    default: return "Unknown";
+    }
+}
+
+const char* ExportFormatExtension(Export_Format format)
+{
+    switch (format)
+    {
+    case EXPORT_GLB: return ".glb";
+    case EXPORT_GLTF: return ".gltf";
+    case EXPORT_OBJ: return ".obj";
+    default: return "";
+    }
+}
+
+bool ExportToFile(const ExportScene& scene, const std::string& path, Export_Format format, JobSystem& jobs, std::string& error, ExportStats* stats)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    ExportStats local;
+    local.Instances = scene.Instances.size();
+    if (scene.Instances.empty())
+    {
+        error = "nothing to export";
+        return false;
+    }
+    for (const ExportInstance& instance : scene.Instances)
+    {
+        if (instance.Mesh >= scene.MeshNames.size())
+        {
+            error = "instance refers to a missing mesh";
+            return false;
+        }
+    }
+
+    bool exported = format == EXPORT_OBJ ? exportObj(scene, path, jobs, error, local)
+        : exportGltf(scene, path, format == EXPORT_GLB, jobs, error, local);
+    local.TotalMs = millisecondsSince(start);
+    if (stats != nullptr)
+        *stats = local;
+    return exported;
+}
@@ -0,0 +1,62 @@
+#ifndef EXPORTER_H
+#define EXPORTER_H
+
+#include "primitives.h"
+#include "job_system.h"
+
+#include <glm/glm.hpp>
+
+#include <functional>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+enum Export_Format {
+    EXPORT_GLB,
+    EXPORT_GLTF,    // JSON with the binary data in a .bin next to it
+    EXPORT_OBJ,
+    EXPORT_FORMAT_COUNT
+};
+
+const char* ExportFormatName(Export_Format format);
+// file extension including the dot
+const char* ExportFormatExtension(Export_Format format);
+
+struct ExportInstance
+{
+    uint32_t Mesh = 0;
+    glm::vec3 Position = glm::vec3(0.0f);
+    glm::vec3 Scale = glm::vec3(1.0f);
+};
+
+// What to write. Instances refer to meshes by index, so instances sharing a mesh are written with one copy of it.
+struct ExportScene
+{
+    std::vector<std::string> MeshNames;
+    std::vector<bool> TopDownTexCoords;     // per mesh: v = 0 is the first image row (glTF) rather than the last (GL, OBJ)
+    std::vector<ExportInstance> Instances;
+    // builds one mesh; called on job threads, concurrently for different meshes
+    std::function<MeshData(uint32_t mesh)> ReadMesh;
+};
+
+struct ExportStats
+{
+    uint64_t Bytes = 0;
+    size_t Meshes = 0;              // meshes read and serialized
+    size_t Instances = 0;
+    size_t InstancedMeshes = 0;     // glTF meshes written once for several instances with EXT_mesh_gpu_instancing
+    size_t PeakChunkBytes = 0;      // most serialized output held at once, waiting for the writer
+    double SerializeMs = 0.0;
+    double WriteMs = 0.0;
+    double TotalMs = 0.0;
+};
+
+// Streams the scene to path. Meshes are read and serialized a round at a time, a few per job system thread in
+// parallel, and each round is written through a BufferedWriter in order before the next one starts, so memory
+// holds one round of output rather than the whole file. glTF meshes with several instances are written once and
+// placed with EXT_mesh_gpu_instancing; GLB streams its binary chunk to a temporary file first, since the JSON that
+// describes it has to come before it. OBJ has no instancing, so every instance is written out in world space.
+bool ExportToFile(const ExportScene& scene, const std::string& path, Export_Format format, JobSystem& jobs, std::string& error, ExportStats* stats = nullptr);
+
+#endif
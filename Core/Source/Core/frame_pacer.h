@@ -0,0 +1,109 @@
+#ifndef FRAME_PACER_H
+#define FRAME_PACER_H
+
+#include <glad/glad.h>
+
+#include <deque>
+#include <chrono>
+
+// Keeps the CPU from queueing frames far ahead of the GPU, so input read at the start of a frame reaches the screen
+// sooner. Every presented frame gets a fence; before the next frame samples input, the pacer waits until at most
+// MaxFramesInFlight - 1 earlier frames are still executing. Also measures the time from the oldest input event a
+// frame consumed to the return of its buffer swap.
+class FramePacer
+{
+public:
+    struct Stats
+    {
+        unsigned int FramesInFlight = 0;    // unfinished frames when the last frame started
+        double WaitMs = 0.0;                // CPU time the last frame spent waiting for the GPU
+        double LatencyMs = 0.0;             // event to swap of the last frame that consumed input
+        double AverageLatencyMs = 0.0;      // exponential average over input frames
+        double MaxLatencyMs = 0.0;
+        unsigned long long InputFrames = 0;
+    };
+
+    unsigned int MaxFramesInFlight = 1;     // 0 lets the driver queue as many frames as it likes
+
+    // call with the time of every input event, as seen by the window system callbacks
+    void InputEvent(double time)
+    {
+        if (pendingInput < 0.0)
+            pendingInput = time;
+    }
+
+    // blocks until the GPU has caught up to the frame limit; call before sampling input for the next frame
+    void WaitForGpu()
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        retireSignaled();
+        stats.FramesInFlight = static_cast<unsigned int>(fences.size());
+        while (MaxFramesInFlight > 0 && fences.size() >= MaxFramesInFlight)
+        {
+            // flushing on the first wait makes sure the fence was submitted at all
+            GLenum result = glClientWaitSync(fences.front(), GL_SYNC_FLUSH_COMMANDS_BIT, 100000000); // 100 ms
+            if (result == GL_TIMEOUT_EXPIRED)
+                continue;
+            glDeleteSync(fences.front());
+            fences.pop_front();
+        }
+        stats.WaitMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+
+    // input events received so far belong to the frame that is about to be built
+    void InputSampled()
+    {
+        frameInput = pendingInput;
+        pendingInput = -1.0;
+    }
+
+    // call right after the buffer swap with the same clock as InputEvent
+    void FramePresented(double time)
+    {
+        fences.push_back(glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+        if (frameInput < 0.0)
+            return;
+
+        stats.LatencyMs = (time - frameInput) * 1000.0;
+        stats.AverageLatencyMs = stats.InputFrames == 0 ? stats.LatencyMs : stats.AverageLatencyMs * 0.9 + stats.LatencyMs * 0.1;
+        if (stats.LatencyMs > stats.MaxLatencyMs)
+            stats.MaxLatencyMs = stats.LatencyMs;
+        stats.InputFrames++;
+        frameInput = -1.0;
+    }
+
+    void ResetLatency()
+    {
+        stats.AverageLatencyMs = 0.0;
+        stats.MaxLatencyMs = 0.0;
+        stats.InputFrames = 0;
+    }
+
+    // deletes outstanding fences; call while the context is still current
+    void Clear()
+    {
+        for (GLsync fence : fences)
+            glDeleteSync(fence);
+        fences.clear();
+    }
+
+    const Stats& GetStats() const { return stats; }
+
+private:
+    std::deque<GLsync> fences;  // one per presented frame, oldest first
+    double pendingInput = -1.0; // oldest event not yet sampled by a frame
+    double frameInput = -1.0;   // oldest event the current frame consumed
+    Stats stats;
+
+    // fences signal in order, so the first unsignaled one ends the scan
+    void retireSignaled()
+    {
+        while (!fences.empty() && glClientWaitSync(fences.front(), 0, 0) != GL_TIMEOUT_EXPIRED)
+        {
+            glDeleteSync(fences.front());
+            fences.pop_front();
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,236 @@
+#ifndef GL_DEBUG_H
+#define GL_DEBUG_H
+
+#include <glad/glad.h>
+
+#include "gpu_resources.h"
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <functional>
+#include <cstring>
+
+// Categories GL debug messages are counted under
+enum GL_Debug_Category {
+    GL_DEBUG_CATEGORY_ERROR,
+    GL_DEBUG_CATEGORY_PERFORMANCE,
+    GL_DEBUG_CATEGORY_DEPRECATED,
+    GL_DEBUG_CATEGORY_UNDEFINED,
+    GL_DEBUG_CATEGORY_PORTABILITY,
+    GL_DEBUG_CATEGORY_OTHER,
+    GL_DEBUG_CATEGORY_COUNT
+};
+
+inline const char* GLDebugCategoryName(GL_Debug_Category category)
+{
+    switch (category)
+    {
+    case GL_DEBUG_CATEGORY_ERROR: return "Error";
+    case GL_DEBUG_CATEGORY_PERFORMANCE: return "Performance";
+    case GL_DEBUG_CATEGORY_DEPRECATED: return "Deprecated";
+    case GL_DEBUG_CATEGORY_UNDEFINED: return "Undefined behavior";
+    case GL_DEBUG_CATEGORY_PORTABILITY: return "Portability";
+    default: return "Other";
+    }
+}
+
+// Routes KHR_debug output into a log sink. Repeated messages are logged once and counted afterwards.
+// Without KHR_debug it falls back to polling glGetError once per frame.
+class GLDebugOutput
+{
+public:
+    typedef std::function<void(const std::string&)> Sink;
+
+    // one distinct driver message and how often it was reported
+    struct Message
+    {
+        GL_Debug_Category Category;
+        GLenum Severity;
+        std::string Text;
+        unsigned int Count;
+    };
+
+    unsigned int FrameCounts[GL_DEBUG_CATEGORY_COUNT] = {};
+    unsigned int LastFrameCounts[GL_DEBUG_CATEGORY_COUNT] = {};
+    unsigned int TotalCounts[GL_DEBUG_CATEGORY_COUNT] = {};
+
+    // installs the callback on the current context; returns false if only the glGetError fallback is available
+    bool Install(GLADloadproc load, Sink logSink)
+    {
+        sink = logSink;
+        available = GLAD_GL_VERSION_4_3 || loadExtension(load);
+        if (!available)
+            return false;
+
+        glEnable(GL_DEBUG_OUTPUT);
+        glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS); // deliver on the calling thread so the message lines up with the offending call
+        glDebugMessageCallback(&GLDebugOutput::callback, this);
+        glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 0, nullptr, GL_TRUE);
+        // our own group markers would otherwise be echoed back as messages
+        glDebugMessageControl(GL_DONT_CARE, GL_DEBUG_TYPE_PUSH_GROUP, GL_DONT_CARE, 0, nullptr, GL_FALSE);
+        glDebugMessageControl(GL_DONT_CARE, GL_DEBUG_TYPE_POP_GROUP, GL_DONT_CARE, 0, nullptr, GL_FALSE);
+        return true;
+    }
+
+    bool IsAvailable() const
+    {
+        return available;
+    }
+
+    // publishes the per-frame counters; call once at the start of every frame
+    void BeginFrame()
+    {
+        if (!available)
+            pollErrors();
+        std::memcpy(LastFrameCounts, FrameCounts, sizeof(FrameCounts));
+        std::memset(FrameCounts, 0, sizeof(FrameCounts));
+    }
+
+    // attaches the registry owner tag as the debug label of every newly created object
+    void LabelResources(GpuResourceRegistry& registry)
+    {
+        bool canLabel = available && glad_glObjectLabel;
+        registry.DrainUnlabeled([canLabel](const GpuResourceRegistry::Entry& entry)
+        {
+            if (canLabel && entry.ID != 0)
+                glObjectLabel(labelIdentifier(entry.Type), entry.ID, -1, entry.Owner.c_str());
+        });
+    }
+
+    void PushGroup(const char* name)
+    {
+        if (available)
+            glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 0, -1, name);
+    }
+
+    void PopGroup()
+    {
+        if (available)
+            glPopDebugGroup();
+    }
+
+    const std::vector<Message>& GetMessages() const
+    {
+        return messages;
+    }
+
+private:
+    Sink sink;
+    bool available = false;
+    std::vector<Message> messages;
+    std::unordered_map<std::string, size_t> messageIndex; // dedup key -> index into messages
+
+    static GL_Debug_Category categorize(GLenum type)
+    {
+        switch (type)
+        {
+        case GL_DEBUG_TYPE_ERROR: return GL_DEBUG_CATEGORY_ERROR;
+        case GL_DEBUG_TYPE_PERFORMANCE: return GL_DEBUG_CATEGORY_PERFORMANCE;
+        case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR: return GL_DEBUG_CATEGORY_DEPRECATED;
+        case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR: return GL_DEBUG_CATEGORY_UNDEFINED;
+        case GL_DEBUG_TYPE_PORTABILITY: return GL_DEBUG_CATEGORY_PORTABILITY;
+        default: return GL_DEBUG_CATEGORY_OTHER;
+        }
+    }
+
+    static const char* severityName(GLenum severity)
+    {
+        switch (severity)
+        {
+        case GL_DEBUG_SEVERITY_HIGH: return "high";
+        case GL_DEBUG_SEVERITY_MEDIUM: return "medium";
+        case GL_DEBUG_SEVERITY_LOW: return "low";
+        default: return "info";
+        }
+    }
+
+    static GLenum labelIdentifier(Gpu_Resource_Type type)
+    {
+        switch (type)
+        {
+        case GPU_BUFFER: return GL_BUFFER;
+        case GPU_TEXTURE: return GL_TEXTURE;
+        case GPU_VERTEX_ARRAY: return GL_VERTEX_ARRAY;
+        case GPU_FRAMEBUFFER: return GL_FRAMEBUFFER;
+        case GPU_RENDERBUFFER: return GL_RENDERBUFFER;
+        case GPU_QUERY: return GL_QUERY;
+        default: return GL_PROGRAM;
+        }
+    }
+
+    void report(GL_Debug_Category category, GLenum severity, GLuint id, const std::string& text)
+    {
+        FrameCounts[category]++;
+        TotalCounts[category]++;
+
+        std::string key = std::to_string(category) + ":" + std::to_string(id) + ":" + text;
+        auto it = messageIndex.find(key);
+        if (it != messageIndex.end())
+        {
+            messages[it->second].Count++;
+            return;
+        }
+
+        messageIndex[key] = messages.size();
+        messages.push_back({ category, severity, text, 1 });
+        if (sink)
+            sink(std::string("GL ") + GLDebugCategoryName(category) + " (" + severityName(severity) + "): " + text);
+    }
+
+    void pollErrors()
+    {
+        for (GLenum err = glGetError(); err != GL_NO_ERROR; err = glGetError())
+            report(GL_DEBUG_CATEGORY_ERROR, GL_DEBUG_SEVERITY_HIGH, err, "glGetError returned " + std::to_string(err));
+    }
+
+    bool loadExtension(GLADloadproc load)
+    {
+        GLint extensionCount = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+        for (GLint i = 0; i < extensionCount; ++i)
+        {
+            const char* name = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+            if (name && std::strcmp(name, "GL_KHR_debug") == 0)
+            {
+                // core-profile KHR_debug entry points carry no suffix
+                glad_glDebugMessageCallback = (PFNGLDEBUGMESSAGECALLBACKPROC)load("glDebugMessageCallback");
+                glad_glDebugMessageControl = (PFNGLDEBUGMESSAGECONTROLPROC)load("glDebugMessageControl");
+                glad_glPushDebugGroup = (PFNGLPUSHDEBUGGROUPPROC)load("glPushDebugGroup");
+                glad_glPopDebugGroup = (PFNGLPOPDEBUGGROUPPROC)load("glPopDebugGroup");
+                glad_glObjectLabel = (PFNGLOBJECTLABELPROC)load("glObjectLabel");
+                return glad_glDebugMessageCallback && glad_glDebugMessageControl && glad_glPushDebugGroup && glad_glPopDebugGroup;
+            }
+        }
+        return false;
+    }
+
+    static void APIENTRY callback(GLenum /*source*/, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message, const void* userParam)
+    {
+        GLDebugOutput* self = static_cast<GLDebugOutput*>(const_cast<void*>(userParam));
+        std::string text = length >= 0 ? std::string(message, length) : std::string(message);
+        self->report(categorize(type), severity, id, text);
+    }
+};
+
+// Scoped debug group marker, so each render pass shows up as a named range in GL captures and traces
+class GLDebugGroup
+{
+public:
+    GLDebugGroup(GLDebugOutput& output, const char* name) : output(output)
+    {
+        output.PushGroup(name);
+    }
+
+    ~GLDebugGroup()
+    {
+        output.PopGroup();
+    }
+
+    GLDebugGroup(const GLDebugGroup&) = delete;
+    GLDebugGroup& operator=(const GLDebugGroup&) = delete;
+
+private:
+    GLDebugOutput& output;
+};
+#endif
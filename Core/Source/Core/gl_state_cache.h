@@ -0,0 +1,320 @@
+#ifndef GL_STATE_CACHE_H
+#define GL_STATE_CACHE_H
+
+#include <glad/glad.h>
+
+#include <cstring>
+
+// Shadows the OpenGL state the renderer touches and drops calls that would not change it.
+// All binds and toggles for the tracked state must go through the cache; after foreign code
+// changes state without restoring it, call Invalidate() so the next calls are issued again.
+class GLStateCache
+{
+public:
+    // number of tracked calls that reached the driver versus calls that were dropped
+    struct Counters
+    {
+        unsigned int Issued = 0;
+        unsigned int Skipped = 0;
+    };
+
+    static const int MAX_TEXTURE_UNITS = 16;
+
+    Counters CurrentFrame;
+    Counters LastFrame;
+
+    GLStateCache()
+    {
+        Invalidate();
+    }
+
+    // forgets all shadowed state, so every following call is forwarded to the driver
+    void Invalidate()
+    {
+        program = UNKNOWN;
+        vertexArray = UNKNOWN;
+        activeUnit = UNKNOWN;
+        std::memset(textures, 0xFF, sizeof(textures));
+        arrayBuffer = UNKNOWN;
+        elementBuffer = UNKNOWN;
+        uniformBuffer = UNKNOWN;
+        readFramebuffer = UNKNOWN;
+        drawFramebuffer = UNKNOWN;
+        for (int i = 0; i < CAP_COUNT; ++i)
+            capabilities[i] = -1;
+        depthFunc = UNKNOWN;
+        depthMask = -1;
+        stencilFunc = UNKNOWN;
+        stencilRef = 0;
+        stencilValueMask = UNKNOWN;
+        stencilFail = stencilDepthFail = stencilPass = UNKNOWN;
+        stencilWriteMask = UNKNOWN;
+        blendSrc = blendDst = UNKNOWN;
+        lineWidth = -1.0f;
+    }
+
+    // publishes the counters of the finished frame and starts counting the next one
+    void BeginFrame()
+    {
+        LastFrame = CurrentFrame;
+        CurrentFrame = Counters();
+    }
+
+    void UseProgram(GLuint id)
+    {
+        if (track(program, id))
+            glUseProgram(id);
+    }
+
+    void BindVertexArray(GLuint id)
+    {
+        if (track(vertexArray, id))
+        {
+            glBindVertexArray(id);
+            elementBuffer = UNKNOWN; // the element array binding is part of the VAO
+        }
+    }
+
+    void ActiveTexture(GLenum unit)
+    {
+        if (track(activeUnit, unit))
+            glActiveTexture(unit);
+    }
+
+    // binds a texture to the active unit; untracked targets and units are always forwarded
+    void BindTexture(GLenum target, GLuint id)
+    {
+        int slot = targetSlot(target);
+        GLuint unit = activeUnit == UNKNOWN ? UNKNOWN : activeUnit - GL_TEXTURE0;
+        if (slot < 0 || unit >= MAX_TEXTURE_UNITS)
+        {
+            CurrentFrame.Issued++;
+            glBindTexture(target, id);
+            return;
+        }
+        if (track(textures[unit][slot], id))
+            glBindTexture(target, id);
+    }
+
+    void BindBuffer(GLenum target, GLuint id)
+    {
+        GLuint* slot = nullptr;
+        switch (target)
+        {
+        case GL_ARRAY_BUFFER: slot = &arrayBuffer; break;
+        case GL_ELEMENT_ARRAY_BUFFER: slot = &elementBuffer; break;
+        case GL_UNIFORM_BUFFER: slot = &uniformBuffer; break;
+        default:
+            CurrentFrame.Issued++;
+            glBindBuffer(target, id);
+            return;
+        }
+        if (track(*slot, id))
+            glBindBuffer(target, id);
+    }
+
+    void BindFramebuffer(GLenum target, GLuint id)
+    {
+        bool read = target == GL_FRAMEBUFFER || target == GL_READ_FRAMEBUFFER;
+        bool draw = target == GL_FRAMEBUFFER || target == GL_DRAW_FRAMEBUFFER;
+        if ((read && readFramebuffer != id) || (draw && drawFramebuffer != id))
+        {
+            CurrentFrame.Issued++;
+            glBindFramebuffer(target, id);
+            if (read) readFramebuffer = id;
+            if (draw) drawFramebuffer = id;
+        }
+        else
+        {
+            CurrentFrame.Skipped++;
+        }
+    }
+
+    // glEnable / glDisable for GL_DEPTH_TEST, GL_STENCIL_TEST, GL_BLEND, GL_CULL_FACE and GL_SCISSOR_TEST
+    void SetEnabled(GLenum cap, bool enabled)
+    {
+        int slot = capSlot(cap);
+        if (slot >= 0 && capabilities[slot] == (enabled ? 1 : 0))
+        {
+            CurrentFrame.Skipped++;
+            return;
+        }
+        CurrentFrame.Issued++;
+        if (slot >= 0)
+            capabilities[slot] = enabled ? 1 : 0;
+        if (enabled)
+            glEnable(cap);
+        else
+            glDisable(cap);
+    }
+
+    void Enable(GLenum cap) { SetEnabled(cap, true); }
+    void Disable(GLenum cap) { SetEnabled(cap, false); }
+
+    void DepthFunc(GLenum func)
+    {
+        if (track(depthFunc, func))
+            glDepthFunc(func);
+    }
+
+    void DepthMask(GLboolean flag)
+    {
+        if (track(depthMask, flag ? 1 : 0))
+            glDepthMask(flag);
+    }
+
+    void StencilFunc(GLenum func, GLint ref, GLuint mask)
+    {
+        if (stencilFunc == func && stencilRef == ref && stencilValueMask == mask)
+        {
+            CurrentFrame.Skipped++;
+            return;
+        }
+        CurrentFrame.Issued++;
+        stencilFunc = func;
+        stencilRef = ref;
+        stencilValueMask = mask;
+        glStencilFunc(func, ref, mask);
+    }
+
+    void StencilOp(GLenum sfail, GLenum dpfail, GLenum dppass)
+    {
+        if (stencilFail == sfail && stencilDepthFail == dpfail && stencilPass == dppass)
+        {
+            CurrentFrame.Skipped++;
+            return;
+        }
+        CurrentFrame.Issued++;
+        stencilFail = sfail;
+        stencilDepthFail = dpfail;
+        stencilPass = dppass;
+        glStencilOp(sfail, dpfail, dppass);
+    }
+
+    void StencilMask(GLuint mask)
+    {
+        if (track(stencilWriteMask, mask))
+            glStencilMask(mask);
+    }
+
+    void BlendFunc(GLenum sfactor, GLenum dfactor)
+    {
+        if (blendSrc == sfactor && blendDst == dfactor)
+        {
+            CurrentFrame.Skipped++;
+            return;
+        }
+        CurrentFrame.Issued++;
+        blendSrc = sfactor;
+        blendDst = dfactor;
+        glBlendFunc(sfactor, dfactor);
+    }
+
+    void LineWidth(float width)
+    {
+        if (lineWidth == width)
+        {
+            CurrentFrame.Skipped++;
+            return;
+        }
+        CurrentFrame.Issued++;
+        lineWidth = width;
+        glLineWidth(width);
+    }
+
+    // call after deleting an object so a recycled name is not mistaken for the old binding
+    void ForgetProgram(GLuint id)
+    {
+        if (program == id) program = UNKNOWN;
+    }
+
+    void ForgetVertexArray(GLuint id)
+    {
+        if (vertexArray == id) vertexArray = UNKNOWN;
+    }
+
+    void ForgetTexture(GLuint id)
+    {
+        for (int unit = 0; unit < MAX_TEXTURE_UNITS; ++unit)
+            for (int slot = 0; slot < TARGET_COUNT; ++slot)
+                if (textures[unit][slot] == id) textures[unit][slot] = UNKNOWN;
+    }
+
+    void ForgetBuffer(GLuint id)
+    {
+        if (arrayBuffer == id) arrayBuffer = UNKNOWN;
+        if (elementBuffer == id) elementBuffer = UNKNOWN;
+        if (uniformBuffer == id) uniformBuffer = UNKNOWN;
+    }
+
+    void ForgetFramebuffer(GLuint id)
+    {
+        if (readFramebuffer == id) readFramebuffer = UNKNOWN;
+        if (drawFramebuffer == id) drawFramebuffer = UNKNOWN;
+    }
+
+private:
+    static const GLuint UNKNOWN = 0xFFFFFFFFu;
+    static const int TARGET_COUNT = 4;
+    static const int CAP_COUNT = 5;
+
+    GLuint program;
+    GLuint vertexArray;
+    GLuint activeUnit;
+    GLuint textures[MAX_TEXTURE_UNITS][TARGET_COUNT];
+    GLuint arrayBuffer;
+    GLuint elementBuffer;
+    GLuint uniformBuffer;
+    GLuint readFramebuffer;
+    GLuint drawFramebuffer;
+    int capabilities[CAP_COUNT]; // -1 unknown, 0 disabled, 1 enabled
+    GLuint depthFunc;
+    int depthMask;
+    GLuint stencilFunc;
+    GLint stencilRef;
+    GLuint stencilValueMask;
+    GLuint stencilFail, stencilDepthFail, stencilPass;
+    GLuint stencilWriteMask;
+    GLuint blendSrc, blendDst;
+    float lineWidth;
+
+    // updates a shadowed value and returns true if the call has to reach the driver
+    template <typename T>
+    bool track(T& shadow, T value)
+    {
+        if (shadow == value)
+        {
+            CurrentFrame.Skipped++;
+            return false;
+        }
+        CurrentFrame.Issued++;
+        shadow = value;
+        return true;
+    }
+
+    static int targetSlot(GLenum target)
+    {
+        switch (target)
+        {
+        case GL_TEXTURE_2D: return 0;
+        case GL_TEXTURE_2D_ARRAY: return 1;
+        case GL_TEXTURE_CUBE_MAP: return 2;
+        case GL_TEXTURE_3D: return 3;
+        default: return -1;
+        }
+    }
+
+    static int capSlot(GLenum cap)
+    {
+        switch (cap)
+        {
+        case GL_DEPTH_TEST: return 0;
+        case GL_STENCIL_TEST: return 1;
+        case GL_BLEND: return 2;
+        case GL_CULL_FACE: return 3;
+        case GL_SCISSOR_TEST: return 4;
+        default: return -1;
+        }
+    }
+};
+#endif
@@ -0,0 +1,819 @@
+#include "gltf.h"
+#include "json.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <cctype>
+#include <limits>
+#include <cstdint>
+#include <fstream>
+
+namespace
+{
+    const uint32_t GLB_MAGIC = 0x46546C67;      // "glTF"
+    const uint32_t GLB_CHUNK_JSON = 0x4E4F534A;
+    const uint32_t GLB_CHUNK_BIN = 0x004E4942;
+
+    uint32_t read32(const uint8_t* p)
+    {
+        return uint32_t(p[0]) | uint32_t(p[1]) << 8 | uint32_t(p[2]) << 16 | uint32_t(p[3]) << 24;
+    }
+
+    double millisecondsSince(std::chrono::high_resolution_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+
+    uint32_t componentCount(const std::string& type)
+    {
+        if (type == "SCALAR") return 1;
+        if (type == "VEC2") return 2;
+        if (type == "VEC3") return 3;
+        if (type == "VEC4") return 4;
+        if (type == "MAT2") return 4;
+        if (type == "MAT3") return 9;
+        if (type == "MAT4") return 16;
+        return 0;
+    }
+
+    // index into a top level array, -1 when absent; false when present but out of range
+    bool reference(const JsonValue& value, size_t count, int& out)
+    {
+        out = -1;
+        if (value.IsNull())
+            return true;
+        if (!value.IsNumber() || value.Number < 0.0 || value.Number >= static_cast<double>(count))
+            return false;
+        out = static_cast<int>(value.Number);
+        return true;
+    }
+
+    template <typename T>
+    float normalizedValue(const uint8_t* p)
+    {
+        T value;
+        std::memcpy(&value, p, sizeof(T));
+        // signed types map their minimum to -1 as well, so clamp rather than divide by it
+        return std::max(static_cast<float>(value) / static_cast<float>(std::numeric_limits<T>::max()), -1.0f);
+    }
+
+    template <typename T>
+    float plainValue(const uint8_t* p)
+    {
+        T value;
+        std::memcpy(&value, p, sizeof(T));
+        return static_cast<float>(value);
+    }
+
+    float componentValue(const uint8_t* p, uint32_t type, bool normalized)
+    {
+        switch (type)
+        {
+        case GLTF_BYTE: return normalized ? normalizedValue<int8_t>(p) : plainValue<int8_t>(p);
+        case GLTF_UNSIGNED_BYTE: return normalized ? normalizedValue<uint8_t>(p) : plainValue<uint8_t>(p);
+        case GLTF_SHORT: return normalized ? normalizedValue<int16_t>(p) : plainValue<int16_t>(p);
+        case GLTF_UNSIGNED_SHORT: return normalized ? normalizedValue<uint16_t>(p) : plainValue<uint16_t>(p);
+        case GLTF_UNSIGNED_INT: return plainValue<uint32_t>(p);
+        case GLTF_FLOAT: return plainValue<float>(p);
+        default: return 0.0f;
+        }
+    }
+
+    // copies count elements of width components into out, one element every MeshData::STRIDE floats
+    void readAttribute(const GltfAccessor& accessor, const uint8_t* data, size_t stride, size_t width, float* out)
+    {
+        if (accessor.ComponentType == GLTF_FLOAT)
+        {
+            for (size_t i = 0; i < accessor.Count; ++i)
+                std::memcpy(out + i * MeshData::STRIDE, data + i * stride, width * sizeof(float));
+            return;
+        }
+        size_t componentSize = GltfComponentSize(accessor.ComponentType);
+        for (size_t i = 0; i < accessor.Count; ++i)
+        {
+            for (size_t c = 0; c < width; ++c)
+                out[i * MeshData::STRIDE + c] = componentValue(data + i * stride + c * componentSize, accessor.ComponentType, accessor.Normalized);
+        }
+    }
+
+    bool decodeBase64(const char* text, size_t length, std::vector<uint8_t>& out)
+    {
+        static int8_t table[256];
+        static bool initialized = false;
+        if (!initialized)
+        {
+            std::memset(table, -1, sizeof(table));
+            const char* alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+            for (int i = 0; i < 64; ++i)
+                table[static_cast<uint8_t>(alphabet[i])] = static_cast<int8_t>(i);
+            initialized = true;
+        }
+        out.clear();
+        out.reserve(length / 4 * 3);
+        uint32_t bits = 0;
+        int pending = 0;
+        for (size_t i = 0; i < length && text[i] != '='; ++i)
+        {
+            int8_t value = table[static_cast<uint8_t>(text[i])];
+            if (value < 0)
+                return false;
+            bits = bits << 6 | static_cast<uint32_t>(value);
+            pending += 6;
+            if (pending >= 8)
+            {
+                pending -= 8;
+                out.push_back(static_cast<uint8_t>(bits >> pending));
+            }
+        }
+        return true;
+    }
+
+    std::string percentDecode(const std::string& uri)
+    {
+        std::string out;
+        for (size_t i = 0; i < uri.size(); ++i)
+        {
+            if (uri[i] == '%' && i + 2 < uri.size() && std::isxdigit(static_cast<unsigned char>(uri[i + 1])) && std::isxdigit(static_cast<unsigned char>(uri[i + 2])))
+            {
+                out += static_cast<char>(std::stoi(uri.substr(i + 1, 2), nullptr, 16));
+                i += 2;
+            }
+            else
+                out += uri[i];
+        }
+        return out;
+    }
+}
+
+size_t GltfComponentSize(uint32_t componentType)
+{
+    switch (componentType)
+    {
+    case GLTF_BYTE:
+    case GLTF_UNSIGNED_BYTE: return 1;
+    case GLTF_SHORT:
+    case GLTF_UNSIGNED_SHORT: return 2;
+    case GLTF_UNSIGNED_INT:
+    case GLTF_FLOAT: return 4;
+    default: return 0;
+    }
+}
+
+bool GltfAsset::Load(const std::string& path, std::string& error)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    Path = path;
+    std::unique_ptr<MappedFile> file = std::make_unique<MappedFile>();
+    if (!file->Open(path))
+    {
+        error = "cannot open " + path;
+        return false;
+    }
+    const uint8_t* data = file->Data();
+    size_t size = file->Size();
+    FileBytes = size;
+    files.push_back(std::move(file));
+    MapMs = millisecondsSince(start);
+
+    start = std::chrono::high_resolution_clock::now();
+    bool parsed;
+    if (size >= 12 && read32(data) == GLB_MAGIC)
+    {
+        if (read32(data + 4) != 2)
+        {
+            error = "unsupported GLB version " + std::to_string(read32(data + 4));
+            return false;
+        }
+        size_t length = std::min<size_t>(read32(data + 8), size);
+        if (length < 20 || read32(data + 16) != GLB_CHUNK_JSON || read32(data + 12) > length - 20)
+        {
+            error = "GLB has no JSON chunk";
+            return false;
+        }
+        size_t jsonLength = read32(data + 12);
+        const uint8_t* binary = nullptr;
+        size_t binarySize = 0;
+        size_t next = 20 + ((jsonLength + 3) & ~size_t(3));
+        if (next + 8 <= length && read32(data + next + 4) == GLB_CHUNK_BIN)
+        {
+            binarySize = std::min<size_t>(read32(data + next), length - next - 8);
+            binary = data + next + 8;
+        }
+        parsed = parse(reinterpret_cast<const char*>(data + 20), jsonLength, binary, binarySize, error);
+    }
+    else
+        parsed = parse(reinterpret_cast<const char*>(data), size, nullptr, 0, error);
+    ParseMs = millisecondsSince(start);
+    return parsed;
+}
+
+bool GltfAsset::parse(const char* json, size_t length, const uint8_t* binary, size_t binarySize, std::string& error)
+{
+    JsonValue doc;
+    if (!ParseJson(json, length, doc, error))
+    {
+        error = "malformed JSON: " + error;
+        return false;
+    }
+    const std::string& version = doc["asset"]["version"].AsString();
+    if (version.empty() || version[0] != '2')
+    {
+        error = "not a glTF 2.0 asset";
+        return false;
+    }
+    if (doc.Find("extensionsRequired") != nullptr && doc["extensionsRequired"].Size() > 0)
+    {
+        error = "requires extension " + doc["extensionsRequired"][0].AsString();
+        return false;
+    }
+
+    const JsonValue& bufferList = doc["buffers"];
+    for (size_t i = 0; i < bufferList.Size(); ++i)
+    {
+        const JsonValue& entry = bufferList[i];
+        Buffer buffer;
+        if (entry.Find("uri") == nullptr)
+        {
+            // only the first buffer may live in the binary chunk
+            if (i != 0 || binary == nullptr)
+            {
+                error = "buffer " + std::to_string(i) + " has no data";
+                return false;
+            }
+            buffer.Data = binary;
+            buffer.Size = binarySize;
+        }
+        else if (!resolveUri(entry["uri"].AsString(), buffer, error))
+            return false;
+        size_t declared = entry["byteLength"].AsSize();
+        if (declared > buffer.Size)
+        {
+            error = "buffer " + std::to_string(i) + " is shorter than its byteLength";
+            return false;
+        }
+        buffer.Size = declared;
+        buffers.push_back(buffer);
+    }
+
+    const JsonValue& viewList = doc["bufferViews"];
+    for (size_t i = 0; i < viewList.Size(); ++i)
+    {
+        const JsonValue& entry = viewList[i];
+        GltfBufferView view;
+        int buffer;
+        if (!reference(entry["buffer"], buffers.size(), buffer) || buffer < 0)
+        {
+            error = "buffer view " + std::to_string(i) + " refers to a missing buffer";
+            return false;
+        }
+        view.Buffer = static_cast<uint32_t>(buffer);
+        view.ByteOffset = entry["byteOffset"].AsSize();
+        view.ByteLength = entry["byteLength"].AsSize();
+        view.ByteStride = static_cast<uint32_t>(entry["byteStride"].AsSize());
+        BufferViews.push_back(view);
+    }
+
+    const JsonValue& accessorList = doc["accessors"];
+    for (size_t i = 0; i < accessorList.Size(); ++i)
+    {
+        const JsonValue& entry = accessorList[i];
+        GltfAccessor accessor;
+        if (!reference(entry["bufferView"], BufferViews.size(), accessor.BufferView))
+        {
+            error = "accessor " + std::to_string(i) + " refers to a missing buffer view";
+            return false;
+        }
+        accessor.ByteOffset = entry["byteOffset"].AsSize();
+        accessor.ComponentType = static_cast<uint32_t>(entry["componentType"].AsSize());
+        accessor.Normalized = entry["normalized"].AsBool();
+        accessor.Sparse = entry.Find("sparse") != nullptr;
+        accessor.Count = entry["count"].AsSize();
+        accessor.Components = componentCount(entry["type"].AsString());
+        if (GltfComponentSize(accessor.ComponentType) == 0 || accessor.Components == 0)
+        {
+            error = "accessor " + std::to_string(i) + " has an unknown type";
+            return false;
+        }
+        Accessors.push_back(accessor);
+    }
+
+    const JsonValue& imageList = doc["images"];
+    for (size_t i = 0; i < imageList.Size(); ++i)
+    {
+        const JsonValue& entry = imageList[i];
+        GltfImage image;
+        if (!reference(entry["bufferView"], BufferViews.size(), image.BufferView))
+        {
+            error = "image " + std::to_string(i) + " refers to a missing buffer view";
+            return false;
+        }
+        image.Uri = entry["uri"].AsString();
+        image.MimeType = entry["mimeType"].AsString();
+        Images.push_back(image);
+    }
+
+    // textures only matter here as the way from a material to its image
+    const JsonValue& textureList = doc["textures"];
+    std::vector<int> textureImages(textureList.Size(), -1);
+    for (size_t i = 0; i < textureList.Size(); ++i)
+    {
+        if (!reference(textureList[i]["source"], Images.size(), textureImages[i]))
+        {
+            error = "texture " + std::to_string(i) + " refers to a missing image";
+            return false;
+        }
+    }
+
+    const JsonValue& materialList = doc["materials"];
+    for (size_t i = 0; i < materialList.Size(); ++i)
+    {
+        const JsonValue& pbr = materialList[i]["pbrMetallicRoughness"];
+        GltfMaterial material;
+        const JsonValue& factor = pbr["baseColorFactor"];
+        for (size_t c = 0; c < 4 && c < factor.Size(); ++c)
+            material.BaseColor[static_cast<int>(c)] = static_cast<float>(factor[c].AsNumber(1.0));
+        int texture;
+        if (!reference(pbr["baseColorTexture"]["index"], textureImages.size(), texture))
+        {
+            error = "material " + std::to_string(i) + " refers to a missing texture";
+            return false;
+        }
+        material.BaseColorImage = texture >= 0 ? textureImages[texture] : -1;
+        Materials.push_back(material);
+    }
+
+    const JsonValue& meshList = doc["meshes"];
+    for (size_t i = 0; i < meshList.Size(); ++i)
+    {
+        const JsonValue& entry = meshList[i];
+        GltfMesh mesh;
+        mesh.Name = entry["name"].AsString();
+        const JsonValue& primitiveList = entry["primitives"];
+        for (size_t p = 0; p < primitiveList.Size(); ++p)
+        {
+            const JsonValue& source = primitiveList[p];
+            const JsonValue& attributes = source["attributes"];
+            GltfPrimitive primitive;
+            bool valid = reference(attributes["POSITION"], Accessors.size(), primitive.Position)
+                && reference(attributes["NORMAL"], Accessors.size(), primitive.Normal)
+                && reference(attributes["TEXCOORD_0"], Accessors.size(), primitive.TexCoord)
+                && reference(source["indices"], Accessors.size(), primitive.Indices)
+                && reference(source["material"], Materials.size(), primitive.Material);
+            if (!valid)
+            {
+                error = "mesh " + std::to_string(i) + " refers to a missing accessor or material";
+                return false;
+            }
+            primitive.Mode = source["mode"].AsInt(4);
+            mesh.Primitives.push_back(primitive);
+        }
+        Meshes.push_back(mesh);
+    }
+
+    const JsonValue& nodeList = doc["nodes"];
+    for (size_t i = 0; i < nodeList.Size(); ++i)
+    {
+        const JsonValue& entry = nodeList[i];
+        GltfNode node;
+        node.Name = entry["name"].AsString();
+        if (!reference(entry["mesh"], Meshes.size(), node.Mesh))
+        {
+            error = "node " + std::to_string(i) + " refers to a missing mesh";
+            return false;
+        }
+        const JsonValue& children = entry["children"];
+        for (size_t c = 0; c < children.Size(); ++c)
+        {
+            int child;
+            if (!reference(children[c], nodeList.Size(), child) || child < 0)
+            {
+                error = "node " + std::to_string(i) + " has a missing child";
+                return false;
+            }
+            node.Children.push_back(child);
+        }
+
+        const JsonValue& instancing = entry["extensions"]["EXT_mesh_gpu_instancing"]["attributes"];
+        bool instancesValid = reference(instancing["TRANSLATION"], Accessors.size(), node.InstanceTranslation)
+            && reference(instancing["ROTATION"], Accessors.size(), node.InstanceRotation)
+            && reference(instancing["SCALE"], Accessors.size(), node.InstanceScale);
+        if (!instancesValid)
+        {
+            error = "node " + std::to_string(i) + " has missing instance accessors";
+            return false;
+        }
+
+        const JsonValue& matrix = entry["matrix"];
+        if (matrix.Size() == 16)
+        {
+            // column major, like glm
+            for (int c = 0; c < 4; ++c)
+            {
+                for (int r = 0; r < 4; ++r)
+                    node.Local[c][r] = static_cast<float>(matrix[static_cast<size_t>(c * 4 + r)].AsNumber());
+            }
+        }
+        else
+        {
+            const JsonValue& t = entry["translation"];
+            const JsonValue& r = entry["rotation"];
+            const JsonValue& s = entry["scale"];
+            glm::vec3 translation(0.0f);
+            glm::quat rotation(1.0f, 0.0f, 0.0f, 0.0f);
+            glm::vec3 scale(1.0f);
+            if (t.Size() == 3)
+                translation = glm::vec3(t[0].AsNumber(), t[1].AsNumber(), t[2].AsNumber());
+            if (r.Size() == 4)
+                rotation = glm::normalize(glm::quat(static_cast<float>(r[3].AsNumber(1.0)), static_cast<float>(r[0].AsNumber()),
+                    static_cast<float>(r[1].AsNumber()), static_cast<float>(r[2].AsNumber())));
+            if (s.Size() == 3)
+                scale = glm::vec3(s[0].AsNumber(1.0), s[1].AsNumber(1.0), s[2].AsNumber(1.0));
+            node.Local = glm::translate(glm::mat4(1.0f), translation) * glm::mat4_cast(rotation) * glm::scale(glm::mat4(1.0f), scale);
+        }
+        Nodes.push_back(node);
+    }
+
+    const JsonValue& sceneList = doc["scenes"];
+    if (sceneList.Size() > 0)
+    {
+        const JsonValue& roots = sceneList[doc["scene"].AsSize(0)]["nodes"];
+        for (size_t i = 0; i < roots.Size(); ++i)
+        {
+            int root;
+            if (reference(roots[i], Nodes.size(), root) && root >= 0)
+                Roots.push_back(root);
+        }
+    }
+    else
+    {
+        // without scenes every node that is nobody's child is a root
+        std::vector<bool> isChild(Nodes.size(), false);
+        for (const GltfNode& node : Nodes)
+        {
+            for (int child : node.Children)
+                isChild[child] = true;
+        }
+        for (size_t i = 0; i < Nodes.size(); ++i)
+        {
+            if (!isChild[i])
+                Roots.push_back(static_cast<int>(i));
+        }
+    }
+    return true;
+}
+
+bool GltfAsset::resolveUri(const std::string& uri, Buffer& out, std::string& error)
+{
+    if (uri.compare(0, 5, "data:") == 0)
+    {
+        size_t marker = uri.find(";base64,");
+        std::unique_ptr<std::vector<uint8_t>> bytes = std::make_unique<std::vector<uint8_t>>();
+        if (marker == std::string::npos || !decodeBase64(uri.data() + marker + 8, uri.size() - marker - 8, *bytes))
+        {
+            error = "unsupported data URI";
+            return false;
+        }
+        out.Data = bytes->data();
+        out.Size = bytes->size();
+        owned.push_back(std::move(bytes));
+        return true;
+    }
+
+    size_t slash = Path.find_last_of("/\\");
+    std::string path = (slash == std::string::npos ? std::string() : Path.substr(0, slash + 1)) + percentDecode(uri);
+    std::unique_ptr<MappedFile> file = std::make_unique<MappedFile>();
+    if (!file->Open(path))
+    {
+        error = "cannot open " + path;
+        return false;
+    }
+    out.Data = file->Data();
+    out.Size = file->Size();
+    FileBytes += file->Size();
+    files.push_back(std::move(file));
+    return true;
+}
+
+const uint8_t* GltfAsset::BufferViewData(int bufferView) const
+{
+    if (bufferView < 0 || static_cast<size_t>(bufferView) >= BufferViews.size())
+        return nullptr;
+    const GltfBufferView& view = BufferViews[bufferView];
+    const Buffer& buffer = buffers[view.Buffer];
+    if (view.ByteOffset > buffer.Size || view.ByteLength > buffer.Size - view.ByteOffset)
+        return nullptr;
+    return buffer.Data + view.ByteOffset;
+}
+
+bool GltfAsset::AccessorData(int index, const uint8_t*& data, size_t& stride) const
+{
+    if (index < 0 || static_cast<size_t>(index) >= Accessors.size())
+        return false;
+    const GltfAccessor& accessor = Accessors[index];
+    const uint8_t* base = BufferViewData(accessor.BufferView);
+    if (base == nullptr || accessor.Count == 0)
+        return false;
+    const GltfBufferView& view = BufferViews[accessor.BufferView];
+    size_t element = accessor.ElementSize();
+    stride = view.ByteStride != 0 ? view.ByteStride : element;
+    // checked in this order so a hostile count cannot overflow the product
+    if (accessor.ByteOffset > view.ByteLength || element > view.ByteLength - accessor.ByteOffset)
+        return false;
+    if ((accessor.Count - 1) > (view.ByteLength - accessor.ByteOffset - element) / stride)
+        return false;
+    data = base + accessor.ByteOffset;
+    return true;
+}
+
+bool GltfAsset::ImageData(int index, const uint8_t*& data, size_t& size, std::string& error)
+{
+    if (index < 0 || static_cast<size_t>(index) >= Images.size())
+    {
+        error = "no image " + std::to_string(index);
+        return false;
+    }
+    const GltfImage& image = Images[index];
+    if (image.BufferView >= 0)
+    {
+        data = BufferViewData(image.BufferView);
+        size = BufferViews[image.BufferView].ByteLength;
+        if (data == nullptr)
+            error = "image " + std::to_string(index) + " does not fit its buffer";
+        return data != nullptr;
+    }
+    Buffer buffer;
+    if (!resolveUri(image.Uri, buffer, error))
+        return false;
+    data = buffer.Data;
+    size = buffer.Size;
+    return true;
+}
+
+bool GltfAsset::ReadPrimitive(const GltfPrimitive& primitive, MeshData& out, std::string& error) const
+{
+    if (primitive.Mode != 4)
+    {
+        error = "only triangle lists are supported, not mode " + std::to_string(primitive.Mode);
+        return false;
+    }
+    const uint8_t* positions;
+    size_t positionStride;
+    if (!AccessorData(primitive.Position, positions, positionStride) || Accessors[primitive.Position].Components != 3)
+    {
+        error = "missing or malformed positions";
+        return false;
+    }
+    const GltfAccessor& position = Accessors[primitive.Position];
+    size_t count = position.Count;
+
+    out.Vertices.assign(count * MeshData::STRIDE, 0.0f);
+    readAttribute(position, positions, positionStride, 3, out.Vertices.data());
+
+    const uint8_t* texCoords;
+    size_t texCoordStride;
+    if (AccessorData(primitive.TexCoord, texCoords, texCoordStride))
+    {
+        const GltfAccessor& texCoord = Accessors[primitive.TexCoord];
+        if (texCoord.Count != count || texCoord.Components != 2)
+        {
+            error = "texture coordinates do not match the positions";
+            return false;
+        }
+        readAttribute(texCoord, texCoords, texCoordStride, 2, out.Vertices.data() + 3);
+    }
+
+    const uint8_t* normals;
+    size_t normalStride;
+    bool hasNormals = AccessorData(primitive.Normal, normals, normalStride);
+    if (hasNormals)
+    {
+        const GltfAccessor& normal = Accessors[primitive.Normal];
+        if (normal.Count != count || normal.Components != 3)
+        {
+            error = "normals do not match the positions";
+            return false;
+        }
+        readAttribute(normal, normals, normalStride, 3, out.Vertices.data() + 5);
+    }
+
+    const uint8_t* indices;
+    size_t indexStride;
+    if (primitive.Indices >= 0)
+    {
+        const GltfAccessor& index = Accessors[primitive.Indices];
+        if (!AccessorData(primitive.Indices, indices, indexStride) || index.Components != 1 || index.ComponentType == GLTF_FLOAT
+            || index.ComponentType == GLTF_BYTE || index.ComponentType == GLTF_SHORT)
+        {
+            error = "malformed indices";
+            return false;
+        }
+        out.Indices.resize(index.Count - index.Count % 3);
+        for (size_t i = 0; i < out.Indices.size(); ++i)
+        {
+            const uint8_t* p = indices + i * indexStride;
+            uint32_t value = index.ComponentType == GLTF_UNSIGNED_INT ? read32(p)
+                : index.ComponentType == GLTF_UNSIGNED_SHORT ? uint32_t(p[0]) | uint32_t(p[1]) << 8 : p[0];
+            if (value >= count)
+            {
+                error = "index " + std::to_string(value) + " is past the last vertex";
+                return false;
+            }
+            out.Indices[i] = value;
+        }
+    }
+    else
+    {
+        out.Indices.resize(count - count % 3);
+        for (size_t i = 0; i < out.Indices.size(); ++i)
+            out.Indices[i] = static_cast<unsigned int>(i);
+    }
+
+    if (!hasNormals)
+        ComputeNormals(out);
+    return true;
+}
+
+bool GltfAsset::InstanceTransforms(const GltfNode& node, std::vector<glm::mat4>& out) const
+{
+    out.clear();
+    const int attributes[3] = { node.InstanceTranslation, node.InstanceRotation, node.InstanceScale };
+    const uint32_t components[3] = { 3, 4, 3 };
+    const uint8_t* data[3] = {};
+    size_t strides[3] = {};
+    size_t count = SIZE_MAX;
+    for (int a = 0; a < 3; ++a)
+    {
+        if (attributes[a] < 0)
+            continue;
+        const GltfAccessor& accessor = Accessors[attributes[a]];
+        if (!AccessorData(attributes[a], data[a], strides[a]) || accessor.Components != components[a] || (count != SIZE_MAX && accessor.Count != count))
+            return false;
+        count = accessor.Count;
+    }
+    if (count == SIZE_MAX)
+        return false;
+
+    out.resize(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        float values[3][4] = { { 0.0f, 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 0.0f, 1.0f }, { 1.0f, 1.0f, 1.0f, 0.0f } };
+        for (int a = 0; a < 3; ++a)
+        {
+            if (data[a] == nullptr)
+                continue;
+            const GltfAccessor& accessor = Accessors[attributes[a]];
+            size_t componentSize = GltfComponentSize(accessor.ComponentType);
+            for (uint32_t c = 0; c < components[a]; ++c)
+                values[a][c] = componentValue(data[a] + i * strides[a] + c * componentSize, accessor.ComponentType, accessor.Normalized);
+        }
+        glm::quat rotation = glm::normalize(glm::quat(values[1][3], values[1][0], values[1][1], values[1][2]));
+        out[i] = glm::translate(glm::mat4(1.0f), glm::vec3(values[0][0], values[0][1], values[0][2])) * glm::mat4_cast(rotation)
+            * glm::scale(glm::mat4(1.0f), glm::vec3(values[2][0], values[2][1], values[2][2]));
+    }
+    return true;
+}
+
+void GltfAsset::WorldTransforms(std::vector<glm::mat4>& world, std::vector<int>& parents) const
+{
+    world.assign(Nodes.size(), glm::mat4(0.0f));
+    parents.assign(Nodes.size(), -1);
+    std::vector<bool> visited(Nodes.size(), false);
+    std::vector<int> stack;
+    for (int root : Roots)
+    {
+        if (visited[root])
+            continue;
+        visited[root] = true;
+        world[root] = Nodes[root].Local;
+        stack.push_back(root);
+        while (!stack.empty())
+        {
+            int node = stack.back();
+            stack.pop_back();
+            for (int child : Nodes[node].Children)
+            {
+                // a node reached twice would make the hierarchy a graph; keep the first parent
+                if (visited[child])
+                    continue;
+                visited[child] = true;
+                parents[child] = node;
+                world[child] = world[node] * Nodes[child].Local;
+                stack.push_back(child);
+            }
+        }
+    }
+}
+
+void GltfAsset::Prefetch() const
+{
+    for (const std::unique_ptr<MappedFile>& file : files)
+        file->Prefetch(0, file->Size());
+}
+
+bool WriteBenchmarkGlb(const std::string& path, size_t targetBytes, std::string& error)
+{
+    MeshData sphere = GeneratePrimitive(PrimitiveDesc::UVSphere(64, 64));
+    size_t vertexCount = sphere.VertexCount();
+    size_t vertexBytes = sphere.Vertices.size() * sizeof(float);
+    size_t indexBytes = sphere.Indices.size() * sizeof(uint32_t);
+    size_t meshBytes = vertexBytes + indexBytes;
+    size_t meshCount = std::max<size_t>(targetBytes / meshBytes, 1);
+    size_t binaryBytes = meshCount * meshBytes;
+    // the GLB header stores lengths in 32 bits; leave room for the JSON
+    if (binaryBytes > 0xF0000000u)
+    {
+        error = "benchmark file too large for GLB";
+        return false;
+    }
+
+    // every eighth mesh leaves its normals out, so imports exercise the conversion path as well
+    // each copy is scaled up a little, so no two meshes hold the same bytes
+    auto inflation = [](size_t mesh) { return 1.0f + 0.001f * static_cast<float>(mesh % 97); };
+    size_t side = static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(meshCount))));
+    std::string json = "{\"asset\":{\"version\":\"2.0\",\"generator\":\"benchmark\"},\"scene\":0,\"scenes\":[{\"nodes\":[0]}],";
+    json += "\"buffers\":[{\"byteLength\":" + std::to_string(binaryBytes) + "}],\"nodes\":[{\"name\":\"Benchmark\",\"children\":[";
+    for (size_t i = 0; i < meshCount; ++i)
+        json += (i > 0 ? "," : "") + std::to_string(i + 1);
+    json += "]}";
+    for (size_t i = 0; i < meshCount; ++i)
+    {
+        float x = 2.5f * static_cast<float>(i % side);
+        float z = 2.5f * static_cast<float>(i / side);
+        json += ",{\"mesh\":" + std::to_string(i) + ",\"translation\":[" + std::to_string(x) + ",0," + std::to_string(z) + "]}";
+    }
+    json += "],\"bufferViews\":[";
+    for (size_t i = 0; i < meshCount; ++i)
+    {
+        size_t offset = i * meshBytes;
+        json += (i > 0 ? "," : "") + std::string("{\"buffer\":0,\"byteOffset\":") + std::to_string(offset) + ",\"byteLength\":" + std::to_string(vertexBytes)
+            + ",\"byteStride\":" + std::to_string(MeshData::STRIDE * sizeof(float)) + ",\"target\":34962}";
+        json += ",{\"buffer\":0,\"byteOffset\":" + std::to_string(offset + vertexBytes) + ",\"byteLength\":" + std::to_string(indexBytes) + ",\"target\":34963}";
+    }
+    json += "],\"accessors\":[";
+    std::string vertices = std::to_string(vertexCount);
+    for (size_t i = 0; i < meshCount; ++i)
+    {
+        std::string view = std::to_string(2 * i);
+        std::string extent = std::to_string(0.5f * inflation(i));
+        json += (i > 0 ? "," : "") + std::string("{\"bufferView\":") + view + ",\"componentType\":5126,\"count\":" + vertices
+            + ",\"type\":\"VEC3\",\"min\":[-" + extent + ",-" + extent + ",-" + extent + "],\"max\":[" + extent + "," + extent + "," + extent + "]}";
+        json += ",{\"bufferView\":" + view + ",\"byteOffset\":12,\"componentType\":5126,\"count\":" + vertices + ",\"type\":\"VEC2\"}";
+        json += ",{\"bufferView\":" + view + ",\"byteOffset\":20,\"componentType\":5126,\"count\":" + vertices + ",\"type\":\"VEC3\"}";
+        json += ",{\"bufferView\":" + std::to_string(2 * i + 1) + ",\"componentType\":5125,\"count\":" + std::to_string(sphere.Indices.size()) + ",\"type\":\"SCALAR\"}";
+    }
+    json += "],\"meshes\":[";
+    for (size_t i = 0; i < meshCount; ++i)
+    {
+        size_t a = 4 * i;
+        json += (i > 0 ? "," : "") + std::string("{\"primitives\":[{\"attributes\":{\"POSITION\":") + std::to_string(a) + ",\"TEXCOORD_0\":" + std::to_string(a + 1);
+        if (i % 8 != 7)
+            json += ",\"NORMAL\":" + std::to_string(a + 2);
+        json += "},\"indices\":" + std::to_string(a + 3) + "}]}";
+    }
+    json += "]}";
+    json.append((4 - json.size() % 4) % 4, ' ');
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file)
+    {
+        error = "cannot write " + path;
+        return false;
+    }
+    auto write32 = [&file](uint32_t value)
+    {
+        uint8_t bytes[4] = { uint8_t(value), uint8_t(value >> 8), uint8_t(value >> 16), uint8_t(value >> 24) };
+        file.write(reinterpret_cast<const char*>(bytes), 4);
+    };
+    write32(GLB_MAGIC);
+    write32(2);
+    write32(static_cast<uint32_t>(12 + 8 + json.size() + 8 + binaryBytes));
+    write32(static_cast<uint32_t>(json.size()));
+    write32(GLB_CHUNK_JSON);
+    file.write(json.data(), static_cast<std::streamsize>(json.size()));
+    write32(static_cast<uint32_t>(binaryBytes));
+    write32(GLB_CHUNK_BIN);
+
+    std::vector<float> vertexData = sphere.Vertices;
+    for (size_t i = 0; i < meshCount && file; ++i)
+    {
+        float inflate = inflation(i);
+        for (size_t v = 0; v < vertexCount; ++v)
+        {
+            for (int c = 0; c < 3; ++c)
+                vertexData[v * MeshData::STRIDE + c] = sphere.Vertices[v * MeshData::STRIDE + c] * inflate;
+        }
+        file.write(reinterpret_cast<const char*>(vertexData.data()), static_cast<std::streamsize>(vertexBytes));
+        file.write(reinterpret_cast<const char*>(sphere.Indices.data()), static_cast<std::streamsize>(indexBytes));
+    }
+    if (!file)
+    {
+        error = "writing " + path + " failed";
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,158 @@
+#ifndef GLTF_H
+#define GLTF_H
+
+#include "primitives.h"
+#include "mapped_file.h"
+
+#include <glm/glm.hpp>
+
+#include <memory>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+// Accessor component types; glTF stores them as the matching GL enums
+enum Gltf_Component {
+    GLTF_BYTE = 5120,
+    GLTF_UNSIGNED_BYTE = 5121,
+    GLTF_SHORT = 5122,
+    GLTF_UNSIGNED_SHORT = 5123,
+    GLTF_UNSIGNED_INT = 5125,
+    GLTF_FLOAT = 5126
+};
+
+// bytes per component, 0 for unknown types
+size_t GltfComponentSize(uint32_t componentType);
+
+struct GltfBufferView
+{
+    uint32_t Buffer = 0;
+    size_t ByteOffset = 0;
+    size_t ByteLength = 0;
+    uint32_t ByteStride = 0;    // 0 means tightly packed
+};
+
+struct GltfAccessor
+{
+    int BufferView = -1;        // -1 reads as zeros
+    size_t ByteOffset = 0;      // within the buffer view
+    uint32_t ComponentType = GLTF_FLOAT;
+    bool Normalized = false;
+    bool Sparse = false;        // sparse substitutions are not applied
+    size_t Count = 0;
+    uint32_t Components = 1;    // SCALAR 1, VEC2 2, VEC3 3, VEC4 4, MAT4 16
+
+    size_t ElementSize() const { return GltfComponentSize(ComponentType) * Components; }
+};
+
+// attribute and index accessors of one draw, -1 when absent
+struct GltfPrimitive
+{
+    int Position = -1;
+    int Normal = -1;
+    int TexCoord = -1;
+    int Indices = -1;
+    int Material = -1;
+    int Mode = 4;               // triangles
+};
+
+struct GltfMesh
+{
+    std::string Name;
+    std::vector<GltfPrimitive> Primitives;
+};
+
+struct GltfNode
+{
+    std::string Name;
+    int Mesh = -1;
+    std::vector<int> Children;
+    glm::mat4 Local = glm::mat4(1.0f);
+    // EXT_mesh_gpu_instancing accessors, -1 when absent; the node's mesh is drawn once per element
+    int InstanceTranslation = -1;
+    int InstanceRotation = -1;
+    int InstanceScale = -1;
+
+    bool IsInstanced() const { return InstanceTranslation >= 0 || InstanceRotation >= 0 || InstanceScale >= 0; }
+};
+
+struct GltfMaterial
+{
+    glm::vec4 BaseColor = glm::vec4(1.0f);
+    int BaseColorImage = -1;    // resolved through the texture to its image
+};
+
+struct GltfImage
+{
+    int BufferView = -1;
+    std::string Uri;            // used when there is no buffer view
+    std::string MimeType;
+};
+
+// Parsed glTF 2.0 asset (.glb or .gltf) whose binary buffers stay memory mapped. Accessor data is read straight
+// from the mapping, so the asset must outlive anything pointing into it; images and buffers given as data URIs
+// are decoded into memory the asset owns.
+class GltfAsset
+{
+public:
+    std::string Path;
+    std::vector<GltfBufferView> BufferViews;
+    std::vector<GltfAccessor> Accessors;
+    std::vector<GltfMesh> Meshes;
+    std::vector<GltfNode> Nodes;
+    std::vector<GltfMaterial> Materials;
+    std::vector<GltfImage> Images;
+    std::vector<int> Roots;     // top level nodes of the default scene
+    size_t FileBytes = 0;       // the file itself plus any external buffers
+    double MapMs = 0.0;
+    double ParseMs = 0.0;
+
+    // maps the file and any external buffers and parses the JSON; on failure error says why
+    bool Load(const std::string& path, std::string& error);
+
+    // first element of an accessor and the distance between elements; false if the accessor has no data or
+    // does not fit its buffer view
+    bool AccessorData(int accessor, const uint8_t*& data, size_t& stride) const;
+
+    // bytes of a buffer view; nullptr if it does not fit its buffer
+    const uint8_t* BufferViewData(int bufferView) const;
+
+    // encoded bytes of an image (PNG, JPEG, ...), embedded or in a file next to the asset
+    bool ImageData(int image, const uint8_t*& data, size_t& size, std::string& error);
+
+    // converts a primitive to the interleaved layout, widening any component type to float, numbering
+    // unindexed vertices and computing normals when the primitive has none
+    bool ReadPrimitive(const GltfPrimitive& primitive, MeshData& out, std::string& error) const;
+
+    // transforms of the instances of an EXT_mesh_gpu_instancing node, relative to the node; false if its
+    // accessors are malformed or disagree on the count
+    bool InstanceTransforms(const GltfNode& node, std::vector<glm::mat4>& out) const;
+
+    // world matrix of every node and its parent (-1 at the roots), walking the default scene; nodes outside it
+    // keep an all zero matrix
+    void WorldTransforms(std::vector<glm::mat4>& world, std::vector<int>& parents) const;
+
+    // hints the OS to read the whole binary data in ahead of the first touch
+    void Prefetch() const;
+
+private:
+    struct Buffer
+    {
+        const uint8_t* Data = nullptr;
+        size_t Size = 0;
+    };
+    std::vector<Buffer> buffers;
+    std::vector<std::unique_ptr<MappedFile>> files;
+    std::vector<std::unique_ptr<std::vector<uint8_t>>> owned;   // decoded data URIs
+
+    bool parse(const char* json, size_t length, const uint8_t* binary, size_t binarySize, std::string& error);
+    // bytes referred to by a buffer or image uri; data URIs are decoded, paths are mapped relative to the asset
+    bool resolveUri(const std::string& uri, Buffer& out, std::string& error);
+};
+
+// Writes a GLB of about targetBytes made of distinct sphere meshes on a grid, one node each, to measure imports
+// of large files. Returns false if the file cannot be written.
+bool WriteBenchmarkGlb(const std::string& path, size_t targetBytes, std::string& error);
+
+#endif
@@ -0,0 +1,478 @@
+#ifndef GLTF_SCENE_H
+#define GLTF_SCENE_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "gltf.h"
+#include "mesh_pool.h"
+#include "job_system.h"
+#include "gpu_resources.h"
+#include "gl_state_cache.h"
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <cstdint>
+#include <cstddef>
+
+struct GltfImportStats
+{
+    size_t Primitives = 0;          // distinct meshes uploaded
+    size_t ZeroCopy = 0;            // drawn straight from buffer views uploaded out of the mapping
+    size_t Converted = 0;           // rewritten to the MeshData layout first
+    size_t Baked = 0;               // converted copies with a node's rotation or shear applied
+    size_t Skipped = 0;
+    size_t ZeroCopyBytes = 0;
+    size_t ConvertedBytes = 0;
+    double ConvertMs = 0.0;         // conversion and validation, on the job system
+    double UploadMs = 0.0;
+    double TotalMs = 0.0;
+    std::string FirstError;         // why the first skipped primitive was skipped
+};
+
+// one primitive of a node, placed by the node's world transform
+struct GltfInstance
+{
+    int Node = -1;
+    const Mesh* Gpu = nullptr;
+    glm::vec3 Position = glm::vec3(0.0f);
+    glm::vec3 Scale = glm::vec3(1.0f);
+    glm::vec4 Color = glm::vec4(1.0f);
+    int Image = -1;                 // base color image of the material
+};
+
+// GPU side of one imported glTF asset. Primitives whose accessors are already in a layout GL can read (float positions
+// and normals, float or normalized texture coordinates, 16 or 32 bit indices) are drawn from copies of their buffer
+// views uploaded straight out of the mapped file, each view once however many primitives share it. Everything else is
+// converted to the MeshData layout on the job system first. Objects have no rotation of their own, so nodes whose world
+// transform rotates or shears get a converted copy with that part applied, shared by nodes with the same one. Nodes
+// instanced with EXT_mesh_gpu_instancing are placed once per instance. The asset stays mapped for as long as the scene
+// lives, so CPU copies of the meshes can be read again later without holding them in memory.
+class GltfScene
+{
+public:
+    std::shared_ptr<GltfAsset> Asset;
+    std::vector<GltfInstance> Instances;
+    std::vector<int> Parents;       // parent of each node, -1 at the roots
+    GltfImportStats Stats;
+
+    GltfScene(GpuResourceRegistry& registry, GLStateCache& state) : registry(registry), state(state)
+    {
+    }
+
+    GltfScene(const GltfScene&) = delete;
+    GltfScene& operator=(const GltfScene&) = delete;
+
+    // loads and uploads the asset; must run on the GL thread
+    bool Load(const std::string& path, JobSystem& jobs, std::string& error)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        Asset = std::make_shared<GltfAsset>();
+        if (!Asset->Load(path, error))
+            return false;
+        Asset->Prefetch();
+
+        std::vector<glm::mat4> world;
+        Asset->WorldTransforms(world, Parents);
+        planVariants(world);
+
+        auto convertStart = std::chrono::high_resolution_clock::now();
+        jobs.ParallelFor(variants.size(), 1, [this](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; ++i)
+                prepare(variants[i]);
+        });
+        Stats.ConvertMs = millisecondsSince(convertStart);
+
+        auto uploadStart = std::chrono::high_resolution_clock::now();
+        std::string name = path.substr(path.find_last_of("/\\") + 1);
+        for (Variant& variant : variants)
+        {
+            if (!variant.Error.empty())
+            {
+                Stats.Skipped++;
+                if (Stats.FirstError.empty())
+                    Stats.FirstError = variant.Error;
+                continue;
+            }
+            variant.Gpu = std::make_unique<Mesh>();
+            if (variant.ZeroCopy)
+                uploadZeroCopy(variant, name);
+            else
+            {
+                UploadMeshData(*variant.Gpu, variant.Data, registry, state, name);
+                Stats.ConvertedBytes += variant.Data.Vertices.size() * sizeof(float) + variant.Data.Indices.size() * sizeof(unsigned int);
+                variant.Data = MeshData();
+                (variant.Baked ? Stats.Baked : Stats.Converted)++;
+            }
+            Stats.Primitives++;
+            meshVariants[variant.Gpu.get()] = &variant - variants.data();
+        }
+        Stats.UploadMs = millisecondsSince(uploadStart);
+
+        for (const Placement& placement : placements)
+        {
+            const Variant& variant = variants[placement.Variant];
+            if (!variant.Gpu)
+                continue;
+            const GltfPrimitive& primitive = primitiveAt(variant.Primitive);
+            GltfInstance instance;
+            instance.Node = placement.Node;
+            instance.Gpu = variant.Gpu.get();
+            instance.Position = placement.Position;
+            instance.Scale = placement.Scale;
+            if (primitive.Material >= 0)
+            {
+                instance.Color = Asset->Materials[primitive.Material].BaseColor;
+                instance.Image = Asset->Materials[primitive.Material].BaseColorImage;
+            }
+            Instances.push_back(instance);
+        }
+        placements.clear();
+        Stats.TotalMs = millisecondsSince(start);
+        return true;
+    }
+
+    bool Owns(const Mesh* mesh) const
+    {
+        return meshVariants.count(mesh) != 0;
+    }
+
+    // CPU copy of a mesh of this scene, read again from the mapping; false for meshes of other scenes
+    bool ReadMesh(const Mesh* mesh, MeshData& out) const
+    {
+        auto it = meshVariants.find(mesh);
+        if (it == meshVariants.end())
+            return false;
+        const Variant& variant = variants[it->second];
+        std::string error;
+        if (!Asset->ReadPrimitive(primitiveAt(variant.Primitive), out, error))
+            return false;
+        if (variant.Baked)
+            applyLinear(out, variant.Linear);
+        return true;
+    }
+
+    size_t GetMeshCount() const
+    {
+        return meshVariants.size();
+    }
+
+    size_t GetBufferBytes() const
+    {
+        size_t bytes = 0;
+        for (const auto& buffer : viewBuffers)
+            bytes += buffer.second.GetBytes();
+        return bytes;
+    }
+
+private:
+    GpuResourceRegistry& registry;
+    GLStateCache& state;
+
+    // a primitive as uploaded: as stored, or converted, or converted with a node's linear transform baked in
+    struct Variant
+    {
+        size_t Primitive = 0;       // flat index over all meshes' primitives
+        bool Baked = false;
+        glm::mat3 Linear = glm::mat3(1.0f);
+        bool ZeroCopy = false;
+        MeshData Data;              // converted vertices until they are uploaded
+        std::vector<float> Positions;
+        std::string Error;
+        std::unique_ptr<Mesh> Gpu;
+    };
+
+    struct Placement
+    {
+        int Node;
+        size_t Variant;
+        glm::vec3 Position;
+        glm::vec3 Scale;
+    };
+
+    std::vector<size_t> firstPrimitive;         // per glTF mesh, then the total
+    std::vector<Variant> variants;
+    std::vector<Placement> placements;
+    std::unordered_map<const Mesh*, size_t> meshVariants;
+    std::unordered_map<int, GpuHandle> viewBuffers;
+
+    static double millisecondsSince(std::chrono::high_resolution_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+
+    const GltfPrimitive& primitiveAt(size_t flat) const
+    {
+        size_t mesh = std::upper_bound(firstPrimitive.begin(), firstPrimitive.end(), flat) - firstPrimitive.begin() - 1;
+        return Asset->Meshes[mesh].Primitives[flat - firstPrimitive[mesh]];
+    }
+
+    // one variant per primitive used without rotation, one per distinct rotation or shear, and a placement per
+    // primitive of every node and node instance
+    void planVariants(const std::vector<glm::mat4>& world)
+    {
+        firstPrimitive.assign(1, 0);
+        for (const GltfMesh& mesh : Asset->Meshes)
+            firstPrimitive.push_back(firstPrimitive.back() + mesh.Primitives.size());
+
+        std::vector<size_t> plain(firstPrimitive.back(), SIZE_MAX);
+        std::unordered_map<uint64_t, size_t> baked;
+        std::vector<glm::mat4> instances;
+        for (size_t n = 0; n < Asset->Nodes.size(); ++n)
+        {
+            const GltfNode& node = Asset->Nodes[n];
+            // nodes outside the default scene keep a zero matrix
+            if (node.Mesh < 0 || world[n][3][3] == 0.0f)
+                continue;
+            if (!node.IsInstanced())
+                instances.assign(1, glm::mat4(1.0f));
+            else if (!Asset->InstanceTransforms(node, instances))
+            {
+                Stats.Skipped++;
+                if (Stats.FirstError.empty())
+                    Stats.FirstError = "malformed instances on node " + std::to_string(n);
+                continue;
+            }
+            for (const glm::mat4& instance : instances)
+                place(static_cast<int>(n), world[n] * instance, plain, baked);
+        }
+    }
+
+    // adds a placement of every primitive of the node's mesh at transform, creating the variants it needs
+    void place(int n, const glm::mat4& transform, std::vector<size_t>& plain, std::unordered_map<uint64_t, size_t>& baked)
+    {
+        const GltfNode& node = Asset->Nodes[n];
+        glm::mat3 linear(transform);
+        glm::vec3 scale(linear[0][0], linear[1][1], linear[2][2]);
+        bool axisAligned = true;
+        float tolerance = 1e-6f * std::max({ std::abs(scale.x), std::abs(scale.y), std::abs(scale.z) });
+        for (int c = 0; c < 3; ++c)
+        {
+            for (int r = 0; r < 3; ++r)
+                axisAligned = axisAligned && (c == r || std::abs(linear[c][r]) <= tolerance);
+        }
+
+        for (size_t p = firstPrimitive[node.Mesh]; p < firstPrimitive[node.Mesh + 1]; ++p)
+        {
+            size_t index;
+            if (axisAligned)
+            {
+                if (plain[p] == SIZE_MAX)
+                {
+                    plain[p] = variants.size();
+                    variants.emplace_back();
+                    variants.back().Primitive = p;
+                }
+                index = plain[p];
+            }
+            else
+            {
+                uint64_t key = 1469598103934665603ull ^ p;
+                for (int c = 0; c < 3; ++c)
+                {
+                    for (int r = 0; r < 3; ++r)
+                    {
+                        uint32_t bits;
+                        std::memcpy(&bits, &linear[c][r], sizeof(bits));
+                        key = (key ^ bits) * 1099511628211ull;
+                    }
+                }
+                auto it = baked.find(key);
+                if (it == baked.end())
+                {
+                    it = baked.emplace(key, variants.size()).first;
+                    variants.emplace_back();
+                    variants.back().Primitive = p;
+                    variants.back().Baked = true;
+                    variants.back().Linear = linear;
+                }
+                index = it->second;
+            }
+            placements.push_back({ n, index, glm::vec3(transform[3]), axisAligned ? scale : glm::vec3(1.0f) });
+        }
+    }
+
+    // true if GL can read the primitive's accessors as they are; the indices are checked against the vertex count,
+    // since the GPU would read past the buffer otherwise
+    bool zeroCopyLayout(const GltfPrimitive& primitive) const
+    {
+        const std::vector<GltfAccessor>& accessors = Asset->Accessors;
+        auto usable = [&](int index, uint32_t components)
+        {
+            const uint8_t* data;
+            size_t stride;
+            if (!Asset->AccessorData(index, data, stride))
+                return false;
+            const GltfAccessor& accessor = accessors[index];
+            size_t componentSize = GltfComponentSize(accessor.ComponentType);
+            return !accessor.Sparse && accessor.Components == components && stride % 4 == 0 && accessor.ByteOffset % componentSize == 0
+                && accessor.Count <= UINT32_MAX;
+        };
+        if (primitive.Mode != 4 || primitive.Indices < 0 || primitive.Normal < 0)
+            return false;
+        if (!usable(primitive.Position, 3) || !usable(primitive.Normal, 3) || !usable(primitive.Indices, 1))
+            return false;
+        const GltfAccessor& position = accessors[primitive.Position];
+        const GltfAccessor& normal = accessors[primitive.Normal];
+        const GltfAccessor& index = accessors[primitive.Indices];
+        if (position.ComponentType != GLTF_FLOAT || position.Normalized || normal.ComponentType != GLTF_FLOAT || normal.Count != position.Count)
+            return false;
+        if (primitive.TexCoord >= 0)
+        {
+            if (!usable(primitive.TexCoord, 2))
+                return false;
+            const GltfAccessor& texCoord = accessors[primitive.TexCoord];
+            bool readable = texCoord.ComponentType == GLTF_FLOAT
+                || (texCoord.Normalized && (texCoord.ComponentType == GLTF_UNSIGNED_BYTE || texCoord.ComponentType == GLTF_UNSIGNED_SHORT));
+            if (!readable || texCoord.Count != position.Count)
+                return false;
+        }
+        // element buffers are read tightly packed
+        if ((index.ComponentType != GLTF_UNSIGNED_SHORT && index.ComponentType != GLTF_UNSIGNED_INT) || Asset->BufferViews[index.BufferView].ByteStride != 0
+            || index.Count % 3 != 0)
+            return false;
+
+        const uint8_t* data;
+        size_t stride;
+        Asset->AccessorData(primitive.Indices, data, stride);
+        uint32_t largest = 0;
+        if (index.ComponentType == GLTF_UNSIGNED_INT)
+        {
+            for (size_t i = 0; i < index.Count; ++i)
+            {
+                uint32_t value;
+                std::memcpy(&value, data + i * 4, 4);
+                largest = std::max(largest, value);
+            }
+        }
+        else
+        {
+            for (size_t i = 0; i < index.Count; ++i)
+            {
+                uint16_t value;
+                std::memcpy(&value, data + i * 2, 2);
+                largest = std::max<uint32_t>(largest, value);
+            }
+        }
+        return largest < position.Count;
+    }
+
+    // runs on the job system: checks or converts the primitive, but never touches GL
+    void prepare(Variant& variant) const
+    {
+        const GltfPrimitive& primitive = primitiveAt(variant.Primitive);
+        if (!variant.Baked && zeroCopyLayout(primitive))
+        {
+            variant.ZeroCopy = true;
+            const GltfAccessor& position = Asset->Accessors[primitive.Position];
+            const uint8_t* data;
+            size_t stride;
+            Asset->AccessorData(primitive.Position, data, stride);
+            variant.Positions.resize(position.Count * 3);
+            for (size_t i = 0; i < position.Count; ++i)
+                std::memcpy(&variant.Positions[i * 3], data + i * stride, 3 * sizeof(float));
+            return;
+        }
+        if (!Asset->ReadPrimitive(primitive, variant.Data, variant.Error))
+            return;
+        if (variant.Data.Indices.empty())
+            variant.Error = "no triangles";
+        else if (variant.Baked)
+            applyLinear(variant.Data, variant.Linear);
+    }
+
+    // transforms positions by linear and normals by its inverse transpose; mirroring transforms flip the winding
+    static void applyLinear(MeshData& data, const glm::mat3& linear)
+    {
+        glm::mat3 normalMatrix = glm::transpose(glm::inverse(linear));
+        for (size_t v = 0; v < data.VertexCount(); ++v)
+        {
+            float* vertex = &data.Vertices[v * MeshData::STRIDE];
+            glm::vec3 position = linear * glm::vec3(vertex[0], vertex[1], vertex[2]);
+            glm::vec3 normal = normalMatrix * glm::vec3(vertex[5], vertex[6], vertex[7]);
+            float length = glm::length(normal);
+            normal = length > 0.0f ? normal / length : normal;
+            vertex[0] = position.x; vertex[1] = position.y; vertex[2] = position.z;
+            vertex[5] = normal.x; vertex[6] = normal.y; vertex[7] = normal.z;
+        }
+        if (glm::determinant(linear) < 0.0f)
+        {
+            for (size_t i = 0; i + 2 < data.Indices.size(); i += 3)
+                std::swap(data.Indices[i + 1], data.Indices[i + 2]);
+        }
+    }
+
+    // GL buffer holding a copy of a buffer view, uploaded from the mapping the first time a primitive needs it
+    GLuint viewBuffer(int view, const std::string& owner)
+    {
+        auto it = viewBuffers.find(view);
+        if (it != viewBuffers.end())
+            return it->second.ID();
+        GpuHandle buffer = GpuHandle::Create(registry, GPU_BUFFER, owner + " buffer view " + std::to_string(view));
+        size_t bytes = Asset->BufferViews[view].ByteLength;
+        // bound as an array buffer only for the upload; the VAO decides how it is read
+        state.BindVertexArray(0);
+        state.BindBuffer(GL_ARRAY_BUFFER, buffer.ID());
+        glBufferData(GL_ARRAY_BUFFER, bytes, Asset->BufferViewData(view), GL_STATIC_DRAW);
+        buffer.SetBytes(bytes);
+        Stats.ZeroCopyBytes += bytes;
+        GLuint id = buffer.ID();
+        viewBuffers.emplace(view, std::move(buffer));
+        return id;
+    }
+
+    void bindAttribute(GLuint location, int accessorIndex, const std::string& owner)
+    {
+        const GltfAccessor& accessor = Asset->Accessors[accessorIndex];
+        GLuint buffer = viewBuffer(accessor.BufferView, owner);
+        state.BindBuffer(GL_ARRAY_BUFFER, buffer);
+        glVertexAttribPointer(location, static_cast<GLint>(accessor.Components), accessor.ComponentType, accessor.Normalized ? GL_TRUE : GL_FALSE,
+            static_cast<GLsizei>(Asset->BufferViews[accessor.BufferView].ByteStride), reinterpret_cast<const void*>(accessor.ByteOffset));
+        glEnableVertexAttribArray(location);
+    }
+
+    void uploadZeroCopy(Variant& variant, const std::string& owner)
+    {
+        const GltfPrimitive& primitive = primitiveAt(variant.Primitive);
+        const GltfAccessor& indices = Asset->Accessors[primitive.Indices];
+        Mesh& mesh = *variant.Gpu;
+        // upload every view first, so binding them below does not disturb the vertex array
+        viewBuffer(Asset->Accessors[primitive.Position].BufferView, owner);
+        viewBuffer(Asset->Accessors[primitive.Normal].BufferView, owner);
+        viewBuffer(indices.BufferView, owner);
+        if (primitive.TexCoord >= 0)
+            viewBuffer(Asset->Accessors[primitive.TexCoord].BufferView, owner);
+
+        mesh.VAO = GpuHandle::Create(registry, GPU_VERTEX_ARRAY, owner + " mesh");
+        mesh.VertexCount = static_cast<unsigned int>(Asset->Accessors[primitive.Position].Count);
+        mesh.IndexCount = static_cast<unsigned int>(indices.Count);
+        mesh.IndexType = indices.ComponentType;
+        mesh.IndexOffset = indices.ByteOffset;
+        mesh.Positions = std::move(variant.Positions);
+        mesh.Radius = PositionsRadius(mesh.Positions.data(), mesh.Positions.size() / 3, 3);
+
+        state.BindVertexArray(mesh.VAO.ID());
+        bindAttribute(0, primitive.Position, owner);
+        if (primitive.TexCoord >= 0)
+            bindAttribute(1, primitive.TexCoord, owner);
+        else
+        {
+            // a disabled array reads the current generic value instead
+            glDisableVertexAttribArray(1);
+            glVertexAttrib2f(1, 0.0f, 0.0f);
+        }
+        bindAttribute(2, primitive.Normal, owner);
+        state.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, viewBuffers[indices.BufferView].ID());
+        state.BindVertexArray(0);
+        Stats.ZeroCopy++;
+    }
+};
+
+#endif
@@ -0,0 +1,286 @@
+#ifndef GPU_RESOURCES_H
+#define GPU_RESOURCES_H
+
+#include <glad/glad.h>
+
+#include "gl_state_cache.h"
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <utility>
+#include <cstddef>
+
+// Kinds of GL objects tracked by the registry
+enum Gpu_Resource_Type {
+    GPU_BUFFER,
+    GPU_TEXTURE,
+    GPU_VERTEX_ARRAY,
+    GPU_FRAMEBUFFER,
+    GPU_RENDERBUFFER,
+    GPU_PROGRAM,
+    GPU_QUERY,
+    GPU_RESOURCE_TYPE_COUNT
+};
+
+inline const char* GpuResourceTypeName(Gpu_Resource_Type type)
+{
+    switch (type)
+    {
+    case GPU_BUFFER: return "Buffers";
+    case GPU_TEXTURE: return "Textures";
+    case GPU_VERTEX_ARRAY: return "Vertex arrays";
+    case GPU_FRAMEBUFFER: return "Framebuffers";
+    case GPU_RENDERBUFFER: return "Renderbuffers";
+    case GPU_PROGRAM: return "Programs";
+    case GPU_QUERY: return "Queries";
+    default: return "Unknown";
+    }
+}
+
+// Bytes used by a texture of the given size; a full mip chain adds a third on top of the base level
+inline size_t EstimateTextureBytes(int width, int height, int bytesPerPixel, bool mipmapped)
+{
+    size_t base = (size_t)width * (size_t)height * (size_t)bytesPerPixel;
+    return mipmapped ? base + base / 3 : base;
+}
+
+// Book-keeping for every live GL object created through GpuHandle: who owns it and how much memory it holds
+class GpuResourceRegistry
+{
+public:
+    struct Entry
+    {
+        Gpu_Resource_Type Type;
+        GLuint ID;
+        std::string Owner;
+        size_t Bytes;
+    };
+
+    struct Totals
+    {
+        size_t Count = 0;
+        size_t Bytes = 0;
+    };
+
+    // optional state cache that is told about deleted names
+    GLStateCache* StateCache = nullptr;
+
+    unsigned int Register(Gpu_Resource_Type type, GLuint id, const std::string& owner, size_t bytes = 0)
+    {
+        unsigned int key = nextKey++;
+        entries[key] = { type, id, owner, bytes };
+        unlabeled.push_back(key);
+        totals[type].Count++;
+        totals[type].Bytes += bytes;
+        return key;
+    }
+
+    void SetBytes(unsigned int key, size_t bytes)
+    {
+        auto it = entries.find(key);
+        if (it == entries.end())
+            return;
+        totals[it->second.Type].Bytes -= it->second.Bytes;
+        totals[it->second.Type].Bytes += bytes;
+        it->second.Bytes = bytes;
+    }
+
+    void SetOwner(unsigned int key, const std::string& owner)
+    {
+        auto it = entries.find(key);
+        if (it != entries.end())
+            it->second.Owner = owner;
+    }
+
+    void Unregister(unsigned int key)
+    {
+        auto it = entries.find(key);
+        if (it == entries.end())
+            return;
+        totals[it->second.Type].Count--;
+        totals[it->second.Type].Bytes -= it->second.Bytes;
+        entries.erase(it);
+    }
+
+    const Entry* Find(unsigned int key) const
+    {
+        auto it = entries.find(key);
+        return it == entries.end() ? nullptr : &it->second;
+    }
+
+    const Totals& GetTotals(Gpu_Resource_Type type) const
+    {
+        return totals[type];
+    }
+
+    size_t GetTotalBytes() const
+    {
+        size_t bytes = 0;
+        for (int i = 0; i < GPU_RESOURCE_TYPE_COUNT; ++i)
+            bytes += totals[i].Bytes;
+        return bytes;
+    }
+
+    // calls fn(entry) for every object registered since the last call, e.g. to attach debug labels once it exists on the GPU
+    template <typename Fn>
+    void DrainUnlabeled(Fn fn)
+    {
+        for (unsigned int key : unlabeled)
+        {
+            auto it = entries.find(key);
+            if (it != entries.end())
+                fn(it->second);
+        }
+        unlabeled.clear();
+    }
+
+    // snapshot of all live objects; anything still listed after the owners released their handles has leaked
+    std::vector<Entry> GetLiveEntries() const
+    {
+        std::vector<Entry> live;
+        live.reserve(entries.size());
+        for (const auto& entry : entries)
+            live.push_back(entry.second);
+        return live;
+    }
+
+private:
+    std::unordered_map<unsigned int, Entry> entries;
+    std::vector<unsigned int> unlabeled;
+    Totals totals[GPU_RESOURCE_TYPE_COUNT];
+    unsigned int nextKey = 1;
+};
+
+// Move-only owner of a single GL object. The object is registered on creation and deleted on Reset or destruction,
+// which must happen while the context is still current.
+class GpuHandle
+{
+public:
+    GpuHandle() = default;
+
+    GpuHandle(const GpuHandle&) = delete;
+    GpuHandle& operator=(const GpuHandle&) = delete;
+
+    GpuHandle(GpuHandle&& other) noexcept
+    {
+        *this = std::move(other);
+    }
+
+    GpuHandle& operator=(GpuHandle&& other) noexcept
+    {
+        if (this != &other)
+        {
+            Reset();
+            registry = other.registry;
+            type = other.type;
+            id = other.id;
+            key = other.key;
+            other.registry = nullptr;
+            other.id = 0;
+            other.key = 0;
+        }
+        return *this;
+    }
+
+    ~GpuHandle()
+    {
+        Reset();
+    }
+
+    // generates a new GL object of the given type (programs are created with glCreateProgram)
+    static GpuHandle Create(GpuResourceRegistry& registry, Gpu_Resource_Type type, const std::string& owner)
+    {
+        GLuint name = 0;
+        switch (type)
+        {
+        case GPU_BUFFER: glGenBuffers(1, &name); break;
+        case GPU_TEXTURE: glGenTextures(1, &name); break;
+        case GPU_VERTEX_ARRAY: glGenVertexArrays(1, &name); break;
+        case GPU_FRAMEBUFFER: glGenFramebuffers(1, &name); break;
+        case GPU_RENDERBUFFER: glGenRenderbuffers(1, &name); break;
+        case GPU_PROGRAM: name = glCreateProgram(); break;
+        case GPU_QUERY: glGenQueries(1, &name); break;
+        default: break;
+        }
+        return Adopt(registry, type, name, owner);
+    }
+
+    // takes ownership of an object created elsewhere, e.g. a program linked by Shader
+    static GpuHandle Adopt(GpuResourceRegistry& registry, Gpu_Resource_Type type, GLuint name, const std::string& owner, size_t bytes = 0)
+    {
+        GpuHandle handle;
+        handle.registry = &registry;
+        handle.type = type;
+        handle.id = name;
+        handle.key = registry.Register(type, name, owner, bytes);
+        return handle;
+    }
+
+    GLuint ID() const { return id; }
+    bool IsValid() const { return id != 0; }
+
+    // records the memory held by the object after its storage has been (re)specified
+    void SetBytes(size_t bytes)
+    {
+        if (registry)
+            registry->SetBytes(key, bytes);
+    }
+
+    size_t GetBytes() const
+    {
+        const GpuResourceRegistry::Entry* entry = registry ? registry->Find(key) : nullptr;
+        return entry ? entry->Bytes : 0;
+    }
+
+    // deletes the GL object and removes it from the registry
+    void Reset()
+    {
+        if (!registry)
+            return;
+
+        GLStateCache* cache = registry->StateCache;
+        switch (type)
+        {
+        case GPU_BUFFER:
+            glDeleteBuffers(1, &id);
+            if (cache) cache->ForgetBuffer(id);
+            break;
+        case GPU_TEXTURE:
+            glDeleteTextures(1, &id);
+            if (cache) cache->ForgetTexture(id);
+            break;
+        case GPU_VERTEX_ARRAY:
+            glDeleteVertexArrays(1, &id);
+            if (cache) cache->ForgetVertexArray(id);
+            break;
+        case GPU_FRAMEBUFFER:
+            glDeleteFramebuffers(1, &id);
+            if (cache) cache->ForgetFramebuffer(id);
+            break;
+        case GPU_RENDERBUFFER:
+            glDeleteRenderbuffers(1, &id);
+            break;
+        case GPU_PROGRAM:
+            glDeleteProgram(id);
+            if (cache) cache->ForgetProgram(id);
+            break;
+        case GPU_QUERY:
+            glDeleteQueries(1, &id);
+            break;
+        default:
+            break;
+        }
+        registry->Unregister(key);
+        registry = nullptr;
+        id = 0;
+        key = 0;
+    }
+
+private:
+    GpuResourceRegistry* registry = nullptr;
+    Gpu_Resource_Type type = GPU_BUFFER;
+    GLuint id = 0;
+    unsigned int key = 0;
+};
+#endif
@@ -0,0 +1,395 @@
+#include "half_edge.h"
+
+#include <algorithm>
+
+namespace
+{
+    // faces or vertices per job; normals are cheap, so chunks are large to keep scheduling overhead down
+    const size_t NORMAL_GRAIN = 16384;
+
+    // corners closer than about a millionth of a unit weld, which absorbs the rounding in generated seams
+    const float WELD_SCALE = 1048576.0f;
+
+    // corner normals within about 2.5 degrees of each other shade smoothly together
+    const float SMOOTH_COSINE = 0.999f;
+
+    glm::ivec3 weldKey(const glm::vec3& position)
+    {
+        return glm::ivec3(glm::round(position * WELD_SCALE));
+    }
+
+    bool keyLess(const glm::ivec3& a, const glm::ivec3& b)
+    {
+        if (a.x != b.x)
+            return a.x < b.x;
+        if (a.y != b.y)
+            return a.y < b.y;
+        return a.z < b.z;
+    }
+}
+
+HalfEdgeMesh HalfEdgeMesh::FromTriangles(const MeshData& data, std::vector<uint32_t>* cornerVertex)
+{
+    const size_t cornerCount = data.VertexCount();
+    std::vector<glm::vec3> cornerPositions(cornerCount);
+    std::vector<glm::ivec3> keys(cornerCount);
+    for (size_t i = 0; i < cornerCount; ++i)
+    {
+        const float* vertex = &data.Vertices[i * MeshData::STRIDE];
+        cornerPositions[i] = glm::vec3(vertex[0], vertex[1], vertex[2]);
+        keys[i] = weldKey(cornerPositions[i]);
+    }
+
+    // sort once instead of hashing every corner; each group of equal keys maps to the vertex of its
+    // first corner, and vertices are numbered in the order the data first uses them to keep its locality
+    std::vector<uint32_t> order(cornerCount);
+    for (size_t i = 0; i < cornerCount; ++i)
+        order[i] = static_cast<uint32_t>(i);
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        if (keyLess(keys[a], keys[b]))
+            return true;
+        if (keyLess(keys[b], keys[a]))
+            return false;
+        return a < b;
+    });
+    std::vector<uint32_t> representative(cornerCount);
+    for (size_t i = 0; i < cornerCount; ++i)
+    {
+        bool same = i > 0 && keys[order[i]] == keys[order[i - 1]];
+        representative[order[i]] = same ? representative[order[i - 1]] : order[i];
+    }
+
+    std::vector<uint32_t> remap(cornerCount);
+    std::vector<glm::vec3> positions;
+    for (size_t i = 0; i < cornerCount; ++i)
+    {
+        if (representative[i] == i)
+        {
+            remap[i] = static_cast<uint32_t>(positions.size());
+            positions.push_back(cornerPositions[i]);
+        }
+        else
+        {
+            remap[i] = remap[representative[i]];
+        }
+    }
+
+    std::vector<uint32_t> faceVertices(data.Indices.size());
+    for (size_t i = 0; i < data.Indices.size(); ++i)
+        faceVertices[i] = remap[data.Indices[i]];
+    std::vector<uint32_t> faceSizes(data.Indices.size() / 3, 3);
+
+    HalfEdgeMesh mesh = FromPolygons(positions, faceSizes, faceVertices);
+
+    // the corners of data are the wedges; edge i starts at corner Indices[i] because faces keep the index order
+    mesh.WedgeVertex = remap;
+    mesh.WedgeTexCoords.resize(cornerCount);
+    for (size_t i = 0; i < cornerCount; ++i)
+    {
+        const float* vertex = &data.Vertices[i * MeshData::STRIDE];
+        mesh.WedgeTexCoords[i] = glm::vec2(vertex[3], vertex[4]);
+    }
+    mesh.EdgeWedge.assign(data.Indices.begin(), data.Indices.end());
+
+    // within each run of welded corners, those whose normals agree form a group named after its first corner;
+    // runs with a single group are smooth
+    mesh.WedgeGroup.assign(cornerCount, INVALID);
+    std::vector<uint32_t> groups;
+    for (size_t begin = 0; begin < cornerCount;)
+    {
+        size_t end = begin + 1;
+        while (end < cornerCount && representative[order[end]] == representative[order[begin]])
+            end++;
+        groups.clear();
+        for (size_t i = begin; i < end; ++i)
+        {
+            const float* vertex = &data.Vertices[order[i] * MeshData::STRIDE];
+            glm::vec3 normal(vertex[5], vertex[6], vertex[7]);
+            uint32_t group = order[i];
+            for (uint32_t candidate : groups)
+            {
+                const float* other = &data.Vertices[candidate * MeshData::STRIDE];
+                if (glm::dot(normal, glm::vec3(other[5], other[6], other[7])) >= SMOOTH_COSINE)
+                {
+                    group = candidate;
+                    break;
+                }
+            }
+            if (group == order[i])
+                groups.push_back(group);
+            mesh.WedgeGroup[order[i]] = group;
+        }
+        if (groups.size() == 1)
+        {
+            for (size_t i = begin; i < end; ++i)
+                mesh.WedgeGroup[order[i]] = INVALID;
+        }
+        begin = end;
+    }
+
+    if (cornerVertex != nullptr)
+        *cornerVertex = std::move(remap);
+    return mesh;
+}
+
+HalfEdgeMesh HalfEdgeMesh::FromPolygons(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& faceSizes, const std::vector<uint32_t>& faceVertices)
+{
+    HalfEdgeMesh mesh;
+    mesh.Positions = positions;
+    mesh.Normals.assign(positions.size(), glm::vec3(0.0f));
+    mesh.VertexEdge.assign(positions.size(), INVALID);
+
+    mesh.WedgeVertex.resize(positions.size());
+    for (size_t v = 0; v < positions.size(); ++v)
+        mesh.WedgeVertex[v] = static_cast<uint32_t>(v);
+    mesh.WedgeTexCoords.assign(positions.size(), glm::vec2(0.0f));
+    mesh.WedgeGroup.assign(positions.size(), INVALID);
+
+    mesh.EdgeVertex.resize(faceVertices.size());
+    mesh.EdgeNext.resize(faceVertices.size());
+    mesh.EdgeTwin.assign(faceVertices.size(), INVALID);
+    mesh.EdgeFace.resize(faceVertices.size());
+    mesh.FaceEdge.resize(faceSizes.size());
+    mesh.FaceNormals.assign(faceSizes.size(), glm::vec3(0.0f));
+
+    // the half-edges of a face are stored consecutively, in corner order
+    uint32_t offset = 0;
+    for (size_t face = 0; face < faceSizes.size(); ++face)
+    {
+        uint32_t size = faceSizes[face];
+        mesh.FaceEdge[face] = offset;
+        for (uint32_t k = 0; k < size; ++k)
+        {
+            uint32_t edge = offset + k;
+            mesh.EdgeVertex[edge] = faceVertices[edge];
+            mesh.EdgeNext[edge] = offset + (k + 1) % size;
+            mesh.EdgeFace[edge] = static_cast<uint32_t>(face);
+            if (mesh.VertexEdge[faceVertices[edge]] == INVALID)
+                mesh.VertexEdge[faceVertices[edge]] = edge;
+        }
+        offset += size;
+    }
+
+    mesh.EdgeWedge = faceVertices;
+    mesh.linkTwins();
+    return mesh;
+}
+
+// Pairs every half-edge u->v with an unpaired v->u found among v's outgoing half-edges, which are grouped per
+// vertex first so the search only looks at a vertex's valence. Boundary vertices then start at the outgoing
+// half-edge that follows the boundary, so ForEachOutgoing sweeps their whole fan.
+void HalfEdgeMesh::linkTwins()
+{
+    const size_t vertexCount = Positions.size();
+    const size_t edgeCount = EdgeVertex.size();
+
+    std::vector<uint32_t> start(vertexCount + 1, 0);
+    for (size_t edge = 0; edge < edgeCount; ++edge)
+        start[EdgeVertex[edge] + 1]++;
+    for (size_t v = 0; v < vertexCount; ++v)
+        start[v + 1] += start[v];
+    std::vector<uint32_t> outgoing(edgeCount);
+    std::vector<uint32_t> fill(start.begin(), start.end() - 1);
+    for (size_t edge = 0; edge < edgeCount; ++edge)
+        outgoing[fill[EdgeVertex[edge]]++] = static_cast<uint32_t>(edge);
+
+    for (uint32_t edge = 0; edge < edgeCount; ++edge)
+    {
+        if (EdgeTwin[edge] != INVALID)
+            continue;
+        uint32_t from = EdgeVertex[edge];
+        uint32_t to = Target(edge);
+        for (uint32_t k = start[to]; k < start[to + 1]; ++k)
+        {
+            uint32_t candidate = outgoing[k];
+            if (EdgeTwin[candidate] == INVALID && candidate != edge && Target(candidate) == from)
+            {
+                EdgeTwin[edge] = candidate;
+                EdgeTwin[candidate] = edge;
+                break;
+            }
+        }
+    }
+
+    for (uint32_t edge = 0; edge < edgeCount; ++edge)
+    {
+        if (EdgeTwin[edge] == INVALID)
+            VertexEdge[Target(edge)] = EdgeNext[edge];
+    }
+}
+
+size_t HalfEdgeMesh::BoundaryEdgeCount() const
+{
+    return static_cast<size_t>(std::count(EdgeTwin.begin(), EdgeTwin.end(), INVALID));
+}
+
+// Newell's method, exact for triangles and robust for slightly non-planar polygons
+glm::vec3 HalfEdgeMesh::faceNormal(uint32_t face) const
+{
+    glm::vec3 normal(0.0f);
+    uint32_t first = FaceEdge[face];
+    uint32_t edge = first;
+    do
+    {
+        const glm::vec3& a = Positions[EdgeVertex[edge]];
+        const glm::vec3& b = Positions[EdgeVertex[EdgeNext[edge]]];
+        normal += glm::cross(a, b);
+        edge = EdgeNext[edge];
+    } while (edge != first);
+    return normal;
+}
+
+glm::vec3 HalfEdgeMesh::vertexNormal(uint32_t vertex) const
+{
+    glm::vec3 sum(0.0f);
+    ForEachOutgoing(vertex, [&](uint32_t edge) { sum += FaceNormals[EdgeFace[edge]]; });
+    float length = glm::length(sum);
+    return length > 0.0f ? sum / length : glm::vec3(0.0f, 1.0f, 0.0f);
+}
+
+void HalfEdgeMesh::ComputeNormals(JobSystem& jobs)
+{
+    FaceNormals.resize(FaceEdge.size());
+    Normals.resize(Positions.size());
+    vertexStamp.resize(Positions.size(), 0);   // sized here so the first edit does not pay for it
+    faceStamp.resize(FaceEdge.size(), 0);
+    jobs.ParallelFor(FaceEdge.size(), NORMAL_GRAIN, [&](size_t begin, size_t end) {
+        for (size_t face = begin; face < end; ++face)
+            FaceNormals[face] = faceNormal(static_cast<uint32_t>(face));
+    });
+    jobs.ParallelFor(Positions.size(), NORMAL_GRAIN, [&](size_t begin, size_t end) {
+        for (size_t vertex = begin; vertex < end; ++vertex)
+            Normals[vertex] = vertexNormal(static_cast<uint32_t>(vertex));
+    });
+    dirty.clear();
+}
+
+void HalfEdgeMesh::SetPosition(uint32_t vertex, const glm::vec3& position)
+{
+    Positions[vertex] = position;
+    dirty.push_back(vertex);
+}
+
+void HalfEdgeMesh::MarkDirty(uint32_t vertex)
+{
+    dirty.push_back(vertex);
+}
+
+void HalfEdgeMesh::nextStamp()
+{
+    vertexStamp.resize(Positions.size(), 0);
+    faceStamp.resize(FaceEdge.size(), 0);
+    if (++stamp == 0)
+    {
+        std::fill(vertexStamp.begin(), vertexStamp.end(), 0);
+        std::fill(faceStamp.begin(), faceStamp.end(), 0);
+        stamp = 1;
+    }
+}
+
+void HalfEdgeMesh::UpdateNormals(JobSystem& jobs, std::vector<uint32_t>& changed)
+{
+    if (dirty.empty())
+        return;
+    nextStamp();
+
+    // the faces around the moved vertices, and every vertex of those faces
+    faces.clear();
+    size_t first = changed.size();
+    for (uint32_t vertex : dirty)
+    {
+        if (vertexStamp[vertex] != stamp)
+        {
+            vertexStamp[vertex] = stamp;
+            changed.push_back(vertex);
+        }
+        ForEachOutgoing(vertex, [&](uint32_t edge) {
+            uint32_t face = EdgeFace[edge];
+            if (faceStamp[face] != stamp)
+            {
+                faceStamp[face] = stamp;
+                faces.push_back(face);
+            }
+        });
+    }
+    for (uint32_t face : faces)
+    {
+        uint32_t edge = FaceEdge[face];
+        do
+        {
+            uint32_t vertex = EdgeVertex[edge];
+            if (vertexStamp[vertex] != stamp)
+            {
+                vertexStamp[vertex] = stamp;
+                changed.push_back(vertex);
+            }
+            edge = EdgeNext[edge];
+        } while (edge != FaceEdge[face]);
+    }
+
+    jobs.ParallelFor(faces.size(), NORMAL_GRAIN, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+            FaceNormals[faces[i]] = faceNormal(faces[i]);
+    });
+    jobs.ParallelFor(changed.size() - first, NORMAL_GRAIN, [&](size_t begin, size_t end) {
+        for (size_t i = first + begin; i < first + end; ++i)
+            Normals[changed[i]] = vertexNormal(changed[i]);
+    });
+    dirty.clear();
+}
+
+glm::vec3 HalfEdgeMesh::WedgeNormal(uint32_t wedge) const
+{
+    uint32_t vertex = WedgeVertex[wedge];
+    uint32_t group = WedgeGroup[wedge];
+    if (group == INVALID)
+        return Normals[vertex];
+    glm::vec3 sum(0.0f);
+    ForEachOutgoing(vertex, [&](uint32_t edge) {
+        if (WedgeGroup[EdgeWedge[edge]] == group)
+            sum += FaceNormals[EdgeFace[edge]];
+    });
+    float length = glm::length(sum);
+    return length > 0.0f ? sum / length : Normals[vertex];
+}
+
+void HalfEdgeMesh::WriteWedges(size_t first, size_t count, float* out) const
+{
+    for (size_t w = first; w < first + count; ++w, out += MeshData::STRIDE)
+    {
+        const glm::vec3& p = Positions[WedgeVertex[w]];
+        const glm::vec2& uv = WedgeTexCoords[w];
+        glm::vec3 n = WedgeNormal(static_cast<uint32_t>(w));
+        out[0] = p.x; out[1] = p.y; out[2] = p.z;
+        out[3] = uv.x; out[4] = uv.y;
+        out[5] = n.x; out[6] = n.y; out[7] = n.z;
+    }
+}
+
+std::vector<unsigned int> HalfEdgeMesh::Triangulate() const
+{
+    std::vector<unsigned int> indices;
+    indices.reserve((EdgeVertex.size() - 2 * FaceEdge.size()) * 3);
+    for (uint32_t face = 0; face < FaceEdge.size(); ++face)
+    {
+        uint32_t first = FaceEdge[face];
+        uint32_t edge = EdgeNext[first];
+        while (EdgeNext[edge] != first)
+        {
+            indices.push_back(EdgeWedge[first]);
+            indices.push_back(EdgeWedge[edge]);
+            indices.push_back(EdgeWedge[EdgeNext[edge]]);
+            edge = EdgeNext[edge];
+        }
+    }
+    return indices;
+}
+
+MeshData HalfEdgeMesh::ToMeshData() const
+{
+    MeshData data;
+    data.Vertices.resize(WedgeCount() * MeshData::STRIDE);
+    WriteWedges(0, WedgeCount(), data.Vertices.data());
+    data.Indices = Triangulate();
+    return data;
+}
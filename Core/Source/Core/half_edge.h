@@ -0,0 +1,116 @@
+#ifndef HALF_EDGE_H
+#define HALF_EDGE_H
+
+#include "primitives.h"
+#include "job_system.h"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// Polygon mesh with explicit connectivity for editing. Everything is stored as parallel index arrays rather
+// than linked records, so a million-vertex mesh is a handful of flat allocations that copy, parallelize and
+// stream well. Half-edge h runs from EdgeVertex[h] to EdgeVertex[EdgeNext[h]] with its face on the left.
+// Vertices are welded by position so the topology is closed across uv seams and hard edges; what gets drawn
+// are wedges, the corners around a vertex that share a texture coordinate and a smoothing group.
+class HalfEdgeMesh
+{
+public:
+    static constexpr uint32_t INVALID = 0xFFFFFFFFu;
+
+    // vertices
+    std::vector<glm::vec3> Positions;
+    std::vector<glm::vec3> Normals;         // unit length, area weighted over the whole fan
+    std::vector<uint32_t> VertexEdge;       // an outgoing half-edge; for boundary vertices the first one clockwise
+
+    // wedges
+    std::vector<uint32_t> WedgeVertex;
+    std::vector<glm::vec2> WedgeTexCoords;
+    std::vector<uint32_t> WedgeGroup;       // wedges of a vertex with equal groups shade smoothly together; INVALID
+                                            // when the vertex has no hard edge and the wedge uses its normal
+
+    // half-edges
+    std::vector<uint32_t> EdgeVertex;       // origin
+    std::vector<uint32_t> EdgeWedge;        // wedge of the origin corner
+    std::vector<uint32_t> EdgeNext;
+    std::vector<uint32_t> EdgeTwin;         // INVALID on the boundary
+    std::vector<uint32_t> EdgeFace;
+
+    // faces
+    std::vector<uint32_t> FaceEdge;
+    std::vector<glm::vec3> FaceNormals;     // not normalized; the length is twice the area for triangles
+
+    // welds corners at the same position into shared vertices and links twins; edges used by more than two
+    // faces keep the extra ones on the boundary; cornerVertex, if given, receives the vertex each corner became.
+    // Every vertex of data becomes the wedge with its index, and corners whose normals differ become separate
+    // smoothing groups, so the seams and hard edges of data survive the weld
+    static HalfEdgeMesh FromTriangles(const MeshData& data, std::vector<uint32_t>* cornerVertex = nullptr);
+    // faces given as corner counts plus a flat list of vertex indices; each vertex is one smooth wedge
+    static HalfEdgeMesh FromPolygons(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& faceSizes, const std::vector<uint32_t>& faceVertices);
+
+    size_t VertexCount() const { return Positions.size(); }
+    size_t EdgeCount() const { return EdgeVertex.size(); }
+    size_t FaceCount() const { return FaceEdge.size(); }
+    size_t WedgeCount() const { return WedgeVertex.size(); }
+
+    uint32_t Target(uint32_t edge) const { return EdgeVertex[EdgeNext[edge]]; }
+    size_t BoundaryEdgeCount() const;
+
+    // calls visit(edge) for every outgoing half-edge of the vertex
+    template<typename Visit>
+    void ForEachOutgoing(uint32_t vertex, Visit visit) const
+    {
+        uint32_t first = VertexEdge[vertex];
+        if (first == INVALID)
+            return;
+        uint32_t edge = first;
+        do
+        {
+            visit(edge);
+            uint32_t twin = EdgeTwin[edge];
+            if (twin == INVALID)
+                break;
+            edge = EdgeNext[twin];
+        } while (edge != first);
+    }
+
+    // full recomputation, split across the job system: faces first, then every vertex sums the faces around it
+    void ComputeNormals(JobSystem& jobs);
+
+    // edits go through these so the normals around them can be refreshed without touching the rest of the mesh
+    void SetPosition(uint32_t vertex, const glm::vec3& position);
+    void MarkDirty(uint32_t vertex);
+    bool HasDirty() const { return !dirty.empty(); }
+
+    // recomputes the normals of the faces around the dirty vertices and of those faces' vertices; appends every
+    // vertex whose position or normal changed to changed and clears the dirty set
+    void UpdateNormals(JobSystem& jobs, std::vector<uint32_t>& changed);
+
+    // unit normal of the wedge: the vertex normal, or at a hard edge the area-weighted sum of its group's faces
+    glm::vec3 WedgeNormal(uint32_t wedge) const;
+
+    // wedges [first, first + count) interleaved like MeshData::Vertices
+    void WriteWedges(size_t first, size_t count, float* out) const;
+
+    // fan-triangulated index list over the wedges for drawing
+    std::vector<unsigned int> Triangulate() const;
+
+    // wedges and triangles as a drawable mesh
+    MeshData ToMeshData() const;
+
+private:
+    std::vector<uint32_t> dirty;
+    std::vector<uint32_t> vertexStamp;  // equals stamp when the vertex is already in this update's list
+    std::vector<uint32_t> faceStamp;
+    std::vector<uint32_t> faces;        // scratch for UpdateNormals
+    uint32_t stamp = 0;
+
+    void linkTwins();
+    glm::vec3 faceNormal(uint32_t face) const;
+    glm::vec3 vertexNormal(uint32_t vertex) const;
+    void nextStamp();
+};
+
+#endif
@@ -0,0 +1,100 @@
+#ifndef ID_BUFFER_H
+#define ID_BUFFER_H
+
+#include <glad/glad.h>
+
+#include "gpu_resources.h"
+#include "gl_state_cache.h"
+
+#include <vector>
+#include <cstdint>
+
+// Offscreen target holding one unsigned ID per pixel with its own depth buffer, so a pass that writes object IDs
+// leaves exactly the frontmost visible object in every pixel. 0 is the background; callers write index + 1.
+class IdBuffer
+{
+public:
+    IdBuffer(GpuResourceRegistry& registry, GLStateCache& state)
+        : registry(registry), state(state)
+    {
+    }
+
+    IdBuffer(const IdBuffer&) = delete;
+    IdBuffer& operator=(const IdBuffer&) = delete;
+
+    int GetWidth() const { return width; }
+    int GetHeight() const { return height; }
+
+    // binds the target for drawing, (re)allocating it at the given size, and clears IDs and depth.
+    // The current clear depth and depth function are kept, so reverse-Z works the same as in the scene pass.
+    void Begin(int targetWidth, int targetHeight)
+    {
+        if (targetWidth != width || targetHeight != height || fbo.ID() == 0)
+            allocate(targetWidth, targetHeight);
+
+        state.BindFramebuffer(GL_FRAMEBUFFER, fbo.ID());
+        glViewport(0, 0, width, height);
+        GLuint clearId[4] = { 0, 0, 0, 0 };
+        glClearBufferuiv(GL_COLOR, 0, clearId);
+        glClear(GL_DEPTH_BUFFER_BIT);
+    }
+
+    void End(GLuint framebuffer, int viewportWidth, int viewportHeight)
+    {
+        state.BindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glViewport(0, 0, viewportWidth, viewportHeight);
+    }
+
+    // reads the IDs of a rectangle in GL pixel coordinates (origin bottom left), rows bottom up; the rectangle must lie inside the target
+    void Read(int x, int y, int regionWidth, int regionHeight, std::vector<uint32_t>& ids)
+    {
+        ids.resize(static_cast<size_t>(regionWidth) * regionHeight);
+        state.BindFramebuffer(GL_READ_FRAMEBUFFER, fbo.ID());
+        glReadBuffer(GL_COLOR_ATTACHMENT0);
+        glPixelStorei(GL_PACK_ALIGNMENT, 4);
+        glReadPixels(x, y, regionWidth, regionHeight, GL_RED_INTEGER, GL_UNSIGNED_INT, ids.data());
+        state.BindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    }
+
+    void Release()
+    {
+        fbo.Reset();
+        texture.Reset();
+        depth.Reset();
+        width = height = 0;
+    }
+
+private:
+    GpuResourceRegistry& registry;
+    GLStateCache& state;
+    GpuHandle fbo;
+    GpuHandle texture;
+    GpuHandle depth;
+    int width = 0;
+    int height = 0;
+
+    void allocate(int targetWidth, int targetHeight)
+    {
+        width = targetWidth;
+        height = targetHeight;
+
+        fbo = GpuHandle::Create(registry, GPU_FRAMEBUFFER, "ID buffer");
+        state.BindFramebuffer(GL_FRAMEBUFFER, fbo.ID());
+
+        texture = GpuHandle::Create(registry, GPU_TEXTURE, "ID buffer IDs");
+        state.BindTexture(GL_TEXTURE_2D, texture.ID());
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R32UI, width, height, 0, GL_RED_INTEGER, GL_UNSIGNED_INT, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        texture.SetBytes(EstimateTextureBytes(width, height, 4, false));
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture.ID(), 0);
+
+        depth = GpuHandle::Create(registry, GPU_RENDERBUFFER, "ID buffer depth");
+        glBindRenderbuffer(GL_RENDERBUFFER, depth.ID());
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT32F, width, height);
+        depth.SetBytes(EstimateTextureBytes(width, height, 4, false));
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth.ID());
+    }
+};
+
+#endif
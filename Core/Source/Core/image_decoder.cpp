@@ -0,0 +1,93 @@
+#include "image_decoder.h"
+
+// declarations only; the implementation is compiled into the application
+#include <stb_image.h>
+
+#include <climits>
+
+namespace
+{
+    // box filters width x height RGBA8 pixels down until the longer side is maxSize. Every output pixel lies at or
+    // before the first source pixel it reads, so the result is written over the source as it goes.
+    void downscale(unsigned char* pixels, int& width, int& height, int maxSize)
+    {
+        if (maxSize <= 0 || (width <= maxSize && height <= maxSize))
+            return;
+        float factor = static_cast<float>(maxSize) / static_cast<float>(std::max(width, height));
+        int targetWidth = std::max(1, static_cast<int>(width * factor + 0.5f));
+        int targetHeight = std::max(1, static_cast<int>(height * factor + 0.5f));
+        for (int y = 0; y < targetHeight; ++y)
+        {
+            int y0 = static_cast<int>(static_cast<long long>(y) * height / targetHeight);
+            int y1 = std::max(y0 + 1, static_cast<int>(static_cast<long long>(y + 1) * height / targetHeight));
+            for (int x = 0; x < targetWidth; ++x)
+            {
+                int x0 = static_cast<int>(static_cast<long long>(x) * width / targetWidth);
+                int x1 = std::max(x0 + 1, static_cast<int>(static_cast<long long>(x + 1) * width / targetWidth));
+                unsigned int sum[4] = { 0, 0, 0, 0 };
+                for (int sy = y0; sy < y1; ++sy)
+                {
+                    const unsigned char* row = pixels + (static_cast<size_t>(sy) * width + x0) * 4;
+                    for (int sx = 0; sx < x1 - x0; ++sx)
+                    {
+                        for (int c = 0; c < 4; ++c)
+                            sum[c] += row[sx * 4 + c];
+                    }
+                }
+                unsigned int count = static_cast<unsigned int>((y1 - y0) * (x1 - x0));
+                unsigned char* out = pixels + (static_cast<size_t>(y) * targetWidth + x) * 4;
+                for (int c = 0; c < 4; ++c)
+                    out[c] = static_cast<unsigned char>((sum[c] + count / 2) / count);
+            }
+        }
+        width = targetWidth;
+        height = targetHeight;
+    }
+}
+
+void ImageFree::operator()(unsigned char* pixels) const
+{
+    stbi_image_free(pixels);
+}
+
+void ImageDecoder::workerLoop()
+{
+    for (;;)
+    {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this]() { return stopping || !jobs.empty(); });
+            if (stopping)
+                return;
+            job = std::move(jobs.front());
+            jobs.pop_front();
+            busy++;
+        }
+
+        auto start = std::chrono::high_resolution_clock::now();
+        DecodedImage image;
+        image.Ticket = job.Ticket;
+        int channels = 0;
+        // the flip flag is per thread, so workers never see each other's setting
+        stbi_set_flip_vertically_on_load_thread(job.Flip ? 1 : 0);
+        if (job.Size <= static_cast<size_t>(INT_MAX))
+            image.Pixels.reset(stbi_load_from_memory(job.Data, static_cast<int>(job.Size), &image.Width, &image.Height, &channels, 4));
+        if (image.Pixels)
+            downscale(image.Pixels.get(), image.Width, image.Height, job.MaxSize);
+        else
+            image.Error = job.Size > static_cast<size_t>(INT_MAX) ? "image too large" :
+                stbi_failure_reason() != nullptr ? stbi_failure_reason() : "unknown error";
+        image.DecodeMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        job.KeepAlive.reset();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            results.push_back(std::move(image));
+            busy--;
+        }
+        idle.notify_all();
+        if (OnDecoded)
+            OnDecoded();
+    }
+}
@@ -0,0 +1,135 @@
+#ifndef IMAGE_DECODER_H
+#define IMAGE_DECODER_H
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <chrono>
+#include <algorithm>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+// releases pixels allocated by the decoder
+struct ImageFree
+{
+    void operator()(unsigned char* pixels) const;
+};
+
+// RGBA8 pixels decoded by an ImageDecoder worker
+struct DecodedImage
+{
+    uint64_t Ticket = 0;
+    int Width = 0;
+    int Height = 0;
+    std::unique_ptr<unsigned char, ImageFree> Pixels;   // null if decoding failed
+    std::string Error;
+    double DecodeMs = 0.0;
+};
+
+// Background threads that decode compressed images (PNG, JPEG, ...) to RGBA8 so loaders do not stall the frame.
+// Results are collected with Poll on the GL thread, which uploads them; GL is never touched by the workers.
+class ImageDecoder
+{
+public:
+    // called on a worker after each image finishes, e.g. to wake an idle main loop
+    std::function<void()> OnDecoded;
+
+    explicit ImageDecoder(unsigned int workerCount = 2)
+    {
+        for (unsigned int i = 0; i < std::max(workerCount, 1u); ++i)
+            workers.emplace_back(&ImageDecoder::workerLoop, this);
+    }
+
+    ~ImageDecoder()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+            jobs.clear();
+        }
+        wake.notify_all();
+        for (std::thread& worker : workers)
+            worker.join();
+    }
+
+    ImageDecoder(const ImageDecoder&) = delete;
+    ImageDecoder& operator=(const ImageDecoder&) = delete;
+
+    // queues size bytes at data for decoding and returns the ticket its result will carry; the bytes are read on
+    // a worker, so they must stay valid until the result is polled or Clear() returns (keepAlive is held until then).
+    // A maxSize above 0 box filters images with a longer side on the worker until they fit, keeping the aspect.
+    uint64_t Submit(const uint8_t* data, size_t size, std::shared_ptr<const void> keepAlive, bool flipVertically, int maxSize = 0)
+    {
+        Job job;
+        job.Data = data;
+        job.Size = size;
+        job.KeepAlive = std::move(keepAlive);
+        job.Flip = flipVertically;
+        job.MaxSize = maxSize;
+        uint64_t ticket;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            ticket = job.Ticket = ++lastTicket;
+            jobs.push_back(std::move(job));
+        }
+        wake.notify_one();
+        return ticket;
+    }
+
+    // takes one finished image; returns false if none is ready
+    bool Poll(DecodedImage& out)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (results.empty())
+            return false;
+        out = std::move(results.front());
+        results.pop_front();
+        return true;
+    }
+
+    // images submitted but not polled yet
+    size_t Pending() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return jobs.size() + results.size() + busy;
+    }
+
+    // drops queued jobs and unpolled results, waiting for images in progress
+    void Clear()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        jobs.clear();
+        idle.wait(lock, [this]() { return busy == 0; });
+        results.clear();
+    }
+
+private:
+    struct Job
+    {
+        uint64_t Ticket = 0;
+        const uint8_t* Data = nullptr;
+        size_t Size = 0;
+        std::shared_ptr<const void> KeepAlive;
+        bool Flip = false;
+        int MaxSize = 0;
+    };
+
+    std::vector<std::thread> workers;
+    std::deque<Job> jobs;
+    std::deque<DecodedImage> results;
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable idle;
+    uint64_t lastTicket = 0;
+    size_t busy = 0;
+    bool stopping = false;
+
+    void workerLoop();
+};
+
+#endif
@@ -23,6 +23,7 @@
 
 // CHANGELOG
 // (minor and older changes stripped away, please see git history for details)
+//  MixerGL:    OpenGL: Added optional streaming mode (ImGui_ImplOpenGL3_SetStreaming): vertices/indices are suballocated from fenced, persistently mapped ring buffers and drawn with base-vertex draws. glBufferData stays the fallback.
 //  2024-XX-XX: Platform: Added support for multiple windows via the ImGuiPlatformIO interface.
 //  2024-05-07: OpenGL: Update loader for Linux to support EGL/GLVND. (#7562)
 //  2024-04-16: OpenGL: Detect ES3 contexts on desktop based on version string, to e.g. avoid calling glPolygonMode() on them. (#7447)
@@ -207,6 +208,41 @@
 #define IMGUI_IMPL_OPENGL_MAY_HAVE_BIND_SAMPLER
 #endif
 
+// [MixerGL] Desktop GL 4.4+ or ARB_buffer_storage can stream vertices through persistently mapped buffers.
+// The stripped loader has no entry points for buffer storage, mapping or sync objects, so they are fetched at init.
+#if !defined(IMGUI_IMPL_OPENGL_ES2) && !defined(IMGUI_IMPL_OPENGL_ES3) && !defined(IMGUI_IMPL_OPENGL_LOADER_CUSTOM) && defined(IMGUI_IMPL_OPENGL_MAY_HAVE_VTX_OFFSET)
+#define IMGUI_IMPL_OPENGL_MAY_HAVE_BUFFER_STORAGE
+#ifndef GL_MAP_WRITE_BIT
+#define GL_MAP_WRITE_BIT                  0x0002
+#endif
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT             0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT               0x0080
+#endif
+#ifndef GL_SYNC_GPU_COMMANDS_COMPLETE
+#define GL_SYNC_GPU_COMMANDS_COMPLETE     0x9117
+#endif
+#ifndef GL_SYNC_FLUSH_COMMANDS_BIT
+#define GL_SYNC_FLUSH_COMMANDS_BIT        0x00000001
+#endif
+#ifndef GL_ALREADY_SIGNALED
+#define GL_ALREADY_SIGNALED               0x911A
+#endif
+#ifndef GL_TIMEOUT_EXPIRED
+#define GL_TIMEOUT_EXPIRED                0x911B
+#endif
+#ifndef GL_CONDITION_SATISFIED
+#define GL_CONDITION_SATISFIED            0x911C
+#endif
+typedef void      (APIENTRYP ImGui_PFNGLBUFFERSTORAGEPROC) (GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+typedef void*     (APIENTRYP ImGui_PFNGLMAPBUFFERRANGEPROC) (GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access);
+typedef GLsync    (APIENTRYP ImGui_PFNGLFENCESYNCPROC) (GLenum condition, GLbitfield flags);
+typedef GLenum    (APIENTRYP ImGui_PFNGLCLIENTWAITSYNCPROC) (GLsync sync, GLbitfield flags, GLuint64 timeout);
+typedef void      (APIENTRYP ImGui_PFNGLDELETESYNCPROC) (GLsync sync);
+#endif
+
 // [Debugging]
 //#define IMGUI_IMPL_OPENGL_DEBUG
 #ifdef IMGUI_IMPL_OPENGL_DEBUG
@@ -216,6 +252,25 @@
 #define GL_CALL(_CALL)      _CALL   // Call without error check
 #endif
 
+#ifdef IMGUI_IMPL_OPENGL_MAY_HAVE_BUFFER_STORAGE
+// [MixerGL] One persistently mapped buffer written front to back and wrapped around
+struct ImGui_ImplOpenGL3_StreamRing
+{
+    GLuint          Buffer;
+    GLsizeiptr      Size;
+    GLsizeiptr      Head;                    // Next byte to write
+    char*           Mapped;
+};
+
+// [MixerGL] Ring ranges read by one RenderDrawData call; they may be overwritten once its fence has signaled
+struct ImGui_ImplOpenGL3_StreamSubmission
+{
+    GLsync          Fence;
+    GLsizeiptr      VtxBegin, VtxEnd;
+    GLsizeiptr      IdxBegin, IdxEnd;
+};
+#endif
+
 // OpenGL Data
 struct ImGui_ImplOpenGL3_Data
 {
@@ -238,6 +293,18 @@ struct ImGui_ImplOpenGL3_Data
     bool            HasPolygonMode;
     bool            HasClipOrigin;
     bool            UseBufferSubData;
+    bool            UseStreaming;            // [MixerGL] Set with ImGui_ImplOpenGL3_SetStreaming()
+    bool            StreamActive;            // [MixerGL] The current RenderDrawData call draws from the rings
+    ImGui_ImplOpenGL3_StreamingStats StreamStats;
+#ifdef IMGUI_IMPL_OPENGL_MAY_HAVE_BUFFER_STORAGE
+    ImGui_ImplOpenGL3_StreamRing StreamVtx, StreamIdx;
+    ImVector<ImGui_ImplOpenGL3_StreamSubmission> StreamSubmissions; // Still in flight, oldest first
+    ImGui_PFNGLBUFFERSTORAGEPROC   BufferStorage;
+    ImGui_PFNGLMAPBUFFERRANGEPROC  MapBufferRange;
+    ImGui_PFNGLFENCESYNCPROC       FenceSync;
+    ImGui_PFNGLCLIENTWAITSYNCPROC  ClientWaitSync;
+    ImGui_PFNGLDELETESYNCPROC      DeleteSync;
+#endif
 
     ImGui_ImplOpenGL3_Data() { memset((void*)this, 0, sizeof(*this)); }
 };
@@ -375,6 +442,7 @@ bool    ImGui_ImplOpenGL3_Init(const char* glsl_version)
     bd->HasPolygonMode = (!bd->GlProfileIsES2 && !bd->GlProfileIsES3);
 #endif
     bd->HasClipOrigin = (bd->GlVersion >= 450);
+    bool has_buffer_storage = (bd->GlVersion >= 440);
 #ifdef IMGUI_IMPL_OPENGL_HAS_EXTENSIONS
     GLint num_extensions = 0;
     glGetIntegerv(GL_NUM_EXTENSIONS, &num_extensions);
@@ -383,9 +451,23 @@ bool    ImGui_ImplOpenGL3_Init(const char* glsl_version)
         const char* extension = (const char*)glGetStringi(GL_EXTENSIONS, i);
         if (extension != nullptr && strcmp(extension, "GL_ARB_clip_control") == 0)
             bd->HasClipOrigin = true;
+        if (extension != nullptr && strcmp(extension, "GL_ARB_buffer_storage") == 0)
+            has_buffer_storage = true;
     }
 #endif
 
+    // [MixerGL] Streaming needs buffer storage, sync objects (GL 3.2) and base-vertex draws (GL 3.2)
+#ifdef IMGUI_IMPL_OPENGL_MAY_HAVE_BUFFER_STORAGE
+    bd->BufferStorage = (ImGui_PFNGLBUFFERSTORAGEPROC)imgl3wGetProcAddress("glBufferStorage");
+    bd->MapBufferRange = (ImGui_PFNGLMAPBUFFERRANGEPROC)imgl3wGetProcAddress("glMapBufferRange");
+    bd->FenceSync = (ImGui_PFNGLFENCESYNCPROC)imgl3wGetProcAddress("glFenceSync");
+    bd->ClientWaitSync = (ImGui_PFNGLCLIENTWAITSYNCPROC)imgl3wGetProcAddress("glClientWaitSync");
+    bd->DeleteSync = (ImGui_PFNGLDELETESYNCPROC)imgl3wGetProcAddress("glDeleteSync");
+    bd->StreamStats.Available = has_buffer_storage && bd->GlVersion >= 320 && !bd->GlProfileIsES3 &&
+        bd->BufferStorage && bd->MapBufferRange && bd->FenceSync && bd->ClientWaitSync && bd->DeleteSync;
+#endif
+    (void)has_buffer_storage;
+
     if (io.ConfigFlags & ImGuiConfigFlags_ViewportsEnable)
         ImGui_ImplOpenGL3_InitPlatformInterface();
 
@@ -479,8 +561,17 @@ static void ImGui_ImplOpenGL3_SetupRenderState(ImDrawData* draw_data, int fb_wid
 #endif
 
     // Bind vertex/index buffers and setup attributes for ImDrawVert
-    GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, bd->VboHandle));
-    GL_CALL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, bd->ElementsHandle));
+    GLuint vertex_buffer = bd->VboHandle;
+    GLuint index_buffer = bd->ElementsHandle;
+#ifdef IMGUI_IMPL_OPENGL_MAY_HAVE_BUFFER_STORAGE
+    if (bd->StreamActive)
+    {
+        vertex_buffer = bd->StreamVtx.Buffer;
+        index_buffer = bd->StreamIdx.Buffer;
+    }
+#endif
+    GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer));
+    GL_CALL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffer));
     GL_CALL(glEnableVertexAttribArray(bd->AttribLocationVtxPos));
     GL_CALL(glEnableVertexAttribArray(bd->AttribLocationVtxUV));
     GL_CALL(glEnableVertexAttribArray(bd->AttribLocationVtxColor));
@@ -489,6 +580,147 @@ static void ImGui_ImplOpenGL3_SetupRenderState(ImDrawData* draw_data, int fb_wid
     GL_CALL(glVertexAttribPointer(bd->AttribLocationVtxColor, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(ImDrawVert), (GLvoid*)offsetof(ImDrawVert, col)));
 }
 
+#ifdef IMGUI_IMPL_OPENGL_MAY_HAVE_BUFFER_STORAGE
+// [MixerGL] Streaming mode helpers
+static void ImGui_ImplOpenGL3_StreamDestroy()
+{
+    ImGui_ImplOpenGL3_Data* bd = ImGui_ImplOpenGL3_GetBackendData();
+    for (ImGui_ImplOpenGL3_StreamSubmission& submission : bd->StreamSubmissions)
+        if (submission.Fence)
+            bd->DeleteSync(submission.Fence);
+    bd->StreamSubmissions.clear();
+    // Deleting a mapped buffer unmaps it; the driver keeps the storage alive until pending draws are done
+    if (bd->StreamVtx.Buffer) glDeleteBuffers(1, &bd->StreamVtx.Buffer);
+    if (bd->StreamIdx.Buffer) glDeleteBuffers(1, &bd->StreamIdx.Buffer);
+    memset(&bd->StreamVtx, 0, sizeof(bd->StreamVtx));
+    memset(&bd->StreamIdx, 0, sizeof(bd->StreamIdx));
+    bd->StreamStats.RingBytes = 0;
+}
+
+static bool ImGui_ImplOpenGL3_StreamCreateRing(ImGui_ImplOpenGL3_StreamRing& ring, GLsizeiptr size)
+{
+    ImGui_ImplOpenGL3_Data* bd = ImGui_ImplOpenGL3_GetBackendData();
+    const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glGenBuffers(1, &ring.Buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, ring.Buffer);
+    bd->BufferStorage(GL_ARRAY_BUFFER, size, nullptr, flags);
+    ring.Mapped = (char*)bd->MapBufferRange(GL_ARRAY_BUFFER, 0, size, flags);
+    ring.Size = size;
+    ring.Head = 0;
+    return ring.Mapped != nullptr;
+}
+
+// Returns a write offset for size bytes aligned to align, wrapping to the start when the end of the ring is reached
+static GLsizeiptr ImGui_ImplOpenGL3_StreamAllocate(ImGui_ImplOpenGL3_StreamRing& ring, GLsizeiptr size, GLsizeiptr align)
+{
+    GLsizeiptr offset = (ring.Head + align - 1) / align * align;
+    if (offset + size > ring.Size)
+        offset = 0;
+    ring.Head = offset + size;
+    return offset;
+}
+
+// Copies every draw list into the rings, waiting for the GPU only when the space is still being read.
+// Returns false when streaming cannot be used for this call, in which case nothing was written.
+static bool ImGui_ImplOpenGL3_StreamUpload(ImDrawData* draw_data, GLsizeiptr* vtx_offset, GLsizeiptr* idx_offset)
+{
+    ImGui_ImplOpenGL3_Data* bd = ImGui_ImplOpenGL3_GetBackendData();
+    const GLsizeiptr vtx_size = (GLsizeiptr)draw_data->TotalVtxCount * (int)sizeof(ImDrawVert);
+    const GLsizeiptr idx_size = (GLsizeiptr)draw_data->TotalIdxCount * (int)sizeof(ImDrawIdx);
+    if (vtx_size == 0 || idx_size == 0)
+        return false;
+
+    // Rings hold three calls of the current size, so one frame can be written while the GPU reads the previous ones.
+    // Growing drops the old rings; draws still using them keep their storage alive until they finish.
+    if (bd->StreamVtx.Size < vtx_size || bd->StreamIdx.Size < idx_size)
+    {
+        ImGui_ImplOpenGL3_StreamDestroy();
+        const GLsizeiptr min_size = 256 * 1024;
+        bool created = ImGui_ImplOpenGL3_StreamCreateRing(bd->StreamVtx, vtx_size * 3 > min_size ? vtx_size * 3 : min_size) &&
+                       ImGui_ImplOpenGL3_StreamCreateRing(bd->StreamIdx, idx_size * 3 > min_size ? idx_size * 3 : min_size);
+        if (!created)
+        {
+            ImGui_ImplOpenGL3_StreamDestroy();
+            bd->StreamStats.Available = false;
+            bd->UseStreaming = false;
+            return false;
+        }
+        bd->StreamStats.RingBytes = (size_t)(bd->StreamVtx.Size + bd->StreamIdx.Size);
+        bd->StreamStats.Resizes++;
+    }
+
+    ImGui_ImplOpenGL3_StreamSubmission submission;
+    submission.Fence = nullptr;
+    submission.VtxBegin = ImGui_ImplOpenGL3_StreamAllocate(bd->StreamVtx, vtx_size, (GLsizeiptr)sizeof(ImDrawVert));
+    submission.VtxEnd = submission.VtxBegin + vtx_size;
+    submission.IdxBegin = ImGui_ImplOpenGL3_StreamAllocate(bd->StreamIdx, idx_size, (GLsizeiptr)sizeof(ImDrawIdx));
+    submission.IdxEnd = submission.IdxBegin + idx_size;
+
+    // Fences signal in order, so waiting for the newest overlapping submission covers every older one
+    int last_overlap = -1;
+    for (int i = 0; i < bd->StreamSubmissions.Size; i++)
+    {
+        const ImGui_ImplOpenGL3_StreamSubmission& pending = bd->StreamSubmissions[i];
+        bool vtx_overlap = submission.VtxBegin < pending.VtxEnd && pending.VtxBegin < submission.VtxEnd;
+        bool idx_overlap = submission.IdxBegin < pending.IdxEnd && pending.IdxBegin < submission.IdxEnd;
+        if (vtx_overlap || idx_overlap)
+            last_overlap = i;
+    }
+    if (last_overlap >= 0)
+    {
+        GLsync fence = bd->StreamSubmissions[last_overlap].Fence;
+        GLenum result = bd->ClientWaitSync(fence, 0, 0);
+        if (result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED)
+        {
+            bd->StreamStats.Waits++;
+            while (result == GL_TIMEOUT_EXPIRED)
+                result = bd->ClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000); // 1 ms
+        }
+        for (int i = 0; i <= last_overlap; i++)
+            bd->DeleteSync(bd->StreamSubmissions[i].Fence);
+        bd->StreamSubmissions.erase(bd->StreamSubmissions.begin(), bd->StreamSubmissions.begin() + last_overlap + 1);
+    }
+
+    // The mapping is coherent, so plain copies are visible to draws issued afterwards
+    char* vtx_dst = bd->StreamVtx.Mapped + submission.VtxBegin;
+    char* idx_dst = bd->StreamIdx.Mapped + submission.IdxBegin;
+    for (int n = 0; n < draw_data->CmdListsCount; n++)
+    {
+        const ImDrawList* cmd_list = draw_data->CmdLists[n];
+        memcpy(vtx_dst, cmd_list->VtxBuffer.Data, (size_t)cmd_list->VtxBuffer.Size * sizeof(ImDrawVert));
+        memcpy(idx_dst, cmd_list->IdxBuffer.Data, (size_t)cmd_list->IdxBuffer.Size * sizeof(ImDrawIdx));
+        vtx_dst += (size_t)cmd_list->VtxBuffer.Size * sizeof(ImDrawVert);
+        idx_dst += (size_t)cmd_list->IdxBuffer.Size * sizeof(ImDrawIdx);
+    }
+
+    bd->StreamSubmissions.push_back(submission);
+    bd->StreamStats.UploadBytes = (size_t)(vtx_size + idx_size);
+    *vtx_offset = submission.VtxBegin;
+    *idx_offset = submission.IdxBegin;
+    return true;
+}
+#endif
+
+void ImGui_ImplOpenGL3_SetStreaming(bool enable)
+{
+    ImGui_ImplOpenGL3_Data* bd = ImGui_ImplOpenGL3_GetBackendData();
+    IM_ASSERT(bd != nullptr && "Context or backend not initialized! Did you call ImGui_ImplOpenGL3_Init()?");
+    bd->UseStreaming = enable && bd->StreamStats.Available;
+#ifdef IMGUI_IMPL_OPENGL_MAY_HAVE_BUFFER_STORAGE
+    if (!bd->UseStreaming)
+        ImGui_ImplOpenGL3_StreamDestroy();
+#endif
+}
+
+ImGui_ImplOpenGL3_StreamingStats ImGui_ImplOpenGL3_GetStreamingStats()
+{
+    ImGui_ImplOpenGL3_Data* bd = ImGui_ImplOpenGL3_GetBackendData();
+    IM_ASSERT(bd != nullptr && "Context or backend not initialized! Did you call ImGui_ImplOpenGL3_Init()?");
+    ImGui_ImplOpenGL3_StreamingStats stats = bd->StreamStats;
+    stats.Enabled = bd->UseStreaming;
+    return stats;
+}
+
 // OpenGL3 Render function.
 // Note that this implementation is little overcomplicated because we are saving/setting up/restoring every OpenGL state explicitly.
 // This is in order to be able to run within an OpenGL engine that doesn't do so.
@@ -548,6 +780,17 @@ void    ImGui_ImplOpenGL3_RenderDrawData(ImDrawData* draw_data)
 #ifdef IMGUI_IMPL_OPENGL_USE_VERTEX_ARRAY
     GL_CALL(glGenVertexArrays(1, &vertex_array_object));
 #endif
+
+    // [MixerGL] In streaming mode all draw lists are copied into the rings up front; the draws then offset into them
+    GLsizeiptr stream_vtx_offset = 0;
+    GLsizeiptr stream_idx_offset = 0;
+    bd->StreamActive = false;
+#ifdef IMGUI_IMPL_OPENGL_MAY_HAVE_BUFFER_STORAGE
+    if (bd->UseStreaming)
+        bd->StreamActive = ImGui_ImplOpenGL3_StreamUpload(draw_data, &stream_vtx_offset, &stream_idx_offset);
+#endif
+    if (!bd->StreamActive)
+        bd->StreamStats.UploadBytes = (size_t)draw_data->TotalVtxCount * sizeof(ImDrawVert) + (size_t)draw_data->TotalIdxCount * sizeof(ImDrawIdx);
     ImGui_ImplOpenGL3_SetupRenderState(draw_data, fb_width, fb_height, vertex_array_object);
 
     // Will project scissor/clipping rectangles into framebuffer space
@@ -569,7 +812,15 @@ void    ImGui_ImplOpenGL3_RenderDrawData(ImDrawData* draw_data)
         // - See https://github.com/ocornut/imgui/issues/4468 and please report any corruption issues.
         const GLsizeiptr vtx_buffer_size = (GLsizeiptr)cmd_list->VtxBuffer.Size * (int)sizeof(ImDrawVert);
         const GLsizeiptr idx_buffer_size = (GLsizeiptr)cmd_list->IdxBuffer.Size * (int)sizeof(ImDrawIdx);
-        if (bd->UseBufferSubData)
+        // [MixerGL] Where this list starts in the bound buffers: the ring position when streaming, else 0
+        const GLsizeiptr idx_base = stream_idx_offset;
+        const GLint vtx_base = (GLint)(stream_vtx_offset / (GLsizeiptr)sizeof(ImDrawVert));
+        if (bd->StreamActive)
+        {
+            stream_vtx_offset += vtx_buffer_size;
+            stream_idx_offset += idx_buffer_size;
+        }
+        else if (bd->UseBufferSubData)
         {
             if (bd->VertexBufferSize < vtx_buffer_size)
             {
@@ -617,14 +868,23 @@ void    ImGui_ImplOpenGL3_RenderDrawData(ImDrawData* draw_data)
                 GL_CALL(glBindTexture(GL_TEXTURE_2D, (GLuint)(intptr_t)pcmd->GetTexID()));
 #ifdef IMGUI_IMPL_OPENGL_MAY_HAVE_VTX_OFFSET
                 if (bd->GlVersion >= 320)
-                    GL_CALL(glDrawElementsBaseVertex(GL_TRIANGLES, (GLsizei)pcmd->ElemCount, sizeof(ImDrawIdx) == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT, (void*)(intptr_t)(pcmd->IdxOffset * sizeof(ImDrawIdx)), (GLint)pcmd->VtxOffset));
+                    GL_CALL(glDrawElementsBaseVertex(GL_TRIANGLES, (GLsizei)pcmd->ElemCount, sizeof(ImDrawIdx) == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT, (void*)(intptr_t)(idx_base + pcmd->IdxOffset * sizeof(ImDrawIdx)), vtx_base + (GLint)pcmd->VtxOffset));
                 else
 #endif
-                GL_CALL(glDrawElements(GL_TRIANGLES, (GLsizei)pcmd->ElemCount, sizeof(ImDrawIdx) == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT, (void*)(intptr_t)(pcmd->IdxOffset * sizeof(ImDrawIdx))));
+                GL_CALL(glDrawElements(GL_TRIANGLES, (GLsizei)pcmd->ElemCount, sizeof(ImDrawIdx) == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT, (void*)(intptr_t)(idx_base + pcmd->IdxOffset * sizeof(ImDrawIdx))));
             }
         }
     }
 
+    // [MixerGL] Fence the ring ranges this call read from
+#ifdef IMGUI_IMPL_OPENGL_MAY_HAVE_BUFFER_STORAGE
+    if (bd->StreamActive)
+    {
+        bd->StreamSubmissions.back().Fence = bd->FenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        bd->StreamActive = false;
+    }
+#endif
+
     // Destroy the temporary VAO
 #ifdef IMGUI_IMPL_OPENGL_USE_VERTEX_ARRAY
     GL_CALL(glDeleteVertexArrays(1, &vertex_array_object));
@@ -953,6 +1213,9 @@ void    ImGui_ImplOpenGL3_DestroyDeviceObjects()
     if (bd->VboHandle)      { glDeleteBuffers(1, &bd->VboHandle); bd->VboHandle = 0; }
     if (bd->ElementsHandle) { glDeleteBuffers(1, &bd->ElementsHandle); bd->ElementsHandle = 0; }
     if (bd->ShaderHandle)   { glDeleteProgram(bd->ShaderHandle); bd->ShaderHandle = 0; }
+#ifdef IMGUI_IMPL_OPENGL_MAY_HAVE_BUFFER_STORAGE
+    ImGui_ImplOpenGL3_StreamDestroy();
+#endif
     ImGui_ImplOpenGL3_DestroyFontsTexture();
 }
 
@@ -42,6 +42,21 @@ IMGUI_IMPL_API void     ImGui_ImplOpenGL3_DestroyFontsTexture();
 IMGUI_IMPL_API bool     ImGui_ImplOpenGL3_CreateDeviceObjects();
 IMGUI_IMPL_API void     ImGui_ImplOpenGL3_DestroyDeviceObjects();
 
+// [MixerGL] (Optional) Streaming mode: instead of re-specifying the buffers with glBufferData for every draw list,
+// vertices and indices are copied into fenced, persistently mapped ring buffers and drawn with base-vertex draws.
+// Needs desktop GL 4.4 or ARB_buffer_storage; without it the call is ignored and glBufferData stays in use.
+struct ImGui_ImplOpenGL3_StreamingStats
+{
+    bool            Available;      // Streaming is supported by the context
+    bool            Enabled;
+    size_t          RingBytes;      // Vertex + index ring capacity
+    size_t          UploadBytes;    // Bytes uploaded by the last RenderDrawData call, in either mode
+    unsigned int    Waits;          // Times a ring range was still in use by the GPU and the CPU had to wait
+    unsigned int    Resizes;        // Times the rings were (re)allocated
+};
+IMGUI_IMPL_API void     ImGui_ImplOpenGL3_SetStreaming(bool enable);
+IMGUI_IMPL_API ImGui_ImplOpenGL3_StreamingStats ImGui_ImplOpenGL3_GetStreamingStats();
+
 // Configuration flags to add in your imconfig file:
 //#define IMGUI_IMPL_OPENGL_ES2     // Enable ES 2 (Auto-detected on Emscripten)
 //#define IMGUI_IMPL_OPENGL_ES3     // Enable ES 3 (Auto-detected on iOS/Android)
@@ -0,0 +1,98 @@
+#ifndef INSTANCE_BATCH_H
+#define INSTANCE_BATCH_H
+
+#include <glad/glad.h>
+
+#include "mesh_pool.h"
+#include "scatter.h"
+#include "gpu_resources.h"
+#include "gl_state_cache.h"
+
+#include <string>
+#include <cstddef>
+#include <algorithm>
+
+// Copies of one pooled mesh drawn with a single instanced call. The instance buffer holds one ScatterInstance
+// per copy, read as attributes 3 (position), 4 (scale) and 5 (color) that advance once per instance.
+class InstanceBatch
+{
+public:
+    std::string Name;
+
+    // the mesh must stay in the pool for as long as the batch lives
+    InstanceBatch(GpuResourceRegistry& registry, GLStateCache& state, const Mesh* mesh, size_t capacity, const std::string& name)
+        : Name(name), state(state), mesh(mesh), capacity(capacity)
+    {
+        vao = GpuHandle::Create(registry, GPU_VERTEX_ARRAY, name + " instances");
+        buffer = GpuHandle::Create(registry, GPU_BUFFER, name + " instances");
+
+        state.BindVertexArray(vao.ID());
+
+        // Per-vertex attributes come from the shared mesh buffers
+        state.BindBuffer(GL_ARRAY_BUFFER, mesh->VBO.ID());
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, MeshData::STRIDE * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, MeshData::STRIDE * sizeof(float), (void*)(3 * sizeof(float)));
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, MeshData::STRIDE * sizeof(float), (void*)(5 * sizeof(float)));
+        glEnableVertexAttribArray(2);
+        state.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->EBO.ID());
+
+        // Per-instance attributes
+        state.BindBuffer(GL_ARRAY_BUFFER, buffer.ID());
+        glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(ScatterInstance), NULL, GL_STATIC_DRAW);
+        buffer.SetBytes(capacity * sizeof(ScatterInstance));
+        glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(ScatterInstance), (void*)offsetof(ScatterInstance, Position));
+        glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(ScatterInstance), (void*)offsetof(ScatterInstance, Scale));
+        glVertexAttribPointer(5, 4, GL_FLOAT, GL_FALSE, sizeof(ScatterInstance), (void*)offsetof(ScatterInstance, Color));
+        for (GLuint location = 3; location <= 5; ++location)
+        {
+            glEnableVertexAttribArray(location);
+            glVertexAttribDivisor(location, 1);
+        }
+
+        state.BindVertexArray(0);
+    }
+
+    InstanceBatch(const InstanceBatch&) = delete;
+    InstanceBatch& operator=(const InstanceBatch&) = delete;
+
+    const Mesh* GetMesh() const { return mesh; }
+    size_t GetCount() const { return count; }
+    size_t GetCapacity() const { return capacity; }
+
+    // maps the whole instance buffer for writing and discards its old contents; any thread may fill the
+    // returned memory, but Unmap must be called on the GL thread before the batch is drawn again
+    ScatterInstance* Map()
+    {
+        state.BindBuffer(GL_ARRAY_BUFFER, buffer.ID());
+        return static_cast<ScatterInstance*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, capacity * sizeof(ScatterInstance),
+            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+    }
+
+    // count is the number of instances written; returns false if the driver lost the mapped contents
+    bool Unmap(size_t written)
+    {
+        state.BindBuffer(GL_ARRAY_BUFFER, buffer.ID());
+        bool intact = glUnmapBuffer(GL_ARRAY_BUFFER) == GL_TRUE;
+        count = intact ? std::min(written, capacity) : 0;
+        return intact;
+    }
+
+    void Draw() const
+    {
+        if (count == 0)
+            return;
+        state.BindVertexArray(vao.ID());
+        glDrawElementsInstanced(GL_TRIANGLES, mesh->IndexCount, GL_UNSIGNED_INT, 0, static_cast<GLsizei>(count));
+    }
+
+private:
+    GLStateCache& state;
+    const Mesh* mesh;
+    GpuHandle vao;
+    GpuHandle buffer;
+    size_t capacity;
+    size_t count = 0;
+};
+#endif
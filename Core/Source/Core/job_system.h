@@ -0,0 +1,138 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <deque>
+#include <vector>
+#include <functional>
+#include <algorithm>
+#include <cstddef>
+
+// Fixed pool of worker threads fed from one queue. The thread that waits on a ParallelFor
+// keeps running queued jobs itself, so nested calls from inside a job cannot deadlock.
+class JobSystem
+{
+public:
+    // workerCount 0 uses one worker per hardware thread, minus the calling thread
+    explicit JobSystem(unsigned int workerCount = 0)
+    {
+        if (workerCount == 0)
+        {
+            unsigned int hardware = std::thread::hardware_concurrency();
+            workerCount = hardware > 1 ? hardware - 1 : 0;
+        }
+        for (unsigned int i = 0; i < workerCount; ++i)
+            workers.emplace_back(&JobSystem::workerLoop, this);
+    }
+
+    ~JobSystem()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread& worker : workers)
+            worker.join();
+    }
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    // threads that take part in a ParallelFor, including the caller
+    unsigned int GetThreadCount() const
+    {
+        return static_cast<unsigned int>(workers.size()) + 1;
+    }
+
+    // calls fn(begin, end) over [0, count) in chunks of at most grain items and returns once all chunks ran
+    template <typename Fn>
+    void ParallelFor(size_t count, size_t grain, const Fn& fn)
+    {
+        if (count == 0)
+            return;
+        grain = std::max<size_t>(grain, 1);
+        size_t chunks = (count + grain - 1) / grain;
+        if (chunks == 1 || workers.empty())
+        {
+            fn(0, count);
+            return;
+        }
+
+        std::atomic<size_t> nextChunk(0);
+        auto runChunks = [&]()
+        {
+            for (size_t chunk = nextChunk++; chunk < chunks; chunk = nextChunk++)
+            {
+                size_t begin = chunk * grain;
+                fn(begin, std::min(count, begin + grain));
+            }
+        };
+
+        // helpers only pull chunks, so a helper that starts late simply finds nothing left
+        size_t helpers = std::min(chunks - 1, workers.size());
+        std::atomic<size_t> activeHelpers(helpers);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (size_t i = 0; i < helpers; ++i)
+            {
+                queue.push_back([&runChunks, &activeHelpers]()
+                {
+                    runChunks();
+                    activeHelpers--;
+                });
+            }
+        }
+        wake.notify_all();
+
+        runChunks();
+        while (activeHelpers.load() != 0)
+        {
+            if (!runOne())
+                std::this_thread::yield();
+        }
+    }
+
+private:
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> queue;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+
+    // runs one queued job on the calling thread; returns false if the queue was empty
+    bool runOne()
+    {
+        std::function<void()> job;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (queue.empty())
+                return false;
+            job = std::move(queue.front());
+            queue.pop_front();
+        }
+        job();
+        return true;
+    }
+
+    void workerLoop()
+    {
+        for (;;)
+        {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [this]() { return stopping || !queue.empty(); });
+                if (stopping && queue.empty())
+                    return;
+                job = std::move(queue.front());
+                queue.pop_front();
+            }
+            job();
+        }
+    }
+};
+#endif
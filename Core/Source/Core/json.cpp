@@ -0,0 +1,346 @@
+#include "json.h"
+
+#include <cstdlib>
+#include <cstring>
+
+namespace
+{
+    // deep enough for any real document, shallow enough that hostile input cannot overflow the stack
+    const int MAX_DEPTH = 256;
+
+    const JsonValue NULL_VALUE;
+    const std::string EMPTY_STRING;
+
+    class Parser
+    {
+    public:
+        Parser(const char* text, size_t length) : cursor(text), begin(text), end(text + length)
+        {
+        }
+
+        bool Document(JsonValue& out, std::string& error)
+        {
+            skipSpace();
+            if (!value(out, 0))
+            {
+                error = message + " at byte " + std::to_string(failedAt - begin);
+                return false;
+            }
+            skipSpace();
+            if (cursor != end)
+            {
+                error = "trailing characters at byte " + std::to_string(cursor - begin);
+                return false;
+            }
+            return true;
+        }
+
+    private:
+        const char* cursor;
+        const char* begin;
+        const char* end;
+        const char* failedAt = nullptr;
+        std::string message;
+
+        bool fail(const char* text)
+        {
+            message = text;
+            failedAt = cursor;
+            return false;
+        }
+
+        void skipSpace()
+        {
+            while (cursor != end && (*cursor == ' ' || *cursor == '\t' || *cursor == '\n' || *cursor == '\r'))
+                ++cursor;
+        }
+
+        bool literal(const char* word)
+        {
+            size_t length = std::strlen(word);
+            if (static_cast<size_t>(end - cursor) < length || std::memcmp(cursor, word, length) != 0)
+                return fail("unknown literal");
+            cursor += length;
+            return true;
+        }
+
+        bool value(JsonValue& out, int depth)
+        {
+            if (cursor == end)
+                return fail("unexpected end of input");
+            switch (*cursor)
+            {
+            case '{': return object(out, depth);
+            case '[': return array(out, depth);
+            case '"': out.Type = JSON_STRING; return string(out.String);
+            case 't': out.Type = JSON_BOOL; out.Bool = true; return literal("true");
+            case 'f': out.Type = JSON_BOOL; out.Bool = false; return literal("false");
+            case 'n': out.Type = JSON_NULL; return literal("null");
+            default: return number(out);
+            }
+        }
+
+        bool object(JsonValue& out, int depth)
+        {
+            if (depth >= MAX_DEPTH)
+                return fail("nesting too deep");
+            out.Type = JSON_OBJECT;
+            ++cursor;
+            skipSpace();
+            if (cursor != end && *cursor == '}')
+            {
+                ++cursor;
+                return true;
+            }
+            for (;;)
+            {
+                skipSpace();
+                if (cursor == end || *cursor != '"')
+                    return fail("expected a member name");
+                out.Members.emplace_back();
+                if (!string(out.Members.back().first))
+                    return false;
+                skipSpace();
+                if (cursor == end || *cursor != ':')
+                    return fail("expected ':'");
+                ++cursor;
+                skipSpace();
+                if (!value(out.Members.back().second, depth + 1))
+                    return false;
+                skipSpace();
+                if (cursor != end && *cursor == ',')
+                {
+                    ++cursor;
+                    continue;
+                }
+                if (cursor != end && *cursor == '}')
+                {
+                    ++cursor;
+                    return true;
+                }
+                return fail("expected ',' or '}'");
+            }
+        }
+
+        bool array(JsonValue& out, int depth)
+        {
+            if (depth >= MAX_DEPTH)
+                return fail("nesting too deep");
+            out.Type = JSON_ARRAY;
+            ++cursor;
+            skipSpace();
+            if (cursor != end && *cursor == ']')
+            {
+                ++cursor;
+                return true;
+            }
+            for (;;)
+            {
+                skipSpace();
+                out.Items.emplace_back();
+                if (!value(out.Items.back(), depth + 1))
+                    return false;
+                skipSpace();
+                if (cursor != end && *cursor == ',')
+                {
+                    ++cursor;
+                    continue;
+                }
+                if (cursor != end && *cursor == ']')
+                {
+                    ++cursor;
+                    return true;
+                }
+                return fail("expected ',' or ']'");
+            }
+        }
+
+        bool number(JsonValue& out)
+        {
+            // strtod accepts more than JSON does (hex, inf), so check the first character ourselves
+            if (*cursor != '-' && (*cursor < '0' || *cursor > '9'))
+                return fail("unexpected character");
+            char buffer[64];
+            size_t length = 0;
+            while (cursor + length != end && length < sizeof(buffer) - 1 && std::strchr("+-.eE0123456789", cursor[length]) != nullptr)
+            {
+                buffer[length] = cursor[length];
+                ++length;
+            }
+            buffer[length] = '\0';
+            char* parsed = nullptr;
+            out.Type = JSON_NUMBER;
+            out.Number = std::strtod(buffer, &parsed);
+            if (parsed != buffer + length)
+                return fail("malformed number");
+            cursor += length;
+            return true;
+        }
+
+        static int hexDigit(char c)
+        {
+            if (c >= '0' && c <= '9') return c - '0';
+            if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+            if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+            return -1;
+        }
+
+        bool codeUnit(unsigned int& unit)
+        {
+            if (end - cursor < 4)
+                return fail("truncated \\u escape");
+            unit = 0;
+            for (int i = 0; i < 4; ++i)
+            {
+                int digit = hexDigit(cursor[i]);
+                if (digit < 0)
+                    return fail("malformed \\u escape");
+                unit = unit * 16 + static_cast<unsigned int>(digit);
+            }
+            cursor += 4;
+            return true;
+        }
+
+        static void appendUtf8(std::string& out, unsigned int code)
+        {
+            if (code < 0x80)
+                out += static_cast<char>(code);
+            else if (code < 0x800)
+            {
+                out += static_cast<char>(0xC0 | (code >> 6));
+                out += static_cast<char>(0x80 | (code & 0x3F));
+            }
+            else if (code < 0x10000)
+            {
+                out += static_cast<char>(0xE0 | (code >> 12));
+                out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+                out += static_cast<char>(0x80 | (code & 0x3F));
+            }
+            else
+            {
+                out += static_cast<char>(0xF0 | (code >> 18));
+                out += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+                out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+                out += static_cast<char>(0x80 | (code & 0x3F));
+            }
+        }
+
+        bool string(std::string& out)
+        {
+            ++cursor;
+            for (;;)
+            {
+                // copy runs without escapes in one go
+                const char* run = cursor;
+                while (cursor != end && *cursor != '"' && *cursor != '\\')
+                    ++cursor;
+                out.append(run, cursor);
+                if (cursor == end)
+                    return fail("unterminated string");
+                if (*cursor++ == '"')
+                    return true;
+                if (cursor == end)
+                    return fail("unterminated string");
+                char escape = *cursor++;
+                switch (escape)
+                {
+                case '"': out += '"'; break;
+                case '\\': out += '\\'; break;
+                case '/': out += '/'; break;
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'n': out += '\n'; break;
+                case 'r': out += '\r'; break;
+                case 't': out += '\t'; break;
+                case 'u':
+                {
+                    unsigned int code;
+                    if (!codeUnit(code))
+                        return false;
+                    // a high surrogate followed by a low one encodes a code point above the basic plane
+                    if (code >= 0xD800 && code < 0xDC00 && end - cursor >= 6 && cursor[0] == '\\' && cursor[1] == 'u')
+                    {
+                        cursor += 2;
+                        unsigned int low;
+                        if (!codeUnit(low))
+                            return false;
+                        if (low >= 0xDC00 && low < 0xE000)
+                            code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                        else
+                        {
+                            appendUtf8(out, code);
+                            code = low;
+                        }
+                    }
+                    appendUtf8(out, code);
+                    break;
+                }
+                default:
+                    return fail("unknown escape");
+                }
+            }
+        }
+    };
+}
+
+const JsonValue* JsonValue::Find(const char* key) const
+{
+    if (Type != JSON_OBJECT)
+        return nullptr;
+    for (const auto& member : Members)
+    {
+        if (member.first == key)
+            return &member.second;
+    }
+    return nullptr;
+}
+
+const JsonValue& JsonValue::operator[](const char* key) const
+{
+    const JsonValue* member = Find(key);
+    return member != nullptr ? *member : NULL_VALUE;
+}
+
+const JsonValue& JsonValue::operator[](size_t index) const
+{
+    return Type == JSON_ARRAY && index < Items.size() ? Items[index] : NULL_VALUE;
+}
+
+const std::string& JsonValue::AsString() const
+{
+    return Type == JSON_STRING ? String : EMPTY_STRING;
+}
+
+bool ParseJson(const char* text, size_t length, JsonValue& out, std::string& error)
+{
+    out = JsonValue();
+    Parser parser(text, length);
+    return parser.Document(out, error);
+}
+
+void AppendJsonString(std::string& out, const std::string& value)
+{
+    static const char* HEX = "0123456789abcdef";
+    out += '"';
+    for (char c : value)
+    {
+        switch (c)
+        {
+        case '"': out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n"; break;
+        case '\r': out += "\\r"; break;
+        case '\t': out += "\\t"; break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20)
+            {
+                out += "\\u00";
+                out += HEX[(c >> 4) & 0xF];
+                out += HEX[c & 0xF];
+            }
+            else
+                out += c;
+        }
+    }
+    out += '"';
+}
@@ -0,0 +1,60 @@
+#ifndef JSON_H
+#define JSON_H
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <cstddef>
+
+enum Json_Type {
+    JSON_NULL,
+    JSON_BOOL,
+    JSON_NUMBER,
+    JSON_STRING,
+    JSON_ARRAY,
+    JSON_OBJECT
+};
+
+// Parsed JSON document node. Lookups that miss return a shared null value, so chains like
+// doc["meshes"][0]["name"] need no checks in between.
+class JsonValue
+{
+public:
+    Json_Type Type = JSON_NULL;
+    bool Bool = false;
+    double Number = 0.0;
+    std::string String;
+    std::vector<JsonValue> Items;                               // arrays
+    std::vector<std::pair<std::string, JsonValue>> Members;     // objects, in document order
+
+    bool IsNull() const { return Type == JSON_NULL; }
+    bool IsNumber() const { return Type == JSON_NUMBER; }
+    bool IsString() const { return Type == JSON_STRING; }
+    bool IsArray() const { return Type == JSON_ARRAY; }
+    bool IsObject() const { return Type == JSON_OBJECT; }
+
+    // elements of an array, 0 for anything else
+    size_t Size() const { return Type == JSON_ARRAY ? Items.size() : 0; }
+
+    // member of an object; nullptr if missing or this is not an object
+    const JsonValue* Find(const char* key) const;
+
+    const JsonValue& operator[](const char* key) const;
+    const JsonValue& operator[](size_t index) const;
+    // literal indices are ints, which would otherwise be as close to const char* as to size_t
+    const JsonValue& operator[](int index) const { return (*this)[static_cast<size_t>(index)]; }
+
+    double AsNumber(double fallback = 0.0) const { return Type == JSON_NUMBER ? Number : fallback; }
+    int AsInt(int fallback = 0) const { return Type == JSON_NUMBER ? static_cast<int>(Number) : fallback; }
+    size_t AsSize(size_t fallback = 0) const { return Type == JSON_NUMBER && Number >= 0.0 ? static_cast<size_t>(Number) : fallback; }
+    bool AsBool(bool fallback = false) const { return Type == JSON_BOOL ? Bool : fallback; }
+    const std::string& AsString() const;
+};
+
+// parses length bytes of UTF-8 text; on failure returns false and describes the problem and its offset in error
+bool ParseJson(const char* text, size_t length, JsonValue& out, std::string& error);
+
+// appends value to out as a quoted JSON string
+void AppendJsonString(std::string& out, const std::string& value);
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+// Read-only view of a whole file mapped into the address space. Pages are read in by the OS when first touched
+// and can be dropped again under memory pressure, so large files cost address space rather than heap.
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile() { Close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // unmaps any previous file; returns false if the file cannot be opened or mapped
+    bool Open(const std::string& path);
+    void Close();
+
+    // hints that the range will be read soon, so the OS can start reading it in ahead of the first touch
+    void Prefetch(size_t offset, size_t size) const;
+
+    bool IsOpen() const { return data != nullptr; }
+    const uint8_t* Data() const { return data; }
+    size_t Size() const { return size; }
+
+private:
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+#ifdef _WIN32
+    void* file = nullptr;
+    void* mapping = nullptr;
+#endif
+};
+
+#endif
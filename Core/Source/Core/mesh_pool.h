@@ -0,0 +1,190 @@
+#ifndef MESH_POOL_H
+#define MESH_POOL_H
+
+#include <glad/glad.h>
+
+#include "primitives.h"
+#include "gpu_resources.h"
+#include "gl_state_cache.h"
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+
+// GPU copy of a generated mesh; vertex layout matches MeshData (location 0 position, location 1 uv, location 2 normal).
+// Imported meshes may instead read their attributes from buffers shared with other meshes, in which case VBO and
+// EBO stay empty and only the VAO knows the layout.
+struct Mesh
+{
+    PrimitiveDesc Desc;
+    GpuHandle VAO;
+    GpuHandle VBO;
+    GpuHandle EBO;
+    unsigned int VertexCount = 0;
+    unsigned int IndexCount = 0;
+    GLenum IndexType = GL_UNSIGNED_INT;
+    size_t IndexOffset = 0;         // bytes into the element buffer
+    std::vector<float> Positions;   // unique vertex positions (xyz), kept on the CPU for vertex snapping
+    float Radius = 0.5f;            // largest coordinate magnitude; times the length of an object's scale it bounds the object
+    bool Adaptive = false;          // smoothed further by the tessellation preview where the context supports it
+
+    void Draw() const
+    {
+        glDrawElements(GL_TRIANGLES, IndexCount, IndexType, reinterpret_cast<const void*>(IndexOffset));
+    }
+};
+
+// largest absolute coordinate of count xyz positions spaced stride floats apart
+inline float PositionsRadius(const float* positions, size_t count, size_t stride)
+{
+    float radius = 0.0f;
+    for (size_t i = 0; i < count; ++i)
+    {
+        for (size_t c = 0; c < 3; ++c)
+            radius = std::max(radius, std::abs(positions[i * stride + c]));
+    }
+    return radius;
+}
+
+// Uploads data into new buffers and a vertex array of mesh in the MeshData layout
+inline void UploadMeshData(Mesh& mesh, const MeshData& data, GpuResourceRegistry& registry, GLStateCache& state, const std::string& owner)
+{
+    mesh.VAO = GpuHandle::Create(registry, GPU_VERTEX_ARRAY, owner + " mesh");
+    mesh.VBO = GpuHandle::Create(registry, GPU_BUFFER, owner + " mesh");
+    mesh.EBO = GpuHandle::Create(registry, GPU_BUFFER, owner + " mesh indices");
+    mesh.VertexCount = static_cast<unsigned int>(data.VertexCount());
+    mesh.IndexCount = static_cast<unsigned int>(data.Indices.size());
+    mesh.Positions = data.UniquePositions();
+    mesh.Radius = PositionsRadius(data.Vertices.data(), data.VertexCount(), MeshData::STRIDE);
+
+    state.BindVertexArray(mesh.VAO.ID());
+
+    state.BindBuffer(GL_ARRAY_BUFFER, mesh.VBO.ID());
+    glBufferData(GL_ARRAY_BUFFER, data.Vertices.size() * sizeof(float), data.Vertices.data(), GL_STATIC_DRAW);
+    mesh.VBO.SetBytes(data.Vertices.size() * sizeof(float));
+
+    state.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.EBO.ID());
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, data.Indices.size() * sizeof(unsigned int), data.Indices.data(), GL_STATIC_DRAW);
+    mesh.EBO.SetBytes(data.Indices.size() * sizeof(unsigned int));
+
+    // Position attribute
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, MeshData::STRIDE * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    // Texture coordinate attribute
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, MeshData::STRIDE * sizeof(float), (void*)(3 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+    // Normal attribute
+    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, MeshData::STRIDE * sizeof(float), (void*)(5 * sizeof(float)));
+    glEnableVertexAttribArray(2);
+
+    state.BindVertexArray(0);
+}
+
+// Uploads every distinct primitive once and hands out shared pointers to it. Pointers stay valid until Clear().
+class MeshPool
+{
+public:
+    unsigned int Uploads = 0;   // meshes generated and uploaded
+    unsigned int Hits = 0;      // requests served from the pool
+
+    MeshPool(GpuResourceRegistry& registry, GLStateCache& state) : registry(registry), state(state)
+    {
+    }
+
+    const Mesh* Acquire(const PrimitiveDesc& desc)
+    {
+        auto it = meshes.find(desc);
+        if (it != meshes.end())
+        {
+            Hits++;
+            return it->second.get();
+        }
+
+        std::unique_ptr<Mesh> mesh = std::make_unique<Mesh>();
+        mesh->Desc = desc;
+        upload(*mesh, GeneratePrimitive(desc), PrimitiveTypeName(desc.Type));
+        Uploads++;
+        const Mesh* result = mesh.get();
+        meshes.emplace(desc, std::move(mesh));
+        return result;
+    }
+
+    size_t GetMeshCount() const
+    {
+        return meshes.size();
+    }
+
+    // Meshes built at run time, such as modifier stack results, are shared by a key describing their content
+    // and freed when their last user releases them. data is only read when the key is not in the pool yet.
+    const Mesh* AcquireDerived(uint64_t key, const MeshData& data, const PrimitiveDesc& desc, const std::string& name, bool adaptive = false)
+    {
+        if (const Mesh* mesh = AcquireDerived(key))
+            return mesh;
+        DerivedMesh& entry = derived[key];
+        entry.Value = std::make_unique<Mesh>();
+        entry.Value->Desc = desc;
+        entry.Value->Adaptive = adaptive;
+        entry.Users = 1;
+        upload(*entry.Value, data, name);
+        Uploads++;
+        return entry.Value.get();
+    }
+
+    // takes another reference to a derived mesh already in the pool; nullptr if there is none
+    const Mesh* AcquireDerived(uint64_t key)
+    {
+        auto it = derived.find(key);
+        if (it == derived.end())
+            return nullptr;
+        it->second.Users++;
+        Hits++;
+        return it->second.Value.get();
+    }
+
+    const Mesh* FindDerived(uint64_t key) const
+    {
+        auto it = derived.find(key);
+        return it != derived.end() ? it->second.Value.get() : nullptr;
+    }
+
+    void ReleaseDerived(uint64_t key)
+    {
+        auto it = derived.find(key);
+        if (it != derived.end() && --it->second.Users == 0)
+            derived.erase(it);
+    }
+
+    size_t GetDerivedCount() const
+    {
+        return derived.size();
+    }
+
+    // releases all GPU meshes; every pointer handed out before becomes invalid
+    void Clear()
+    {
+        meshes.clear();
+        derived.clear();
+    }
+
+private:
+    GpuResourceRegistry& registry;
+    GLStateCache& state;
+    std::unordered_map<PrimitiveDesc, std::unique_ptr<Mesh>, PrimitiveDescHash> meshes;
+
+    struct DerivedMesh
+    {
+        std::unique_ptr<Mesh> Value;
+        size_t Users = 0;
+    };
+    std::unordered_map<uint64_t, DerivedMesh> derived;
+
+    void upload(Mesh& mesh, const MeshData& data, const std::string& owner)
+    {
+        UploadMeshData(mesh, data, registry, state, owner);
+    }
+};
+#endif
@@ -0,0 +1,403 @@
+#include "modifiers.h"
+
+#include <unordered_map>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <cmath>
+#include <limits>
+
+const char* ModifierTypeName(Modifier_Type type)
+{
+    switch (type)
+    {
+    case MODIFIER_ARRAY: return "Array";
+    case MODIFIER_MIRROR: return "Mirror";
+    case MODIFIER_SUBDIVIDE: return "Subdivide";
+    case MODIFIER_SUBDIVISION_SURFACE: return "Subdivision Surface";
+    case MODIFIER_DECIMATE: return "Decimate";
+    default: return "Unknown";
+    }
+}
+
+Modifier Modifier::Default(Modifier_Type type)
+{
+    Modifier modifier;
+    modifier.Type = type;
+    return modifier;
+}
+
+uint64_t HashCombine(uint64_t seed, uint64_t value)
+{
+    return seed ^ (value + 0x9E3779B97F4A7C15ull + (seed << 6) + (seed >> 2));
+}
+
+namespace
+{
+    uint64_t hashFloat(float value)
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+}
+
+uint64_t Modifier::Hash() const
+{
+    uint64_t h = HashCombine(0, static_cast<uint64_t>(Type));
+    switch (Type)
+    {
+    case MODIFIER_ARRAY:
+        h = HashCombine(h, static_cast<uint64_t>(Count));
+        h = HashCombine(h, hashFloat(Offset.x));
+        h = HashCombine(h, hashFloat(Offset.y));
+        h = HashCombine(h, hashFloat(Offset.z));
+        break;
+    case MODIFIER_MIRROR:
+        h = HashCombine(h, static_cast<uint64_t>(Axis));
+        break;
+    case MODIFIER_SUBDIVIDE:
+        h = HashCombine(h, static_cast<uint64_t>(Levels));
+        break;
+    case MODIFIER_SUBDIVISION_SURFACE:
+        h = HashCombine(h, static_cast<uint64_t>(Levels));
+        h = HashCombine(h, Adaptive ? 1 : 0);
+        break;
+    case MODIFIER_DECIMATE:
+        h = HashCombine(h, hashFloat(Ratio));
+        break;
+    default:
+        break;
+    }
+    return h;
+}
+
+void ModifierStack::Add(const Modifier& modifier)
+{
+    ModifierStage stage;
+    stage.Params = modifier;
+    Stages.push_back(stage);
+}
+
+void ModifierStack::Remove(size_t index)
+{
+    Stages.erase(Stages.begin() + index);
+}
+
+void ModifierStack::Move(size_t from, size_t to)
+{
+    ModifierStage stage = Stages[from];
+    Stages.erase(Stages.begin() + from);
+    Stages.insert(Stages.begin() + to, stage);
+}
+
+uint64_t ModifierStack::ResultKey(uint64_t baseKey) const
+{
+    uint64_t key = baseKey;
+    for (const ModifierStage& stage : Stages)
+    {
+        if (stage.Params.Enabled)
+            key = HashCombine(key, stage.Params.Hash());
+    }
+    return key;
+}
+
+void ModifierStack::Evaluate(const std::shared_ptr<const MeshData>& base, uint64_t baseKey, JobSystem& jobs)
+{
+    std::shared_ptr<const MeshData> input = base;
+    uint64_t key = baseKey;
+    for (ModifierStage& stage : Stages)
+    {
+        // a disabled stage keeps its cache, so enabling it again over the same input costs nothing
+        if (!stage.Params.Enabled)
+            continue;
+        uint64_t stageKey = HashCombine(key, stage.Params.Hash());
+        stage.Reused = stage.Key == stageKey && stage.Output != nullptr;
+        if (!stage.Reused)
+        {
+            auto start = std::chrono::high_resolution_clock::now();
+            const Modifier& params = stage.Params;
+            switch (params.Type)
+            {
+            case MODIFIER_ARRAY: stage.Output = std::make_shared<const MeshData>(ArrayMesh(*input, params.Count, params.Offset)); break;
+            case MODIFIER_MIRROR: stage.Output = std::make_shared<const MeshData>(MirrorMesh(*input, params.Axis)); break;
+            case MODIFIER_SUBDIVIDE: stage.Output = std::make_shared<const MeshData>(SubdivideMesh(*input, params.Levels)); break;
+            case MODIFIER_SUBDIVISION_SURFACE:
+                if (!stage.Surface)
+                    stage.Surface = std::make_shared<SurfaceCache>();
+                stage.Output = std::make_shared<const MeshData>(SubdivisionSurfaceMesh(*input, params.Levels, *stage.Surface, jobs));
+                break;
+            case MODIFIER_DECIMATE: stage.Output = std::make_shared<const MeshData>(DecimateMesh(*input, params.Ratio)); break;
+            default: stage.Output = input; break;
+            }
+            stage.Key = stageKey;
+            stage.Ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        }
+        input = stage.Output;
+        key = stageKey;
+    }
+    result = input;
+}
+
+bool ModifierStack::IsAdaptive() const
+{
+    for (auto it = Stages.rbegin(); it != Stages.rend(); ++it)
+    {
+        if (it->Params.Enabled)
+            return it->Params.Type == MODIFIER_SUBDIVISION_SURFACE && it->Params.Adaptive;
+    }
+    return false;
+}
+
+double ModifierStack::LastEvaluationMs() const
+{
+    double total = 0.0;
+    for (const ModifierStage& stage : Stages)
+    {
+        if (stage.Params.Enabled && !stage.Reused)
+            total += stage.Ms;
+    }
+    return total;
+}
+
+MeshData ArrayMesh(const MeshData& mesh, int count, const glm::vec3& offset)
+{
+    MeshData result;
+    count = std::max(count, 1);
+    result.Vertices.reserve(mesh.Vertices.size() * count);
+    result.Indices.reserve(mesh.Indices.size() * count);
+    for (int copy = 0; copy < count; ++copy)
+    {
+        unsigned int base = static_cast<unsigned int>(result.VertexCount());
+        glm::vec3 shift = offset * static_cast<float>(copy);
+        for (size_t v = 0; v < mesh.VertexCount(); ++v)
+        {
+            const float* vertex = &mesh.Vertices[v * MeshData::STRIDE];
+            result.Vertices.insert(result.Vertices.end(), vertex, vertex + MeshData::STRIDE);
+            float* moved = &result.Vertices[result.Vertices.size() - MeshData::STRIDE];
+            moved[0] += shift.x;
+            moved[1] += shift.y;
+            moved[2] += shift.z;
+        }
+        for (unsigned int index : mesh.Indices)
+            result.Indices.push_back(base + index);
+    }
+    return result;
+}
+
+// The mirrored half gets flipped positions and normals and reversed winding so it still faces outwards
+MeshData MirrorMesh(const MeshData& mesh, int axis)
+{
+    axis = glm::clamp(axis, 0, 2);
+    MeshData result = mesh;
+    unsigned int base = static_cast<unsigned int>(mesh.VertexCount());
+    result.Vertices.reserve(mesh.Vertices.size() * 2);
+    for (size_t v = 0; v < mesh.VertexCount(); ++v)
+    {
+        const float* vertex = &mesh.Vertices[v * MeshData::STRIDE];
+        result.Vertices.insert(result.Vertices.end(), vertex, vertex + MeshData::STRIDE);
+        float* mirrored = &result.Vertices[result.Vertices.size() - MeshData::STRIDE];
+        mirrored[axis] = -mirrored[axis];
+        mirrored[5 + axis] = -mirrored[5 + axis];
+    }
+    result.Indices.reserve(mesh.Indices.size() * 2);
+    for (size_t t = 0; t + 2 < mesh.Indices.size(); t += 3)
+    {
+        result.Indices.push_back(base + mesh.Indices[t]);
+        result.Indices.push_back(base + mesh.Indices[t + 2]);
+        result.Indices.push_back(base + mesh.Indices[t + 1]);
+    }
+    return result;
+}
+
+// Linear subdivision: every edge gets one midpoint vertex shared by the triangles on both sides, and every
+// triangle becomes four. Attributes are interpolated, so the shape and its creases stay as they were.
+MeshData SubdivideMesh(const MeshData& mesh, int levels)
+{
+    MeshData current = mesh;
+    for (int level = 0; level < levels; ++level)
+    {
+        MeshData next;
+        next.Vertices = current.Vertices;
+        next.Vertices.reserve(current.Vertices.size() * 4);
+        next.Indices.reserve(current.Indices.size() * 4);
+        std::unordered_map<uint64_t, unsigned int> midpoints;
+        midpoints.reserve(current.Indices.size());
+
+        auto midpoint = [&](unsigned int a, unsigned int b) {
+            uint64_t key = static_cast<uint64_t>(std::min(a, b)) << 32 | std::max(a, b);
+            auto it = midpoints.find(key);
+            if (it != midpoints.end())
+                return it->second;
+            unsigned int index = static_cast<unsigned int>(next.VertexCount());
+            for (int k = 0; k < MeshData::STRIDE; ++k)
+                next.Vertices.push_back(0.5f * (current.Vertices[a * MeshData::STRIDE + k] + current.Vertices[b * MeshData::STRIDE + k]));
+            float* normal = &next.Vertices[index * MeshData::STRIDE + 5];
+            glm::vec3 n(normal[0], normal[1], normal[2]);
+            if (glm::length(n) > 0.0f)
+                n = glm::normalize(n);
+            normal[0] = n.x;
+            normal[1] = n.y;
+            normal[2] = n.z;
+            midpoints.emplace(key, index);
+            return index;
+        };
+
+        for (size_t t = 0; t + 2 < current.Indices.size(); t += 3)
+        {
+            unsigned int a = current.Indices[t], b = current.Indices[t + 1], c = current.Indices[t + 2];
+            unsigned int ab = midpoint(a, b), bc = midpoint(b, c), ca = midpoint(c, a);
+            next.AddTriangle(a, ab, ca);
+            next.AddTriangle(ab, b, bc);
+            next.AddTriangle(ca, bc, c);
+            next.AddTriangle(ab, bc, ca);
+        }
+        current = std::move(next);
+    }
+    return current;
+}
+
+namespace
+{
+    // seam copies generated at the same spot differ by rounding at most
+    const float WELD_TOLERANCE = 1.0e-5f;
+
+    uint64_t topologyKey(const MeshData& mesh, int levels)
+    {
+        uint64_t h = HashCombine(static_cast<uint64_t>(levels), mesh.VertexCount());
+        for (unsigned int index : mesh.Indices)
+            h = HashCombine(h, index);
+        return h;
+    }
+
+    glm::vec3 positionOf(const MeshData& mesh, uint32_t vertex)
+    {
+        const float* p = &mesh.Vertices[static_cast<size_t>(vertex) * MeshData::STRIDE];
+        return glm::vec3(p[0], p[1], p[2]);
+    }
+
+    // the weld is part of the topology: vertices merged into one cage vertex must still coincide
+    bool weldHolds(const MeshData& mesh, const SurfaceCache& cache)
+    {
+        for (size_t v = 0; v < mesh.VertexCount(); ++v)
+        {
+            glm::vec3 offset = positionOf(mesh, static_cast<uint32_t>(v)) - positionOf(mesh, cache.ControlCorner[cache.CornerVertex[v]]);
+            if (glm::any(glm::greaterThan(glm::abs(offset), glm::vec3(WELD_TOLERANCE))))
+                return false;
+        }
+        return true;
+    }
+}
+
+MeshData SubdivisionSurfaceMesh(const MeshData& mesh, int levels, SurfaceCache& cache, JobSystem& jobs)
+{
+    uint64_t key = topologyKey(mesh, levels);
+    if (key != cache.TopologyKey || cache.CornerVertex.size() != mesh.VertexCount() || !weldHolds(mesh, cache))
+    {
+        // uv seams and hard edges split vertices in the input; the cage welds them so the surface stays closed and
+        // keeps the split vertices as its wedges
+        HalfEdgeMesh cage = HalfEdgeMesh::FromTriangles(mesh, &cache.CornerVertex);
+        cache.ControlCorner.assign(cage.VertexCount(), HalfEdgeMesh::INVALID);
+        for (size_t v = 0; v < cache.CornerVertex.size(); ++v)
+        {
+            if (cache.ControlCorner[cache.CornerVertex[v]] == HalfEdgeMesh::INVALID)
+                cache.ControlCorner[cache.CornerVertex[v]] = static_cast<uint32_t>(v);
+        }
+        cache.Surface.Build(cage, levels, jobs);
+        cache.TopologyKey = key;
+    }
+
+    std::vector<glm::vec3> positions(cache.ControlCorner.size());
+    for (size_t c = 0; c < cache.ControlCorner.size(); ++c)
+        positions[c] = positionOf(mesh, cache.ControlCorner[c]);
+    // the cage's wedges are the input vertices, so their uvs are read in place
+    std::vector<glm::vec2> texCoords(mesh.VertexCount());
+    for (size_t v = 0; v < mesh.VertexCount(); ++v)
+        texCoords[v] = glm::vec2(mesh.Vertices[v * MeshData::STRIDE + 3], mesh.Vertices[v * MeshData::STRIDE + 4]);
+    cache.Surface.Evaluate(positions, texCoords, jobs);
+    return cache.Surface.ToMeshData();
+}
+
+namespace
+{
+    // clusters of the vertices on a grid with cells of the given size; returns the number of clusters.
+    // Sorting the cell keys groups the vertices without a hash map, and numbers clusters in grid order.
+    size_t clusterVertices(const MeshData& mesh, const glm::vec3& origin, float cellSize, std::vector<unsigned int>& cluster)
+    {
+        std::vector<std::pair<uint64_t, unsigned int>> keys(mesh.VertexCount());
+        for (size_t v = 0; v < mesh.VertexCount(); ++v)
+        {
+            const float* vertex = &mesh.Vertices[v * MeshData::STRIDE];
+            glm::uvec3 cell = glm::uvec3(glm::max((glm::vec3(vertex[0], vertex[1], vertex[2]) - origin) / cellSize, glm::vec3(0.0f)));
+            keys[v] = { static_cast<uint64_t>(cell.x) | static_cast<uint64_t>(cell.y) << 21 | static_cast<uint64_t>(cell.z) << 42, static_cast<unsigned int>(v) };
+        }
+        std::sort(keys.begin(), keys.end());
+
+        cluster.resize(mesh.VertexCount());
+        size_t clusters = 0;
+        for (size_t i = 0; i < keys.size(); ++i)
+        {
+            if (i > 0 && keys[i].first != keys[i - 1].first)
+                clusters++;
+            cluster[keys[i].second] = static_cast<unsigned int>(clusters);
+        }
+        return keys.empty() ? 0 : clusters + 1;
+    }
+}
+
+// Vertices sharing a grid cell collapse into their average; triangles that lose a corner disappear. The cell
+// size is guessed from the target count once and corrected once from the count it actually produced.
+MeshData DecimateMesh(const MeshData& mesh, float ratio)
+{
+    if (mesh.VertexCount() == 0 || ratio >= 1.0f)
+        return mesh;
+
+    glm::vec3 lower(std::numeric_limits<float>::max()), upper(std::numeric_limits<float>::lowest());
+    for (size_t v = 0; v < mesh.VertexCount(); ++v)
+    {
+        glm::vec3 p(mesh.Vertices[v * MeshData::STRIDE], mesh.Vertices[v * MeshData::STRIDE + 1], mesh.Vertices[v * MeshData::STRIDE + 2]);
+        lower = glm::min(lower, p);
+        upper = glm::max(upper, p);
+    }
+    float extent = std::max({ upper.x - lower.x, upper.y - lower.y, upper.z - lower.z, 1e-6f });
+
+    // surfaces occupy about the square of the cells per axis
+    float target = std::max(4.0f, ratio * static_cast<float>(mesh.VertexCount()));
+    float cells = std::max(1.0f, std::sqrt(target));
+    std::vector<unsigned int> cluster;
+    size_t clusters = clusterVertices(mesh, lower, extent / cells, cluster);
+    cells = std::max(1.0f, cells * std::sqrt(target / static_cast<float>(clusters)));
+    clusters = clusterVertices(mesh, lower, extent / cells, cluster);
+
+    MeshData result;
+    result.Vertices.assign(clusters * MeshData::STRIDE, 0.0f);
+    std::vector<unsigned int> members(clusters, 0);
+    for (size_t v = 0; v < mesh.VertexCount(); ++v)
+    {
+        const float* vertex = &mesh.Vertices[v * MeshData::STRIDE];
+        float* merged = &result.Vertices[cluster[v] * MeshData::STRIDE];
+        if (members[cluster[v]]++ == 0)
+        {
+            merged[3] = vertex[3];  // texture coordinates of the first member; averaging across seams would smear them
+            merged[4] = vertex[4];
+        }
+        merged[0] += vertex[0];
+        merged[1] += vertex[1];
+        merged[2] += vertex[2];
+    }
+    for (size_t c = 0; c < clusters; ++c)
+    {
+        float* vertex = &result.Vertices[c * MeshData::STRIDE];
+        for (int k = 0; k < 3; ++k)
+            vertex[k] /= static_cast<float>(members[c]);
+    }
+
+    for (size_t t = 0; t + 2 < mesh.Indices.size(); t += 3)
+    {
+        unsigned int a = cluster[mesh.Indices[t]], b = cluster[mesh.Indices[t + 1]], c = cluster[mesh.Indices[t + 2]];
+        if (a != b && b != c && c != a)
+            result.AddTriangle(a, b, c);
+    }
+    ComputeNormals(result);
+    return result;
+}
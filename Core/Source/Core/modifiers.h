@@ -0,0 +1,105 @@
+#ifndef MODIFIERS_H
+#define MODIFIERS_H
+
+#include "primitives.h"
+#include "subdivision.h"
+#include "job_system.h"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+enum Modifier_Type {
+    MODIFIER_ARRAY,
+    MODIFIER_MIRROR,
+    MODIFIER_SUBDIVIDE,
+    MODIFIER_SUBDIVISION_SURFACE,
+    MODIFIER_DECIMATE,
+    MODIFIER_TYPE_COUNT
+};
+
+const char* ModifierTypeName(Modifier_Type type);
+
+// Parameters of one non-destructive operation; each type reads only its own fields
+struct Modifier
+{
+    Modifier_Type Type = MODIFIER_ARRAY;
+    bool Enabled = true;
+    int Count = 3;                              // array copies
+    glm::vec3 Offset = glm::vec3(1.2f, 0, 0);   // array step between copies, in object space
+    int Axis = 0;                               // mirror axis, 0..2
+    int Levels = 1;                             // subdivision levels; each splits every face into four (or n quads)
+    float Ratio = 0.5f;                         // decimate: fraction of the vertices to keep, approximately
+    bool Adaptive = false;                      // subdivision surface: smooth further on the GPU, tessellating by screen size
+
+    static Modifier Default(Modifier_Type type);
+
+    // covers the type and the fields it reads, so equal hashes mean equal results for the same input
+    uint64_t Hash() const;
+};
+
+// Catmull-Clark stencils of a subdivision surface stage, kept while the connectivity of its input stays the same
+struct SurfaceCache
+{
+    uint64_t TopologyKey = 0;
+    std::vector<uint32_t> CornerVertex;         // input vertex -> cage vertex it was welded into
+    std::vector<uint32_t> ControlCorner;        // cage vertex -> first input vertex welded into it
+    SubdivisionSurface Surface;
+};
+
+// Output of one stage together with the key it was computed for
+struct ModifierStage
+{
+    Modifier Params;
+    uint64_t Key = 0;                           // input key combined with the parameters; 0 before the first evaluation
+    std::shared_ptr<const MeshData> Output;
+    std::shared_ptr<SurfaceCache> Surface;      // subdivision surface stages only
+    double Ms = 0.0;                            // time of the last real evaluation
+    bool Reused = false;                        // the last Evaluate kept this stage's cached output
+};
+
+// Ordered list of modifiers applied to a base mesh. Every stage keeps its last output keyed on the key of its
+// input and its own parameters, so editing one modifier re-runs only that stage and the ones after it, and
+// nothing runs while the keys are unchanged. Disabled stages pass their input through.
+class ModifierStack
+{
+public:
+    std::vector<ModifierStage> Stages;
+
+    void Add(const Modifier& modifier);
+    void Remove(size_t index);
+    void Move(size_t from, size_t to);
+
+    // key of the final mesh for a base with the given key, without evaluating anything; equals baseKey
+    // when no stage is enabled
+    uint64_t ResultKey(uint64_t baseKey) const;
+
+    // runs the stages whose keys changed; safe to call for different stacks on different threads
+    void Evaluate(const std::shared_ptr<const MeshData>& base, uint64_t baseKey, JobSystem& jobs);
+
+    // true when the last enabled stage is a subdivision surface that wants the GPU to refine its result further
+    bool IsAdaptive() const;
+
+    const std::shared_ptr<const MeshData>& Result() const { return result; }
+    double LastEvaluationMs() const;
+
+private:
+    std::shared_ptr<const MeshData> result;
+};
+
+uint64_t HashCombine(uint64_t seed, uint64_t value);
+
+// The operations behind the modifiers, usable on their own. Normals follow the geometry.
+MeshData ArrayMesh(const MeshData& mesh, int count, const glm::vec3& offset);
+MeshData MirrorMesh(const MeshData& mesh, int axis);
+MeshData SubdivideMesh(const MeshData& mesh, int levels);
+// Catmull-Clark; the stencils in cache are rebuilt only when the input's connectivity changed, otherwise the
+// input positions just run through them
+MeshData SubdivisionSurfaceMesh(const MeshData& mesh, int levels, SurfaceCache& cache, JobSystem& jobs);
+// vertex clustering on a uniform grid sized so roughly ratio of the vertices survive
+MeshData DecimateMesh(const MeshData& mesh, float ratio);
+
+#endif
@@ -0,0 +1,381 @@
+#ifndef PARTICLES_H
+#define PARTICLES_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "gpu_resources.h"
+#include "gl_state_cache.h"
+#include "shader_m.h"
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+
+// Where the particle update runs
+enum Particle_Backend {
+    PARTICLE_BACKEND_TRANSFORM_FEEDBACK,
+    PARTICLE_BACKEND_COMPUTE
+};
+
+inline const char* ParticleBackendName(Particle_Backend backend)
+{
+    return backend == PARTICLE_BACKEND_COMPUTE ? "Compute shader" : "Transform feedback";
+}
+
+// Spawn and motion parameters of the particle effect
+struct ParticleEmitter
+{
+    glm::vec3 Position = glm::vec3(0.0f, 0.5f, 0.0f);
+    float Radius = 0.1f;
+    glm::vec3 Direction = glm::vec3(0.0f, 1.0f, 0.0f);
+    float Spread = 0.35f;           // 0 = straight along Direction, 1 = any direction
+    float Speed = 4.0f;
+    float SpeedJitter = 0.4f;       // relative random speed variation
+    glm::vec2 Lifetime = glm::vec2(0.8f, 1.6f);
+    float Rate = 150000.0f;         // particles spawned per second
+    glm::vec3 Gravity = glm::vec3(0.0f, -9.81f, 0.0f);
+    float Drag = 0.3f;
+    float Size = 0.015f;
+    glm::vec4 ColorStart = glm::vec4(1.0f, 0.8f, 0.3f, 1.0f);
+    glm::vec4 ColorEnd = glm::vec4(1.0f, 0.2f, 0.0f, 0.0f);
+
+    static ParticleEmitter Sparks()
+    {
+        return ParticleEmitter();
+    }
+
+    static ParticleEmitter Dust()
+    {
+        ParticleEmitter emitter;
+        emitter.Radius = 2.0f;
+        emitter.Spread = 1.0f;
+        emitter.Speed = 0.15f;
+        emitter.SpeedJitter = 0.8f;
+        emitter.Lifetime = glm::vec2(3.0f, 6.0f);
+        emitter.Rate = 60000.0f;
+        emitter.Gravity = glm::vec3(0.0f, -0.02f, 0.0f);
+        emitter.Drag = 1.5f;
+        emitter.Size = 0.01f;
+        emitter.ColorStart = glm::vec4(0.8f, 0.75f, 0.65f, 0.5f);
+        emitter.ColorEnd = glm::vec4(0.6f, 0.55f, 0.5f, 0.0f);
+        return emitter;
+    }
+};
+
+// Particles that live entirely in GPU buffers. Each particle is two vec4s (position + age, velocity + lifetime).
+// The update runs in a compute shader on GL 4.3+, otherwise as a transform feedback pass that ping-pongs
+// between two buffers. Emission recycles a moving window of slots, so no readback or CPU-side list is needed.
+// Rendering is one instanced draw of camera facing quads.
+class ParticleSystem
+{
+public:
+    Particle_Backend Backend = PARTICLE_BACKEND_TRANSFORM_FEEDBACK;
+
+    ParticleSystem(GpuResourceRegistry& registry, GLStateCache& state) : registry(registry), state(state)
+    {
+    }
+
+    // compiles the programs found in shaderDirectory; prefers compute when the context supports it
+    bool Initialize(const std::string& shaderDirectory)
+    {
+        std::string common = readFile(shaderDirectory + "particle_common.glsl");
+
+        const char* varyings[] = { "outPosAge", "outVelLife" };
+        GLuint feedback = compile(GL_VERTEX_SHADER, "#version 330 core\n", common, readFile(shaderDirectory + "particle_update_feedback.glsl"), varyings, 2);
+        if (feedback)
+            feedbackProgram = GpuHandle::Adopt(registry, GPU_PROGRAM, feedback, "Particle update (transform feedback)");
+
+        if (GLAD_GL_VERSION_4_3)
+        {
+            GLuint compute = compile(GL_COMPUTE_SHADER, "#version 430 core\n", common, readFile(shaderDirectory + "particle_update_compute.glsl"), nullptr, 0);
+            if (compute)
+                computeProgram = GpuHandle::Adopt(registry, GPU_PROGRAM, compute, "Particle update (compute)");
+        }
+
+        // Shader only logs a failed link, so its status is checked here like the update programs'
+        Shader draw((shaderDirectory + "particle_vertex.glsl").c_str(), (shaderDirectory + "particle_fragment.glsl").c_str());
+        GLint linked = GL_FALSE;
+        glGetProgramiv(draw.ID, GL_LINK_STATUS, &linked);
+        if (linked)
+            drawProgram = GpuHandle::Adopt(registry, GPU_PROGRAM, draw.ID, "Particle draw");
+        else
+            glDeleteProgram(draw.ID);
+
+        for (int i = 0; i < 2; ++i)
+            timerQueries[i] = GpuHandle::Create(registry, GPU_QUERY, "Particle update timer");
+
+        Backend = IsComputeAvailable() ? PARTICLE_BACKEND_COMPUTE : PARTICLE_BACKEND_TRANSFORM_FEEDBACK;
+        return IsReady();
+    }
+
+    // false when the update or draw programs failed to build; Update and Draw then do nothing
+    bool IsReady() const
+    {
+        return feedbackProgram.IsValid() && drawProgram.IsValid();
+    }
+
+    bool IsComputeAvailable() const
+    {
+        return computeProgram.IsValid();
+    }
+
+    // reallocates the particle buffers; all particles start dead
+    void SetCapacity(unsigned int count)
+    {
+        capacity = count;
+        current = 0;
+        spawnCursor = 0;
+        spawnRemainder = 0.0f;
+
+        // zeroed particles have age == lifetime == 0, which reads as dead
+        std::vector<glm::vec4> zeros((size_t)count * 2, glm::vec4(0.0f));
+        for (int i = 0; i < 2; ++i)
+        {
+            buffers[i] = GpuHandle::Create(registry, GPU_BUFFER, "Particles");
+            state.BindBuffer(GL_ARRAY_BUFFER, buffers[i].ID());
+            glBufferData(GL_ARRAY_BUFFER, zeros.size() * sizeof(glm::vec4), zeros.data(), GL_DYNAMIC_COPY);
+            buffers[i].SetBytes(zeros.size() * sizeof(glm::vec4));
+
+            updateArrays[i] = GpuHandle::Create(registry, GPU_VERTEX_ARRAY, "Particle update");
+            setupAttributes(updateArrays[i], buffers[i], 0);
+            drawArrays[i] = GpuHandle::Create(registry, GPU_VERTEX_ARRAY, "Particle draw");
+            setupAttributes(drawArrays[i], buffers[i], 1);
+        }
+    }
+
+    unsigned int GetCapacity() const
+    {
+        return capacity;
+    }
+
+    // simulates one step and spawns the emitter's share of particles for it
+    void Update(const ParticleEmitter& emitter, float deltaTime)
+    {
+        if (capacity == 0 || !IsReady())
+            return;
+
+        float spawn = emitter.Rate * deltaTime + spawnRemainder;
+        unsigned int spawnCount = static_cast<unsigned int>(std::min(spawn, static_cast<float>(capacity)));
+        spawnRemainder = spawn - std::floor(spawn);
+
+        bool compute = Backend == PARTICLE_BACKEND_COMPUTE && IsComputeAvailable();
+        GLuint program = compute ? computeProgram.ID() : feedbackProgram.ID();
+        state.UseProgram(program);
+        setSimulationUniforms(program, emitter, deltaTime, spawnCount);
+
+        bool timing = !timerActive[frame % 2];
+        if (timing)
+            glBeginQuery(GL_TIME_ELAPSED, timerQueries[frame % 2].ID());
+
+        if (compute)
+        {
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, buffers[current].ID());
+            glDispatchCompute((capacity + 255) / 256, 1, 1);
+            // the draw sources the buffer as vertex attributes and the next step reads it back as an SSBO
+            glMemoryBarrier(GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+        }
+        else
+        {
+            state.Enable(GL_RASTERIZER_DISCARD);
+            state.BindVertexArray(updateArrays[current].ID());
+            glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, buffers[1 - current].ID());
+            glBeginTransformFeedback(GL_POINTS);
+            glDrawArrays(GL_POINTS, 0, capacity);
+            glEndTransformFeedback();
+            glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+            state.Disable(GL_RASTERIZER_DISCARD);
+            current = 1 - current;
+        }
+
+        if (timing)
+        {
+            glEndQuery(GL_TIME_ELAPSED);
+            timerActive[frame % 2] = true;
+        }
+
+        spawnCursor = (spawnCursor + spawnCount) % capacity;
+        seed = seed * 1664525u + 1013904223u;
+        frame++;
+        readTimer(frame % 2);
+    }
+
+    void Draw(const ParticleEmitter& emitter, const glm::mat4& view, const glm::mat4& projection)
+    {
+        if (capacity == 0 || !IsReady())
+            return;
+
+        GLuint program = drawProgram.ID();
+        state.UseProgram(program);
+        glUniformMatrix4fv(glGetUniformLocation(program, "view"), 1, GL_FALSE, &view[0][0]);
+        glUniformMatrix4fv(glGetUniformLocation(program, "projection"), 1, GL_FALSE, &projection[0][0]);
+        glUniform1f(glGetUniformLocation(program, "size"), emitter.Size);
+        glUniform4fv(glGetUniformLocation(program, "colorStart"), 1, &emitter.ColorStart[0]);
+        glUniform4fv(glGetUniformLocation(program, "colorEnd"), 1, &emitter.ColorEnd[0]);
+
+        // additive blending without depth writes, so particle order does not matter
+        state.Enable(GL_BLEND);
+        state.BlendFunc(GL_SRC_ALPHA, GL_ONE);
+        state.DepthMask(GL_FALSE);
+        state.BindVertexArray(drawArrays[current].ID());
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, capacity);
+        state.DepthMask(GL_TRUE);
+        state.Disable(GL_BLEND);
+    }
+
+    // GPU time of a recent update pass, read back without stalling
+    float GetLastUpdateMs() const
+    {
+        return lastUpdateMs;
+    }
+
+    void Release()
+    {
+        for (int i = 0; i < 2; ++i)
+        {
+            drawArrays[i].Reset();
+            updateArrays[i].Reset();
+            buffers[i].Reset();
+            timerQueries[i].Reset();
+        }
+        feedbackProgram.Reset();
+        computeProgram.Reset();
+        drawProgram.Reset();
+        capacity = 0;
+    }
+
+private:
+    GpuResourceRegistry& registry;
+    GLStateCache& state;
+    GpuHandle feedbackProgram, computeProgram, drawProgram;
+    GpuHandle buffers[2];
+    GpuHandle updateArrays[2];  // per-vertex attributes, read by the transform feedback pass
+    GpuHandle drawArrays[2];    // per-instance attributes, read by the draw
+    GpuHandle timerQueries[2];
+    bool timerActive[2] = { false, false };
+    unsigned int capacity = 0;
+    unsigned int current = 0;   // buffer holding the latest state
+    unsigned int spawnCursor = 0;
+    float spawnRemainder = 0.0f;
+    unsigned int seed = 12345u;
+    unsigned int frame = 0;
+    float lastUpdateMs = 0.0f;
+
+    void setupAttributes(const GpuHandle& vertexArray, const GpuHandle& buffer, GLuint divisor)
+    {
+        state.BindVertexArray(vertexArray.ID());
+        state.BindBuffer(GL_ARRAY_BUFFER, buffer.ID());
+        // Position and age
+        glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 2 * sizeof(glm::vec4), (void*)0);
+        glEnableVertexAttribArray(0);
+        glVertexAttribDivisor(0, divisor);
+        // Velocity and lifetime
+        glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, 2 * sizeof(glm::vec4), (void*)sizeof(glm::vec4));
+        glEnableVertexAttribArray(1);
+        glVertexAttribDivisor(1, divisor);
+        state.BindVertexArray(0);
+    }
+
+    void setSimulationUniforms(GLuint program, const ParticleEmitter& emitter, float deltaTime, unsigned int spawnCount)
+    {
+        glm::vec3 direction = glm::length(emitter.Direction) > 0.0f ? glm::normalize(emitter.Direction) : glm::vec3(0.0f, 1.0f, 0.0f);
+        glUniform1f(glGetUniformLocation(program, "deltaTime"), deltaTime);
+        glUniform1ui(glGetUniformLocation(program, "seed"), seed);
+        glUniform1ui(glGetUniformLocation(program, "capacity"), capacity);
+        glUniform1ui(glGetUniformLocation(program, "spawnStart"), spawnCursor);
+        glUniform1ui(glGetUniformLocation(program, "spawnCount"), spawnCount);
+        glUniform3fv(glGetUniformLocation(program, "emitterPosition"), 1, &emitter.Position[0]);
+        glUniform1f(glGetUniformLocation(program, "emitterRadius"), emitter.Radius);
+        glUniform3fv(glGetUniformLocation(program, "emitterDirection"), 1, &direction[0]);
+        glUniform1f(glGetUniformLocation(program, "emitterSpread"), emitter.Spread);
+        glUniform1f(glGetUniformLocation(program, "speed"), emitter.Speed);
+        glUniform1f(glGetUniformLocation(program, "speedJitter"), emitter.SpeedJitter);
+        glUniform2fv(glGetUniformLocation(program, "lifetimeRange"), 1, &emitter.Lifetime[0]);
+        glUniform3fv(glGetUniformLocation(program, "gravity"), 1, &emitter.Gravity[0]);
+        glUniform1f(glGetUniformLocation(program, "drag"), emitter.Drag);
+    }
+
+    // picks up the timer of an earlier update once the GPU has finished it
+    void readTimer(int index)
+    {
+        if (!timerActive[index])
+            return;
+        GLint available = 0;
+        glGetQueryObjectiv(timerQueries[index].ID(), GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+            return;
+        GLuint64 nanoseconds = 0;
+        glGetQueryObjectui64v(timerQueries[index].ID(), GL_QUERY_RESULT, &nanoseconds);
+        lastUpdateMs = nanoseconds / 1.0e6f;
+        timerActive[index] = false;
+    }
+
+    static std::string readFile(const std::string& path)
+    {
+        std::ifstream file(path);
+        if (!file)
+        {
+            std::cout << "ERROR::PARTICLES::FILE_NOT_SUCCESSFULLY_READ: " << path << std::endl;
+            return std::string();
+        }
+        std::stringstream stream;
+        stream << file.rdbuf();
+        return stream.str();
+    }
+
+    static bool checkShader(GLuint shader, const char* type)
+    {
+        GLint success;
+        glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+        if (!success)
+        {
+            GLchar infoLog[1024];
+            glGetShaderInfoLog(shader, 1024, NULL, infoLog);
+            std::cout << "ERROR::SHADER_COMPILATION_ERROR of type: " << type << "\n" << infoLog << std::endl;
+        }
+        return success != 0;
+    }
+
+    static GLuint linkProgram(GLuint program)
+    {
+        glLinkProgram(program);
+        GLint success;
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+        if (!success)
+        {
+            GLchar infoLog[1024];
+            glGetProgramInfoLog(program, 1024, NULL, infoLog);
+            std::cout << "ERROR::PROGRAM_LINKING_ERROR of type: PARTICLES\n" << infoLog << std::endl;
+            glDeleteProgram(program);
+            return 0;
+        }
+        return program;
+    }
+
+    // builds a single-stage update program from the version line, the shared simulation code and the stage body
+    static GLuint compile(GLenum type, const char* version, const std::string& common, const std::string& body, const char* const* varyings, int varyingCount)
+    {
+        const char* sources[] = { version, common.c_str(), body.c_str() };
+        GLuint shader = glCreateShader(type);
+        glShaderSource(shader, 3, sources, NULL);
+        glCompileShader(shader);
+        if (!checkShader(shader, type == GL_COMPUTE_SHADER ? "COMPUTE" : "VERTEX"))
+        {
+            glDeleteShader(shader);
+            return 0;
+        }
+
+        GLuint program = glCreateProgram();
+        glAttachShader(program, shader);
+        if (varyingCount > 0)
+            glTransformFeedbackVaryings(program, varyingCount, varyings, GL_INTERLEAVED_ATTRIBS);
+        program = linkProgram(program);
+        glDeleteShader(shader);
+        return program;
+    }
+};
+#endif
@@ -0,0 +1,572 @@
+#include "path_tracer.h"
+#include "ray_sampling.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <numeric>
+
+namespace
+{
+    const int STACK_SIZE = 64;
+    const float PI = 3.14159265f;
+    const float SUN_RADIUS = 0.02f;         // radians; gives the sun's shadows a soft edge
+    const int ROULETTE_BOUNCE = 2;          // paths may end randomly from this bounce on
+    const glm::vec3 GROUND_ALBEDO = glm::vec3(0.45f);
+
+    float nextRandom(uint32_t& state)
+    {
+        state = HashRandom(state);
+        return (state >> 8) * (1.0f / 16777216.0f);
+    }
+
+    glm::vec3 cosineHemisphere(const glm::vec3& n, uint32_t& random)
+    {
+        float phi = 2.0f * PI * nextRandom(random);
+        float r2 = nextRandom(random);
+        float r = std::sqrt(r2);
+        glm::vec3 t, b;
+        Tangents(n, t, b);
+        return glm::normalize(t * (r * std::cos(phi)) + b * (r * std::sin(phi)) + n * std::sqrt(std::max(1.0f - r2, 0.0f)));
+    }
+
+    glm::vec3 sky(const glm::vec3& direction, float intensity)
+    {
+        const glm::vec3 HORIZON = glm::vec3(0.85f, 0.9f, 1.0f);
+        const glm::vec3 ZENITH = glm::vec3(0.3f, 0.5f, 0.9f);
+        const glm::vec3 BELOW = glm::vec3(0.25f, 0.23f, 0.2f);
+        if (direction.y < 0.0f)
+            return BELOW * intensity;
+        return glm::mix(HORIZON, ZENITH, std::sqrt(direction.y)) * intensity;
+    }
+
+    int laneCount(int lanes)
+    {
+        return (lanes & 1) + ((lanes >> 1) & 1) + ((lanes >> 2) & 1) + ((lanes >> 3) & 1);
+    }
+
+    // rays of four lanes kept as plain arrays between bounces and loaded into a packet for each trace
+    struct Lanes
+    {
+        float OriginX[4], OriginY[4], OriginZ[4];
+        float DirectionX[4], DirectionY[4], DirectionZ[4];
+
+        void Set(int lane, const glm::vec3& origin, const glm::vec3& direction)
+        {
+            OriginX[lane] = origin.x; OriginY[lane] = origin.y; OriginZ[lane] = origin.z;
+            DirectionX[lane] = direction.x; DirectionY[lane] = direction.y; DirectionZ[lane] = direction.z;
+        }
+
+        glm::vec3 Origin(int lane) const { return glm::vec3(OriginX[lane], OriginY[lane], OriginZ[lane]); }
+        glm::vec3 Direction(int lane) const { return glm::vec3(DirectionX[lane], DirectionY[lane], DirectionZ[lane]); }
+
+        void Load(RayPacket& packet, int active) const
+        {
+            packet.OriginX = Float4::Load(OriginX);
+            packet.OriginY = Float4::Load(OriginY);
+            packet.OriginZ = Float4::Load(OriginZ);
+            packet.DirectionX = Float4::Load(DirectionX);
+            packet.DirectionY = Float4::Load(DirectionY);
+            packet.DirectionZ = Float4::Load(DirectionZ);
+            packet.Distance = Float4::Set1(std::numeric_limits<float>::infinity());
+            packet.Active = active;
+            packet.Prepare();
+        }
+    };
+
+    uint8_t toneMap(float value)
+    {
+        value = std::max(value, 0.0f);
+        value = std::pow(value / (1.0f + value), 1.0f / 2.2f);
+        return static_cast<uint8_t>(std::min(value * 255.0f + 0.5f, 255.0f));
+    }
+}
+
+void TracedMesh::Build(const MeshData& data, JobSystem& jobs)
+{
+    size_t triangles = data.Indices.size() / 3;
+    std::vector<glm::vec3> corners(triangles * 3);
+    Normals.resize(triangles * 3);
+    for (size_t i = 0; i < triangles * 3; ++i)
+    {
+        const float* vertex = &data.Vertices[size_t(data.Indices[i]) * MeshData::STRIDE];
+        corners[i] = glm::vec3(vertex[0], vertex[1], vertex[2]);
+        Normals[i] = glm::vec3(vertex[5], vertex[6], vertex[7]);
+    }
+    Bvh.Build(corners, jobs);
+}
+
+void TracedScene::Build()
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    Instances.erase(std::remove_if(Instances.begin(), Instances.end(), [](const TracedInstance& instance)
+    {
+        return !instance.Mesh || instance.Mesh->Bvh.Empty() || instance.Scale.x == 0.0f || instance.Scale.y == 0.0f || instance.Scale.z == 0.0f;
+    }), Instances.end());
+    Nodes.clear();
+    if (Instances.empty())
+        return;
+
+    // world bounds of each instance; a negative scale swaps the sides of its mesh's bounds
+    std::vector<glm::vec3> minimum(Instances.size()), maximum(Instances.size()), centers(Instances.size());
+    for (size_t i = 0; i < Instances.size(); ++i)
+    {
+        const TracedInstance& instance = Instances[i];
+        const BvhNode& root = instance.Mesh->Bvh.Nodes[0];
+        glm::vec3 a = root.Min * instance.Scale + instance.Position;
+        glm::vec3 b = root.Max * instance.Scale + instance.Position;
+        minimum[i] = glm::min(a, b);
+        maximum[i] = glm::max(a, b);
+        centers[i] = (minimum[i] + maximum[i]) * 0.5f;
+    }
+
+    // median splits along the widest axis of the centers; instances are few next to triangles, so SAH would not
+    // pay for itself here
+    std::vector<uint32_t> order(Instances.size());
+    std::iota(order.begin(), order.end(), 0u);
+    Nodes.reserve(Instances.size() * 2);
+    std::function<uint32_t(uint32_t, uint32_t)> build = [&](uint32_t begin, uint32_t end)
+    {
+        uint32_t index = static_cast<uint32_t>(Nodes.size());
+        Nodes.push_back(BvhNode());
+        glm::vec3 lower(std::numeric_limits<float>::max()), upper(-std::numeric_limits<float>::max());
+        glm::vec3 centerLower = lower, centerUpper = upper;
+        for (uint32_t i = begin; i < end; ++i)
+        {
+            lower = glm::min(lower, minimum[order[i]]);
+            upper = glm::max(upper, maximum[order[i]]);
+            centerLower = glm::min(centerLower, centers[order[i]]);
+            centerUpper = glm::max(centerUpper, centers[order[i]]);
+        }
+        Nodes[index].Min = lower;
+        Nodes[index].Max = upper;
+        if (end - begin <= MAX_LEAF_SIZE)
+        {
+            Nodes[index].Start = begin;
+            Nodes[index].Count = end - begin;
+            return index;
+        }
+        glm::vec3 extent = centerUpper - centerLower;
+        int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+        uint32_t middle = begin + (end - begin) / 2;
+        std::nth_element(order.begin() + begin, order.begin() + middle, order.begin() + end,
+            [&](uint32_t a, uint32_t b) { return centers[a][axis] < centers[b][axis]; });
+        build(begin, middle);
+        uint32_t second = build(middle, end);
+        Nodes[index].Start = second;
+        Nodes[index].Count = 0;
+        return index;
+    };
+    build(0, static_cast<uint32_t>(Instances.size()));
+
+    std::vector<TracedInstance> sorted(Instances.size());
+    for (size_t i = 0; i < order.size(); ++i)
+        sorted[i] = std::move(Instances[order[i]]);
+    Instances = std::move(sorted);
+    BuildMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+int TracedScene::IntersectPacket(RayPacket& packet, uint32_t instance[4]) const
+{
+    if (Nodes.empty() || packet.Active == 0)
+        return 0;
+    int updated = 0;
+    uint32_t stack[STACK_SIZE];
+    int top = 0;
+    stack[top++] = 0;
+    Float4 enter;
+    while (top > 0)
+    {
+        uint32_t index = stack[--top];
+        const BvhNode& node = Nodes[index];
+        if (packet.EntersBox(node.Min, node.Max, enter) == 0)
+            continue;
+        if (!node.IsLeaf())
+        {
+            stack[top++] = node.Start;
+            stack[top++] = index + 1;
+            continue;
+        }
+        for (uint32_t i = node.Start; i < node.Start + node.Count; ++i)
+        {
+            // scaling the direction along with the origin keeps distances the same in the instance's space
+            const TracedInstance& traced = Instances[i];
+            glm::vec3 inverseScale = 1.0f / traced.Scale;
+            Float4 scaleX = Float4::Set1(inverseScale.x), scaleY = Float4::Set1(inverseScale.y), scaleZ = Float4::Set1(inverseScale.z);
+            RayPacket local = packet;
+            local.OriginX = (packet.OriginX - Float4::Set1(traced.Position.x)) * scaleX;
+            local.OriginY = (packet.OriginY - Float4::Set1(traced.Position.y)) * scaleY;
+            local.OriginZ = (packet.OriginZ - Float4::Set1(traced.Position.z)) * scaleZ;
+            local.DirectionX = packet.DirectionX * scaleX;
+            local.DirectionY = packet.DirectionY * scaleY;
+            local.DirectionZ = packet.DirectionZ * scaleZ;
+            local.Prepare();
+            int hit = traced.Mesh->Bvh.IntersectPacket(local);
+            if (hit == 0)
+                continue;
+            Float4 mask = Float4::FromBits(hit);
+            packet.Distance = Select(mask, local.Distance, packet.Distance);
+            packet.U = Select(mask, local.U, packet.U);
+            packet.V = Select(mask, local.V, packet.V);
+            for (int lane = 0; lane < 4; ++lane)
+            {
+                if (hit & (1 << lane))
+                {
+                    packet.Triangle[lane] = local.Triangle[lane];
+                    instance[lane] = i;
+                }
+            }
+            updated |= hit;
+        }
+    }
+    return updated;
+}
+
+PathTracer::PathTracer(unsigned int workerCount)
+{
+    if (workerCount == 0)
+        workerCount = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+    for (unsigned int i = 0; i < workerCount; ++i)
+        workers.emplace_back(&PathTracer::workerLoop, this);
+}
+
+PathTracer::~PathTracer()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        generation++;
+    }
+    wake.notify_all();
+    for (std::thread& worker : workers)
+        worker.join();
+}
+
+void PathTracer::Restart(std::shared_ptr<const TracedScene> tracedScene, const TracerCamera& tracedCamera, const TracerSettings& tracedSettings, int imageWidth, int imageHeight)
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        generation++;
+        idle.wait(lock, [this]() { return busy == 0; });
+        scene = std::move(tracedScene);
+        camera = tracedCamera;
+        settings = tracedSettings;
+        settings.MaxBounces = std::max(settings.MaxBounces, 0);
+        if (imageWidth != width || imageHeight != height)
+        {
+            width = std::max(imageWidth, 0);
+            height = std::max(imageHeight, 0);
+            tiles.clear();
+            for (int y = 0; y < height; y += TILE_SIZE)
+            {
+                for (int x = 0; x < width; x += TILE_SIZE)
+                {
+                    Tile tile;
+                    tile.X = x;
+                    tile.Y = y;
+                    tile.Width = std::min(TILE_SIZE, width - x);
+                    tile.Height = std::min(TILE_SIZE, height - y);
+                    tile.Sum.resize(size_t(tile.Width) * tile.Height);
+                    tile.Pixels.resize(tile.Sum.size() * 4);
+                    tiles.push_back(std::move(tile));
+                }
+            }
+        }
+        // the tone mapped pixels stay, so the old image shows until new samples replace it tile by tile
+        for (Tile& tile : tiles)
+        {
+            tile.Samples = 0;
+            tile.Updated = false;
+            std::fill(tile.Sum.begin(), tile.Sum.end(), glm::vec3(0.0f));
+        }
+        cursor = 0;
+        stats = TracerStats();
+        stats.Threads = GetThreadCount();
+        started = std::chrono::high_resolution_clock::now();
+    }
+    wake.notify_all();
+}
+
+void PathTracer::Stop()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    generation++;
+    idle.wait(lock, [this]() { return busy == 0; });
+    scene.reset();
+    tiles.clear();
+    width = 0;
+    height = 0;
+}
+
+bool PathTracer::Running() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!scene)
+        return false;
+    for (const Tile& tile : tiles)
+    {
+        if (tile.Samples < settings.MaxSamples || tile.Updated)
+            return true;
+    }
+    return false;
+}
+
+bool PathTracer::CopyUpdated(std::vector<uint8_t>& pixels)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t bytes = size_t(width) * height * 4;
+    bool updated = false;
+    if (pixels.size() != bytes)
+    {
+        pixels.assign(bytes, 0);
+        updated = true;
+    }
+    for (Tile& tile : tiles)
+    {
+        if (!tile.Updated || tile.Busy)
+            continue;
+        for (int row = 0; row < tile.Height; ++row)
+        {
+            std::copy_n(&tile.Pixels[size_t(row) * tile.Width * 4], size_t(tile.Width) * 4, &pixels[(size_t(tile.Y + row) * width + tile.X) * 4]);
+        }
+        tile.Updated = false;
+        updated = true;
+    }
+    return updated;
+}
+
+TracerStats PathTracer::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    TracerStats current = stats;
+    current.Samples = tiles.empty() ? 0 : std::numeric_limits<uint32_t>::max();
+    for (const Tile& tile : tiles)
+        current.Samples = std::min(current.Samples, tile.Samples);
+    current.ElapsedMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - started).count();
+    return current;
+}
+
+size_t PathTracer::nextTile()
+{
+    size_t best = tiles.size();
+    if (!scene)
+        return best;
+    for (size_t i = 0; i < tiles.size(); ++i)
+    {
+        size_t index = (cursor + i) % tiles.size();
+        const Tile& tile = tiles[index];
+        if (tile.Busy || tile.Samples >= settings.MaxSamples)
+            continue;
+        if (best == tiles.size() || tile.Samples < tiles[best].Samples)
+            best = index;
+    }
+    if (best != tiles.size())
+        cursor = best + 1;
+    return best;
+}
+
+void PathTracer::workerLoop()
+{
+    for (;;)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        size_t index = tiles.size();
+        wake.wait(lock, [&]() { return stopping || (index = nextTile()) < tiles.size(); });
+        if (stopping)
+            return;
+        Tile& tile = tiles[index];
+        tile.Busy = true;
+        busy++;
+        std::shared_ptr<const TracedScene> tracedScene = scene;
+        TracerCamera tracedCamera = camera;
+        TracerSettings tracedSettings = settings;
+        uint64_t tracing = generation.load();
+        lock.unlock();
+
+        // a restart waits for busy tiles, so the tile stays in place while it is traced
+        auto start = std::chrono::high_resolution_clock::now();
+        uint64_t rays = 0;
+        bool finished = traceTile(tile, *tracedScene, tracedCamera, tracedSettings, tracing, rays);
+        double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+        lock.lock();
+        tile.Busy = false;
+        busy--;
+        if (finished && generation.load() == tracing)
+        {
+            tile.Samples++;
+            tile.Updated = true;
+            stats.Rays += rays;
+            stats.TraceSeconds += seconds;
+        }
+        lock.unlock();
+        idle.notify_all();
+    }
+}
+
+bool PathTracer::traceTile(Tile& tile, const TracedScene& tracedScene, const TracerCamera& view, const TracerSettings& lighting, uint64_t tracing, uint64_t& rays) const
+{
+    glm::vec3 sun = glm::normalize(lighting.SunDirection);
+    glm::vec3 sunTangent, sunBitangent;
+    Tangents(sun, sunTangent, sunBitangent);
+    uint32_t sample = tile.Samples;
+
+    for (int quadY = 0; quadY < tile.Height; quadY += 2)
+    {
+        if (generation.load(std::memory_order_relaxed) != tracing)
+            return false;
+        for (int quadX = 0; quadX < tile.Width; quadX += 2)
+        {
+            // one lane per pixel of the 2x2 quad
+            Lanes paths;
+            glm::vec3 throughput[4], radiance[4];
+            uint32_t random[4];
+            int active = 0;
+            for (int lane = 0; lane < 4; ++lane)
+            {
+                int x = quadX + (lane & 1);
+                int y = quadY + (lane >> 1);
+                throughput[lane] = glm::vec3(1.0f);
+                radiance[lane] = glm::vec3(0.0f);
+                x = std::min(x, tile.Width - 1);
+                y = std::min(y, tile.Height - 1);
+                if (quadX + (lane & 1) < tile.Width && quadY + (lane >> 1) < tile.Height)
+                    active |= 1 << lane;
+                uint32_t pixel = uint32_t(tile.Y + y) * uint32_t(width) + uint32_t(tile.X + x);
+                random[lane] = HashRandom(pixel ^ HashRandom(sample + 0x9E3779B9u));
+                float ndcX = (tile.X + x + nextRandom(random[lane])) / width * 2.0f - 1.0f;
+                float ndcY = (tile.Y + y + nextRandom(random[lane])) / height * 2.0f - 1.0f;
+                glm::vec3 direction = view.Forward + view.Right * (ndcX * view.TanHalfFov * view.Aspect) + view.Up * (ndcY * view.TanHalfFov);
+                paths.Set(lane, view.Position, glm::normalize(direction));
+            }
+
+            for (int bounce = 0; active != 0 && bounce <= lighting.MaxBounces; ++bounce)
+            {
+                RayPacket packet;
+                paths.Load(packet, active);
+                uint32_t instance[4] = { TriangleBvh::INVALID, TriangleBvh::INVALID, TriangleBvh::INVALID, TriangleBvh::INVALID };
+                tracedScene.IntersectPacket(packet, instance);
+                rays += laneCount(active);
+                float distance[4], u[4], v[4];
+                packet.Distance.Store(distance);
+                packet.U.Store(u);
+                packet.V.Store(v);
+
+                Lanes shadows;
+                glm::vec3 sunLight[4];
+                int shadowActive = 0;
+                for (int lane = 0; lane < 4; ++lane)
+                {
+                    if (!(active & (1 << lane)))
+                        continue;
+                    glm::vec3 origin = paths.Origin(lane);
+                    glm::vec3 direction = paths.Direction(lane);
+                    bool ground = false;
+                    if (lighting.GroundPlane && origin.y > 0.0f && direction.y < 0.0f)
+                    {
+                        float t = -origin.y / direction.y;
+                        if (t < distance[lane])
+                        {
+                            distance[lane] = t;
+                            ground = true;
+                        }
+                    }
+                    if (!ground && instance[lane] == TriangleBvh::INVALID)
+                    {
+                        radiance[lane] += throughput[lane] * sky(direction, lighting.SkyIntensity);
+                        active &= ~(1 << lane);
+                        continue;
+                    }
+
+                    glm::vec3 normal, albedo;
+                    glm::vec3 point = origin + direction * distance[lane];
+                    if (ground)
+                    {
+                        normal = glm::vec3(0.0f, 1.0f, 0.0f);
+                        albedo = GROUND_ALBEDO;
+                        point.y = 0.0f;
+                    }
+                    else
+                    {
+                        const TracedInstance& traced = tracedScene.Instances[instance[lane]];
+                        const glm::vec3* normals = &traced.Mesh->Normals[size_t(packet.Triangle[lane]) * 3];
+                        normal = normals[0] * (1.0f - u[lane] - v[lane]) + normals[1] * u[lane] + normals[2] * v[lane];
+                        normal /= traced.Scale;
+                        albedo = traced.Albedo;
+                    }
+                    float length = glm::length(normal);
+                    normal = length > 1.0e-12f ? normal / length : -direction;
+                    if (glm::dot(normal, direction) > 0.0f)
+                        normal = -normal;
+                    glm::vec3 start = point + normal * SurfaceOffset(point);
+
+                    // sun light arriving here if nothing blocks the shadow ray
+                    float angle = 2.0f * PI * nextRandom(random[lane]);
+                    float radius = SUN_RADIUS * std::sqrt(nextRandom(random[lane]));
+                    glm::vec3 toSun = glm::normalize(sun + (sunTangent * std::cos(angle) + sunBitangent * std::sin(angle)) * radius);
+                    float cosine = glm::dot(normal, toSun);
+                    if (cosine > 0.0f && lighting.SunIntensity > 0.0f && (!lighting.GroundPlane || toSun.y > 0.0f))
+                    {
+                        sunLight[lane] = throughput[lane] * albedo * (lighting.SunIntensity * cosine / PI);
+                        shadows.Set(lane, start, toSun);
+                        shadowActive |= 1 << lane;
+                    }
+
+                    // next bounce, cosine weighted so the diffuse BRDF and the pdf cancel down to the albedo
+                    throughput[lane] *= albedo;
+                    paths.Set(lane, start, cosineHemisphere(normal, random[lane]));
+                    if (bounce >= ROULETTE_BOUNCE)
+                    {
+                        float survive = std::clamp(std::max(throughput[lane].x, std::max(throughput[lane].y, throughput[lane].z)), 0.05f, 0.95f);
+                        if (nextRandom(random[lane]) >= survive)
+                            active &= ~(1 << lane);
+                        else
+                            throughput[lane] /= survive;
+                    }
+                }
+                if (bounce == lighting.MaxBounces)
+                    active = 0;
+
+                // shadow rays only go up, so the ground plane cannot be in their way
+                if (shadowActive != 0)
+                {
+                    RayPacket shadow;
+                    for (int lane = 0; lane < 4; ++lane)
+                    {
+                        if (!(shadowActive & (1 << lane)))
+                            shadows.Set(lane, glm::vec3(0.0f), sun);
+                    }
+                    shadows.Load(shadow, shadowActive);
+                    uint32_t blocker[4];
+                    int blocked = tracedScene.IntersectPacket(shadow, blocker);
+                    rays += laneCount(shadowActive);
+                    for (int lane = 0; lane < 4; ++lane)
+                    {
+                        if ((shadowActive & ~blocked) & (1 << lane))
+                            radiance[lane] += sunLight[lane];
+                    }
+                }
+            }
+
+            for (int lane = 0; lane < 4; ++lane)
+            {
+                int x = quadX + (lane & 1);
+                int y = quadY + (lane >> 1);
+                if (x < tile.Width && y < tile.Height && std::isfinite(radiance[lane].x + radiance[lane].y + radiance[lane].z))
+                    tile.Sum[size_t(y) * tile.Width + x] += radiance[lane];
+            }
+        }
+    }
+
+    float scale = lighting.Exposure / float(sample + 1);
+    for (size_t p = 0; p < tile.Sum.size(); ++p)
+    {
+        glm::vec3 color = tile.Sum[p] * scale;
+        tile.Pixels[p * 4 + 0] = toneMap(color.r);
+        tile.Pixels[p * 4 + 1] = toneMap(color.g);
+        tile.Pixels[p * 4 + 2] = toneMap(color.b);
+        tile.Pixels[p * 4 + 3] = 255;
+    }
+    return true;
+}
@@ -0,0 +1,172 @@
+#ifndef PATH_TRACER_H
+#define PATH_TRACER_H
+
+#include "bvh.h"
+#include "primitives.h"
+#include "job_system.h"
+
+#include <glm/glm.hpp>
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <atomic>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+// Mesh in object space as the path tracer sees it; shared by every instance with the same content
+struct TracedMesh
+{
+    TriangleBvh Bvh;
+    std::vector<glm::vec3> Normals;     // three per input triangle, interpolated across it
+
+    void Build(const MeshData& data, JobSystem& jobs);
+};
+
+struct TracedInstance
+{
+    std::shared_ptr<const TracedMesh> Mesh;
+    glm::vec3 Position = glm::vec3(0.0f);
+    glm::vec3 Scale = glm::vec3(1.0f);
+    glm::vec3 Albedo = glm::vec3(0.8f);
+};
+
+// Instances under a top-level BVH over their world bounds. Objects only translate and scale, so a ray enters an
+// instance's space with one multiply-add per component and keeps its hit distances there.
+class TracedScene
+{
+public:
+    static const uint32_t MAX_LEAF_SIZE = 2;
+
+    std::vector<TracedInstance> Instances;  // leaf order once built
+    std::vector<BvhNode> Nodes;             // same layout as TriangleBvh's, with instances in place of triangles
+    double BuildMs = 0.0;
+
+    // builds the top level over Instances, reordering them and dropping empty or flattened ones
+    void Build();
+
+    // closest hits of the packet's active lanes over every instance; instance receives the hit instance of each
+    // updated lane. Returns the updated lanes.
+    int IntersectPacket(RayPacket& packet, uint32_t instance[4]) const;
+};
+
+struct TracerCamera
+{
+    glm::vec3 Position = glm::vec3(0.0f);
+    glm::vec3 Forward = glm::vec3(0.0f, 0.0f, -1.0f);
+    glm::vec3 Right = glm::vec3(1.0f, 0.0f, 0.0f);
+    glm::vec3 Up = glm::vec3(0.0f, 1.0f, 0.0f);
+    float TanHalfFov = 0.41421356f;
+    float Aspect = 16.0f / 9.0f;            // width over height of the image plane
+
+    bool operator==(const TracerCamera& other) const
+    {
+        return Position == other.Position && Forward == other.Forward && Right == other.Right && Up == other.Up &&
+            TanHalfFov == other.TanHalfFov && Aspect == other.Aspect;
+    }
+};
+
+// Lighting and path settings; surfaces are diffuse with the instance's albedo
+struct TracerSettings
+{
+    int MaxBounces = 4;
+    uint32_t MaxSamples = 1024;             // per pixel, after which the image is left as it is
+    bool GroundPlane = true;                // infinite plane at y = 0, under the editor grid
+    glm::vec3 SunDirection = glm::vec3(0.45f, 0.8f, 0.4f);     // towards the sun
+    float SunIntensity = 3.0f;              // irradiance on a surface facing the sun
+    float SkyIntensity = 1.0f;
+    float Exposure = 1.0f;
+
+    bool operator==(const TracerSettings& other) const
+    {
+        return MaxBounces == other.MaxBounces && MaxSamples == other.MaxSamples && GroundPlane == other.GroundPlane &&
+            SunDirection == other.SunDirection && SunIntensity == other.SunIntensity && SkyIntensity == other.SkyIntensity &&
+            Exposure == other.Exposure;
+    }
+};
+
+struct TracerStats
+{
+    uint32_t Samples = 0;           // samples every pixel has
+    uint64_t Rays = 0;              // path and shadow rays since the restart
+    double TraceSeconds = 0.0;      // time the workers spent tracing, summed over workers
+    double ElapsedMs = 0.0;         // since the restart
+    unsigned int Threads = 0;
+
+    double RaysPerSecond() const { return ElapsedMs > 0.0 ? Rays / (ElapsedMs / 1000.0) : 0.0; }
+    // rays per second of one worker while it traces, independent of how many cores there are
+    double RaysPerSecondPerCore() const { return TraceSeconds > 0.0 ? Rays / TraceSeconds : 0.0; }
+};
+
+// Progressive path tracer on its own worker threads. The image is split into tiles; a worker takes the tile with
+// the fewest samples, adds one sample per pixel and tone maps the tile, so the whole image refines evenly and the
+// display copy only changes a tile at a time. Camera rays of each 2x2 pixel quad travel as one SIMD packet, and
+// so do their bounces and sun shadow rays. Restart drops the accumulated samples; workers notice it between rows
+// of quads and abandon their tile.
+class PathTracer
+{
+public:
+    static const int TILE_SIZE = 32;
+
+    // workerCount 0 uses one worker per hardware thread, minus one for the main thread
+    explicit PathTracer(unsigned int workerCount = 0);
+    ~PathTracer();
+
+    PathTracer(const PathTracer&) = delete;
+    PathTracer& operator=(const PathTracer&) = delete;
+
+    // starts accumulating a new image of the scene
+    void Restart(std::shared_ptr<const TracedScene> scene, const TracerCamera& camera, const TracerSettings& settings, int width, int height);
+    // idles the workers and drops the image
+    void Stop();
+
+    // true while a scene is set and some pixel has fewer than MaxSamples
+    bool Running() const;
+    // copies tiles that changed since the last call into pixels, RGBA8 rows from the bottom up; returns whether
+    // any did. pixels is resized to the image when it does not match.
+    bool CopyUpdated(std::vector<uint8_t>& pixels);
+    TracerStats GetStats() const;
+
+    int GetWidth() const { return width; }
+    int GetHeight() const { return height; }
+    unsigned int GetThreadCount() const { return static_cast<unsigned int>(workers.size()); }
+
+private:
+    struct Tile
+    {
+        int X = 0, Y = 0, Width = 0, Height = 0;
+        uint32_t Samples = 0;
+        bool Busy = false;
+        bool Updated = false;
+        std::vector<glm::vec3> Sum;         // radiance summed over the samples, per pixel
+        std::vector<uint8_t> Pixels;        // tone mapped RGBA8
+    };
+
+    std::vector<std::thread> workers;
+    std::vector<Tile> tiles;
+    std::shared_ptr<const TracedScene> scene;
+    TracerCamera camera;
+    TracerSettings settings;
+    int width = 0;
+    int height = 0;
+    size_t cursor = 0;                      // next tile to look at, so tiles with equal samples go in order
+    std::atomic<uint64_t> generation{ 0 };  // bumped by every restart
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable idle;
+    size_t busy = 0;
+    bool stopping = false;
+    TracerStats stats;
+    std::chrono::high_resolution_clock::time_point started;
+
+    void workerLoop();
+    // tile to trace next, or tiles.size() when every tile has MaxSamples or is taken; call with mutex held
+    size_t nextTile();
+    // adds one sample to every pixel of the tile and tone maps it; false if a restart interrupted it
+    bool traceTile(Tile& tile, const TracedScene& scene, const TracerCamera& camera, const TracerSettings& settings, uint64_t tracing, uint64_t& rays) const;
+};
+
+#endif
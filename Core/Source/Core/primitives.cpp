@@ -0,0 +1,621 @@
+#include "primitives.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+
+#include <unordered_map>
+#include <string>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <array>
+
+const char* PrimitiveTypeName(Primitive_Type type)
+{
+    switch (type)
+    {
+    case PRIMITIVE_CUBE: return "Cube";
+    case PRIMITIVE_UV_SPHERE: return "UV Sphere";
+    case PRIMITIVE_ICO_SPHERE: return "Ico Sphere";
+    case PRIMITIVE_CYLINDER: return "Cylinder";
+    case PRIMITIVE_CONE: return "Cone";
+    case PRIMITIVE_TORUS: return "Torus";
+    case PRIMITIVE_PLANE: return "Plane";
+    default: return "Unknown";
+    }
+}
+
+PrimitiveDesc PrimitiveDesc::Cube()
+{
+    PrimitiveDesc desc;
+    desc.Type = PRIMITIVE_CUBE;
+    return desc;
+}
+
+PrimitiveDesc PrimitiveDesc::UVSphere(int segments, int rings)
+{
+    PrimitiveDesc desc;
+    desc.Type = PRIMITIVE_UV_SPHERE;
+    desc.Segments = std::max(segments, 3);
+    desc.Rings = std::max(rings, 2);
+    return desc;
+}
+
+PrimitiveDesc PrimitiveDesc::IcoSphere(int subdivisions)
+{
+    PrimitiveDesc desc;
+    desc.Type = PRIMITIVE_ICO_SPHERE;
+    desc.Rings = std::clamp(subdivisions, 0, 7);
+    return desc;
+}
+
+PrimitiveDesc PrimitiveDesc::Cylinder(int segments)
+{
+    PrimitiveDesc desc;
+    desc.Type = PRIMITIVE_CYLINDER;
+    desc.Segments = std::max(segments, 3);
+    return desc;
+}
+
+PrimitiveDesc PrimitiveDesc::Cone(int segments)
+{
+    PrimitiveDesc desc;
+    desc.Type = PRIMITIVE_CONE;
+    desc.Segments = std::max(segments, 3);
+    return desc;
+}
+
+PrimitiveDesc PrimitiveDesc::Torus(int segments, int rings, float minorRadius)
+{
+    PrimitiveDesc desc;
+    desc.Type = PRIMITIVE_TORUS;
+    desc.Segments = std::max(segments, 3);
+    desc.Rings = std::max(rings, 3);
+    desc.MinorRadius = std::clamp(minorRadius, 0.01f, 0.25f);
+    return desc;
+}
+
+PrimitiveDesc PrimitiveDesc::Plane(int subdivisions)
+{
+    PrimitiveDesc desc;
+    desc.Type = PRIMITIVE_PLANE;
+    desc.Rings = std::max(subdivisions, 1);
+    return desc;
+}
+
+PrimitiveDesc PrimitiveDesc::Default(Primitive_Type type)
+{
+    switch (type)
+    {
+    case PRIMITIVE_UV_SPHERE: return UVSphere();
+    case PRIMITIVE_ICO_SPHERE: return IcoSphere();
+    case PRIMITIVE_CYLINDER: return Cylinder();
+    case PRIMITIVE_CONE: return Cone();
+    case PRIMITIVE_TORUS: return Torus();
+    case PRIMITIVE_PLANE: return Plane();
+    default: return Cube();
+    }
+}
+
+unsigned int MeshData::AddVertex(float x, float y, float z, float u, float v)
+{
+    unsigned int index = static_cast<unsigned int>(VertexCount());
+    Vertices.insert(Vertices.end(), { x, y, z, u, v, 0.0f, 0.0f, 0.0f });
+    return index;
+}
+
+void MeshData::AddTriangle(unsigned int a, unsigned int b, unsigned int c)
+{
+    Indices.insert(Indices.end(), { a, b, c });
+}
+
+std::vector<float> MeshData::UniquePositions() const
+{
+    std::vector<std::array<float, 3>> positions;
+    positions.reserve(VertexCount());
+    for (size_t i = 0; i < VertexCount(); ++i)
+        positions.push_back({ Vertices[i * STRIDE], Vertices[i * STRIDE + 1], Vertices[i * STRIDE + 2] });
+    std::sort(positions.begin(), positions.end());
+    positions.erase(std::unique(positions.begin(), positions.end()), positions.end());
+
+    std::vector<float> result;
+    result.reserve(positions.size() * 3);
+    for (const std::array<float, 3>& position : positions)
+        result.insert(result.end(), position.begin(), position.end());
+    return result;
+}
+
+namespace {
+
+    const float PI = glm::pi<float>();
+
+    void generateCube(MeshData& mesh)
+    {
+        // one quad per face so every face gets its own texture coordinates
+        const glm::vec3 normals[6] = { {0, 0, -1}, {0, 0, 1}, {-1, 0, 0}, {1, 0, 0}, {0, -1, 0}, {0, 1, 0} };
+        for (const glm::vec3& n : normals)
+        {
+            glm::vec3 up = std::abs(n.y) > 0.5f ? glm::vec3(0, 0, 1) : glm::vec3(0, 1, 0);
+            glm::vec3 right = glm::cross(up, n);
+            glm::vec3 center = n * 0.5f;
+            unsigned int base = static_cast<unsigned int>(mesh.VertexCount());
+            for (int corner = 0; corner < 4; ++corner)
+            {
+                float u = (corner == 1 || corner == 2) ? 1.0f : 0.0f;
+                float v = (corner >= 2) ? 1.0f : 0.0f;
+                glm::vec3 p = center + right * (u - 0.5f) + up * (v - 0.5f);
+                mesh.AddVertex(p.x, p.y, p.z, u, v);
+            }
+            mesh.AddTriangle(base, base + 1, base + 2);
+            mesh.AddTriangle(base, base + 2, base + 3);
+        }
+    }
+
+    void generateUVSphere(MeshData& mesh, int longitudeBands, int latitudeBands)
+    {
+        const float radius = 0.5f;
+        for (int lat = 0; lat <= latitudeBands; ++lat)
+        {
+            float theta = lat * PI / latitudeBands;
+            for (int lon = 0; lon <= longitudeBands; ++lon)
+            {
+                float phi = lon * 2.0f * PI / longitudeBands;
+                float x = std::cos(phi) * std::sin(theta);
+                float y = std::cos(theta);
+                float z = std::sin(phi) * std::sin(theta);
+                mesh.AddVertex(radius * x, radius * y, radius * z, 1.0f - (float)lon / longitudeBands, 1.0f - (float)lat / latitudeBands);
+            }
+        }
+
+        for (int lat = 0; lat < latitudeBands; ++lat)
+        {
+            for (int lon = 0; lon < longitudeBands; ++lon)
+            {
+                unsigned int first = lat * (longitudeBands + 1) + lon;
+                unsigned int second = first + longitudeBands + 1;
+                // the pole rows would otherwise produce zero-area triangles
+                if (lat != 0)
+                    mesh.AddTriangle(first, first + 1, second);
+                if (lat != latitudeBands - 1)
+                    mesh.AddTriangle(second, first + 1, second + 1);
+            }
+        }
+    }
+
+    void generateIcoSphere(MeshData& mesh, int subdivisions)
+    {
+        const float t = (1.0f + std::sqrt(5.0f)) * 0.5f;
+        std::vector<glm::vec3> positions = {
+            {-1, t, 0}, {1, t, 0}, {-1, -t, 0}, {1, -t, 0},
+            {0, -1, t}, {0, 1, t}, {0, -1, -t}, {0, 1, -t},
+            {t, 0, -1}, {t, 0, 1}, {-t, 0, -1}, {-t, 0, 1}
+        };
+        for (glm::vec3& p : positions)
+            p = glm::normalize(p);
+
+        std::vector<unsigned int> triangles = {
+            0, 11, 5,  0, 5, 1,  0, 1, 7,  0, 7, 10,  0, 10, 11,
+            1, 5, 9,  5, 11, 4,  11, 10, 2,  10, 7, 6,  7, 1, 8,
+            3, 9, 4,  3, 4, 2,  3, 2, 6,  3, 6, 8,  3, 8, 9,
+            4, 9, 5,  2, 4, 11,  6, 2, 10,  8, 6, 7,  9, 8, 1
+        };
+
+        for (int level = 0; level < subdivisions; ++level)
+        {
+            std::unordered_map<unsigned long long, unsigned int> midpoints;
+            auto midpoint = [&](unsigned int a, unsigned int b)
+            {
+                unsigned long long key = a < b ? ((unsigned long long)a << 32) | b : ((unsigned long long)b << 32) | a;
+                auto it = midpoints.find(key);
+                if (it != midpoints.end())
+                    return it->second;
+                unsigned int index = static_cast<unsigned int>(positions.size());
+                positions.push_back(glm::normalize(positions[a] + positions[b]));
+                midpoints[key] = index;
+                return index;
+            };
+
+            std::vector<unsigned int> refined;
+            refined.reserve(triangles.size() * 4);
+            for (size_t i = 0; i < triangles.size(); i += 3)
+            {
+                unsigned int a = triangles[i], b = triangles[i + 1], c = triangles[i + 2];
+                unsigned int ab = midpoint(a, b), bc = midpoint(b, c), ca = midpoint(c, a);
+                refined.insert(refined.end(), { a, ab, ca,  b, bc, ab,  c, ca, bc,  ab, bc, ca });
+            }
+            triangles.swap(refined);
+        }
+
+        // spherical texture mapping; triangles crossing the seam get their own copies with wrapped u
+        for (size_t i = 0; i < triangles.size(); i += 3)
+        {
+            glm::vec2 uv[3];
+            for (int k = 0; k < 3; ++k)
+            {
+                const glm::vec3& p = positions[triangles[i + k]];
+                uv[k] = glm::vec2(0.5f + std::atan2(p.z, p.x) / (2.0f * PI), 0.5f + std::asin(glm::clamp(p.y, -1.0f, 1.0f)) / PI);
+            }
+            for (int k = 0; k < 3; ++k)
+            {
+                float maxU = std::max(uv[0].x, std::max(uv[1].x, uv[2].x));
+                if (maxU - uv[k].x > 0.5f)
+                    uv[k].x += 1.0f;
+            }
+            unsigned int index[3];
+            for (int k = 0; k < 3; ++k)
+            {
+                glm::vec3 p = positions[triangles[i + k]] * 0.5f;
+                index[k] = mesh.AddVertex(p.x, p.y, p.z, uv[k].x, uv[k].y);
+            }
+            mesh.AddTriangle(index[0], index[1], index[2]);
+        }
+    }
+
+    // closed disc at height y facing up (+1) or down (-1)
+    void addCap(MeshData& mesh, int segments, float y, float facing)
+    {
+        unsigned int center = mesh.AddVertex(0.0f, y, 0.0f, 0.5f, 0.5f);
+        unsigned int first = static_cast<unsigned int>(mesh.VertexCount());
+        for (int i = 0; i <= segments; ++i)
+        {
+            float phi = i * 2.0f * PI / segments;
+            float c = std::cos(phi), s = std::sin(phi);
+            mesh.AddVertex(0.5f * c, y, 0.5f * s, 0.5f + 0.5f * c, 0.5f + 0.5f * s);
+        }
+        for (int i = 0; i < segments; ++i)
+        {
+            if (facing > 0.0f)
+                mesh.AddTriangle(center, first + i + 1, first + i);
+            else
+                mesh.AddTriangle(center, first + i, first + i + 1);
+        }
+    }
+
+    void generateCylinder(MeshData& mesh, int segments)
+    {
+        unsigned int first = static_cast<unsigned int>(mesh.VertexCount());
+        for (int i = 0; i <= segments; ++i)
+        {
+            float phi = i * 2.0f * PI / segments;
+            float u = (float)i / segments;
+            mesh.AddVertex(0.5f * std::cos(phi), -0.5f, 0.5f * std::sin(phi), u, 0.0f);
+            mesh.AddVertex(0.5f * std::cos(phi), 0.5f, 0.5f * std::sin(phi), u, 1.0f);
+        }
+        for (int i = 0; i < segments; ++i)
+        {
+            unsigned int bottom = first + 2 * i;
+            mesh.AddTriangle(bottom, bottom + 1, bottom + 3);
+            mesh.AddTriangle(bottom, bottom + 3, bottom + 2);
+        }
+        addCap(mesh, segments, 0.5f, 1.0f);
+        addCap(mesh, segments, -0.5f, -1.0f);
+    }
+
+    void generateCone(MeshData& mesh, int segments)
+    {
+        // the apex is split per segment so each side triangle keeps a sensible u coordinate
+        unsigned int first = static_cast<unsigned int>(mesh.VertexCount());
+        for (int i = 0; i <= segments; ++i)
+        {
+            float phi = i * 2.0f * PI / segments;
+            float u = (float)i / segments;
+            mesh.AddVertex(0.5f * std::cos(phi), -0.5f, 0.5f * std::sin(phi), u, 0.0f);
+            mesh.AddVertex(0.0f, 0.5f, 0.0f, u + 0.5f / segments, 1.0f);
+        }
+        for (int i = 0; i < segments; ++i)
+        {
+            unsigned int base = first + 2 * i;
+            mesh.AddTriangle(base, base + 1, base + 2);
+        }
+        addCap(mesh, segments, -0.5f, -1.0f);
+    }
+
+    void generateTorus(MeshData& mesh, int segments, int rings, float minorRadius)
+    {
+        float majorRadius = 0.5f - minorRadius;
+        for (int i = 0; i <= segments; ++i)
+        {
+            float phi = i * 2.0f * PI / segments;
+            for (int j = 0; j <= rings; ++j)
+            {
+                float theta = j * 2.0f * PI / rings;
+                float r = majorRadius + minorRadius * std::cos(theta);
+                mesh.AddVertex(r * std::cos(phi), minorRadius * std::sin(theta), r * std::sin(phi), (float)i / segments, (float)j / rings);
+            }
+        }
+        for (int i = 0; i < segments; ++i)
+        {
+            for (int j = 0; j < rings; ++j)
+            {
+                unsigned int a = i * (rings + 1) + j;
+                unsigned int b = a + rings + 1;
+                mesh.AddTriangle(a, a + 1, b);
+                mesh.AddTriangle(b, a + 1, b + 1);
+            }
+        }
+    }
+
+    void generatePlane(MeshData& mesh, int subdivisions)
+    {
+        for (int z = 0; z <= subdivisions; ++z)
+        {
+            for (int x = 0; x <= subdivisions; ++x)
+            {
+                float u = (float)x / subdivisions;
+                float v = (float)z / subdivisions;
+                mesh.AddVertex(u - 0.5f, 0.0f, 0.5f - v, u, v);
+            }
+        }
+        for (int z = 0; z < subdivisions; ++z)
+        {
+            for (int x = 0; x < subdivisions; ++x)
+            {
+                unsigned int a = z * (subdivisions + 1) + x;
+                unsigned int b = a + subdivisions + 1;
+                mesh.AddTriangle(a, a + 1, b + 1);
+                mesh.AddTriangle(a, b + 1, b);
+            }
+        }
+    }
+
+    void weldVertices(MeshData& mesh)
+    {
+        const size_t vertexBytes = MeshData::STRIDE * sizeof(float);
+        std::unordered_map<std::string, unsigned int> unique;
+        std::vector<unsigned int> remap(mesh.VertexCount());
+        std::vector<float> welded;
+        welded.reserve(mesh.Vertices.size());
+
+        for (size_t i = 0; i < mesh.VertexCount(); ++i)
+        {
+            const float* vertex = &mesh.Vertices[i * MeshData::STRIDE];
+            std::string key(reinterpret_cast<const char*>(vertex), vertexBytes);
+            auto it = unique.find(key);
+            if (it != unique.end())
+            {
+                remap[i] = it->second;
+                continue;
+            }
+            unsigned int index = static_cast<unsigned int>(welded.size() / MeshData::STRIDE);
+            unique.emplace(std::move(key), index);
+            welded.insert(welded.end(), vertex, vertex + MeshData::STRIDE);
+            remap[i] = index;
+        }
+
+        for (unsigned int& index : mesh.Indices)
+            index = remap[index];
+        mesh.Vertices.swap(welded);
+    }
+
+    // Tom Forsyth, "Linear-Speed Vertex Cache Optimisation"
+    const int CACHE_SIZE = 32;
+
+    float vertexScore(int cachePosition, int remainingTriangles)
+    {
+        if (remainingTriangles == 0)
+            return -1.0f;
+
+        float score = 0.0f;
+        if (cachePosition >= 0)
+        {
+            if (cachePosition < 3)
+                score = 0.75f; // the last triangle's vertices get a fixed score so they are not reused straight away
+            else
+                score = std::pow(1.0f - (float)(cachePosition - 3) / (CACHE_SIZE - 3), 1.5f);
+        }
+        score += 2.0f / std::sqrt((float)remainingTriangles);
+        return score;
+    }
+
+    void optimizeVertexCache(MeshData& mesh)
+    {
+        size_t triangleCount = mesh.Indices.size() / 3;
+        size_t vertexCount = mesh.VertexCount();
+        if (triangleCount == 0)
+            return;
+
+        // vertex -> triangle adjacency
+        std::vector<int> remaining(vertexCount, 0);
+        for (unsigned int index : mesh.Indices)
+            remaining[index]++;
+        std::vector<size_t> offsets(vertexCount + 1, 0);
+        for (size_t v = 0; v < vertexCount; ++v)
+            offsets[v + 1] = offsets[v] + remaining[v];
+        std::vector<unsigned int> adjacency(mesh.Indices.size());
+        std::vector<size_t> fill(offsets.begin(), offsets.end() - 1);
+        for (size_t t = 0; t < triangleCount; ++t)
+            for (int k = 0; k < 3; ++k)
+                adjacency[fill[mesh.Indices[t * 3 + k]]++] = static_cast<unsigned int>(t);
+
+        std::vector<int> cachePosition(vertexCount, -1);
+        std::vector<float> score(vertexCount);
+        for (size_t v = 0; v < vertexCount; ++v)
+            score[v] = vertexScore(-1, remaining[v]);
+
+        std::vector<float> triangleScore(triangleCount);
+        std::vector<char> emitted(triangleCount, 0);
+        for (size_t t = 0; t < triangleCount; ++t)
+            triangleScore[t] = score[mesh.Indices[t * 3]] + score[mesh.Indices[t * 3 + 1]] + score[mesh.Indices[t * 3 + 2]];
+
+        std::vector<unsigned int> output;
+        output.reserve(mesh.Indices.size());
+        std::vector<unsigned int> cache;
+        cache.reserve(CACHE_SIZE + 3);
+        size_t scanCursor = 0;
+
+        long long best = -1;
+        for (size_t emittedCount = 0; emittedCount < triangleCount; ++emittedCount)
+        {
+            if (best < 0)
+            {
+                // nothing adjacent to the cache: continue with the next unemitted triangle
+                while (emitted[scanCursor])
+                    scanCursor++;
+                best = static_cast<long long>(scanCursor);
+            }
+
+            const unsigned int* tri = &mesh.Indices[best * 3];
+            output.insert(output.end(), tri, tri + 3);
+            emitted[best] = 1;
+
+            // move the triangle's vertices to the front of the cache
+            std::vector<unsigned int> newCache(tri, tri + 3);
+            for (unsigned int v : cache)
+                if (v != tri[0] && v != tri[1] && v != tri[2])
+                    newCache.push_back(v);
+            for (int k = 0; k < 3; ++k)
+                remaining[tri[k]]--;
+
+            for (size_t i = 0; i < newCache.size(); ++i)
+            {
+                unsigned int v = newCache[i];
+                cachePosition[v] = i < (size_t)CACHE_SIZE ? static_cast<int>(i) : -1;
+                score[v] = vertexScore(cachePosition[v], remaining[v]);
+            }
+            if (newCache.size() > (size_t)CACHE_SIZE)
+                newCache.resize(CACHE_SIZE);
+            cache.swap(newCache);
+
+            // rescore triangles touching the cache and pick the best one
+            best = -1;
+            float bestScore = -1.0f;
+            for (unsigned int v : cache)
+            {
+                for (size_t a = offsets[v]; a < offsets[v + 1]; ++a)
+                {
+                    unsigned int t = adjacency[a];
+                    if (emitted[t])
+                        continue;
+                    const unsigned int* other = &mesh.Indices[t * 3];
+                    triangleScore[t] = score[other[0]] + score[other[1]] + score[other[2]];
+                    if (triangleScore[t] > bestScore)
+                    {
+                        bestScore = triangleScore[t];
+                        best = t;
+                    }
+                }
+            }
+        }
+
+        mesh.Indices.swap(output);
+    }
+
+    void optimizeVertexFetch(MeshData& mesh)
+    {
+        const unsigned int UNUSED = 0xFFFFFFFFu;
+        std::vector<unsigned int> remap(mesh.VertexCount(), UNUSED);
+        std::vector<float> ordered;
+        ordered.reserve(mesh.Vertices.size());
+        unsigned int next = 0;
+
+        for (unsigned int& index : mesh.Indices)
+        {
+            if (remap[index] == UNUSED)
+            {
+                remap[index] = next++;
+                const float* vertex = &mesh.Vertices[index * MeshData::STRIDE];
+                ordered.insert(ordered.end(), vertex, vertex + MeshData::STRIDE);
+            }
+            index = remap[index];
+        }
+        mesh.Vertices.swap(ordered); // vertices no triangle references are dropped here
+    }
+
+}
+
+void OptimizeMesh(MeshData& mesh)
+{
+    weldVertices(mesh);
+    optimizeVertexCache(mesh);
+    optimizeVertexFetch(mesh);
+}
+
+MeshData GeneratePrimitive(const PrimitiveDesc& desc)
+{
+    MeshData mesh;
+    switch (desc.Type)
+    {
+    case PRIMITIVE_CUBE: generateCube(mesh); break;
+    case PRIMITIVE_UV_SPHERE: generateUVSphere(mesh, desc.Segments, desc.Rings); break;
+    case PRIMITIVE_ICO_SPHERE: generateIcoSphere(mesh, desc.Rings); break;
+    case PRIMITIVE_CYLINDER: generateCylinder(mesh, desc.Segments); break;
+    case PRIMITIVE_CONE: generateCone(mesh, desc.Segments); break;
+    case PRIMITIVE_TORUS: generateTorus(mesh, desc.Segments, desc.Rings, desc.MinorRadius); break;
+    case PRIMITIVE_PLANE: generatePlane(mesh, desc.Rings); break;
+    default: break;
+    }
+    // normals first, so welding keeps vertices apart where a crease gave them different normals
+    ComputeNormals(mesh);
+    OptimizeMesh(mesh);
+    return mesh;
+}
+
+void ComputeNormals(MeshData& mesh, float smoothAngle)
+{
+    const size_t vertexCount = mesh.VertexCount();
+    const size_t triangleCount = mesh.Indices.size() / 3;
+    auto position = [&](unsigned int index) {
+        const float* vertex = &mesh.Vertices[index * MeshData::STRIDE];
+        return glm::vec3(vertex[0], vertex[1], vertex[2]);
+    };
+
+    // face normals scaled by twice the area, and each vertex's normal from its own faces
+    std::vector<glm::vec3> faceNormals(triangleCount);
+    std::vector<glm::vec3> own(vertexCount, glm::vec3(0.0f));
+    for (size_t t = 0; t < triangleCount; ++t)
+    {
+        const unsigned int* corner = &mesh.Indices[t * 3];
+        glm::vec3 p0 = position(corner[0]);
+        faceNormals[t] = glm::cross(position(corner[1]) - p0, position(corner[2]) - p0);
+        for (int k = 0; k < 3; ++k)
+            own[corner[k]] += faceNormals[t];
+    }
+
+    // vertices sharing a position form one group; the triangles of the whole group are candidates for smoothing.
+    // Groups come from sorting the position bits, which is much cheaper than hashing every vertex.
+    std::vector<std::pair<std::array<uint32_t, 3>, unsigned int>> keys(vertexCount);
+    for (size_t i = 0; i < vertexCount; ++i)
+    {
+        std::memcpy(keys[i].first.data(), &mesh.Vertices[i * MeshData::STRIDE], 3 * sizeof(float));
+        keys[i].second = static_cast<unsigned int>(i);
+    }
+    std::sort(keys.begin(), keys.end());
+    std::vector<unsigned int> group(vertexCount);
+    size_t groupCount = 0;
+    for (size_t i = 0; i < vertexCount; ++i)
+    {
+        if (i > 0 && keys[i].first != keys[i - 1].first)
+            groupCount++;
+        group[keys[i].second] = static_cast<unsigned int>(groupCount);
+    }
+    if (vertexCount > 0)
+        groupCount++;
+    std::vector<unsigned int> groupStart(groupCount + 1, 0);
+    for (size_t t = 0; t < triangleCount * 3; ++t)
+        groupStart[group[mesh.Indices[t]] + 1]++;
+    for (size_t g = 1; g < groupStart.size(); ++g)
+        groupStart[g] += groupStart[g - 1];
+    std::vector<unsigned int> groupTriangles(triangleCount * 3);
+    std::vector<unsigned int> fill(groupStart.begin(), groupStart.end() - 1);
+    for (size_t t = 0; t < triangleCount * 3; ++t)
+        groupTriangles[fill[group[mesh.Indices[t]]]++] = static_cast<unsigned int>(t / 3);
+
+    const float threshold = std::cos(glm::radians(smoothAngle));
+    for (size_t i = 0; i < vertexCount; ++i)
+    {
+        glm::vec3 reference = glm::length(own[i]) > 0.0f ? glm::normalize(own[i]) : glm::vec3(0.0f);
+        glm::vec3 sum(0.0f);
+        for (unsigned int k = groupStart[group[i]]; k < groupStart[group[i] + 1]; ++k)
+        {
+            const glm::vec3& face = faceNormals[groupTriangles[k]];
+            float length = glm::length(face);
+            if (length > 0.0f && glm::dot(face / length, reference) >= threshold)
+                sum += face;
+        }
+        glm::vec3 normal = glm::length(sum) > 0.0f ? glm::normalize(sum) : reference;
+        float* vertex = &mesh.Vertices[i * MeshData::STRIDE];
+        vertex[5] = normal.x;
+        vertex[6] = normal.y;
+        vertex[7] = normal.z;
+    }
+}
@@ -0,0 +1,88 @@
+#ifndef PRIMITIVES_H
+#define PRIMITIVES_H
+
+#include <vector>
+#include <cstddef>
+#include <functional>
+
+// Shapes the primitive generator can build. All of them fit the unit cube centered at the origin.
+enum Primitive_Type {
+    PRIMITIVE_CUBE,
+    PRIMITIVE_UV_SPHERE,
+    PRIMITIVE_ICO_SPHERE,
+    PRIMITIVE_CYLINDER,
+    PRIMITIVE_CONE,
+    PRIMITIVE_TORUS,
+    PRIMITIVE_PLANE,
+    PRIMITIVE_TYPE_COUNT
+};
+
+const char* PrimitiveTypeName(Primitive_Type type);
+
+// Parameters identifying one generated mesh; two equal descriptions always produce the same mesh,
+// so the description doubles as the key of the shared mesh pool
+struct PrimitiveDesc
+{
+    Primitive_Type Type = PRIMITIVE_CUBE;
+    int Segments = 1;           // divisions around the main axis (sphere longitude, cylinder/cone/torus ring)
+    int Rings = 1;              // sphere latitude bands, torus tube divisions, plane subdivisions, ico sphere subdivision level
+    float MinorRadius = 0.0f;   // torus tube radius
+
+    static PrimitiveDesc Cube();
+    static PrimitiveDesc UVSphere(int segments = 30, int rings = 30);
+    static PrimitiveDesc IcoSphere(int subdivisions = 2);
+    static PrimitiveDesc Cylinder(int segments = 32);
+    static PrimitiveDesc Cone(int segments = 32);
+    static PrimitiveDesc Torus(int segments = 48, int rings = 16, float minorRadius = 0.15f);
+    static PrimitiveDesc Plane(int subdivisions = 1);
+    // default parameters for a shape type
+    static PrimitiveDesc Default(Primitive_Type type);
+
+    bool operator==(const PrimitiveDesc& other) const
+    {
+        return Type == other.Type && Segments == other.Segments && Rings == other.Rings && MinorRadius == other.MinorRadius;
+    }
+};
+
+struct PrimitiveDescHash
+{
+    size_t operator()(const PrimitiveDesc& desc) const
+    {
+        size_t h = std::hash<int>()(desc.Type);
+        h = h * 31 + std::hash<int>()(desc.Segments);
+        h = h * 31 + std::hash<int>()(desc.Rings);
+        h = h * 31 + std::hash<float>()(desc.MinorRadius);
+        return h;
+    }
+};
+
+// Indexed triangle mesh on the CPU with interleaved vertices
+struct MeshData
+{
+    static const int STRIDE = 8; // position xyz, texture coordinates uv, normal xyz
+
+    std::vector<float> Vertices;
+    std::vector<unsigned int> Indices;
+
+    size_t VertexCount() const { return Vertices.size() / STRIDE; }
+
+    // appends a vertex with a zero normal and returns its index; ComputeNormals fills the normals in
+    unsigned int AddVertex(float x, float y, float z, float u, float v);
+    void AddTriangle(unsigned int a, unsigned int b, unsigned int c);
+
+    // vertex positions (xyz) with the copies made for uv seams and hard edges removed
+    std::vector<float> UniquePositions() const;
+};
+
+// Builds the indexed mesh for a description, computes its normals and runs OptimizeMesh on it
+MeshData GeneratePrimitive(const PrimitiveDesc& desc);
+
+// Area-weighted vertex normals. Vertices at the same position (split for uv seams or hard edges) share the
+// faces whose normals lie within smoothAngle degrees of their own, so seams stay smooth and creases stay sharp.
+void ComputeNormals(MeshData& mesh, float smoothAngle = 60.0f);
+
+// Welds identical vertices, reorders triangles for the post-transform vertex cache (Forsyth's algorithm)
+// and then reorders vertices by first use so fetches stay sequential
+void OptimizeMesh(MeshData& mesh);
+
+#endif
@@ -0,0 +1,116 @@
+#ifndef PROJECTION_H
+#define PROJECTION_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <cmath>
+#include <cstring>
+
+// Depth conventions the viewport can render with
+enum Depth_Mode {
+    DEPTH_STANDARD,     // OpenGL [-1, 1] clip depth, finite far plane, GL_LESS
+    DEPTH_REVERSE_Z     // [0, 1] clip depth via glClipControl, infinite far plane, GL_GREATER
+};
+
+// Builds an infinite-far perspective matrix that maps the near plane to depth 1 and infinity to depth 0.
+// Must be paired with glClipControl(GL_LOWER_LEFT, GL_ZERO_TO_ONE) and a floating-point depth buffer.
+inline glm::mat4 InfinitePerspectiveReverseZ(float fovy, float aspect, float zNear)
+{
+    float f = 1.0f / std::tan(fovy * 0.5f);
+    glm::mat4 result(0.0f);
+    result[0][0] = f / aspect;
+    result[1][1] = f;
+    result[2][3] = -1.0f;
+    result[3][2] = zNear;
+    return result;
+}
+
+// Returns true if the current context can remap clip depth, either as GL 4.5 core or through ARB_clip_control.
+// If only the extension is present, the entry point is resolved through the given loader.
+inline bool LoadClipControl(GLADloadproc load)
+{
+    if (GLAD_GL_VERSION_4_5 && glad_glClipControl)
+        return true;
+
+    GLint extensionCount = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+    for (GLint i = 0; i < extensionCount; ++i)
+    {
+        const char* name = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+        if (name && std::strcmp(name, "GL_ARB_clip_control") == 0)
+        {
+            glad_glClipControl = (PFNGLCLIPCONTROLPROC)load("glClipControl");
+            return glad_glClipControl != nullptr;
+        }
+    }
+    return false;
+}
+
+// Viewport projection state shared by rendering, picking and culling
+class Projection
+{
+public:
+    Depth_Mode Mode;
+    float Near;
+    float Far;      // ignored in reverse-Z mode, which has no far plane
+
+    Projection(Depth_Mode mode = DEPTH_STANDARD, float zNear = 0.1f, float zFar = 100.0f) : Mode(mode), Near(zNear), Far(zFar)
+    {
+    }
+
+    // returns the projection matrix for the given vertical field of view (radians) and aspect ratio
+    glm::mat4 GetMatrix(float fovy, float aspect) const
+    {
+        if (Mode == DEPTH_REVERSE_Z)
+            return InfinitePerspectiveReverseZ(fovy, aspect, Near);
+        return glm::perspective(fovy, aspect, Near, Far);
+    }
+
+    // NDC depth of the near plane, used when unprojecting screen positions into rays
+    float NearPlaneNdcZ() const
+    {
+        return Mode == DEPTH_REVERSE_Z ? 1.0f : -1.0f;
+    }
+
+    // applies clip range, depth clear value and depth comparison for this mode to the current context
+    void ApplyDepthState() const
+    {
+        if (Mode == DEPTH_REVERSE_Z)
+        {
+            glClipControl(GL_LOWER_LEFT, GL_ZERO_TO_ONE);
+            glClearDepth(0.0);
+            glDepthFunc(GL_GREATER);
+        }
+        else
+        {
+            if (glad_glClipControl)
+                glClipControl(GL_LOWER_LEFT, GL_NEGATIVE_ONE_TO_ONE);
+            glClearDepth(1.0);
+            glDepthFunc(GL_LESS);
+        }
+    }
+
+    // conservative view-space frustum test for a bounding sphere; the far plane is only tested in standard mode
+    bool IsSphereVisible(const glm::vec3& viewCenter, float radius, float fovy, float aspect) const
+    {
+        float depth = -viewCenter.z;
+        if (depth + radius < Near)
+            return false;
+        if (Mode == DEPTH_STANDARD && depth - radius > Far)
+            return false;
+
+        // side planes pass through the eye, so the test only needs the plane normals
+        float tanY = std::tan(fovy * 0.5f);
+        float tanX = tanY * aspect;
+        float invLenY = 1.0f / std::sqrt(1.0f + tanY * tanY);
+        float invLenX = 1.0f / std::sqrt(1.0f + tanX * tanX);
+        if ((std::abs(viewCenter.y) - depth * tanY) * invLenY > radius)
+            return false;
+        if ((std::abs(viewCenter.x) - depth * tanX) * invLenX > radius)
+            return false;
+        return true;
+    }
+};
+#endif
@@ -0,0 +1,36 @@
+#ifndef RAY_SAMPLING_H
+#define RAY_SAMPLING_H
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+// Helpers shared by the CPU ray tracers (path tracer preview, ambient occlusion baker)
+
+// PCG hash; seeding with a pixel, sample or vertex index gives each its own stream
+inline uint32_t HashRandom(uint32_t value)
+{
+    uint32_t state = value * 747796405u + 2891336453u;
+    uint32_t word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+    return (word >> 22u) ^ word;
+}
+
+// two unit vectors perpendicular to n and each other (Duff et al.)
+inline void Tangents(const glm::vec3& n, glm::vec3& t, glm::vec3& b)
+{
+    float sign = std::copysign(1.0f, n.z);
+    float a = -1.0f / (sign + n.z);
+    float c = n.x * n.y * a;
+    t = glm::vec3(1.0f + sign * n.x * n.x * a, sign * c, -sign * n.x);
+    b = glm::vec3(c, sign + n.y * n.y * a, -n.y);
+}
+
+// origin offset off a surface, growing with the distance from the world origin to stay above float precision
+inline float SurfaceOffset(const glm::vec3& point)
+{
+    return 1.0e-4f * std::max(1.0f, std::max(std::abs(point.x), std::max(std::abs(point.y), std::abs(point.z))));
+}
+
+#endif
@@ -0,0 +1,146 @@
+#ifndef REDRAW_H
+#define REDRAW_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+// Why a frame was rendered. Several reasons can be pending for the same frame.
+enum Redraw_Reason {
+    REDRAW_INPUT,       // window, mouse or keyboard event
+    REDRAW_CAMERA,      // the view changed during the last frame
+    REDRAW_SCENE,       // objects were edited outside of input handling
+    REDRAW_UI,          // ImGui needs more frames: an active widget, a blinking text cursor or a pending tooltip
+    REDRAW_ANIMATION,   // timeline playback, particles or a running script
+    REDRAW_ASYNC,       // work that finished off the main thread, e.g. automation requests
+    REDRAW_REASON_COUNT
+};
+
+const char* RedrawReasonName(Redraw_Reason reason);
+
+// CPU time used by all threads of the process, in seconds
+double ProcessCpuSeconds();
+// most physical memory the process has held at once, in bytes
+size_t ProcessPeakResidentBytes();
+
+// Decides when the main loop renders. In on-demand mode a frame is only rendered while a redraw is pending;
+// otherwise the loop sleeps in the window system's event wait until an event, a timed request or Wake() arrives.
+// Continuous mode renders every frame, as before. Times are in seconds on the caller's clock (glfwGetTime).
+class RedrawScheduler
+{
+public:
+    struct Stats
+    {
+        unsigned long long Frames = 0;
+        unsigned long long Wakeups = 0;                             // event waits that returned
+        unsigned long long ByReason[REDRAW_REASON_COUNT] = {};      // frames each reason was pending for
+        uint32_t LastReasons = 0;                                   // bit per Redraw_Reason of the last frame
+        // measured over windows of at least one second
+        double FramesPerSecond = 0.0;
+        double CpuPercent = 0.0;            // process CPU time / wall time of the last window, 100 = one core
+        double IdleCpuPercent = -1.0;       // the same for the last window without any frame; -1 until there was one
+    };
+
+    bool OnDemand = true;
+    unsigned int InputFrames = 3;   // frames rendered after an event; ImGui needs a few to settle hover and layout
+
+    // renders the next frames; frames > 1 keeps rendering after this one
+    void Request(Redraw_Reason reason, unsigned int frames = 1)
+    {
+        pendingReasons |= 1u << reason;
+        if (frames > pendingFrames)
+            pendingFrames = frames;
+    }
+
+    // renders one frame once seconds have passed, e.g. to blink a text cursor
+    void RequestAfter(Redraw_Reason reason, double seconds, double now)
+    {
+        double time = now + seconds;
+        if (deadline < 0.0 || time < deadline)
+        {
+            deadline = time;
+            deadlineReason = reason;
+        }
+    }
+
+    // requests a frame from any thread; the caller still has to wake the event wait (glfwPostEmptyEvent)
+    void Wake()
+    {
+        woken.store(true, std::memory_order_release);
+    }
+
+    // 0 when a frame should be rendered now, otherwise how long to wait for events; negative waits without a timeout
+    double GetWaitTimeout(double now)
+    {
+        if (woken.exchange(false, std::memory_order_acq_rel))
+            Request(REDRAW_ASYNC);
+        if (deadline >= 0.0 && deadline <= now)
+        {
+            Request(deadlineReason);
+            deadline = -1.0;
+        }
+        if (!OnDemand || pendingFrames > 0)
+            return 0.0;
+        return deadline >= 0.0 ? deadline - now : -1.0;
+    }
+
+    // call after returning from an event wait
+    void Waited(double now)
+    {
+        stats.Wakeups++;
+        sample(now);
+    }
+
+    // call after a frame was presented
+    void FrameRendered(double now)
+    {
+        stats.Frames++;
+        windowFrames++;
+        stats.LastReasons = pendingReasons;
+        for (int i = 0; i < REDRAW_REASON_COUNT; ++i)
+            if (pendingReasons & (1u << i))
+                stats.ByReason[i]++;
+        pendingReasons = 0;
+        if (pendingFrames > 0)
+            pendingFrames--;
+        sample(now);
+    }
+
+    const Stats& GetStats() const { return stats; }
+
+private:
+    std::atomic<bool> woken{ false };
+    unsigned int pendingFrames = 1;
+    uint32_t pendingReasons = 0;
+    double deadline = -1.0;
+    Redraw_Reason deadlineReason = REDRAW_UI;
+    Stats stats;
+
+    double windowStart = -1.0;
+    double windowCpu = 0.0;
+    unsigned long long windowFrames = 0;
+
+    // closes the measurement window once it spans a second
+    void sample(double now)
+    {
+        if (windowStart < 0.0)
+        {
+            windowStart = now;
+            windowCpu = ProcessCpuSeconds();
+            return;
+        }
+        double wall = now - windowStart;
+        if (wall < 1.0)
+            return;
+        double cpu = ProcessCpuSeconds();
+        stats.FramesPerSecond = windowFrames / wall;
+        stats.CpuPercent = 100.0 * (cpu - windowCpu) / wall;
+        if (windowFrames == 0)
+            stats.IdleCpuPercent = stats.CpuPercent;
+        windowStart = now;
+        windowCpu = cpu;
+        windowFrames = 0;
+    }
+};
+
+#endif
@@ -0,0 +1,236 @@
+#include "region_select.h"
+#include "simd.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace
+{
+    // objects per job
+    const size_t SELECT_GRAIN = 16384;
+    // lasso mask rows per job
+    const size_t ROW_GRAIN = 32;
+
+    // positions and scales of four objects, one component per register
+    struct ObjectLanes
+    {
+        Float4 PositionX, PositionY, PositionZ;
+        Float4 ScaleX, ScaleY, ScaleZ;
+        Float4 Radius;              // object space
+    };
+
+    // screen position and pixel radius of four bounding spheres; W <= 0 marks a sphere centered behind the camera
+    struct ProjectedLanes
+    {
+        float X[4];
+        float Y[4];
+        float Radius[4];
+        float W[4];
+    };
+
+    struct Projector
+    {
+        Float4 m[4][4];             // view-projection, m[column][row]
+        Float4 halfWidth, halfHeight;
+        Float4 radiusScale;         // pixels per world unit at distance 1
+
+        Projector(const glm::mat4& view, const glm::mat4& projection, const glm::vec2& viewportSize)
+        {
+            glm::mat4 viewProjection = projection * view;
+            for (int c = 0; c < 4; ++c)
+                for (int r = 0; r < 4; ++r)
+                    m[c][r] = Float4::Set1(viewProjection[c][r]);
+            halfWidth = Float4::Set1(0.5f * viewportSize.x);
+            halfHeight = Float4::Set1(0.5f * viewportSize.y);
+            radiusScale = Float4::Set1(projection[1][1] * 0.5f * viewportSize.y);
+        }
+
+        void Project(const ObjectLanes& lanes, ProjectedLanes& out) const
+        {
+            Float4 px = lanes.PositionX, py = lanes.PositionY, pz = lanes.PositionZ;
+            Float4 x = m[0][0] * px + m[1][0] * py + m[2][0] * pz + m[3][0];
+            Float4 y = m[0][1] * px + m[1][1] * py + m[2][1] * pz + m[3][1];
+            Float4 w = m[0][3] * px + m[1][3] * py + m[2][3] * pz + m[3][3];
+            w.Store(out.W);
+
+            // lanes behind the camera produce garbage here and are rejected by the caller through W
+            Float4 one = Float4::Set1(1.0f);
+            Float4 inverseW = one / w;
+            (halfWidth * (one + x * inverseW)).Store(out.X);
+            (halfHeight * (one - y * inverseW)).Store(out.Y);
+
+            Float4 sx = lanes.ScaleX, sy = lanes.ScaleY, sz = lanes.ScaleZ;
+            (Sqrt(sx * sx + sy * sy + sz * sz) * lanes.Radius * radiusScale * inverseW).Store(out.Radius);
+        }
+    };
+
+    // evaluated without branches; hits are too irregular for the branch predictor
+    inline bool overlapsRectangle(float x, float y, float radius, const SelectionRegion& region)
+    {
+        return (x + radius >= region.Min.x) & (x - radius <= region.Max.x) & (y + radius >= region.Min.y) & (y - radius <= region.Max.y);
+    }
+
+    void selectRange(const float* objects, const ObjectLayout& layout, const float* radii, size_t begin, size_t end, const Projector& projector,
+        const SelectionRegion& region, const RegionMask& mask, std::vector<uint32_t>& out)
+    {
+        const float nearW = 1e-4f;
+        bool lasso = region.Shape == REGION_LASSO;
+        ProjectedLanes projected;
+
+        // every candidate is written and the cursor only advances on a hit, so the loop has no data-dependent branch
+        out.resize(end - begin);
+        size_t written = 0;
+
+        for (size_t i = begin; i < end; i += 4)
+        {
+            // the last group repeats its final object to fill the unused lanes; gathering straight into registers
+            // avoids the store-forwarding stalls of staging the components through memory
+            size_t lanesUsed = std::min<size_t>(4, end - i);
+            size_t i1 = i + (lanesUsed > 1 ? 1 : 0);
+            size_t i2 = i + (lanesUsed > 2 ? 2 : lanesUsed - 1);
+            size_t i3 = i + lanesUsed - 1;
+            const float* o0 = objects + i * layout.Stride;
+            const float* o1 = objects + i1 * layout.Stride;
+            const float* o2 = objects + i2 * layout.Stride;
+            const float* o3 = objects + i3 * layout.Stride;
+            const size_t p = layout.PositionOffset;
+            const size_t s = layout.ScaleOffset;
+            ObjectLanes lanes;
+            lanes.PositionX = Float4::Set(o0[p], o1[p], o2[p], o3[p]);
+            lanes.PositionY = Float4::Set(o0[p + 1], o1[p + 1], o2[p + 1], o3[p + 1]);
+            lanes.PositionZ = Float4::Set(o0[p + 2], o1[p + 2], o2[p + 2], o3[p + 2]);
+            lanes.ScaleX = Float4::Set(o0[s], o1[s], o2[s], o3[s]);
+            lanes.ScaleY = Float4::Set(o0[s + 1], o1[s + 1], o2[s + 1], o3[s + 1]);
+            lanes.ScaleZ = Float4::Set(o0[s + 2], o1[s + 2], o2[s + 2], o3[s + 2]);
+            lanes.Radius = radii ? Float4::Set(radii[i], radii[i1], radii[i2], radii[i3]) : Float4::Set1(0.5f);
+            projector.Project(lanes, projected);
+
+            for (size_t k = 0; k < lanesUsed; ++k)
+            {
+                bool inFront = projected.W[k] > nearW;
+                bool hit = lasso ? inFront & mask.Contains(projected.X[k], projected.Y[k])
+                                 : inFront & overlapsRectangle(projected.X[k], projected.Y[k], projected.Radius[k], region);
+                out[written] = static_cast<uint32_t>(i + k);
+                written += hit;
+            }
+        }
+        out.resize(written);
+    }
+}
+
+SelectionRegion SelectionRegion::Rectangle(const glm::vec2& a, const glm::vec2& b)
+{
+    SelectionRegion region;
+    region.Shape = REGION_RECTANGLE;
+    region.Min = glm::min(a, b);
+    region.Max = glm::max(a, b);
+    return region;
+}
+
+SelectionRegion SelectionRegion::Lasso(const std::vector<glm::vec2>& points)
+{
+    SelectionRegion region;
+    region.Shape = REGION_LASSO;
+    region.Points = points;
+    if (!points.empty())
+    {
+        region.Min = region.Max = points[0];
+        for (const glm::vec2& point : points)
+        {
+            region.Min = glm::min(region.Min, point);
+            region.Max = glm::max(region.Max, point);
+        }
+    }
+    return region;
+}
+
+void RegionMask::Build(const SelectionRegion& region, const glm::vec2& viewportSize, JobSystem& jobs)
+{
+    lasso = false;
+    left = std::max(0, static_cast<int>(std::floor(region.Min.x)));
+    top = std::max(0, static_cast<int>(std::floor(region.Min.y)));
+    int right = std::min(static_cast<int>(viewportSize.x), static_cast<int>(std::ceil(region.Max.x)) + 1);
+    int bottom = std::min(static_cast<int>(viewportSize.y), static_cast<int>(std::ceil(region.Max.y)) + 1);
+    width = std::max(0, right - left);
+    height = std::max(0, bottom - top);
+    cells.clear();
+    if (region.Shape != REGION_LASSO)
+        return;
+    if (region.Points.size() < 3 || width == 0 || height == 0)
+    {
+        width = height = 0; // encloses nothing
+        return;
+    }
+
+    lasso = true;
+    rowBytes = (width + 7) / 8;
+    cells.assign(static_cast<size_t>(rowBytes) * height, 0);
+    const std::vector<glm::vec2>& points = region.Points;
+    jobs.ParallelFor(static_cast<size_t>(height), ROW_GRAIN, [&](size_t begin, size_t end)
+    {
+        std::vector<float> crossings;
+        for (size_t row = begin; row < end; ++row)
+        {
+            // x positions where the outline crosses this row's pixel centers; the spans between pairs are inside
+            float y = top + static_cast<float>(row) + 0.5f;
+            crossings.clear();
+            for (size_t i = 0, j = points.size() - 1; i < points.size(); j = i++)
+            {
+                const glm::vec2& a = points[j];
+                const glm::vec2& b = points[i];
+                if ((a.y <= y) != (b.y <= y))
+                    crossings.push_back(a.x + (y - a.y) / (b.y - a.y) * (b.x - a.x));
+            }
+            std::sort(crossings.begin(), crossings.end());
+
+            uint8_t* line = cells.data() + row * rowBytes;
+            for (size_t c = 0; c + 1 < crossings.size(); c += 2)
+            {
+                // pixels whose centers lie between the two crossings
+                int first = std::max(0, static_cast<int>(std::ceil(crossings[c] - 0.5f)) - left);
+                int last = std::min(width, static_cast<int>(std::ceil(crossings[c + 1] - 0.5f)) - left);
+                for (int x = first; x < last; ++x)
+                    line[x >> 3] |= static_cast<uint8_t>(1u << (x & 7));
+            }
+        }
+    });
+}
+
+void SelectObjectsInRegion(const float* objects, const ObjectLayout& layout, const float* radii, size_t count, const glm::mat4& view,
+    const glm::mat4& projection, const glm::vec2& viewportSize, const SelectionRegion& region, JobSystem& jobs, std::vector<uint32_t>& selected,
+    RegionSelectStats* stats)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    RegionMask mask;
+    if (region.Shape == REGION_LASSO)
+        mask.Build(region, viewportSize, jobs);
+    auto projectStart = std::chrono::high_resolution_clock::now();
+
+    // each chunk collects its hits separately; appending them in chunk order keeps the output sorted
+    Projector projector(view, projection, viewportSize);
+    size_t chunks = (count + SELECT_GRAIN - 1) / SELECT_GRAIN;
+    std::vector<std::vector<uint32_t>> hits(chunks);
+    jobs.ParallelFor(chunks, 1, [&](size_t begin, size_t end)
+    {
+        for (size_t chunk = begin; chunk < end; ++chunk)
+            selectRange(objects, layout, radii, chunk * SELECT_GRAIN, std::min(count, (chunk + 1) * SELECT_GRAIN), projector, region, mask, hits[chunk]);
+    });
+
+    size_t before = selected.size();
+    size_t total = before;
+    for (const std::vector<uint32_t>& chunkHits : hits)
+        total += chunkHits.size();
+    selected.reserve(total);
+    for (const std::vector<uint32_t>& chunkHits : hits)
+        selected.insert(selected.end(), chunkHits.begin(), chunkHits.end());
+
+    if (stats)
+    {
+        auto end = std::chrono::high_resolution_clock::now();
+        stats->Tested = count;
+        stats->Selected = selected.size() - before;
+        stats->MaskMs = std::chrono::duration<double, std::milli>(projectStart - start).count();
+        stats->ProjectMs = std::chrono::duration<double, std::milli>(end - projectStart).count();
+    }
+}
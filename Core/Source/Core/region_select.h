@@ -0,0 +1,81 @@
+#ifndef REGION_SELECT_H
+#define REGION_SELECT_H
+
+#include "selection.h"
+#include "job_system.h"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+enum Region_Shape {
+    REGION_RECTANGLE,
+    REGION_LASSO
+};
+
+// Screen-space area dragged out by the user, in window pixels with the origin at the top left
+struct SelectionRegion
+{
+    Region_Shape Shape = REGION_RECTANGLE;
+    glm::vec2 Min = glm::vec2(0.0f);    // rectangle corners, or the bounds of the lasso
+    glm::vec2 Max = glm::vec2(0.0f);
+    std::vector<glm::vec2> Points;      // lasso outline, implicitly closed
+
+    static SelectionRegion Rectangle(const glm::vec2& a, const glm::vec2& b);
+    static SelectionRegion Lasso(const std::vector<glm::vec2>& points);
+
+    // too small to be a drag rather than a click
+    bool IsEmpty() const { return Max.x - Min.x < 2.0f && Max.y - Min.y < 2.0f; }
+};
+
+// Pixel coverage of a region over its bounds, so testing a point against a lasso of any length is one lookup.
+// The coverage is stored as bits so the mask of a large lasso still fits in cache.
+// Rectangles need no mask; Contains answers from the bounds alone.
+class RegionMask
+{
+public:
+    // rasterizes the lasso with the even-odd rule at pixel centers, clipped to the viewport; rows are filled in parallel
+    void Build(const SelectionRegion& region, const glm::vec2& viewportSize, JobSystem& jobs);
+
+    // branch free apart from the shape, since it runs once per object with unpredictable outcomes
+    bool Contains(float x, float y) const
+    {
+        int px = static_cast<int>(x) - left;
+        int py = static_cast<int>(y) - top;
+        bool inside = (x >= 0.0f) & (y >= 0.0f) & (px >= 0) & (py >= 0) & (px < width) & (py < height);
+        if (!lasso)
+            return inside;
+        size_t cell = inside ? static_cast<size_t>(py) * rowBytes * 8 + px : 0;
+        return inside & ((cells[cell >> 3] >> (cell & 7) & 1) != 0);
+    }
+
+private:
+    bool lasso = false;     // cells hold the coverage; otherwise the bounds are the region
+    int left = 0;
+    int top = 0;
+    int width = 0;
+    int height = 0;
+    int rowBytes = 0;
+    std::vector<uint8_t> cells;     // one bit per pixel, rows padded to whole bytes so rows can be filled in parallel
+};
+
+struct RegionSelectStats
+{
+    size_t Tested = 0;
+    size_t Selected = 0;
+    double MaskMs = 0.0;
+    double ProjectMs = 0.0;
+};
+
+// Projects every object's bounding sphere (its position, radius radii[i] times the length of its scale, as used for
+// culling and picking) to the screen in batches of four and appends the indices of the hits to selected in increasing
+// order. radii holds each mesh's object-space radius; nullptr means 0.5, the extent of a unit primitive.
+// A rectangle takes objects whose projected sphere overlaps it, a lasso those whose projected center lies inside.
+// Objects behind the camera are never selected.
+void SelectObjectsInRegion(const float* objects, const ObjectLayout& layout, const float* radii, size_t count, const glm::mat4& view,
+    const glm::mat4& projection, const glm::vec2& viewportSize, const SelectionRegion& region, JobSystem& jobs, std::vector<uint32_t>& selected,
+    RegionSelectStats* stats = nullptr);
+
+#endif
@@ -0,0 +1,367 @@
+#include "scatter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <utility>
+
+namespace
+{
+    // samples per job; fixed so every sample gets the same random stream on any thread count
+    const size_t SAMPLE_GRAIN = 16384;
+    const uint64_t CELL_BITS = 20;
+    const uint64_t CELL_MASK = (1ull << CELL_BITS) - 1;
+
+    // splitmix64 stream, seeded per job from the settings seed and the job's first sample
+    struct Random
+    {
+        uint64_t State;
+
+        Random(uint32_t seed, size_t stream) : State((seed + 1ull) * 0x9E3779B97F4A7C15ull ^ (stream + 1ull) * 0xD1B54A32D192ED03ull)
+        {
+        }
+
+        uint64_t Next()
+        {
+            uint64_t z = (State += 0x9E3779B97F4A7C15ull);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            return z ^ (z >> 31);
+        }
+
+        // uniform in [0, 1)
+        float Uniform()
+        {
+            return static_cast<float>(Next() >> 40) * (1.0f / 16777216.0f);
+        }
+    };
+
+    double millisecondsSince(std::chrono::high_resolution_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+
+    // area-weighted point on the surface: pick a triangle by binary search over the running area sum, then a uniform point in it.
+    // surfacePoints, when given, receives the points before they are lifted off the surface.
+    void sampleRange(const ScatterSurface& surface, const ScatterSettings& settings, size_t begin, size_t end, ScatterInstance* output, glm::vec3* surfacePoints)
+    {
+        const float totalArea = surface.TotalArea();
+        const size_t lastTriangle = surface.TriangleCount() - 1;
+
+        Random random(settings.Seed, begin / SAMPLE_GRAIN);
+        for (size_t i = begin; i < end; ++i)
+        {
+            // a range can span several grains when the job system runs it in one call
+            if (i % SAMPLE_GRAIN == 0)
+                random = Random(settings.Seed, i / SAMPLE_GRAIN);
+
+            float target = random.Uniform() * totalArea;
+            size_t triangle = std::upper_bound(surface.CumulativeArea.begin(), surface.CumulativeArea.end(), target) - surface.CumulativeArea.begin();
+            const glm::vec3* corner = &surface.Corners[std::min(triangle, lastTriangle) * 3];
+
+            float r1 = std::sqrt(random.Uniform());
+            float r2 = random.Uniform();
+            glm::vec3 position = (1.0f - r1) * corner[0] + r1 * (1.0f - r2) * corner[1] + r1 * r2 * corner[2];
+            if (surfacePoints)
+                surfacePoints[i] = position;
+
+            float scale = settings.ScaleMin + (settings.ScaleMax - settings.ScaleMin) * random.Uniform();
+            if (settings.RestOnSurface)
+                position += glm::normalize(glm::cross(corner[1] - corner[0], corner[2] - corner[0])) * (0.5f * scale);
+
+            glm::vec4 color = glm::mix(settings.ColorA, settings.ColorB, random.Uniform());
+
+            ScatterInstance& instance = output[i];
+            instance.Position[0] = position.x;
+            instance.Position[1] = position.y;
+            instance.Position[2] = position.z;
+            instance.Scale[0] = instance.Scale[1] = instance.Scale[2] = scale;
+            instance.Color[0] = color.r;
+            instance.Color[1] = color.g;
+            instance.Color[2] = color.b;
+            instance.Color[3] = color.a;
+        }
+    }
+
+    // cell key: the parity phase in the top bits, then 20 bits per axis. Cells of one phase are at least
+    // two cells apart on some axis, so their 3x3x3 neighbourhoods never overlap and can be filtered concurrently.
+    uint64_t cellKey(uint64_t x, uint64_t y, uint64_t z)
+    {
+        uint64_t phase = (x & 1) | ((y & 1) << 1) | ((z & 1) << 2);
+        return (phase << (3 * CELL_BITS)) | (x << (2 * CELL_BITS)) | (y << CELL_BITS) | z;
+    }
+
+    // sorts key/sample pairs: chunks are sorted on jobs, then merged pairwise level by level
+    void parallelSort(std::vector<std::pair<uint64_t, uint32_t>>& entries, JobSystem& jobs)
+    {
+        const size_t grain = 1 << 16;
+        size_t chunks = (entries.size() + grain - 1) / grain;
+        jobs.ParallelFor(chunks, 1, [&](size_t begin, size_t end)
+        {
+            for (size_t chunk = begin; chunk < end; ++chunk)
+                std::sort(entries.begin() + chunk * grain, entries.begin() + std::min(entries.size(), (chunk + 1) * grain));
+        });
+
+        for (size_t width = grain; width < entries.size(); width *= 2)
+        {
+            size_t pairs = (entries.size() + 2 * width - 1) / (2 * width);
+            jobs.ParallelFor(pairs, 1, [&](size_t begin, size_t end)
+            {
+                for (size_t pair = begin; pair < end; ++pair)
+                {
+                    size_t first = pair * 2 * width;
+                    size_t middle = std::min(entries.size(), first + width);
+                    size_t last = std::min(entries.size(), first + 2 * width);
+                    std::inplace_merge(entries.begin() + first, entries.begin() + middle, entries.begin() + last);
+                }
+            });
+        }
+    }
+
+    // Poisson disk thinning over a uniform grid with cells at least one radius wide. The eight cell phases run one after
+    // another, the cells of one phase in parallel; inside a cell samples are tested in order against every sample already
+    // accepted in the 27 surrounding cells. Cells are two radii wide, which keeps the per-cell bookkeeping below the cost
+    // of the extra distance tests. keep receives 1 for every sample that survives.
+    void poissonFilter(const ScatterSurface& surface, const glm::vec3* samples, size_t count, float radius, JobSystem& jobs, std::vector<uint8_t>& keep)
+    {
+        glm::vec3 origin = surface.BoundsMin - glm::vec3(2.0f * radius);
+        glm::vec3 extent = surface.BoundsMax - surface.BoundsMin + glm::vec3(4.0f * radius);
+        float cellSize = std::max(2.0f * radius, std::max(extent.x, std::max(extent.y, extent.z)) / static_cast<float>(CELL_MASK - 2));
+        float inverseCell = 1.0f / cellSize;
+
+        auto cellOf = [&](const glm::vec3& sample, int axis)
+        {
+            float offset = (sample[axis] - origin[axis]) * inverseCell;
+            return static_cast<uint64_t>(std::clamp(offset, 1.0f, static_cast<float>(CELL_MASK - 1)));
+        };
+
+        // Sort samples by cell so every cell is one contiguous run, ordered by phase
+        std::vector<std::pair<uint64_t, uint32_t>> entries(count);
+        jobs.ParallelFor(count, SAMPLE_GRAIN, [&](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; ++i)
+                entries[i] = { cellKey(cellOf(samples[i], 0), cellOf(samples[i], 1), cellOf(samples[i], 2)), static_cast<uint32_t>(i) };
+        });
+        parallelSort(entries, jobs);
+
+        std::vector<glm::vec3> points(count);
+        jobs.ParallelFor(count, SAMPLE_GRAIN, [&](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; ++i)
+                points[i] = samples[entries[i].second];
+        });
+
+        // Runs of equal keys; runs are ordered by phase, then by cell
+        struct Run
+        {
+            uint64_t Key;
+            uint32_t Begin;
+            uint32_t End;
+        };
+        std::vector<Run> runs;
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (runs.empty() || runs.back().Key != entries[i].first)
+                runs.push_back({ entries[i].first, static_cast<uint32_t>(i), static_cast<uint32_t>(i) });
+            runs.back().End = static_cast<uint32_t>(i + 1);
+        }
+        auto runBefore = [](const Run& run, uint64_t key) { return run.Key < key; };
+
+        std::vector<uint8_t> accepted(count, 0);
+        const float radiusSquared = radius * radius;
+        size_t phaseBegin = 0;
+        for (uint64_t phase = 0; phase < 8; ++phase)
+        {
+            size_t phaseEnd = phaseBegin;
+            while (phaseEnd < runs.size() && (runs[phaseEnd].Key >> (3 * CELL_BITS)) == phase)
+                phaseEnd++;
+
+            jobs.ParallelFor(phaseEnd - phaseBegin, 1024, [&](size_t begin, size_t end)
+            {
+                // One cursor per neighbour offset. Every cell of this phase has its neighbour at that offset in the
+                // same other phase, and those keys grow with the cell key, so each cursor only ever moves forward.
+                size_t cursors[27];
+                bool started = false;
+
+                for (size_t run = phaseBegin + begin; run < phaseBegin + end; ++run)
+                {
+                    uint64_t key = runs[run].Key;
+                    uint64_t x = (key >> (2 * CELL_BITS)) & CELL_MASK;
+                    uint64_t y = (key >> CELL_BITS) & CELL_MASK;
+                    uint64_t z = key & CELL_MASK;
+
+                    // the neighbourhood does not change while this phase runs, so find it once per cell
+                    const Run* neighbours[27];
+                    int neighbourCount = 0;
+                    int offset = 0;
+                    for (uint64_t nx = x - 1; nx <= x + 1; ++nx)
+                        for (uint64_t ny = y - 1; ny <= y + 1; ++ny)
+                            for (uint64_t nz = z - 1; nz <= z + 1; ++nz, ++offset)
+                            {
+                                uint64_t neighbourKey = cellKey(nx, ny, nz);
+                                size_t& cursor = cursors[offset];
+                                if (!started)
+                                    cursor = std::lower_bound(runs.begin(), runs.end(), neighbourKey, runBefore) - runs.begin();
+                                while (cursor < runs.size() && runs[cursor].Key < neighbourKey)
+                                    cursor++;
+                                if (cursor < runs.size() && runs[cursor].Key == neighbourKey)
+                                    neighbours[neighbourCount++] = &runs[cursor];
+                            }
+                    started = true;
+
+                    for (uint32_t i = runs[run].Begin; i < runs[run].End; ++i)
+                    {
+                        bool free = true;
+                        for (int n = 0; n < neighbourCount && free; ++n)
+                        {
+                            for (uint32_t j = neighbours[n]->Begin; j < neighbours[n]->End; ++j)
+                            {
+                                if (!accepted[j])
+                                    continue;
+                                glm::vec3 delta = points[j] - points[i];
+                                if (glm::dot(delta, delta) < radiusSquared)
+                                {
+                                    free = false;
+                                    break;
+                                }
+                            }
+                        }
+                        accepted[i] = free;
+                    }
+                }
+            });
+            phaseBegin = phaseEnd;
+        }
+
+        keep.assign(count, 0);
+        jobs.ParallelFor(count, SAMPLE_GRAIN, [&](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; ++i)
+                keep[entries[i].second] = accepted[i];
+        });
+    }
+}
+
+ScatterSurface ScatterSurface::FromMesh(const MeshData& mesh, const glm::vec3& position, const glm::vec3& scale)
+{
+    ScatterSurface surface;
+    size_t triangles = mesh.Indices.size() / 3;
+    surface.Corners.reserve(triangles * 3);
+    surface.CumulativeArea.reserve(triangles);
+
+    float area = 0.0f;
+    for (size_t t = 0; t < triangles; ++t)
+    {
+        glm::vec3 corner[3];
+        for (int k = 0; k < 3; ++k)
+        {
+            const float* vertex = &mesh.Vertices[mesh.Indices[t * 3 + k] * MeshData::STRIDE];
+            corner[k] = position + glm::vec3(vertex[0], vertex[1], vertex[2]) * scale;
+            surface.Corners.push_back(corner[k]);
+        }
+        area += 0.5f * glm::length(glm::cross(corner[1] - corner[0], corner[2] - corner[0]));
+        surface.CumulativeArea.push_back(area);
+    }
+
+    if (!surface.Corners.empty())
+    {
+        surface.BoundsMin = surface.BoundsMax = surface.Corners[0];
+        for (const glm::vec3& corner : surface.Corners)
+        {
+            surface.BoundsMin = glm::min(surface.BoundsMin, corner);
+            surface.BoundsMax = glm::max(surface.BoundsMax, corner);
+        }
+    }
+    return surface;
+}
+
+ScatterSurface ScatterSurface::Plane(float halfSize, float height)
+{
+    ScatterSurface surface;
+    glm::vec3 a(-halfSize, height, -halfSize);
+    glm::vec3 b(-halfSize, height, halfSize);
+    glm::vec3 c(halfSize, height, halfSize);
+    glm::vec3 d(halfSize, height, -halfSize);
+    // wound so the normals point up
+    surface.Corners = { a, b, c, a, c, d };
+    float half = 2.0f * halfSize * halfSize;
+    surface.CumulativeArea = { half, 2.0f * half };
+    surface.BoundsMin = a;
+    surface.BoundsMax = c;
+    return surface;
+}
+
+float SuggestScatterDistance(const ScatterSurface& surface, size_t count)
+{
+    return count > 0 ? std::sqrt(surface.TotalArea() / static_cast<float>(count)) : 0.0f;
+}
+
+size_t ScatterInstances(const ScatterSurface& surface, const ScatterSettings& settings, JobSystem& jobs, ScatterInstance* output, ScatterStats* stats)
+{
+    ScatterStats local;
+    ScatterStats& result = stats ? *stats : local;
+    result = ScatterStats();
+    result.Samples = settings.Count;
+    if (settings.Count == 0 || surface.TotalArea() <= 0.0f)
+        return 0;
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    // White noise needs no filtering, so samples go straight to the output
+    if (settings.MinDistance <= 0.0f)
+    {
+        jobs.ParallelFor(settings.Count, SAMPLE_GRAIN, [&](size_t begin, size_t end)
+        {
+            sampleRange(surface, settings, begin, end, output, nullptr);
+        });
+        result.SampleMs = millisecondsSince(start);
+        result.Written = settings.Count;
+        return settings.Count;
+    }
+
+    // Blue noise is measured between the points on the surface, so instances of different sizes space out the same
+    std::vector<ScatterInstance> samples(settings.Count);
+    std::vector<glm::vec3> surfacePoints(settings.Count);
+    jobs.ParallelFor(settings.Count, SAMPLE_GRAIN, [&](size_t begin, size_t end)
+    {
+        sampleRange(surface, settings, begin, end, samples.data(), surfacePoints.data());
+    });
+    result.SampleMs = millisecondsSince(start);
+
+    start = std::chrono::high_resolution_clock::now();
+    std::vector<uint8_t> keep;
+    poissonFilter(surface, surfacePoints.data(), surfacePoints.size(), settings.MinDistance, jobs, keep);
+    result.FilterMs = millisecondsSince(start);
+
+    // Compact the survivors in sample order: count per chunk, prefix sum, then copy on jobs
+    start = std::chrono::high_resolution_clock::now();
+    size_t chunks = (samples.size() + SAMPLE_GRAIN - 1) / SAMPLE_GRAIN;
+    std::vector<size_t> offsets(chunks + 1, 0);
+    jobs.ParallelFor(chunks, 1, [&](size_t begin, size_t end)
+    {
+        for (size_t chunk = begin; chunk < end; ++chunk)
+        {
+            size_t last = std::min(samples.size(), (chunk + 1) * SAMPLE_GRAIN);
+            offsets[chunk + 1] = std::count(keep.begin() + chunk * SAMPLE_GRAIN, keep.begin() + last, 1);
+        }
+    });
+    for (size_t chunk = 0; chunk < chunks; ++chunk)
+        offsets[chunk + 1] += offsets[chunk];
+
+    jobs.ParallelFor(chunks, 1, [&](size_t begin, size_t end)
+    {
+        for (size_t chunk = begin; chunk < end; ++chunk)
+        {
+            ScatterInstance* target = output + offsets[chunk];
+            size_t last = std::min(samples.size(), (chunk + 1) * SAMPLE_GRAIN);
+            for (size_t i = chunk * SAMPLE_GRAIN; i < last; ++i)
+            {
+                if (keep[i])
+                    *target++ = samples[i];
+            }
+        }
+    });
+    result.WriteMs = millisecondsSince(start);
+    result.Written = offsets[chunks];
+    return result.Written;
+}
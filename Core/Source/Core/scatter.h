@@ -0,0 +1,67 @@
+#ifndef SCATTER_H
+#define SCATTER_H
+
+#include "primitives.h"
+#include "job_system.h"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// One scattered instance exactly as it is stored in an instance buffer (per-instance attributes 3, 4 and 5)
+struct ScatterInstance
+{
+    float Position[3];
+    float Scale[3];
+    float Color[4];
+};
+
+// World-space triangles to scatter over, with the running sum of their areas for area-weighted triangle selection
+struct ScatterSurface
+{
+    std::vector<glm::vec3> Corners;     // three per triangle
+    std::vector<float> CumulativeArea;  // area of all triangles up to and including this one
+    glm::vec3 BoundsMin = glm::vec3(0.0f);
+    glm::vec3 BoundsMax = glm::vec3(0.0f);
+
+    size_t TriangleCount() const { return CumulativeArea.size(); }
+    float TotalArea() const { return CumulativeArea.empty() ? 0.0f : CumulativeArea.back(); }
+
+    // the mesh placed at position with the given scale, as objects are drawn
+    static ScatterSurface FromMesh(const MeshData& mesh, const glm::vec3& position, const glm::vec3& scale);
+    // a horizontal square from -halfSize to halfSize on X and Z
+    static ScatterSurface Plane(float halfSize, float height);
+};
+
+struct ScatterSettings
+{
+    size_t Count = 100000;              // samples drawn; blue-noise rejection keeps a subset of them
+    float MinDistance = 0.0f;           // Poisson disk radius; 0 keeps every sample (white noise)
+    uint32_t Seed = 1;
+    float ScaleMin = 0.05f;
+    float ScaleMax = 0.15f;
+    glm::vec4 ColorA = glm::vec4(0.25f, 0.55f, 0.2f, 1.0f);    // each instance gets a random mix of the two colors
+    glm::vec4 ColorB = glm::vec4(0.6f, 0.75f, 0.3f, 1.0f);
+    bool RestOnSurface = true;          // lift each instance by half its size along the surface normal
+};
+
+struct ScatterStats
+{
+    size_t Samples = 0;
+    size_t Written = 0;
+    double SampleMs = 0.0;
+    double FilterMs = 0.0;
+    double WriteMs = 0.0;
+};
+
+// Poisson disk radius at which rejection keeps roughly 40% of count samples on the surface
+float SuggestScatterDistance(const ScatterSurface& surface, size_t count);
+
+// Draws settings.Count area-weighted samples on parallel jobs, thins them to a Poisson disk set when MinDistance > 0
+// and writes the survivors to output, which must have room for settings.Count instances (e.g. a mapped instance buffer).
+// The result depends only on the settings, not on the number of threads. Returns the number of instances written.
+size_t ScatterInstances(const ScatterSurface& surface, const ScatterSettings& settings, JobSystem& jobs, ScatterInstance* output, ScatterStats* stats = nullptr);
+
+#endif
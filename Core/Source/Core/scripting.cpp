@@ -0,0 +1,539 @@
+#include "scripting.h"
+
+#ifdef MIXERGL_WITH_LUA
+#include <lua/lua.hpp>
+#endif
+
+#include <algorithm>
+#include <cstdint>
+
+const char* ScriptStatusName(Script_Status status)
+{
+    switch (status)
+    {
+    case SCRIPT_IDLE: return "Idle";
+    case SCRIPT_RUNNING: return "Running";
+    case SCRIPT_FINISHED: return "Finished";
+    case SCRIPT_FAILED: return "Failed";
+    default: return "Unknown";
+    }
+}
+
+void ScriptRuntime::Bind(const ScriptScene& boundScene)
+{
+    scene = boundScene;
+    registerApi();
+}
+
+void ScriptRuntime::ResetApiStats()
+{
+    for (ApiStats& stats : apiStats)
+    {
+        stats.Calls = 0;
+        stats.Elements = 0;
+        stats.Ms = 0.0;
+    }
+}
+
+#ifndef MIXERGL_WITH_LUA
+
+ScriptRuntime::ScriptRuntime()
+{
+}
+
+ScriptRuntime::~ScriptRuntime()
+{
+}
+
+bool ScriptRuntime::IsAvailable()
+{
+    return false;
+}
+
+bool ScriptRuntime::Run(const std::string& name, const std::string& /*source*/)
+{
+    profile = Profile();
+    profile.Name = name;
+    profile.Status = SCRIPT_FAILED;
+    profile.Error = "This build has no Lua runtime (MIXERGL_WITH_LUA is not defined)";
+    return false;
+}
+
+void ScriptRuntime::Stop()
+{
+}
+
+void ScriptRuntime::Update()
+{
+}
+
+void ScriptRuntime::registerApi()
+{
+}
+
+#else
+
+namespace
+{
+    // indices into ScriptRuntime::apiStats
+    enum Api_Function {
+        API_GET,
+        API_SET,
+        API_FILL,
+        API_OFFSET,
+        API_MULTIPLY,
+        API_RANDOM,
+        API_GRID,
+        API_COPY,
+        API_CREATE,
+        API_FUNCTION_COUNT
+    };
+
+    const char* API_NAMES[API_FUNCTION_COUNT] = { "get", "set", "fill", "offset", "multiply", "random", "grid", "copy", "create" };
+
+    const char* VIEW_METATABLE = "MixerGL.View";
+
+    // the userdata behind scene.positions, scene.scales and scene.colors
+    struct ScriptView
+    {
+        size_t Offset;      // float offset of the field inside an object
+        int Components;
+    };
+
+    const int HOOK_INSTRUCTIONS = 1000;  // instructions between budget checks
+
+    uint32_t hashIndex(uint32_t x)
+    {
+        x ^= x >> 16;
+        x *= 0x7feb352du;
+        x ^= x >> 15;
+        x *= 0x846ca68bu;
+        x ^= x >> 16;
+        return x;
+    }
+}
+
+// Lua entry points; a friend so they can reach the runtime's scene and statistics
+struct ScriptApi
+{
+    static ScriptRuntime& runtime(lua_State* L)
+    {
+        return **static_cast<ScriptRuntime**>(lua_getextraspace(L));
+    }
+
+    // records calls, touched objects and time of one API function for the profiler
+    struct Timer
+    {
+        ScriptRuntime::ApiStats& stats;
+        size_t elements;
+        std::chrono::steady_clock::time_point start;
+
+        Timer(lua_State* L, Api_Function function, size_t elements)
+            : stats(runtime(L).apiStats[function]), elements(elements), start(std::chrono::steady_clock::now())
+        {
+        }
+
+        ~Timer()
+        {
+            stats.Calls++;
+            stats.Elements += elements;
+            stats.Ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+    };
+
+    // checks the view argument and the [first, first + count) range; errors before any C++ object is alive
+    static ScriptView* checkRange(lua_State* L, size_t& first, size_t& count)
+    {
+        ScriptView* view = static_cast<ScriptView*>(luaL_checkudata(L, 1, VIEW_METATABLE));
+        lua_Integer firstArg = luaL_checkinteger(L, 2);
+        lua_Integer countArg = luaL_checkinteger(L, 3);
+        lua_Integer size = static_cast<lua_Integer>(runtime(L).scene.Count());
+        luaL_argcheck(L, firstArg >= 0 && firstArg <= size, 2, "first index out of range");
+        luaL_argcheck(L, countArg >= 0 && countArg <= size - firstArg, 3, "count out of range");
+        first = static_cast<size_t>(firstArg);
+        count = static_cast<size_t>(countArg);
+        return view;
+    }
+
+    static ScriptView* checkIndex(lua_State* L, size_t& index)
+    {
+        ScriptView* view = static_cast<ScriptView*>(luaL_checkudata(L, 1, VIEW_METATABLE));
+        lua_Integer indexArg = luaL_checkinteger(L, 2);
+        luaL_argcheck(L, indexArg >= 0 && indexArg < static_cast<lua_Integer>(runtime(L).scene.Count()), 2, "index out of range");
+        index = static_cast<size_t>(indexArg);
+        return view;
+    }
+
+    // reads one value per component starting at argument arg; colors default their alpha to 1
+    static void checkValues(lua_State* L, const ScriptView* view, int arg, float* values, float fallback)
+    {
+        for (int c = 0; c < view->Components; ++c)
+        {
+            bool optional = view->Components == 4 && c == 3;
+            values[c] = static_cast<float>(optional ? luaL_optnumber(L, arg + c, fallback) : luaL_checknumber(L, arg + c));
+        }
+    }
+
+    static float* element(lua_State* L, const ScriptView* view, size_t index)
+    {
+        const ScriptScene& scene = runtime(L).scene;
+        return scene.Data() + index * scene.Stride + view->Offset;
+    }
+
+    static size_t stride(lua_State* L)
+    {
+        return runtime(L).scene.Stride;
+    }
+
+    // view:get(i) -> components of object i
+    static int get(lua_State* L)
+    {
+        size_t index;
+        ScriptView* view = checkIndex(L, index);
+        Timer timer(L, API_GET, 1);
+        const float* values = element(L, view, index);
+        for (int c = 0; c < view->Components; ++c)
+            lua_pushnumber(L, values[c]);
+        return view->Components;
+    }
+
+    // view:set(i, x, y, z[, w])
+    static int set(lua_State* L)
+    {
+        size_t index;
+        ScriptView* view = checkIndex(L, index);
+        float values[4];
+        checkValues(L, view, 3, values, 1.0f);
+        Timer timer(L, API_SET, 1);
+        std::copy(values, values + view->Components, element(L, view, index));
+        return 0;
+    }
+
+    // view:fill(first, count, x, y, z[, w]) sets every object in the range to the same value
+    static int fill(lua_State* L)
+    {
+        size_t first, count;
+        ScriptView* view = checkRange(L, first, count);
+        float values[4];
+        checkValues(L, view, 4, values, 1.0f);
+        Timer timer(L, API_FILL, count);
+        float* target = element(L, view, first);
+        for (size_t i = 0; i < count; ++i, target += stride(L))
+            std::copy(values, values + view->Components, target);
+        return 0;
+    }
+
+    // view:offset(first, count, dx, dy, dz[, dw]) adds to every object in the range
+    static int offset(lua_State* L)
+    {
+        size_t first, count;
+        ScriptView* view = checkRange(L, first, count);
+        float values[4];
+        checkValues(L, view, 4, values, 0.0f);
+        Timer timer(L, API_OFFSET, count);
+        float* target = element(L, view, first);
+        for (size_t i = 0; i < count; ++i, target += stride(L))
+        {
+            for (int c = 0; c < view->Components; ++c)
+                target[c] += values[c];
+        }
+        return 0;
+    }
+
+    // view:multiply(first, count, sx, sy, sz[, sw]) scales every object in the range per component
+    static int multiply(lua_State* L)
+    {
+        size_t first, count;
+        ScriptView* view = checkRange(L, first, count);
+        float values[4];
+        checkValues(L, view, 4, values, 1.0f);
+        Timer timer(L, API_MULTIPLY, count);
+        float* target = element(L, view, first);
+        for (size_t i = 0; i < count; ++i, target += stride(L))
+        {
+            for (int c = 0; c < view->Components; ++c)
+                target[c] *= values[c];
+        }
+        return 0;
+    }
+
+    // view:random(first, count, min, max[, seed]) fills each component with a uniform value in [min, max]
+    static int random(lua_State* L)
+    {
+        size_t first, count;
+        ScriptView* view = checkRange(L, first, count);
+        float low = static_cast<float>(luaL_checknumber(L, 4));
+        float high = static_cast<float>(luaL_checknumber(L, 5));
+        uint32_t seed = static_cast<uint32_t>(luaL_optinteger(L, 6, 1));
+        Timer timer(L, API_RANDOM, count);
+        float* target = element(L, view, first);
+        for (size_t i = first; i < first + count; ++i, target += stride(L))
+        {
+            for (int c = 0; c < view->Components; ++c)
+            {
+                uint32_t bits = hashIndex(seed * 0x9E3779B9u ^ static_cast<uint32_t>(i * 4 + c));
+                target[c] = low + (high - low) * (bits * (1.0f / 4294967295.0f));
+            }
+        }
+        return 0;
+    }
+
+    // view:grid(first, count, columns, spacing) lays the range out on the XZ plane, keeping Y
+    static int grid(lua_State* L)
+    {
+        size_t first, count;
+        ScriptView* view = checkRange(L, first, count);
+        lua_Integer columns = luaL_checkinteger(L, 4);
+        float spacing = static_cast<float>(luaL_checknumber(L, 5));
+        luaL_argcheck(L, columns > 0, 4, "columns must be positive");
+        luaL_argcheck(L, view->Components >= 3, 1, "grid needs a view with at least three components");
+        Timer timer(L, API_GRID, count);
+        float* target = element(L, view, first);
+        for (size_t i = 0; i < count; ++i, target += stride(L))
+        {
+            target[0] = spacing * static_cast<float>(i % columns);
+            target[2] = -spacing * static_cast<float>(i / columns);
+        }
+        return 0;
+    }
+
+    // view:copy(first, count, source, sourceFirst) copies a range from another view with the same component count
+    static int copy(lua_State* L)
+    {
+        size_t first, count;
+        ScriptView* view = checkRange(L, first, count);
+        ScriptView* source = static_cast<ScriptView*>(luaL_checkudata(L, 4, VIEW_METATABLE));
+        lua_Integer sourceFirst = luaL_checkinteger(L, 5);
+        luaL_argcheck(L, source->Components == view->Components, 4, "component counts differ");
+        luaL_argcheck(L, sourceFirst >= 0 && static_cast<size_t>(sourceFirst) + count <= runtime(L).scene.Count(), 5, "source range out of range");
+        Timer timer(L, API_COPY, count);
+        const float* from = element(L, source, sourceFirst);
+        float* target = element(L, view, first);
+        for (size_t i = 0; i < count; ++i, from += stride(L), target += stride(L))
+            std::copy(from, from + view->Components, target);
+        return 0;
+    }
+
+    // #view -> number of objects
+    static int length(lua_State* L)
+    {
+        luaL_checkudata(L, 1, VIEW_METATABLE);
+        lua_pushinteger(L, static_cast<lua_Integer>(runtime(L).scene.Count()));
+        return 1;
+    }
+
+    // scene.count()
+    static int count(lua_State* L)
+    {
+        lua_pushinteger(L, static_cast<lua_Integer>(runtime(L).scene.Count()));
+        return 1;
+    }
+
+    // scene.create(primitive, count) -> first index; primitive is "cube", "uv_sphere", "ico_sphere", "cylinder", "cone", "torus" or "plane"
+    static int create(lua_State* L)
+    {
+        const char* primitive = luaL_checkstring(L, 1);
+        lua_Integer count = luaL_checkinteger(L, 2);
+        luaL_argcheck(L, count >= 0 && count <= 10000000, 2, "count out of range");
+        size_t first;
+        {
+            std::string name(primitive);
+            Timer timer(L, API_CREATE, static_cast<size_t>(count));
+            first = runtime(L).scene.Create(name, static_cast<size_t>(count));
+        }
+        if (first == static_cast<size_t>(-1))
+            return luaL_error(L, "unknown primitive '%s'", primitive);
+        lua_pushinteger(L, static_cast<lua_Integer>(first));
+        return 1;
+    }
+
+    // scene.select(index), -1 clears the selection
+    static int select(lua_State* L)
+    {
+        lua_Integer index = luaL_checkinteger(L, 1);
+        luaL_argcheck(L, index >= -1 && index < static_cast<lua_Integer>(runtime(L).scene.Count()), 1, "index out of range");
+        runtime(L).scene.Select(static_cast<int>(index));
+        return 0;
+    }
+
+    // print(...) goes to the editor console
+    static int print(lua_State* L)
+    {
+        int top = lua_gettop(L);
+        luaL_Buffer buffer;
+        luaL_buffinit(L, &buffer);
+        for (int i = 1; i <= top; ++i)
+        {
+            if (i > 1)
+                luaL_addchar(&buffer, '\t');
+            luaL_tolstring(L, i, nullptr);
+            luaL_addvalue(&buffer);
+        }
+        luaL_pushresult(&buffer);
+        std::string line = lua_tostring(L, -1);
+        lua_pop(L, 1);
+        if (runtime(L).scene.Log)
+            runtime(L).scene.Log("[script] " + line);
+        return 0;
+    }
+
+    // suspends the script once its frame budget is used up. Only the script's own coroutine is suspended, and only
+    // where it can yield: coroutines the script made inherit the hook and would see a spurious yield, and inside a
+    // C call such as a table.sort comparator the yield would raise an error. Both run on to the next hook that can.
+    static void hook(lua_State* L, lua_Debug*)
+    {
+        ScriptRuntime& self = runtime(L);
+        if (!self.deadlineHit && std::chrono::steady_clock::now() < self.deadline)
+            return;
+        self.deadlineHit = true;
+        if (L == self.thread && lua_isyieldable(L))
+            lua_yield(L, 0);
+    }
+
+    static void pushView(lua_State* L, size_t offset, int components)
+    {
+        ScriptView* view = static_cast<ScriptView*>(lua_newuserdata(L, sizeof(ScriptView)));
+        view->Offset = offset;
+        view->Components = components;
+        luaL_setmetatable(L, VIEW_METATABLE);
+    }
+};
+
+ScriptRuntime::ScriptRuntime()
+{
+    for (int i = 0; i < API_FUNCTION_COUNT; ++i)
+    {
+        ApiStats stats;
+        stats.Name = API_NAMES[i];
+        apiStats.push_back(stats);
+    }
+
+    state = luaL_newstate();
+    luaL_openlibs(state);
+    *static_cast<ScriptRuntime**>(lua_getextraspace(state)) = this; // copied into every coroutine
+}
+
+ScriptRuntime::~ScriptRuntime()
+{
+    lua_close(state);
+}
+
+bool ScriptRuntime::IsAvailable()
+{
+    return true;
+}
+
+// publishes the scene table with the typed views and their metatable
+void ScriptRuntime::registerApi()
+{
+    static const luaL_Reg viewMethods[] = {
+        { "get", ScriptApi::get },
+        { "set", ScriptApi::set },
+        { "fill", ScriptApi::fill },
+        { "offset", ScriptApi::offset },
+        { "multiply", ScriptApi::multiply },
+        { "random", ScriptApi::random },
+        { "grid", ScriptApi::grid },
+        { "copy", ScriptApi::copy },
+        { nullptr, nullptr }
+    };
+    static const luaL_Reg sceneFunctions[] = {
+        { "count", ScriptApi::count },
+        { "create", ScriptApi::create },
+        { "select", ScriptApi::select },
+        { nullptr, nullptr }
+    };
+
+    luaL_newmetatable(state, VIEW_METATABLE);
+    lua_newtable(state);
+    luaL_setfuncs(state, viewMethods, 0);
+    lua_setfield(state, -2, "__index");
+    lua_pushcfunction(state, ScriptApi::length);
+    lua_setfield(state, -2, "__len");
+    lua_pop(state, 1);
+
+    lua_newtable(state);
+    luaL_setfuncs(state, sceneFunctions, 0);
+    ScriptApi::pushView(state, scene.PositionOffset, 3);
+    lua_setfield(state, -2, "positions");
+    ScriptApi::pushView(state, scene.ScaleOffset, 3);
+    lua_setfield(state, -2, "scales");
+    ScriptApi::pushView(state, scene.ColorOffset, 4);
+    lua_setfield(state, -2, "colors");
+    lua_setglobal(state, "scene");
+
+    lua_pushcfunction(state, ScriptApi::print);
+    lua_setglobal(state, "print");
+}
+
+bool ScriptRuntime::Run(const std::string& name, const std::string& source)
+{
+    Stop();
+    lua_settop(state, 0);
+
+    profile = Profile();
+    profile.Name = name;
+
+    thread = lua_newthread(state);
+    threadRef = luaL_ref(state, LUA_REGISTRYINDEX); // keeps the coroutine alive between frames
+    if (luaL_loadbuffer(thread, source.data(), source.size(), ("=" + name).c_str()) != LUA_OK)
+    {
+        profile.Status = SCRIPT_FAILED;
+        profile.Error = lua_tostring(thread, -1);
+        Stop();
+        return false;
+    }
+    lua_sethook(thread, ScriptApi::hook, LUA_MASKCOUNT, HOOK_INSTRUCTIONS);
+    profile.Status = SCRIPT_RUNNING;
+    return true;
+}
+
+void ScriptRuntime::Stop()
+{
+    if (threadRef >= 0)
+        luaL_unref(state, LUA_REGISTRYINDEX, threadRef);
+    threadRef = -1;
+    thread = nullptr;
+    if (profile.Status == SCRIPT_RUNNING)
+        profile.Status = SCRIPT_IDLE;
+}
+
+void ScriptRuntime::Update()
+{
+    if (profile.Status != SCRIPT_RUNNING)
+        return;
+
+    auto start = std::chrono::steady_clock::now();
+    deadline = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<float, std::milli>(BudgetMs));
+    deadlineHit = false;
+
+    int results = 0;
+    int status = lua_resume(thread, state, 0, &results);
+
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    profile.Frames++;
+    profile.LastFrameMs = ms;
+    profile.TotalMs += ms;
+    profile.MaxFrameMs = std::max(profile.MaxFrameMs, ms);
+    if (status == LUA_YIELD)
+    {
+        if (deadlineHit)
+            profile.BudgetYields++;
+        lua_pop(thread, results); // values passed to coroutine.yield are ignored
+        return;
+    }
+
+    if (status == LUA_OK)
+    {
+        profile.Status = SCRIPT_FINISHED;
+    }
+    else
+    {
+        profile.Status = SCRIPT_FAILED;
+        const char* message = lua_tostring(thread, -1);
+        profile.Error = message ? message : "unknown error";
+    }
+    Stop();
+}
+
+#endif
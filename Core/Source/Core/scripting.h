@@ -0,0 +1,105 @@
+#ifndef SCRIPTING_H
+#define SCRIPTING_H
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <chrono>
+#include <cstddef>
+
+struct lua_State;
+
+// The scene as scripts see it: one float array holding every object with a fixed stride,
+// plus the offsets of the per-object fields that scripts can address as typed views
+struct ScriptScene
+{
+    std::function<float*()> Data;       // start of the object array; fetched on every call since it may move
+    std::function<size_t()> Count;
+    size_t Stride = 0;                  // floats per object
+    size_t PositionOffset = 0;
+    size_t ScaleOffset = 0;
+    size_t ColorOffset = 0;
+    std::function<size_t(const std::string& primitive, size_t count)> Create; // returns the first new index
+    std::function<void(int)> Select;
+    std::function<void(const std::string&)> Log;
+};
+
+enum Script_Status {
+    SCRIPT_IDLE,
+    SCRIPT_RUNNING,     // started and not finished yet; resumed every frame
+    SCRIPT_FINISHED,
+    SCRIPT_FAILED
+};
+
+const char* ScriptStatusName(Script_Status status);
+
+// Embedded Lua runtime. A script runs as a coroutine that is resumed once per frame and is suspended by an
+// instruction hook when it exceeds the frame budget, so long scripts spread over frames instead of stalling the UI.
+// Scene data is exposed as typed views (scene.positions, scene.scales, scene.colors) whose range methods
+// work on the object array in place; one call covers any number of objects.
+// Core builds it against the vendored Lua 5.4 (Vendor/Lua) when its sources are present; built without MIXERGL_WITH_LUA
+// the runtime only reports that scripting is unavailable.
+class ScriptRuntime
+{
+public:
+    // time and volume spent in one scene API function
+    struct ApiStats
+    {
+        const char* Name;
+        unsigned long long Calls = 0;
+        unsigned long long Elements = 0;    // objects touched
+        double Ms = 0.0;
+    };
+
+    struct Profile
+    {
+        std::string Name;
+        Script_Status Status = SCRIPT_IDLE;
+        std::string Error;
+        unsigned int Frames = 0;            // frames the script has run in
+        unsigned int BudgetYields = 0;      // times the budget suspended it
+        double TotalMs = 0.0;
+        double LastFrameMs = 0.0;
+        double MaxFrameMs = 0.0;
+    };
+
+    float BudgetMs = 4.0f;  // script time allowed per frame
+
+    ScriptRuntime();
+    ~ScriptRuntime();
+
+    ScriptRuntime(const ScriptRuntime&) = delete;
+    ScriptRuntime& operator=(const ScriptRuntime&) = delete;
+
+    static bool IsAvailable();
+
+    void Bind(const ScriptScene& scene);
+
+    // compiles source and starts it on the next Update; a script already running is stopped. Returns false on compile errors.
+    bool Run(const std::string& name, const std::string& source);
+    void Stop();
+
+    // resumes the running script until it finishes, yields or runs out of budget
+    void Update();
+
+    bool IsRunning() const { return profile.Status == SCRIPT_RUNNING; }
+    const Profile& GetProfile() const { return profile; }
+    const std::vector<ApiStats>& GetApiStats() const { return apiStats; }
+    void ResetApiStats();
+
+private:
+    friend struct ScriptApi;
+
+    ScriptScene scene;
+    lua_State* state = nullptr;
+    lua_State* thread = nullptr;
+    int threadRef = -1;
+    Profile profile;
+    std::vector<ApiStats> apiStats;
+    std::chrono::steady_clock::time_point deadline;
+    bool deadlineHit = false;
+
+    void registerApi();
+};
+
+#endif
@@ -0,0 +1,139 @@
+#include "selection.h"
+#include "simd.h"
+
+#include <glm/gtc/quaternion.hpp>
+
+#include <algorithm>
+
+namespace
+{
+    // objects per job; small enough to spread a few hundred thousand objects over all workers
+    const size_t TRANSFORM_GRAIN = 8192;
+
+    void transformRange(float* objects, const ObjectLayout& layout, const uint32_t* indices, size_t count, const SelectionTransform& transform)
+    {
+        const glm::mat3& m = transform.Linear;
+        const glm::vec3 offset = transform.Pivot + transform.Translation;
+
+        // positions and scales are gathered into four-wide lanes, transformed together and scattered back
+        const Float4 m00 = Float4::Set1(m[0][0]), m01 = Float4::Set1(m[1][0]), m02 = Float4::Set1(m[2][0]);
+        const Float4 m10 = Float4::Set1(m[0][1]), m11 = Float4::Set1(m[1][1]), m12 = Float4::Set1(m[2][1]);
+        const Float4 m20 = Float4::Set1(m[0][2]), m21 = Float4::Set1(m[1][2]), m22 = Float4::Set1(m[2][2]);
+        const Float4 pivotX = Float4::Set1(transform.Pivot.x), pivotY = Float4::Set1(transform.Pivot.y), pivotZ = Float4::Set1(transform.Pivot.z);
+        const Float4 offsetX = Float4::Set1(offset.x), offsetY = Float4::Set1(offset.y), offsetZ = Float4::Set1(offset.z);
+        const Float4 factorX = Float4::Set1(transform.ScaleFactor.x), factorY = Float4::Set1(transform.ScaleFactor.y), factorZ = Float4::Set1(transform.ScaleFactor.z);
+        const Float4 minScale = Float4::Set1(transform.MinScale);
+
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4)
+        {
+            float lanes[6][4];
+            for (int k = 0; k < 4; ++k)
+            {
+                const float* object = objects + static_cast<size_t>(indices[i + k]) * layout.Stride;
+                for (int c = 0; c < 3; ++c)
+                {
+                    lanes[c][k] = object[layout.PositionOffset + c];
+                    lanes[3 + c][k] = object[layout.ScaleOffset + c];
+                }
+            }
+
+            Float4 rx = Float4::Load(lanes[0]) - pivotX;
+            Float4 ry = Float4::Load(lanes[1]) - pivotY;
+            Float4 rz = Float4::Load(lanes[2]) - pivotZ;
+            (m00 * rx + m01 * ry + m02 * rz + offsetX).Store(lanes[0]);
+            (m10 * rx + m11 * ry + m12 * rz + offsetY).Store(lanes[1]);
+            (m20 * rx + m21 * ry + m22 * rz + offsetZ).Store(lanes[2]);
+            Max(Float4::Load(lanes[3]) * factorX, minScale).Store(lanes[3]);
+            Max(Float4::Load(lanes[4]) * factorY, minScale).Store(lanes[4]);
+            Max(Float4::Load(lanes[5]) * factorZ, minScale).Store(lanes[5]);
+
+            for (int k = 0; k < 4; ++k)
+            {
+                float* object = objects + static_cast<size_t>(indices[i + k]) * layout.Stride;
+                for (int c = 0; c < 3; ++c)
+                {
+                    object[layout.PositionOffset + c] = lanes[c][k];
+                    object[layout.ScaleOffset + c] = lanes[3 + c][k];
+                }
+            }
+        }
+
+        for (; i < count; ++i)
+        {
+            float* object = objects + static_cast<size_t>(indices[i]) * layout.Stride;
+            float* position = object + layout.PositionOffset;
+            float* scale = object + layout.ScaleOffset;
+            glm::vec3 moved = m * (glm::vec3(position[0], position[1], position[2]) - transform.Pivot) + offset;
+            for (int c = 0; c < 3; ++c)
+            {
+                position[c] = moved[c];
+                float scaled = scale[c] * transform.ScaleFactor[c];
+                scale[c] = scaled > transform.MinScale ? scaled : transform.MinScale;
+            }
+        }
+    }
+}
+
+SelectionTransform SelectionTransform::Translate(const glm::vec3& offset)
+{
+    SelectionTransform transform;
+    transform.Translation = offset;
+    return transform;
+}
+
+SelectionTransform SelectionTransform::Rotate(const glm::vec3& pivot, const glm::vec3& axis, float radians)
+{
+    SelectionTransform transform;
+    transform.Pivot = pivot;
+    transform.Linear = glm::mat3_cast(glm::angleAxis(radians, glm::normalize(axis)));
+    return transform;
+}
+
+SelectionTransform SelectionTransform::Scale(const glm::vec3& pivot, const glm::vec3& factor, float minScale)
+{
+    SelectionTransform transform;
+    transform.Pivot = pivot;
+    transform.Linear = glm::mat3(glm::vec3(factor.x, 0.0f, 0.0f), glm::vec3(0.0f, factor.y, 0.0f), glm::vec3(0.0f, 0.0f, factor.z));
+    transform.ScaleFactor = factor;
+    transform.MinScale = minScale;
+    return transform;
+}
+
+void ApplySelectionTransform(float* objects, const ObjectLayout& layout, const std::vector<uint32_t>& indices, const SelectionTransform& transform, JobSystem& jobs)
+{
+    jobs.ParallelFor(indices.size(), TRANSFORM_GRAIN, [&](size_t begin, size_t end)
+    {
+        transformRange(objects, layout, indices.data() + begin, end - begin, transform);
+    });
+}
+
+glm::vec3 SelectionCentroid(const float* objects, const ObjectLayout& layout, const std::vector<uint32_t>& indices, JobSystem& jobs)
+{
+    if (indices.empty())
+        return glm::vec3(0.0f);
+
+    // one partial sum per chunk, added in chunk order so the result does not depend on scheduling
+    size_t chunks = (indices.size() + TRANSFORM_GRAIN - 1) / TRANSFORM_GRAIN;
+    std::vector<glm::dvec3> sums(chunks, glm::dvec3(0.0));
+    jobs.ParallelFor(chunks, 1, [&](size_t begin, size_t end)
+    {
+        for (size_t chunk = begin; chunk < end; ++chunk)
+        {
+            size_t first = chunk * TRANSFORM_GRAIN;
+            size_t last = std::min(first + TRANSFORM_GRAIN, indices.size());
+            glm::dvec3 sum(0.0);
+            for (size_t i = first; i < last; ++i)
+            {
+                const float* position = objects + static_cast<size_t>(indices[i]) * layout.Stride + layout.PositionOffset;
+                sum += glm::dvec3(position[0], position[1], position[2]);
+            }
+            sums[chunk] = sum;
+        }
+    });
+
+    glm::dvec3 total(0.0);
+    for (const glm::dvec3& sum : sums)
+        total += sum;
+    return glm::vec3(total / static_cast<double>(indices.size()));
+}
@@ -0,0 +1,123 @@
+#ifndef SELECTION_H
+#define SELECTION_H
+
+#include "job_system.h"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <limits>
+#include <cstdint>
+#include <cstddef>
+
+// Set of selected object indices, kept twice: a dense bitset for constant-time membership tests while drawing
+// and picking, and a compact index list so per-selection work touches only the selected objects.
+// Objects may be added to the scene without resizing; indices past the bitset are simply not selected.
+class Selection
+{
+public:
+    bool Contains(size_t index) const
+    {
+        size_t word = index >> 6;
+        return word < bits.size() && (bits[word] >> (index & 63) & 1) != 0;
+    }
+
+    // returns false if the object was already selected
+    bool Add(size_t index)
+    {
+        if (Contains(index))
+            return false;
+        size_t word = index >> 6;
+        if (word >= bits.size())
+            bits.resize(word + 1, 0);
+        bits[word] |= uint64_t(1) << (index & 63);
+        indices.push_back(static_cast<uint32_t>(index));
+        return true;
+    }
+
+    // returns false if the object was not selected; the last index takes the removed one's place in the list
+    bool Remove(size_t index)
+    {
+        if (!Contains(index))
+            return false;
+        bits[index >> 6] &= ~(uint64_t(1) << (index & 63));
+        for (size_t i = 0; i < indices.size(); ++i)
+        {
+            if (indices[i] == index)
+            {
+                indices[i] = indices.back();
+                indices.pop_back();
+                break;
+            }
+        }
+        return true;
+    }
+
+    // returns whether the object is selected afterwards
+    bool Toggle(size_t index)
+    {
+        if (Remove(index))
+            return false;
+        Add(index);
+        return true;
+    }
+
+    // clears only the words holding selected bits, so clearing a small selection in a large scene stays cheap
+    void Clear()
+    {
+        for (uint32_t index : indices)
+            bits[index >> 6] = 0;
+        indices.clear();
+    }
+
+    void SelectAll(size_t objectCount)
+    {
+        bits.assign((objectCount + 63) >> 6, ~uint64_t(0));
+        if (objectCount & 63)
+            bits.back() = (uint64_t(1) << (objectCount & 63)) - 1;
+        indices.resize(objectCount);
+        for (size_t i = 0; i < objectCount; ++i)
+            indices[i] = static_cast<uint32_t>(i);
+    }
+
+    size_t Count() const { return indices.size(); }
+    bool Empty() const { return indices.empty(); }
+    const std::vector<uint32_t>& Indices() const { return indices; }
+
+private:
+    std::vector<uint64_t> bits;
+    std::vector<uint32_t> indices;  // in selection order
+};
+
+// Affine edit applied to every selected object around a shared pivot:
+// position' = Pivot + Linear * (position - Pivot) + Translation, scale' = max(scale * ScaleFactor, MinScale)
+struct SelectionTransform
+{
+    glm::vec3 Pivot = glm::vec3(0.0f);
+    glm::mat3 Linear = glm::mat3(1.0f);
+    glm::vec3 Translation = glm::vec3(0.0f);
+    glm::vec3 ScaleFactor = glm::vec3(1.0f);
+    float MinScale = std::numeric_limits<float>::lowest();  // Scale() raises this so objects cannot collapse
+
+    static SelectionTransform Translate(const glm::vec3& offset);
+    // radians around axis through pivot; objects have no orientation of their own, so only positions turn
+    static SelectionTransform Rotate(const glm::vec3& pivot, const glm::vec3& axis, float radians);
+    // scales both the object sizes and their distances to the pivot; no object gets smaller than minScale on any axis
+    static SelectionTransform Scale(const glm::vec3& pivot, const glm::vec3& factor, float minScale = 0.1f);
+};
+
+// Where position and scale live in an array of objects addressed as floats
+struct ObjectLayout
+{
+    size_t Stride = 0;          // floats per object
+    size_t PositionOffset = 0;
+    size_t ScaleOffset = 0;
+};
+
+// Applies transform to the listed objects in place, four at a time with SIMD, split across the job system
+void ApplySelectionTransform(float* objects, const ObjectLayout& layout, const std::vector<uint32_t>& indices, const SelectionTransform& transform, JobSystem& jobs);
+
+// Mean position of the listed objects; the origin for an empty list
+glm::vec3 SelectionCentroid(const float* objects, const ObjectLayout& layout, const std::vector<uint32_t>& indices, JobSystem& jobs);
+
+#endif
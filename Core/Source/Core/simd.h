@@ -0,0 +1,76 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+// Four-wide float vector used by the batched kernels. Maps onto SSE2 where the compiler targets it
+// (always the case on x64) and falls back to plain scalar code elsewhere.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MIXERGL_SIMD_SSE2 1
+#include <emmintrin.h>
+#else
+#include <cmath>
+#include <cstring>
+#include <cstdint>
+#endif
+
+struct Float4
+{
+#ifdef MIXERGL_SIMD_SSE2
+    __m128 v;
+
+    static Float4 Load(const float* p) { return { _mm_loadu_ps(p) }; }
+    static Float4 Set1(float x) { return { _mm_set1_ps(x) }; }
+    static Float4 Set(float a, float b, float c, float d) { return { _mm_setr_ps(a, b, c, d) }; }
+    void Store(float* p) const { _mm_storeu_ps(p, v); }
+
+    friend Float4 operator+(Float4 a, Float4 b) { return { _mm_add_ps(a.v, b.v) }; }
+    friend Float4 operator-(Float4 a, Float4 b) { return { _mm_sub_ps(a.v, b.v) }; }
+    friend Float4 operator*(Float4 a, Float4 b) { return { _mm_mul_ps(a.v, b.v) }; }
+    friend Float4 operator/(Float4 a, Float4 b) { return { _mm_div_ps(a.v, b.v) }; }
+    friend Float4 Sqrt(Float4 a) { return { _mm_sqrt_ps(a.v) }; }
+    friend Float4 Min(Float4 a, Float4 b) { return { _mm_min_ps(a.v, b.v) }; }
+    friend Float4 Max(Float4 a, Float4 b) { return { _mm_max_ps(a.v, b.v) }; }
+
+    // comparisons give masks: lanes with every bit set where true, clear where false
+    friend Float4 Less(Float4 a, Float4 b) { return { _mm_cmplt_ps(a.v, b.v) }; }
+    friend Float4 LessEqual(Float4 a, Float4 b) { return { _mm_cmple_ps(a.v, b.v) }; }
+    friend Float4 And(Float4 a, Float4 b) { return { _mm_and_ps(a.v, b.v) }; }
+    friend Float4 Or(Float4 a, Float4 b) { return { _mm_or_ps(a.v, b.v) }; }
+    // a where mask is set, b elsewhere
+    friend Float4 Select(Float4 mask, Float4 a, Float4 b) { return { _mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v)) }; }
+    // bit i set when lane i of mask is set
+    friend int MoveMask(Float4 mask) { return _mm_movemask_ps(mask.v); }
+#else
+    float v[4];
+
+    static Float4 Load(const float* p) { return { { p[0], p[1], p[2], p[3] } }; }
+    static Float4 Set1(float x) { return { { x, x, x, x } }; }
+    static Float4 Set(float a, float b, float c, float d) { return { { a, b, c, d } }; }
+    void Store(float* p) const { for (int i = 0; i < 4; ++i) p[i] = v[i]; }
+
+    friend Float4 operator+(Float4 a, Float4 b) { for (int i = 0; i < 4; ++i) a.v[i] += b.v[i]; return a; }
+    friend Float4 operator-(Float4 a, Float4 b) { for (int i = 0; i < 4; ++i) a.v[i] -= b.v[i]; return a; }
+    friend Float4 operator*(Float4 a, Float4 b) { for (int i = 0; i < 4; ++i) a.v[i] *= b.v[i]; return a; }
+    friend Float4 operator/(Float4 a, Float4 b) { for (int i = 0; i < 4; ++i) a.v[i] /= b.v[i]; return a; }
+    friend Float4 Sqrt(Float4 a) { for (int i = 0; i < 4; ++i) a.v[i] = std::sqrt(a.v[i]); return a; }
+    friend Float4 Min(Float4 a, Float4 b) { for (int i = 0; i < 4; ++i) a.v[i] = a.v[i] < b.v[i] ? a.v[i] : b.v[i]; return a; }
+    friend Float4 Max(Float4 a, Float4 b) { for (int i = 0; i < 4; ++i) a.v[i] = a.v[i] > b.v[i] ? a.v[i] : b.v[i]; return a; }
+
+    static float MaskLane(bool set) { uint32_t bits = set ? 0xFFFFFFFFu : 0u; float lane; std::memcpy(&lane, &bits, sizeof(lane)); return lane; }
+    static bool IsSet(float lane) { uint32_t bits; std::memcpy(&bits, &lane, sizeof(bits)); return (bits >> 31) != 0; }
+
+    friend Float4 Less(Float4 a, Float4 b) { for (int i = 0; i < 4; ++i) a.v[i] = MaskLane(a.v[i] < b.v[i]); return a; }
+    friend Float4 LessEqual(Float4 a, Float4 b) { for (int i = 0; i < 4; ++i) a.v[i] = MaskLane(a.v[i] <= b.v[i]); return a; }
+    friend Float4 And(Float4 a, Float4 b) { for (int i = 0; i < 4; ++i) a.v[i] = MaskLane(IsSet(a.v[i]) && IsSet(b.v[i])); return a; }
+    friend Float4 Or(Float4 a, Float4 b) { for (int i = 0; i < 4; ++i) a.v[i] = MaskLane(IsSet(a.v[i]) || IsSet(b.v[i])); return a; }
+    friend Float4 Select(Float4 mask, Float4 a, Float4 b) { for (int i = 0; i < 4; ++i) a.v[i] = IsSet(mask.v[i]) ? a.v[i] : b.v[i]; return a; }
+    friend int MoveMask(Float4 mask) { int bits = 0; for (int i = 0; i < 4; ++i) bits |= IsSet(mask.v[i]) ? 1 << i : 0; return bits; }
+#endif
+
+    // mask with lane i set where bit i of bits is
+    static Float4 FromBits(int bits)
+    {
+        Float4 lanes = Float4::Set(float(bits & 1), float(bits & 2), float(bits & 4), float(bits & 8));
+        return Less(Float4::Set1(0.0f), lanes);
+    }
+};
+#endif
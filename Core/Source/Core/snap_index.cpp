@@ -0,0 +1,255 @@
+#include "snap_index.h"
+
+#include <algorithm>
+#include <chrono>
+
+const char* SnapModeName(Snap_Mode mode)
+{
+    switch (mode)
+    {
+    case SNAP_OFF: return "Off";
+    case SNAP_GRID: return "Grid";
+    case SNAP_OBJECT: return "Object bounds";
+    case SNAP_VERTEX: return "Vertices";
+    default: return "Unknown";
+    }
+}
+
+void SpatialHash::Reset(float newCellSize)
+{
+    cellSize = newCellSize;
+    inverseCellSize = 1.0f / newCellSize;
+    points.clear();
+    freeIds.clear();
+    table.clear();
+    cellCount = 0;
+}
+
+uint32_t SpatialHash::Insert(const glm::vec3& position, uint32_t owner)
+{
+    uint32_t id;
+    if (!freeIds.empty())
+    {
+        id = freeIds.back();
+        freeIds.pop_back();
+    }
+    else
+    {
+        id = static_cast<uint32_t>(points.size());
+        points.push_back(Point());
+    }
+    points[id].Position = position;
+    points[id].Owner = owner;
+    link(id, keyOf(cellOf(position)));
+    return id;
+}
+
+void SpatialHash::Move(uint32_t id, const glm::vec3& position)
+{
+    Point& point = points[id];
+    point.Position = position;
+    uint64_t cell = keyOf(cellOf(position));
+    if (cell == point.Cell)
+        return;
+    unlink(id);
+    link(id, cell);
+}
+
+void SpatialHash::Erase(uint32_t id)
+{
+    unlink(id);
+    points[id].Owner = INVALID;
+    freeIds.push_back(id);
+}
+
+// pushes the point on the front of its cell's list, claiming a slot for the cell if it was empty
+void SpatialHash::link(uint32_t id, uint64_t cell)
+{
+    if ((cellCount + 1) * 2 > table.size())
+        grow();
+    size_t slot = home(cell);
+    while (table[slot].Key != cell && table[slot].Key != EMPTY)
+        slot = (slot + 1) & (table.size() - 1);
+    if (table[slot].Key == EMPTY)
+    {
+        table[slot].Key = cell;
+        table[slot].Head = INVALID;
+        cellCount++;
+    }
+
+    Point& point = points[id];
+    point.Cell = cell;
+    point.Previous = INVALID;
+    point.Next = table[slot].Head;
+    if (point.Next != INVALID)
+        points[point.Next].Previous = id;
+    table[slot].Head = id;
+}
+
+// takes the point out of its cell's list; the slot of a cell left empty is freed so the table only holds occupied cells
+void SpatialHash::unlink(uint32_t id)
+{
+    Point& point = points[id];
+    if (point.Next != INVALID)
+        points[point.Next].Previous = point.Previous;
+    if (point.Previous != INVALID)
+    {
+        points[point.Previous].Next = point.Next;
+        return;
+    }
+    size_t slot = find(point.Cell);
+    table[slot].Head = point.Next;
+    if (point.Next == INVALID)
+        removeSlot(slot);
+}
+
+// backward-shift deletion: later entries of the probe run move up so lookups never need tombstones
+void SpatialHash::removeSlot(size_t slot)
+{
+    size_t mask = table.size() - 1;
+    size_t hole = slot;
+    for (size_t next = (hole + 1) & mask; table[next].Key != EMPTY; next = (next + 1) & mask)
+    {
+        size_t ideal = home(table[next].Key);
+        // the entry may fill the hole only if its home is not cyclically within (hole, next]
+        if (((next - ideal) & mask) >= ((next - hole) & mask))
+        {
+            table[hole] = table[next];
+            hole = next;
+        }
+    }
+    table[hole].Key = EMPTY;
+    cellCount--;
+}
+
+void SpatialHash::grow()
+{
+    std::vector<Slot> old;
+    old.swap(table);
+    table.assign(old.empty() ? 1024 : old.size() * 2, Slot{ EMPTY, INVALID });
+    for (const Slot& entry : old)
+    {
+        if (entry.Key == EMPTY)
+            continue;
+        size_t slot = home(entry.Key);
+        while (table[slot].Key != EMPTY)
+            slot = (slot + 1) & (table.size() - 1);
+        table[slot] = entry;
+    }
+}
+
+void SnapIndex::clear()
+{
+    hash.Reset(hash.GetCellSize());
+    objects.clear();
+    next.clear();
+}
+
+// Cells near the snap radius keep a query to the 27 cells around it, and cells near the point spacing keep the
+// lists in them short; the larger of the two wins. The spacing is estimated from the summed volume of the objects'
+// bounds, with flat bounds thickened so planes do not come out with no volume. Returns whether the index was rebuilt.
+bool SnapIndex::fitCellSize(float radius)
+{
+    size_t count = hash.Size();
+    if (count == 0)
+        return false;
+    double volume = 0.0;
+    for (const Entry& entry : objects)
+    {
+        glm::vec3 extent = 2.0f * entry.Object.Radius * glm::abs(entry.Object.Scale);
+        float largest = std::max(extent.x, std::max(extent.y, extent.z));
+        extent = glm::max(extent, glm::vec3(largest * 0.01f));
+        volume += static_cast<double>(extent.x) * extent.y * extent.z;
+    }
+    float spacing = static_cast<float>(std::cbrt(volume / static_cast<double>(count)));
+    float target = std::max(std::max(std::sqrt(std::max(radius, 0.0f) * spacing), spacing), 1.0e-4f);
+
+    float cellSize = hash.GetCellSize();
+    if (cellSize <= target * 2.0f && cellSize >= target * 0.5f)
+        return false;
+
+    hash.Reset(target);
+    next.clear();
+    for (size_t i = 0; i < objects.size(); ++i)
+    {
+        Entry& entry = objects[i];
+        entry.Head = SpatialHash::INVALID;
+        entry.Count = 0;
+        SnapObject object = entry.Object;
+        updateObject(static_cast<uint32_t>(i), entry, object);
+    }
+    Stats.Rebuilds++;
+    return true;
+}
+
+void SnapIndex::eraseObject(Entry& entry)
+{
+    uint32_t id = entry.Head;
+    for (uint32_t i = 0; i < entry.Count; ++i)
+    {
+        uint32_t following = next[id];
+        hash.Erase(id);
+        id = following;
+    }
+    entry.Head = SpatialHash::INVALID;
+    entry.Count = 0;
+}
+
+// Recomputes the object's snap points and moves the existing ones in place when the point count is unchanged
+void SnapIndex::updateObject(uint32_t index, Entry& entry, const SnapObject& object)
+{
+    scratch.clear();
+    bool vertices = indexedMode == SNAP_VERTEX && object.Vertices != nullptr && !object.Vertices->empty() &&
+        ((entry.Head != SpatialHash::INVALID && entry.Vertices) || hash.Size() + object.Vertices->size() / 3 <= MaxPoints);
+    if (vertices)
+    {
+        const std::vector<float>& local = *object.Vertices;
+        for (size_t i = 0; i + 2 < local.size(); i += 3)
+            scratch.push_back(object.Position + object.Scale * glm::vec3(local[i], local[i + 1], local[i + 2]));
+    }
+    else
+    {
+        // corners of the cube the mesh's radius bounds, which for primitives is -0.5..0.5 in object space
+        glm::vec3 half = object.Radius * object.Scale;
+        scratch.push_back(object.Position);
+        for (int corner = 0; corner < 8; ++corner)
+        {
+            glm::vec3 sign((corner & 1) ? 1.0f : -1.0f, (corner & 2) ? 1.0f : -1.0f, (corner & 4) ? 1.0f : -1.0f);
+            scratch.push_back(object.Position + sign * half);
+        }
+    }
+
+    if (entry.Head != SpatialHash::INVALID && entry.Count == scratch.size())
+    {
+        uint32_t id = entry.Head;
+        for (const glm::vec3& point : scratch)
+        {
+            hash.Move(id, point);
+            id = next[id];
+        }
+    }
+    else
+    {
+        if (entry.Head != SpatialHash::INVALID)
+            eraseObject(entry);
+        // chained back to front so Head ends up at the first point
+        uint32_t following = SpatialHash::INVALID;
+        for (size_t i = scratch.size(); i-- > 0;)
+        {
+            uint32_t id = hash.Insert(scratch[i], index);
+            if (id >= next.size())
+                next.resize(id + 1, SpatialHash::INVALID);
+            next[id] = following;
+            following = id;
+        }
+        entry.Head = following;
+        entry.Count = static_cast<uint32_t>(scratch.size());
+    }
+    entry.Object = object;
+    entry.Vertices = vertices;
+}
+
+double SnapIndex::now()
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
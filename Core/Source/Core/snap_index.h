@@ -0,0 +1,325 @@
+#ifndef SNAP_INDEX_H
+#define SNAP_INDEX_H
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <unordered_map>
+#include <limits>
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
+#include <algorithm>
+
+enum Snap_Mode {
+    SNAP_OFF,
+    SNAP_GRID,      // round to the grid step; needs no index
+    SNAP_OBJECT,    // object centers and bounding box corners
+    SNAP_VERTEX,    // mesh vertices in world space
+    SNAP_MODE_COUNT
+};
+
+const char* SnapModeName(Snap_Mode mode);
+
+// Nearest indexed point found by a query
+struct SnapHit
+{
+    glm::vec3 Position = glm::vec3(0.0f);
+    uint32_t Owner = 0;     // object index the point belongs to
+    float Distance = 0.0f;
+};
+
+// Points bucketed into a uniform grid of cubic cells, hashed by cell coordinates so the grid is unbounded and
+// sparse. Each occupied cell is one slot of an open-addressing table holding the head of an intrusive list
+// through the points, so moving a point between cells allocates nothing. Points keep their id while they move
+// and only change lists when they cross a cell boundary, which makes updating a moved object proportional to
+// its own point count.
+class SpatialHash
+{
+public:
+    static constexpr uint32_t INVALID = std::numeric_limits<uint32_t>::max();
+
+    explicit SpatialHash(float cellSize = 1.0f) : cellSize(cellSize), inverseCellSize(1.0f / cellSize)
+    {
+    }
+
+    // drops every point; the cell size only changes here because all buckets depend on it
+    void Reset(float newCellSize);
+
+    // returns the point's id; ids of erased points are reused
+    uint32_t Insert(const glm::vec3& position, uint32_t owner);
+    void Move(uint32_t id, const glm::vec3& position);
+    void Erase(uint32_t id);
+
+    // closest point within radius whose owner skip() rejects; cells are visited in shells of growing distance
+    // so a close hit ends the search early. Once a shell would cover more cells than are occupied, the search
+    // walks the occupied cells instead, which bounds a query with a radius far larger than the cells.
+    template<typename Skip>
+    bool Nearest(const glm::vec3& position, float radius, Skip skip, SnapHit& hit) const
+    {
+        if (cellCount == 0)
+            return false;
+        float best = radius * radius;
+        bool found = false;
+        auto visit = [&](uint32_t head) {
+            for (uint32_t id = head; id != INVALID; id = points[id].Next)
+            {
+                const Point& point = points[id];
+                glm::vec3 d = point.Position - position;
+                float distance = glm::dot(d, d);
+                if (distance < best && !skip(point.Owner))
+                {
+                    best = distance;
+                    hit.Position = point.Position;
+                    hit.Owner = point.Owner;
+                    found = true;
+                }
+            }
+        };
+
+        glm::ivec3 center = cellOf(position);
+        double shellCount = std::floor(static_cast<double>(radius) * inverseCellSize) + 1.0;
+        int shells = static_cast<int>(std::min(shellCount, 1.0e6));
+        for (int shell = 0; shell <= shells; ++shell)
+        {
+            // every point in this shell is at least (shell - 1) cells away
+            float reach = (shell - 1) * cellSize;
+            if (shell > 1 && reach * reach > best)
+                return finish(found, best, hit);
+            // past this shell the cube holds more cells than are occupied, so walking the table is cheaper
+            double side = 2.0 * shell + 1.0;
+            if (side * side * side > static_cast<double>(cellCount))
+                break;
+            for (int dz = -shell; dz <= shell; ++dz)
+            {
+                for (int dy = -shell; dy <= shell; ++dy)
+                {
+                    // inside the shell only the two x faces belong to it
+                    bool face = dz == -shell || dz == shell || dy == -shell || dy == shell;
+                    int step = face ? 1 : 2 * shell;
+                    for (int dx = -shell; dx <= shell; dx += step)
+                    {
+                        size_t slot = find(keyOf(center + glm::ivec3(dx, dy, dz)));
+                        if (slot != NOT_FOUND)
+                            visit(table[slot].Head);
+                    }
+                }
+            }
+            if (shell == shells)
+                return finish(found, best, hit);
+        }
+        glm::vec3 local = position * inverseCellSize - glm::vec3(center);
+        for (const Slot& slot : table)
+        {
+            if (slot.Key == EMPTY)
+                continue;
+            // distance from the position to the cell's box, in cells, skips the cells that cannot hold a closer point
+            glm::vec3 offset(offsetOf(slot.Key, center));
+            glm::vec3 gap = glm::max(glm::max(offset - local, local - offset - 1.0f), 0.0f) * cellSize;
+            if (glm::dot(gap, gap) < best)
+                visit(slot.Head);
+        }
+        return finish(found, best, hit);
+    }
+
+    size_t Size() const { return points.size() - freeIds.size(); }
+    size_t CellCount() const { return cellCount; }
+    float GetCellSize() const { return cellSize; }
+
+private:
+    static constexpr uint64_t EMPTY = ~uint64_t(0);     // cell keys use 63 bits, so no cell has this key
+    static constexpr size_t NOT_FOUND = ~size_t(0);
+
+    struct Point
+    {
+        glm::vec3 Position;
+        uint32_t Owner;
+        uint64_t Cell;
+        uint32_t Next;      // neighbours in the cell's list
+        uint32_t Previous;
+    };
+
+    struct Slot
+    {
+        uint64_t Key;
+        uint32_t Head;
+    };
+
+    float cellSize;
+    float inverseCellSize;
+    std::vector<Point> points;
+    std::vector<uint32_t> freeIds;
+    std::vector<Slot> table;        // linear probing, power of two, at most half full
+    size_t cellCount = 0;
+
+    glm::ivec3 cellOf(const glm::vec3& position) const
+    {
+        return glm::ivec3(glm::floor(position * inverseCellSize));
+    }
+
+    // 21 bits per axis; coordinates wrap around, which only merges cells about two million cells apart
+    static uint64_t keyOf(const glm::ivec3& cell)
+    {
+        const uint64_t mask = (uint64_t(1) << 21) - 1;
+        return (uint64_t(cell.x) & mask) | (uint64_t(cell.y) & mask) << 21 | (uint64_t(cell.z) & mask) << 42;
+    }
+
+    // cell of the key relative to center, taking the wrapped coordinates the shortest way round
+    static glm::ivec3 offsetOf(uint64_t key, const glm::ivec3& center)
+    {
+        const uint64_t mask = (uint64_t(1) << 21) - 1;
+        glm::ivec3 offset;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            uint64_t delta = ((key >> (21 * axis)) - uint64_t(center[axis])) & mask;
+            offset[axis] = static_cast<int>(delta) - (delta >= (mask >> 1) + 1 ? static_cast<int>(mask) + 1 : 0);
+        }
+        return offset;
+    }
+
+    size_t home(uint64_t key) const
+    {
+        return static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> 32) & (table.size() - 1);
+    }
+
+    size_t find(uint64_t key) const
+    {
+        for (size_t slot = home(key);; slot = (slot + 1) & (table.size() - 1))
+        {
+            if (table[slot].Key == key)
+                return slot;
+            if (table[slot].Key == EMPTY)
+                return NOT_FOUND;
+        }
+    }
+
+    static bool finish(bool found, float best, SnapHit& hit)
+    {
+        if (found)
+            hit.Distance = glm::sqrt(best);
+        return found;
+    }
+
+    void link(uint32_t id, uint64_t cell);
+    void unlink(uint32_t id);
+    void removeSlot(size_t slot);
+    void grow();
+};
+
+// What the snap index needs to know about one scene object
+struct SnapObject
+{
+    glm::vec3 Position = glm::vec3(0.0f);
+    glm::vec3 Scale = glm::vec3(1.0f);
+    float Radius = 0.5f;                            // largest object-space coordinate of the mesh
+    const std::vector<float>* Vertices = nullptr;   // unique mesh positions, xyz in object space
+    uint64_t Revision = 0;                          // changes whenever *Vertices is rewritten in place
+};
+
+struct SnapIndexStats
+{
+    size_t Points = 0;
+    size_t Cells = 0;
+    size_t Objects = 0;
+    size_t ObjectsUpdated = 0;  // by the last Sync
+    float CellSize = 0.0f;
+    size_t Rebuilds = 0;        // times the cell size drifted far enough to re-index everything
+    double SyncMs = 0.0;
+    double LastQueryUs = 0.0;
+    double MaxQueryUs = 0.0;    // since the last Sync
+    size_t Queries = 0;
+};
+
+// Snap targets of every object kept in a SpatialHash. Sync compares the scene with the copy taken last time
+// and re-indexes only the objects that changed, so it can run at the start of every drag; queries during the
+// drag then cost a few cell lookups no matter how large the scene is. The cell size follows the snap radius
+// and the spacing of the indexed points, and the whole index is rebuilt when it drifts more than 2x from them.
+class SnapIndex
+{
+public:
+    // objects whose meshes would push the index past this many points fall back to their bounds
+    size_t MaxPoints = 8 * 1024 * 1024;
+    SnapIndexStats Stats;
+
+    // get(i) returns a SnapObject for each of count objects; switching between object and vertex mode rebuilds the index.
+    // radius is the world-space snap radius the coming queries are expected to use
+    template<typename Get>
+    void Sync(Snap_Mode mode, float radius, size_t count, Get get)
+    {
+        double start = now();
+        if (mode != indexedMode)
+        {
+            clear();
+            indexedMode = mode;
+        }
+        while (objects.size() > count)
+        {
+            eraseObject(objects.back());
+            objects.pop_back();
+        }
+        size_t updated = 0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            SnapObject object = get(i);
+            if (i == objects.size())
+                objects.push_back(Entry());
+            Entry& entry = objects[i];
+            if (entry.Head != SpatialHash::INVALID && entry.Object.Position == object.Position && entry.Object.Scale == object.Scale &&
+                entry.Object.Radius == object.Radius && entry.Object.Vertices == object.Vertices && entry.Object.Revision == object.Revision)
+                continue;
+            updateObject(static_cast<uint32_t>(i), entry, object);
+            updated++;
+        }
+        if (fitCellSize(radius))
+            updated = objects.size();
+        Stats.ObjectsUpdated = updated;
+        Stats.Objects = objects.size();
+        Stats.Points = hash.Size();
+        Stats.Cells = hash.CellCount();
+        Stats.CellSize = hash.GetCellSize();
+        Stats.SyncMs = now() - start;
+        Stats.MaxQueryUs = 0.0;
+    }
+
+    // nearest snap target within radius of position, ignoring objects skip() rejects (typically the ones being moved)
+    template<typename Skip>
+    bool Nearest(const glm::vec3& position, float radius, Skip skip, SnapHit& hit)
+    {
+        double start = now();
+        bool found = hash.Nearest(position, radius, skip, hit);
+        Stats.LastQueryUs = (now() - start) * 1000.0;
+        Stats.MaxQueryUs = Stats.LastQueryUs > Stats.MaxQueryUs ? Stats.LastQueryUs : Stats.MaxQueryUs;
+        Stats.Queries++;
+        return found;
+    }
+
+    // drops every point; the next Sync indexes the whole scene again
+    void Clear()
+    {
+        clear();
+        Stats = SnapIndexStats();
+    }
+
+private:
+    struct Entry
+    {
+        SnapObject Object;
+        uint32_t Head = SpatialHash::INVALID;   // first point id of this object
+        uint32_t Count = 0;                     // points in the chain starting at Head
+        bool Vertices = false;                  // points are mesh vertices rather than bounds
+    };
+
+    SpatialHash hash;
+    std::vector<Entry> objects;
+    std::vector<uint32_t> next;     // per point id, the object's following point
+    std::vector<glm::vec3> scratch;
+    Snap_Mode indexedMode = SNAP_OFF;
+
+    void clear();
+    bool fitCellSize(float radius);
+    void eraseObject(Entry& entry);
+    void updateObject(uint32_t index, Entry& entry, const SnapObject& object);
+    static double now();
+};
+
+#endif
@@ -0,0 +1,393 @@
+#include "subdivision.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace
+{
+    // rows per job when stencils of consecutive levels are multiplied together
+    const size_t COMPOSE_GRAIN = 4096;
+
+    struct StencilEntry
+    {
+        uint32_t Source;
+        float Weight;
+    };
+
+    // sparse rows in the same layout as SubdivisionSurface
+    struct StencilTable
+    {
+        std::vector<uint32_t> Offsets = { 0 };
+        std::vector<uint32_t> Sources;
+        std::vector<float> Weights;
+    };
+
+    // sorts the entries of one row by source, sums duplicates and appends the row to table; row is cleared
+    void appendRow(std::vector<StencilEntry>& row, StencilTable& table)
+    {
+        std::sort(row.begin(), row.end(), [](const StencilEntry& a, const StencilEntry& b) { return a.Source < b.Source; });
+        for (size_t i = 0; i < row.size();)
+        {
+            uint32_t source = row[i].Source;
+            float weight = 0.0f;
+            while (i < row.size() && row[i].Source == source)
+                weight += row[i++].Weight;
+            table.Sources.push_back(source);
+            table.Weights.push_back(weight);
+        }
+        table.Offsets.push_back(static_cast<uint32_t>(table.Sources.size()));
+        row.clear();
+    }
+
+    // adds scale times the centroid of the face
+    void addFace(const HalfEdgeMesh& mesh, uint32_t face, float scale, std::vector<StencilEntry>& row)
+    {
+        uint32_t first = mesh.FaceEdge[face];
+        uint32_t size = 0;
+        uint32_t edge = first;
+        do
+        {
+            size++;
+            edge = mesh.EdgeNext[edge];
+        } while (edge != first);
+        do
+        {
+            row.push_back({ mesh.EdgeVertex[edge], scale / size });
+            edge = mesh.EdgeNext[edge];
+        } while (edge != first);
+    }
+
+    uint32_t previousEdge(const HalfEdgeMesh& mesh, uint32_t edge)
+    {
+        uint32_t previous = edge;
+        while (mesh.EdgeNext[previous] != edge)
+            previous = mesh.EdgeNext[previous];
+        return previous;
+    }
+
+    // One Catmull-Clark step: the stencils of the refined vertices over the vertices of mesh, and the refined
+    // quads. Refined vertices are numbered vertex points first, then face points, then edge points.
+    size_t refineLevel(const HalfEdgeMesh& mesh, StencilTable& table, std::vector<uint32_t>& quads)
+    {
+        const uint32_t INVALID = HalfEdgeMesh::INVALID;
+        const uint32_t vertexCount = static_cast<uint32_t>(mesh.VertexCount());
+        const uint32_t faceCount = static_cast<uint32_t>(mesh.FaceCount());
+
+        // one edge point per undirected edge, numbered by its lower half-edge
+        std::vector<uint32_t> edgeId(mesh.EdgeCount(), INVALID);
+        uint32_t edgeCount = 0;
+        for (uint32_t edge = 0; edge < mesh.EdgeCount(); ++edge)
+        {
+            if (edgeId[edge] != INVALID)
+                continue;
+            edgeId[edge] = edgeCount;
+            if (mesh.EdgeTwin[edge] != INVALID)
+                edgeId[mesh.EdgeTwin[edge]] = edgeCount;
+            edgeCount++;
+        }
+
+        std::vector<StencilEntry> row;
+        for (uint32_t vertex = 0; vertex < vertexCount; ++vertex)
+        {
+            if (mesh.VertexEdge[vertex] == INVALID)
+            {
+                row.push_back({ vertex, 1.0f });
+                appendRow(row, table);
+                continue;
+            }
+
+            uint32_t valence = 0;
+            uint32_t last = INVALID;
+            mesh.ForEachOutgoing(vertex, [&](uint32_t edge) {
+                valence++;
+                last = edge;
+            });
+
+            if (mesh.EdgeTwin[last] == INVALID)
+            {
+                // boundary: the fan ends on the outgoing boundary edge and starts after the incoming one
+                uint32_t incoming = previousEdge(mesh, mesh.VertexEdge[vertex]);
+                row.push_back({ vertex, 0.75f });
+                row.push_back({ mesh.Target(last), 0.125f });
+                row.push_back({ mesh.EdgeVertex[incoming], 0.125f });
+            }
+            else
+            {
+                // (n - 2) / n V + 1 / n^2 (sum of neighbours + sum of face points)
+                float n = static_cast<float>(valence);
+                row.push_back({ vertex, (n - 2.0f) / n });
+                mesh.ForEachOutgoing(vertex, [&](uint32_t edge) {
+                    row.push_back({ mesh.Target(edge), 1.0f / (n * n) });
+                    addFace(mesh, mesh.EdgeFace[edge], 1.0f / (n * n), row);
+                });
+            }
+            appendRow(row, table);
+        }
+
+        for (uint32_t face = 0; face < faceCount; ++face)
+        {
+            addFace(mesh, face, 1.0f, row);
+            appendRow(row, table);
+        }
+
+        for (uint32_t edge = 0; edge < mesh.EdgeCount(); ++edge)
+        {
+            uint32_t twin = mesh.EdgeTwin[edge];
+            if (twin != INVALID && twin < edge)
+                continue;
+            if (twin == INVALID)
+            {
+                row.push_back({ mesh.EdgeVertex[edge], 0.5f });
+                row.push_back({ mesh.Target(edge), 0.5f });
+            }
+            else
+            {
+                row.push_back({ mesh.EdgeVertex[edge], 0.25f });
+                row.push_back({ mesh.Target(edge), 0.25f });
+                addFace(mesh, mesh.EdgeFace[edge], 0.25f, row);
+                addFace(mesh, mesh.EdgeFace[twin], 0.25f, row);
+            }
+            appendRow(row, table);
+        }
+
+        // every corner of a face becomes a quad: corner, next edge point, face point, previous edge point
+        quads.clear();
+        quads.reserve(mesh.EdgeCount() * 4);
+        for (uint32_t face = 0; face < faceCount; ++face)
+        {
+            uint32_t first = mesh.FaceEdge[face];
+            uint32_t previous = previousEdge(mesh, first);
+            uint32_t edge = first;
+            do
+            {
+                quads.push_back(mesh.EdgeVertex[edge]);
+                quads.push_back(vertexCount + faceCount + edgeId[edge]);
+                quads.push_back(vertexCount + face);
+                quads.push_back(vertexCount + faceCount + edgeId[previous]);
+                previous = edge;
+                edge = mesh.EdgeNext[edge];
+            } while (edge != first);
+        }
+        return static_cast<size_t>(vertexCount) + faceCount + edgeCount;
+    }
+
+    // Linear refinement of face-varying values: the stencils of the refined half-edges, in the order of the quads
+    // refineLevel emits, over the half-edges of mesh. A quad's corners take its parent corner, the midpoints of
+    // the face's two edges at that corner and the face's centroid, so values never blend across a seam. wedges,
+    // if given, maps the parent half-edges to the values they read instead.
+    void refineCorners(const HalfEdgeMesh& mesh, const std::vector<uint32_t>* wedges, StencilTable& table)
+    {
+        auto source = [&](uint32_t edge) { return wedges != nullptr ? (*wedges)[edge] : edge; };
+        std::vector<StencilEntry> row;
+        for (uint32_t face = 0; face < mesh.FaceCount(); ++face)
+        {
+            uint32_t first = mesh.FaceEdge[face];
+            uint32_t size = 0;
+            uint32_t edge = first;
+            do
+            {
+                size++;
+                edge = mesh.EdgeNext[edge];
+            } while (edge != first);
+
+            uint32_t previous = previousEdge(mesh, first);
+            do
+            {
+                uint32_t next = mesh.EdgeNext[edge];
+                row.push_back({ source(edge), 1.0f });
+                appendRow(row, table);
+                row.push_back({ source(edge), 0.5f });
+                row.push_back({ source(next), 0.5f });
+                appendRow(row, table);
+                uint32_t corner = first;
+                do
+                {
+                    row.push_back({ source(corner), 1.0f / size });
+                    corner = mesh.EdgeNext[corner];
+                } while (corner != first);
+                appendRow(row, table);
+                row.push_back({ source(previous), 0.5f });
+                row.push_back({ source(edge), 0.5f });
+                appendRow(row, table);
+                previous = edge;
+                edge = next;
+            } while (edge != first);
+        }
+    }
+
+    bool sameRow(const StencilTable& table, uint32_t a, uint32_t b)
+    {
+        uint32_t length = table.Offsets[a + 1] - table.Offsets[a];
+        if (length != table.Offsets[b + 1] - table.Offsets[b])
+            return false;
+        for (uint32_t k = 0; k < length; ++k)
+        {
+            uint32_t i = table.Offsets[a] + k;
+            uint32_t j = table.Offsets[b] + k;
+            if (table.Sources[i] != table.Sources[j] || std::abs(table.Weights[i] - table.Weights[j]) > 1.0e-6f)
+                return false;
+        }
+        return true;
+    }
+
+    // Corners of a refined vertex whose stencils match read the same values everywhere, so they share a wedge;
+    // where a seam ran through the cage they differ. Fills the wedges of mesh and returns their stencils.
+    StencilTable groupWedges(const StencilTable& corners, HalfEdgeMesh& mesh)
+    {
+        const uint32_t INVALID = HalfEdgeMesh::INVALID;
+        std::vector<uint32_t> start(mesh.VertexCount() + 1, 0);
+        for (uint32_t vertex : mesh.EdgeVertex)
+            start[vertex + 1]++;
+        for (size_t v = 0; v < mesh.VertexCount(); ++v)
+            start[v + 1] += start[v];
+        std::vector<uint32_t> outgoing(mesh.EdgeCount());
+        std::vector<uint32_t> fill(start.begin(), start.end() - 1);
+        for (uint32_t edge = 0; edge < mesh.EdgeCount(); ++edge)
+            outgoing[fill[mesh.EdgeVertex[edge]]++] = edge;
+
+        StencilTable table;
+        std::vector<uint32_t> representative;   // per wedge, the corner its stencil is copied from
+        mesh.WedgeVertex.clear();
+        mesh.EdgeWedge.assign(mesh.EdgeCount(), INVALID);
+        for (uint32_t vertex = 0; vertex < mesh.VertexCount(); ++vertex)
+        {
+            size_t firstWedge = representative.size();
+            for (uint32_t k = start[vertex]; k < start[vertex + 1]; ++k)
+            {
+                uint32_t edge = outgoing[k];
+                for (size_t w = firstWedge; w < representative.size() && mesh.EdgeWedge[edge] == INVALID; ++w)
+                {
+                    if (sameRow(corners, edge, representative[w]))
+                        mesh.EdgeWedge[edge] = static_cast<uint32_t>(w);
+                }
+                if (mesh.EdgeWedge[edge] != INVALID)
+                    continue;
+                mesh.EdgeWedge[edge] = static_cast<uint32_t>(representative.size());
+                representative.push_back(edge);
+                mesh.WedgeVertex.push_back(vertex);
+                for (uint32_t m = corners.Offsets[edge]; m < corners.Offsets[edge + 1]; ++m)
+                {
+                    table.Sources.push_back(corners.Sources[m]);
+                    table.Weights.push_back(corners.Weights[m]);
+                }
+                table.Offsets.push_back(static_cast<uint32_t>(table.Sources.size()));
+            }
+        }
+        mesh.WedgeTexCoords.assign(mesh.WedgeVertex.size(), glm::vec2(0.0f));
+        mesh.WedgeGroup.assign(mesh.WedgeVertex.size(), INVALID);
+        return table;
+    }
+
+    // rows of local (over the previous level's vertices) times previous (over the control points)
+    StencilTable compose(const StencilTable& local, const StencilTable& previous, JobSystem& jobs)
+    {
+        size_t rows = local.Offsets.size() - 1;
+        size_t chunks = (rows + COMPOSE_GRAIN - 1) / COMPOSE_GRAIN;
+        std::vector<StencilTable> parts(chunks);
+        jobs.ParallelFor(chunks, 1, [&](size_t begin, size_t end) {
+            std::vector<StencilEntry> row;
+            for (size_t chunk = begin; chunk < end; ++chunk)
+            {
+                size_t last = std::min(rows, (chunk + 1) * COMPOSE_GRAIN);
+                for (size_t i = chunk * COMPOSE_GRAIN; i < last; ++i)
+                {
+                    for (uint32_t k = local.Offsets[i]; k < local.Offsets[i + 1]; ++k)
+                    {
+                        uint32_t source = local.Sources[k];
+                        for (uint32_t m = previous.Offsets[source]; m < previous.Offsets[source + 1]; ++m)
+                            row.push_back({ previous.Sources[m], local.Weights[k] * previous.Weights[m] });
+                    }
+                    appendRow(row, parts[chunk]);
+                }
+            }
+        });
+
+        StencilTable result;
+        for (const StencilTable& part : parts)
+        {
+            uint32_t base = static_cast<uint32_t>(result.Sources.size());
+            for (size_t k = 1; k < part.Offsets.size(); ++k)
+                result.Offsets.push_back(base + part.Offsets[k]);
+            result.Sources.insert(result.Sources.end(), part.Sources.begin(), part.Sources.end());
+            result.Weights.insert(result.Weights.end(), part.Weights.begin(), part.Weights.end());
+        }
+        return result;
+    }
+}
+
+void SubdivisionSurface::Build(const HalfEdgeMesh& cage, int levels, JobSystem& jobs)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    Levels = levels;
+    controlCount = cage.VertexCount();
+
+    StencilTable stencils;
+    StencilTable wedges;
+    std::vector<uint32_t> quads;
+    if (levels <= 0)
+    {
+        // identity, so callers need no special case
+        std::vector<StencilEntry> row;
+        for (uint32_t vertex = 0; vertex < controlCount; ++vertex)
+        {
+            row.push_back({ vertex, 1.0f });
+            appendRow(row, stencils);
+        }
+        for (uint32_t wedge = 0; wedge < cage.WedgeCount(); ++wedge)
+        {
+            row.push_back({ wedge, 1.0f });
+            appendRow(row, wedges);
+        }
+        Refined = cage;
+    }
+
+    StencilTable corners;
+    for (int level = 0; level < levels; ++level)
+    {
+        const HalfEdgeMesh& parent = level == 0 ? cage : Refined;
+        StencilTable localCorners;
+        refineCorners(parent, level == 0 ? &cage.EdgeWedge : nullptr, localCorners);
+        corners = level == 0 ? std::move(localCorners) : compose(localCorners, corners, jobs);
+
+        StencilTable local;
+        size_t count = refineLevel(parent, local, quads);
+        stencils = level == 0 ? std::move(local) : compose(local, stencils, jobs);
+
+        std::vector<uint32_t> faceSizes(quads.size() / 4, 4);
+        Refined = HalfEdgeMesh::FromPolygons(std::vector<glm::vec3>(count, glm::vec3(0.0f)), faceSizes, quads);
+    }
+    if (levels > 0)
+        wedges = groupWedges(corners, Refined);
+
+    Offsets = std::move(stencils.Offsets);
+    Sources = std::move(stencils.Sources);
+    Weights = std::move(stencils.Weights);
+    WedgeOffsets = std::move(wedges.Offsets);
+    WedgeSources = std::move(wedges.Sources);
+    WedgeWeights = std::move(wedges.Weights);
+    Indices = Refined.Triangulate();
+    BuildMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+void SubdivisionSurface::Evaluate(const std::vector<glm::vec3>& positions, const std::vector<glm::vec2>& wedgeTexCoords, JobSystem& jobs)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    Refined.Positions.resize(RefinedCount());
+    Refined.WedgeTexCoords.resize(Refined.WedgeCount());
+    Apply(positions.data(), Refined.Positions.data(), jobs);
+    ApplyWedges(wedgeTexCoords.data(), Refined.WedgeTexCoords.data(), jobs);
+    auto applied = std::chrono::high_resolution_clock::now();
+    Refined.ComputeNormals(jobs);
+    ApplyMs = std::chrono::duration<double, std::milli>(applied - start).count();
+    NormalsMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - applied).count();
+}
+
+MeshData SubdivisionSurface::ToMeshData() const
+{
+    MeshData data;
+    data.Vertices.resize(Refined.WedgeCount() * MeshData::STRIDE);
+    Refined.WriteWedges(0, Refined.WedgeCount(), data.Vertices.data());
+    data.Indices = Indices;
+    return data;
+}
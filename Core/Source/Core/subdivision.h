@@ -0,0 +1,88 @@
+#ifndef SUBDIVISION_H
+#define SUBDIVISION_H
+
+#include "half_edge.h"
+#include "job_system.h"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// Catmull-Clark refinement of a fixed control cage, precomputed as stencils: every refined vertex is a weighted
+// sum of control points, stored as one sparse matrix in compressed rows. Building walks the topology once per
+// level; after that, moving control points only needs Evaluate, a matrix-vector product whose rows split across
+// the job system. Boundary edges and vertices follow the cubic B-spline boundary rules, so open meshes keep their
+// outline. Texture coordinates refine linearly inside each face of the cage, through a second table over the
+// cage's wedges, so uv seams stay where the cage has them.
+class SubdivisionSurface
+{
+public:
+    int Levels = 0;
+
+    // refined vertex i is the sum of Weights[k] * control[Sources[k]] for k in [Offsets[i], Offsets[i + 1])
+    std::vector<uint32_t> Offsets;
+    std::vector<uint32_t> Sources;
+    std::vector<float> Weights;
+
+    // the same for refined wedge i over the wedges of the cage
+    std::vector<uint32_t> WedgeOffsets;
+    std::vector<uint32_t> WedgeSources;
+    std::vector<float> WedgeWeights;
+
+    HalfEdgeMesh Refined;               // quads of the last level; Evaluate fills its positions, uvs and normals
+    std::vector<unsigned int> Indices;  // Refined triangulated for drawing
+
+    double BuildMs = 0.0;
+    double ApplyMs = 0.0;               // stencils of the last Evaluate
+    double NormalsMs = 0.0;
+
+    // only the cage's connectivity and wedges are read, so the stencils stay valid while its vertices move
+    void Build(const HalfEdgeMesh& cage, int levels, JobSystem& jobs);
+
+    size_t ControlCount() const { return controlCount; }
+    size_t RefinedCount() const { return Offsets.empty() ? 0 : Offsets.size() - 1; }
+
+    // refines control positions and the texture coordinates of the cage's wedges into Refined and recomputes its normals
+    void Evaluate(const std::vector<glm::vec3>& positions, const std::vector<glm::vec2>& wedgeTexCoords, JobSystem& jobs);
+
+    // interleaved copy of Refined for upload
+    MeshData ToMeshData() const;
+
+    // the matrix-vector product itself, for any value that interpolates linearly
+    template<typename T>
+    void Apply(const T* control, T* refined, JobSystem& jobs) const
+    {
+        apply(Offsets, Sources, Weights, control, refined, jobs);
+    }
+
+    // the same over the wedges, for face-varying values
+    template<typename T>
+    void ApplyWedges(const T* control, T* refined, JobSystem& jobs) const
+    {
+        apply(WedgeOffsets, WedgeSources, WedgeWeights, control, refined, jobs);
+    }
+
+private:
+    static const size_t APPLY_GRAIN = 8192;
+
+    template<typename T>
+    static void apply(const std::vector<uint32_t>& offsets, const std::vector<uint32_t>& sources, const std::vector<float>& weights,
+        const T* control, T* refined, JobSystem& jobs)
+    {
+        jobs.ParallelFor(offsets.empty() ? 0 : offsets.size() - 1, APPLY_GRAIN, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i)
+            {
+                T sum(0.0f);
+                for (uint32_t k = offsets[i]; k < offsets[i + 1]; ++k)
+                    sum += weights[k] * control[sources[k]];
+                refined[i] = sum;
+            }
+        });
+    }
+
+    size_t controlCount = 0;
+};
+
+#endif
@@ -0,0 +1,173 @@
+#ifndef TESSELLATION_H
+#define TESSELLATION_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "mesh_pool.h"
+#include "gpu_resources.h"
+#include "gl_state_cache.h"
+
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+
+// Smooth preview of subdivision surfaces on GL 4.0+. Meshes are drawn as triangle patches that the tessellation
+// stages turn into PN triangles (cubic patches through the corners, bent along the corner normals). The control
+// stage picks each edge's level from its projected length, so detail follows screen size instead of the mesh,
+// and drops patches outside the view. Contexts without tessellation keep drawing the meshes as plain triangles.
+class TessellationPreview
+{
+public:
+    float PixelsPerEdge = 16.0f;    // target projected length of a tessellated edge
+    float MaxLevel = 32.0f;         // GL guarantees at least 64
+    unsigned int DrawnPatches = 0;  // submitted by the last frame
+    GLint OcclusionUnit = 1;        // texture unit the baked occlusion buffer is bound to, read before Initialize
+
+    TessellationPreview(GpuResourceRegistry& registry, GLStateCache& state) : registry(registry), state(state)
+    {
+    }
+
+    // compiles the program from shaderDirectory; the fragment stage is the scene's, so the preview is lit the same
+    bool Initialize(const std::string& shaderDirectory)
+    {
+        if (!GLAD_GL_VERSION_4_0)
+            return false;
+
+        GLuint stages[] = {
+            compile(GL_VERTEX_SHADER, readFile(shaderDirectory + "tess_vertex.glsl"), "VERTEX"),
+            compile(GL_TESS_CONTROL_SHADER, readFile(shaderDirectory + "tess_control.glsl"), "TESS_CONTROL"),
+            compile(GL_TESS_EVALUATION_SHADER, readFile(shaderDirectory + "tess_evaluation.glsl"), "TESS_EVALUATION"),
+            compile(GL_FRAGMENT_SHADER, readFile(shaderDirectory + "fragment.glsl"), "FRAGMENT")
+        };
+        GLuint program = glCreateProgram();
+        bool compiled = true;
+        for (GLuint stage : stages)
+        {
+            compiled = compiled && stage != 0;
+            if (stage != 0)
+                glAttachShader(program, stage);
+        }
+        program = compiled ? linkProgram(program) : (glDeleteProgram(program), 0u);
+        for (GLuint stage : stages)
+        {
+            if (stage != 0)
+                glDeleteShader(stage);
+        }
+        if (program == 0)
+            return false;
+
+        this->program = GpuHandle::Adopt(registry, GPU_PROGRAM, program, "Tessellation preview");
+        locations.Model = glGetUniformLocation(program, "model");
+        locations.View = glGetUniformLocation(program, "view");
+        locations.Projection = glGetUniformLocation(program, "projection");
+        locations.ViewportSize = glGetUniformLocation(program, "viewportSize");
+        locations.PixelsPerEdge = glGetUniformLocation(program, "pixelsPerEdge");
+        locations.MaxLevel = glGetUniformLocation(program, "maxLevel");
+        locations.UseTexture = glGetUniformLocation(program, "useTexture");
+        locations.Color = glGetUniformLocation(program, "color");
+        locations.OcclusionOffset = glGetUniformLocation(program, "occlusionOffset");
+        state.UseProgram(program);
+        glUniform1i(glGetUniformLocation(program, "occlusion"), OcclusionUnit);
+        return true;
+    }
+
+    bool IsAvailable() const
+    {
+        return program.IsValid();
+    }
+
+    // binds the program and sets what stays the same for every mesh of the frame
+    void Begin(const glm::mat4& view, const glm::mat4& projection, const glm::vec2& viewportSize)
+    {
+        state.UseProgram(program.ID());
+        glUniformMatrix4fv(locations.View, 1, GL_FALSE, glm::value_ptr(view));
+        glUniformMatrix4fv(locations.Projection, 1, GL_FALSE, glm::value_ptr(projection));
+        glUniform2fv(locations.ViewportSize, 1, glm::value_ptr(viewportSize));
+        glUniform1f(locations.PixelsPerEdge, PixelsPerEdge);
+        glUniform1f(locations.MaxLevel, MaxLevel);
+        glPatchParameteri(GL_PATCH_VERTICES, 3);
+        DrawnPatches = 0;
+    }
+
+    // texture 0 draws in color; occlusionOffset is the mesh's first baked occlusion value, -1 for none
+    void Draw(const Mesh& mesh, const glm::mat4& model, const glm::vec4& color, GLuint texture, GLint occlusionOffset = -1)
+    {
+        glUniformMatrix4fv(locations.Model, 1, GL_FALSE, glm::value_ptr(model));
+        glUniform1i(locations.UseTexture, texture != 0);
+        glUniform4fv(locations.Color, 1, glm::value_ptr(color));
+        glUniform1i(locations.OcclusionOffset, occlusionOffset);
+        if (texture != 0)
+            state.BindTexture(GL_TEXTURE_2D, texture);
+        state.BindVertexArray(mesh.VAO.ID());
+        glDrawElements(GL_PATCHES, mesh.IndexCount, mesh.IndexType, reinterpret_cast<const void*>(mesh.IndexOffset));
+        DrawnPatches += mesh.IndexCount / 3;
+    }
+
+    void Release()
+    {
+        program.Reset();
+    }
+
+private:
+    GpuResourceRegistry& registry;
+    GLStateCache& state;
+    GpuHandle program;
+
+    struct Locations
+    {
+        GLint Model = -1, View = -1, Projection = -1, ViewportSize = -1, PixelsPerEdge = -1, MaxLevel = -1, UseTexture = -1, Color = -1, OcclusionOffset = -1;
+    } locations;
+
+    static std::string readFile(const std::string& path)
+    {
+        std::ifstream file(path);
+        if (!file)
+        {
+            std::cout << "ERROR::TESSELLATION::FILE_NOT_SUCCESSFULLY_READ: " << path << std::endl;
+            return std::string();
+        }
+        std::stringstream stream;
+        stream << file.rdbuf();
+        return stream.str();
+    }
+
+    static GLuint compile(GLenum type, const std::string& source, const char* name)
+    {
+        const char* code = source.c_str();
+        GLuint shader = glCreateShader(type);
+        glShaderSource(shader, 1, &code, NULL);
+        glCompileShader(shader);
+        GLint success;
+        glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+        if (!success)
+        {
+            GLchar infoLog[1024];
+            glGetShaderInfoLog(shader, 1024, NULL, infoLog);
+            std::cout << "ERROR::SHADER_COMPILATION_ERROR of type: " << name << "\n" << infoLog << std::endl;
+            glDeleteShader(shader);
+            return 0;
+        }
+        return shader;
+    }
+
+    static GLuint linkProgram(GLuint program)
+    {
+        glLinkProgram(program);
+        GLint success;
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+        if (!success)
+        {
+            GLchar infoLog[1024];
+            glGetProgramInfoLog(program, 1024, NULL, infoLog);
+            std::cout << "ERROR::PROGRAM_LINKING_ERROR of type: TESSELLATION\n" << infoLog << std::endl;
+            glDeleteProgram(program);
+            return 0;
+        }
+        return program;
+    }
+};
+
+#endif
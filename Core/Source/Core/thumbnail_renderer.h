@@ -0,0 +1,154 @@
+#ifndef THUMBNAIL_RENDERER_H
+#define THUMBNAIL_RENDERER_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "shader_m.h"
+#include "mesh_pool.h"
+#include "primitives.h"
+#include "gpu_resources.h"
+#include "gl_state_cache.h"
+
+#include <memory>
+#include <vector>
+#include <string>
+#include <cmath>
+#include <cstring>
+#include <cstdint>
+
+// Offscreen renders of meshes for asset thumbnails, lit by the scene shaders. A mesh is drawn at twice the thumbnail
+// size and filtered down by a linear blit, which smooths its edges without a multisampled target, then read back.
+// Meshes are expected centered and fitting the unit sphere, as ReadThumbnailMesh leaves them.
+class ThumbnailRenderer
+{
+public:
+    static const int SUPERSAMPLE = 2;
+
+    ThumbnailRenderer(GpuResourceRegistry& registry, GLStateCache& state) : registry(registry), state(state)
+    {
+    }
+
+    ThumbnailRenderer(const ThumbnailRenderer&) = delete;
+    ThumbnailRenderer& operator=(const ThumbnailRenderer&) = delete;
+
+    // compiles the scene program from shaderDirectory; occlusionUnit is where that program expects its baked
+    // occlusion, which thumbnails never read but which must not share a unit with the texture sampler
+    void Initialize(const std::string& shaderDirectory, GLint occlusionUnit)
+    {
+        shader = std::make_unique<Shader>((shaderDirectory + "vertex.glsl").c_str(), (shaderDirectory + "fragment.glsl").c_str());
+        program = GpuHandle::Adopt(registry, GPU_PROGRAM, shader->ID, "Thumbnail shader");
+        state.UseProgram(shader->ID);
+        shader->setInt("occlusion", occlusionUnit);
+        shader->setInt("occlusionOffset", -1);
+        shader->setBool("useTexture", false);
+        shader->setVec4("color", glm::vec4(0.8f, 0.8f, 0.8f, 1.0f));
+    }
+
+    // draws mesh from a three-quarter view into a size x size thumbnail and reads it back as RGBA8, top row first.
+    // The context's depth conventions are kept, so projection must be built for them; End restores the target.
+    void Render(const MeshData& mesh, int size, const glm::mat4& projection, std::vector<uint8_t>& pixels)
+    {
+        if (size != width)
+            allocate(size);
+
+        Mesh gpu;
+        UploadMeshData(gpu, mesh, registry, state, "Thumbnail");
+
+        state.BindFramebuffer(GL_FRAMEBUFFER, large.ID());
+        glViewport(0, 0, width * SUPERSAMPLE, width * SUPERSAMPLE);
+        glClearColor(0.16f, 0.16f, 0.18f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        state.Enable(GL_DEPTH_TEST);
+        state.DepthMask(GL_TRUE);
+
+        glm::vec3 eye = glm::normalize(glm::vec3(1.0f, 0.8f, 1.4f)) * DISTANCE;
+        state.UseProgram(shader->ID);
+        shader->setMat4("projection", projection);
+        shader->setMat4("view", glm::lookAt(eye, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f)));
+        shader->setMat4("model", glm::mat4(1.0f));
+        state.BindVertexArray(gpu.VAO.ID());
+        gpu.Draw();
+        state.BindVertexArray(0);
+
+        state.BindFramebuffer(GL_READ_FRAMEBUFFER, large.ID());
+        state.BindFramebuffer(GL_DRAW_FRAMEBUFFER, small.ID());
+        glBlitFramebuffer(0, 0, width * SUPERSAMPLE, width * SUPERSAMPLE, 0, 0, width, width, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+
+        // GL reads rows bottom up
+        std::vector<uint8_t> rows(static_cast<size_t>(width) * width * 4);
+        state.BindFramebuffer(GL_READ_FRAMEBUFFER, small.ID());
+        glReadBuffer(GL_COLOR_ATTACHMENT0);
+        glPixelStorei(GL_PACK_ALIGNMENT, 4);
+        glReadPixels(0, 0, width, width, GL_RGBA, GL_UNSIGNED_BYTE, rows.data());
+        pixels.resize(rows.size());
+        size_t stride = static_cast<size_t>(width) * 4;
+        for (int y = 0; y < width; ++y)
+            std::memcpy(&pixels[y * stride], &rows[(width - 1 - y) * stride], stride);
+    }
+
+    // the vertical field of view to build Render's projection with; the mesh fits it with a small margin
+    static float FieldOfView()
+    {
+        return 2.0f * std::asin(1.0f / DISTANCE) * 1.1f;
+    }
+
+    void End(GLuint framebuffer, int viewportWidth, int viewportHeight)
+    {
+        state.BindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glViewport(0, 0, viewportWidth, viewportHeight);
+    }
+
+    void Release()
+    {
+        large.Reset();
+        largeColor.Reset();
+        largeDepth.Reset();
+        small.Reset();
+        smallColor.Reset();
+        program.Reset();
+        shader.reset();
+        width = 0;
+    }
+
+private:
+    static constexpr float DISTANCE = 3.0f;    // of the camera from the mesh center, in unit sphere radii
+
+    GpuResourceRegistry& registry;
+    GLStateCache& state;
+    std::unique_ptr<Shader> shader;
+    GpuHandle program;
+    GpuHandle large, largeColor, largeDepth;
+    GpuHandle small, smallColor;
+    int width = 0;
+
+    void allocate(int size)
+    {
+        width = size;
+        int supersampled = size * SUPERSAMPLE;
+
+        large = GpuHandle::Create(registry, GPU_FRAMEBUFFER, "Thumbnail target");
+        state.BindFramebuffer(GL_FRAMEBUFFER, large.ID());
+        largeColor = GpuHandle::Create(registry, GPU_RENDERBUFFER, "Thumbnail color");
+        glBindRenderbuffer(GL_RENDERBUFFER, largeColor.ID());
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, supersampled, supersampled);
+        largeColor.SetBytes(EstimateTextureBytes(supersampled, supersampled, 4, false));
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, largeColor.ID());
+        largeDepth = GpuHandle::Create(registry, GPU_RENDERBUFFER, "Thumbnail depth");
+        glBindRenderbuffer(GL_RENDERBUFFER, largeDepth.ID());
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT32F, supersampled, supersampled);
+        largeDepth.SetBytes(EstimateTextureBytes(supersampled, supersampled, 4, false));
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, largeDepth.ID());
+
+        small = GpuHandle::Create(registry, GPU_FRAMEBUFFER, "Thumbnail resolve");
+        state.BindFramebuffer(GL_FRAMEBUFFER, small.ID());
+        smallColor = GpuHandle::Create(registry, GPU_RENDERBUFFER, "Thumbnail resolve color");
+        glBindRenderbuffer(GL_RENDERBUFFER, smallColor.ID());
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, size, size);
+        smallColor.SetBytes(EstimateTextureBytes(size, size, 4, false));
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, smallColor.ID());
+    }
+};
+
+#endif
@@ -0,0 +1,300 @@
+#include "timeline.h"
+#include "simd.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    // channels handled per lookup/evaluate/scatter round; the scratch arrays stay on the stack
+    const size_t BLOCK_SIZE = 256;
+
+    // cubic Bezier from p0 to p3 with control values p1 and p2
+    inline float bezier(float u, float p0, float p1, float p2, float p3)
+    {
+        float inv = 1.0f - u;
+        return inv * inv * inv * p0 + 3.0f * inv * inv * u * p1 + 3.0f * inv * u * u * p2 + u * u * u * p3;
+    }
+}
+
+const char* InterpolationModeName(Interpolation_Mode mode)
+{
+    switch (mode)
+    {
+    case INTERPOLATION_LINEAR: return "Linear";
+    case INTERPOLATION_BEZIER: return "Bezier";
+    default: return "Unknown";
+    }
+}
+
+int Timeline::GetOrAddChannel(size_t target)
+{
+    int existing = FindChannel(target);
+    if (existing >= 0)
+        return existing;
+
+    Channel channel;
+    channel.Target = target;
+    channel.FirstKey = static_cast<unsigned int>(KeyTimes.size());
+    channel.KeyCount = 0;
+    channel.Cursor = 0;
+    channels.push_back(channel);
+    int index = static_cast<int>(channels.size()) - 1;
+    channelByTarget[target] = index;
+    return index;
+}
+
+int Timeline::FindChannel(size_t target) const
+{
+    auto it = channelByTarget.find(target);
+    return it == channelByTarget.end() ? -1 : it->second;
+}
+
+void Timeline::SetKey(int channelIndex, float time, float value, Interpolation_Mode mode)
+{
+    Channel& channel = channels[channelIndex];
+
+    // an empty channel may carry a stale start, so its first key always goes to the end of the storage
+    if (channel.KeyCount == 0)
+        channel.FirstKey = static_cast<unsigned int>(KeyTimes.size());
+
+    const float* begin = KeyTimes.data() + channel.FirstKey;
+    const float* end = begin + channel.KeyCount;
+    const float* it = std::lower_bound(begin, end, time);
+    size_t position = channel.FirstKey + (it - begin);
+
+    if (it != end && std::abs(*it - time) < 1e-4f)
+    {
+        KeyValues[position] = value;
+        KeyModes[position] = static_cast<unsigned char>(mode);
+    }
+    else
+    {
+        // shift the runs of the channels stored after the insertion point
+        if (position < KeyTimes.size())
+        {
+            for (Channel& other : channels)
+            {
+                if (&other != &channel && other.KeyCount > 0 && other.FirstKey >= position)
+                    other.FirstKey++;
+            }
+        }
+        KeyTimes.insert(KeyTimes.begin() + position, time);
+        KeyValues.insert(KeyValues.begin() + position, value);
+        KeyInHandles.insert(KeyInHandles.begin() + position, value);
+        KeyOutHandles.insert(KeyOutHandles.begin() + position, value);
+        KeyModes.insert(KeyModes.begin() + position, static_cast<unsigned char>(mode));
+        channel.KeyCount++;
+    }
+
+    updateHandles(channel, static_cast<unsigned int>(position));
+}
+
+void Timeline::Clear()
+{
+    channels.clear();
+    channelByTarget.clear();
+    KeyTimes.clear();
+    KeyValues.clear();
+    KeyInHandles.clear();
+    KeyOutHandles.clear();
+    KeyModes.clear();
+    Time = 0.0f;
+    Playing = false;
+}
+
+bool Timeline::Advance(float deltaTime)
+{
+    if (!Playing)
+        return false;
+
+    Time += deltaTime;
+    if (Time > Duration)
+    {
+        if (Loop && Duration > 0.0f)
+        {
+            Time = std::fmod(Time, Duration);
+        }
+        else
+        {
+            Time = Duration;
+            Playing = false;
+        }
+    }
+    return true;
+}
+
+// Recomputes the handles of the keys around a changed key. Bezier keys get an auto-clamped tangent:
+// the slope through both neighbours, flattened at the ends and at local extremes so curves never overshoot.
+void Timeline::updateHandles(const Channel& channel, unsigned int key)
+{
+    unsigned int first = channel.FirstKey;
+    unsigned int last = channel.FirstKey + channel.KeyCount - 1;
+    const float* t = KeyTimes.data();
+    const float* v = KeyValues.data();
+
+    auto slope = [&](unsigned int k)
+    {
+        if (k == first || k == last)
+            return 0.0f;
+        if ((v[k] - v[k - 1]) * (v[k + 1] - v[k]) <= 0.0f)
+            return 0.0f;
+        return (v[k + 1] - v[k - 1]) / (t[k + 1] - t[k - 1]);
+    };
+
+    // a key's tangent depends on its neighbours, so every segment within two keys of the change is refreshed
+    unsigned int from = key > first + 2 ? key - 2 : first;
+    unsigned int to = std::min(key + 2, last);
+    for (unsigned int k = from; k < to; ++k)
+    {
+        float dt = t[k + 1] - t[k];
+        if (KeyModes[k] == INTERPOLATION_LINEAR)
+        {
+            float step = (v[k + 1] - v[k]) / 3.0f;
+            KeyOutHandles[k] = v[k] + step;
+            KeyInHandles[k + 1] = v[k + 1] - step;
+        }
+        else
+        {
+            KeyOutHandles[k] = v[k] + slope(k) * dt / 3.0f;
+            KeyInHandles[k + 1] = v[k + 1] - slope(k + 1) * dt / 3.0f;
+        }
+    }
+}
+
+void Timeline::Evaluate(float time, float* output, size_t outputCount, JobSystem* jobs)
+{
+    if (jobs)
+    {
+        jobs->ParallelFor(channels.size(), BLOCK_SIZE * 16, [&](size_t begin, size_t end)
+        {
+            evaluateBlock(time, begin, end, output, outputCount);
+        });
+    }
+    else
+    {
+        evaluateBlock(time, 0, channels.size(), output, outputCount);
+    }
+}
+
+void Timeline::evaluateBlock(float time, size_t begin, size_t end, float* output, size_t outputCount)
+{
+    alignas(16) float u[BLOCK_SIZE];
+    alignas(16) float p0[BLOCK_SIZE];
+    alignas(16) float p1[BLOCK_SIZE];
+    alignas(16) float p2[BLOCK_SIZE];
+    alignas(16) float p3[BLOCK_SIZE];
+    alignas(16) float result[BLOCK_SIZE];
+
+    const float* times = KeyTimes.data();
+    const float* values = KeyValues.data();
+    const float* inHandles = KeyInHandles.data();
+    const float* outHandles = KeyOutHandles.data();
+
+    for (size_t blockStart = begin; blockStart < end; blockStart += BLOCK_SIZE)
+    {
+        size_t count = std::min(BLOCK_SIZE, end - blockStart);
+
+        // Segment lookup: gather the four control values and the local parameter of every channel
+        for (size_t i = 0; i < count; ++i)
+        {
+            Channel& channel = channels[blockStart + i];
+            unsigned int base = channel.FirstKey;
+            unsigned int keyCount = channel.KeyCount;
+
+            if (keyCount == 0 || time <= times[base] || keyCount == 1)
+            {
+                float value = keyCount == 0 ? 0.0f : values[base];
+                u[i] = 0.0f;
+                p0[i] = p1[i] = p2[i] = p3[i] = value;
+                continue;
+            }
+            if (time >= times[base + keyCount - 1])
+            {
+                float value = values[base + keyCount - 1];
+                u[i] = 0.0f;
+                p0[i] = p1[i] = p2[i] = p3[i] = value;
+                continue;
+            }
+
+            const float* t = times + base;
+            unsigned int segment = std::min(channel.Cursor, keyCount - 2);
+            if (time >= t[segment] && time < t[segment + 1])
+            {
+            }
+            else if (segment + 2 < keyCount && time >= t[segment + 1] && time < t[segment + 2])
+            {
+                segment++;
+            }
+            else
+            {
+                segment = static_cast<unsigned int>(std::upper_bound(t, t + keyCount, time) - t) - 1;
+            }
+            channel.Cursor = segment;
+
+            unsigned int k = base + segment;
+            u[i] = (time - t[segment]) / (t[segment + 1] - t[segment]);
+            p0[i] = values[k];
+            p1[i] = outHandles[k];
+            p2[i] = inHandles[k + 1];
+            p3[i] = values[k + 1];
+        }
+
+        // pad the last partial group so the vector loop never reads uninitialised lanes
+        size_t padded = (count + 3) & ~size_t(3);
+        for (size_t i = count; i < padded; ++i)
+            u[i] = p0[i] = p1[i] = p2[i] = p3[i] = 0.0f;
+
+        // Bezier evaluation, four channels at a time
+        const Float4 one = Float4::Set1(1.0f);
+        const Float4 three = Float4::Set1(3.0f);
+        for (size_t i = 0; i < padded; i += 4)
+        {
+            Float4 s = Float4::Load(u + i);
+            Float4 inv = one - s;
+            Float4 inv2 = inv * inv;
+            Float4 s2 = s * s;
+            Float4 value = inv2 * inv * Float4::Load(p0 + i)
+                + three * inv2 * s * Float4::Load(p1 + i)
+                + three * inv * s2 * Float4::Load(p2 + i)
+                + s2 * s * Float4::Load(p3 + i);
+            value.Store(result + i);
+        }
+
+        // Scatter into the target array
+        for (size_t i = 0; i < count; ++i)
+        {
+            const Channel& channel = channels[blockStart + i];
+            if (channel.KeyCount > 0 && channel.Target < outputCount)
+                output[channel.Target] = result[i];
+        }
+    }
+}
+
+void Timeline::EvaluateScalar(float time, float* output, size_t outputCount) const
+{
+    for (const Channel& channel : channels)
+    {
+        if (channel.KeyCount == 0 || channel.Target >= outputCount)
+            continue;
+
+        const float* t = KeyTimes.data() + channel.FirstKey;
+        const float* v = KeyValues.data() + channel.FirstKey;
+        unsigned int last = channel.KeyCount - 1;
+        if (time <= t[0])
+        {
+            output[channel.Target] = v[0];
+            continue;
+        }
+        if (time >= t[last])
+        {
+            output[channel.Target] = v[last];
+            continue;
+        }
+
+        unsigned int segment = static_cast<unsigned int>(std::upper_bound(t, t + channel.KeyCount, time) - t) - 1;
+        unsigned int k = channel.FirstKey + segment;
+        float u = (time - t[segment]) / (t[segment + 1] - t[segment]);
+        output[channel.Target] = bezier(u, KeyValues[k], KeyOutHandles[k], KeyInHandles[k + 1], KeyValues[k + 1]);
+    }
+}
@@ -0,0 +1,78 @@
+#ifndef TIMELINE_H
+#define TIMELINE_H
+
+#include "job_system.h"
+
+#include <vector>
+#include <unordered_map>
+#include <cstddef>
+
+// How a curve segment moves from a key to the next one
+enum Interpolation_Mode {
+    INTERPOLATION_LINEAR,
+    INTERPOLATION_BEZIER
+};
+
+const char* InterpolationModeName(Interpolation_Mode mode);
+
+// Keyframed float channels evaluated in one batch per frame.
+// Keys of all channels live in shared structure-of-arrays storage, each channel owning a contiguous run.
+// Every segment is stored as a cubic Bezier whose handles sit at a third and two thirds of the segment in time,
+// so a curve is a plain cubic in time: no root solve is needed, and linear segments are just evenly spaced handles.
+class Timeline
+{
+public:
+    struct Channel
+    {
+        size_t Target;          // index of the float this channel drives in the output array
+        unsigned int FirstKey;  // first key in the shared key arrays
+        unsigned int KeyCount;
+        unsigned int Cursor;    // segment used by the last evaluation; playback rarely moves more than one segment
+    };
+
+    // shared key storage, indexed by Channel::FirstKey + i
+    std::vector<float> KeyTimes;
+    std::vector<float> KeyValues;
+    std::vector<float> KeyInHandles;    // Bezier control value before the key
+    std::vector<float> KeyOutHandles;   // Bezier control value after the key
+    std::vector<unsigned char> KeyModes; // Interpolation_Mode of the segment starting at the key
+
+    // playback state
+    float Time = 0.0f;
+    float Duration = 4.0f;
+    bool Playing = false;
+    bool Loop = true;
+
+    // returns the channel driving target, creating an empty one if needed
+    int GetOrAddChannel(size_t target);
+    int FindChannel(size_t target) const;
+
+    // inserts a key, or replaces the key already at that time, and refreshes the handles around it
+    void SetKey(int channel, float time, float value, Interpolation_Mode mode);
+
+    void Clear();
+
+    size_t GetChannelCount() const { return channels.size(); }
+    size_t GetKeyCount() const { return KeyTimes.size(); }
+    const Channel& GetChannel(int channel) const { return channels[channel]; }
+
+    // moves the playhead by deltaTime while playing; returns true if the time changed
+    bool Advance(float deltaTime);
+
+    // evaluates every channel at time and writes output[channel.Target]; targets past outputCount are skipped.
+    // Channels are processed in blocks: segment lookup, then a four-wide Bezier pass, then the scatter into output.
+    // Blocks are spread over the job system when one is given.
+    void Evaluate(float time, float* output, size_t outputCount, JobSystem* jobs = nullptr);
+
+    // straightforward one-channel-at-a-time evaluation, kept as the reference for the batched path
+    void EvaluateScalar(float time, float* output, size_t outputCount) const;
+
+private:
+    std::vector<Channel> channels;
+    std::unordered_map<size_t, int> channelByTarget;
+
+    void updateHandles(const Channel& channel, unsigned int key);
+    void evaluateBlock(float time, size_t begin, size_t end, float* output, size_t outputCount);
+};
+
+#endif
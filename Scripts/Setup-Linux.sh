@@ -1,5 +1,26 @@
 #!/bin/bash
 
 pushd ..
+# Lua 5.4 sources for the Lua project in Vendor/Lua, fetched once if they are not checked in
+LUA_VERSION=5.4.6
+LUA_SHA256=7d5ea1b9cb6aa0b59ca3dde1c6adcb57ef83a1ba8e5432c0ecd06bf439b3ad88
+if [ ! -f Vendor/Lua/lua/lapi.c ]; then
+    LUA_ARCHIVE=Vendor/Lua/lua-$LUA_VERSION.tar.gz
+    if ! curl -fsSL -o "$LUA_ARCHIVE" "https://www.lua.org/ftp/lua-$LUA_VERSION.tar.gz"; then
+        echo "Failed to download lua-$LUA_VERSION.tar.gz" >&2
+        rm -f "$LUA_ARCHIVE"
+        popd
+        exit 1
+    fi
+    if ! echo "$LUA_SHA256  $LUA_ARCHIVE" | sha256sum -c --status; then
+        echo "lua-$LUA_VERSION.tar.gz does not match its pinned SHA-256; not extracting it" >&2
+        rm -f "$LUA_ARCHIVE"
+        popd
+        exit 1
+    fi
+    mkdir -p Vendor/Lua/lua
+    tar -xzf "$LUA_ARCHIVE" -C Vendor/Lua/lua --strip-components=2 "lua-$LUA_VERSION/src" || { popd; exit 1; }
+    rm -f "$LUA_ARCHIVE"
+fi
 Vendor/Binaries/Premake/Linux/premake5 --cc=clang --file=Build.lua gmake2
 popd
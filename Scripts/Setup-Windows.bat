@@ -1,6 +1,34 @@
 @echo off
 
 pushd ..
+rem Lua 5.4 sources for the Lua project in Vendor\Lua, fetched once if they are not checked in
+set LUA_VERSION=5.4.6
+set LUA_SHA256=7d5ea1b9cb6aa0b59ca3dde1c6adcb57ef83a1ba8e5432c0ecd06bf439b3ad88
+set LUA_ARCHIVE=Vendor\Lua\lua-%LUA_VERSION%.tar.gz
+if exist Vendor\Lua\lua\lapi.c goto premake
+curl -fsSL -o %LUA_ARCHIVE% https://www.lua.org/ftp/lua-%LUA_VERSION%.tar.gz
+if errorlevel 1 (
+    echo Failed to download lua-%LUA_VERSION%.tar.gz
+    goto fail
+)
+powershell -NoProfile -Command "if ((Get-FileHash -Algorithm SHA256 '%LUA_ARCHIVE%').Hash -ne '%LUA_SHA256%') { exit 1 }"
+if errorlevel 1 (
+    echo lua-%LUA_VERSION%.tar.gz does not match its pinned SHA-256; not extracting it
+    goto fail
+)
+mkdir Vendor\Lua\lua
+tar -xzf %LUA_ARCHIVE% -C Vendor\Lua\lua --strip-components=2 lua-%LUA_VERSION%/src
+if errorlevel 1 goto fail
+del %LUA_ARCHIVE%
+
+:premake
 Vendor\Binaries\Premake\Windows\premake5.exe --file=Build.lua vs2022
 popd
-pause
\ No newline at end of file
+pause
+exit /b 0
+
+:fail
+if exist %LUA_ARCHIVE% del %LUA_ARCHIVE%
+popd
+pause
+exit /b 1
\ No newline at end of file
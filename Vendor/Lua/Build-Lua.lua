@@ -0,0 +1,39 @@
+project "Lua"
+   kind "StaticLib"
+   language "C"
+   staticruntime "off"
+
+   -- Lua 5.4 sources from the official release (src/ of lua-5.4.6.tar.gz) live in lua/, so they are included as
+   -- <lua/lua.hpp>; the setup scripts download and verify them when they are missing
+   files { "lua/*.h", "lua/*.c" }
+   -- the standalone interpreter and compiler have their own main()
+   removefiles { "lua/lua.c", "lua/luac.c" }
+
+   includedirs
+   {
+      "lua"
+   }
+
+   targetdir ("../../Binaries/" .. OutputDir .. "/%{prj.name}")
+   objdir ("../../Binaries/Intermediates/" .. OutputDir .. "/%{prj.name}")
+
+   filter "system:windows"
+       systemversion "latest"
+       defines { "_CRT_SECURE_NO_WARNINGS" }
+
+   filter "system:linux"
+       defines { "LUA_USE_POSIX" }
+
+   filter "configurations:Debug"
+       runtime "Debug"
+       symbols "On"
+
+   filter "configurations:Release"
+       runtime "Release"
+       optimize "On"
+       symbols "On"
+
+   filter "configurations:Dist"
+       runtime "Release"
+       optimize "On"
+       symbols "Off"